@@ -50,6 +50,10 @@
 #define EMGD_CONTROL_NOOP_DRAWABLE          (0x20021 | EMGD_CONTROL_NO_REPLY)
 #define EMGD_CONTROL_GET_DEBUG               0x20022
 #define EMGD_CONTROL_SET_DEBUG               0x20023
+#define EMGD_CONTROL_GET_PERF_COUNTERS       0x20024
+#define EMGD_CONTROL_RESET_PERF_COUNTERS     0x20025
+#define EMGD_CONTROL_DUMP_TRACE              0x20026
+#define EMGD_CONTROL_PROBE_OUTPUTS           0x20027
 #define EMGD_CONTROL_OVERLAY_PIPEBLEND       0x20105
 #define EMGD_CONTROL_SPLASHSCREEN            0x2021A
 
@@ -73,6 +77,14 @@ static __inline char *intel_esc_str(unsigned int esc)
 		return "EMGD_CONTROL_GET_DEBUG";
 	case EMGD_CONTROL_SET_DEBUG:
 		return "EMGD_CONTROL_SET_DEBUG";
+	case EMGD_CONTROL_GET_PERF_COUNTERS:
+		return "EMGD_CONTROL_GET_PERF_COUNTERS";
+	case EMGD_CONTROL_RESET_PERF_COUNTERS:
+		return "EMGD_CONTROL_RESET_PERF_COUNTERS";
+	case EMGD_CONTROL_DUMP_TRACE:
+		return "EMGD_CONTROL_DUMP_TRACE";
+	case EMGD_CONTROL_PROBE_OUTPUTS:
+		return "EMGD_CONTROL_PROBE_OUTPUTS";
 	case EMGD_CONTROL_OVERLAY_PIPEBLEND:
 		return "EMGD_CONTROL_OVERLAY_PIPEBLEND";
 	case EMGD_CONTROL_SPLASHSCREEN:
@@ -195,6 +207,121 @@ typedef struct _iegd_esc_debug_info {
 } iegd_esc_debug_info_t;
 
 
+/*
+ * Runtime performance counters, returned by EMGD_CONTROL_GET_PERF_COUNTERS
+ * and cleared by EMGD_CONTROL_RESET_PERF_COUNTERS.
+ *
+ * All counters are 64-bit so the layout is the same for 32-bit clients
+ * talking to a 64-bit server.  Counters are cumulative since the last
+ * reset; rates and averages (bytes per batch, cache hit ratios) are left
+ * to the client.
+ *
+ * New counters take their slots from reserved[], so the block keeps
+ * its size and layout across driver versions.
+ */
+#define EMGD_PERF_FALLBACK_FILL_SPANS       0
+#define EMGD_PERF_FALLBACK_SET_SPANS        1
+#define EMGD_PERF_FALLBACK_PUT_IMAGE        2
+#define EMGD_PERF_FALLBACK_COPY_AREA        3
+#define EMGD_PERF_FALLBACK_COPY_PLANE       4
+#define EMGD_PERF_FALLBACK_POLY_POINT       5
+#define EMGD_PERF_FALLBACK_POLY_LINES       6
+#define EMGD_PERF_FALLBACK_POLY_SEGMENT     7
+#define EMGD_PERF_FALLBACK_POLY_ARC         8
+#define EMGD_PERF_FALLBACK_POLY_FILL_RECT   9
+#define EMGD_PERF_FALLBACK_IMAGE_GLYPH_BLT  10
+#define EMGD_PERF_FALLBACK_POLY_GLYPH_BLT   11
+#define EMGD_PERF_FALLBACK_PUSH_PIXELS      12
+#define EMGD_PERF_FALLBACK_GET_SPANS        13
+#define EMGD_PERF_FALLBACK_COMPOSITE        14
+#define EMGD_PERF_FALLBACK_ADD_TRAPS        15
+#define EMGD_PERF_NUM_FALLBACKS             16
+
+typedef struct _iegd_esc_perf_counters {
+	/* Batch buffer submission */
+	uint64_t batch_submits;        /* Batches handed to the kernel */
+	uint64_t batch_bytes;          /* Total bytes of all submitted batches */
+	uint64_t batch_max_bytes;      /* Largest single batch */
+	uint64_t exec_ns;              /* Time spent in drm_intel_bo_mrb_exec */
+
+	/* Buffer objects */
+	uint64_t bo_allocs;            /* Pixmap, batch and vertex allocations */
+	uint64_t bo_cache_hits;        /* Pixmaps served from the in-flight list */
+	uint64_t gtt_maps;             /* GTT mappings for CPU access */
+	uint64_t gtt_map_ns;           /* Time spent mapping (incl. GPU stalls) */
+
+	/* Software fallbacks, indexed by EMGD_PERF_FALLBACK_* */
+	uint64_t fallbacks[EMGD_PERF_NUM_FALLBACKS];
+
+	/* UXA caches */
+	uint64_t glyph_cache_hits;
+	uint64_t glyph_cache_misses;
+	uint64_t solid_cache_hits;
+	uint64_t solid_cache_misses;
+
+	/* DRI2 swaps */
+	uint64_t swap_flips;
+	uint64_t swap_blits;
+
+	/* XVideo frames by display path */
+	uint64_t xv_overlay_frames;    /* Flipped onto a sprite plane */
+	uint64_t xv_blend_frames;      /* Textured (blended) video */
+
+	/* GPU hang recovery */
+	uint64_t gpu_hangs;            /* Batches rejected with -EIO */
+	uint64_t gpu_recoveries;       /* Acceleration re-enabled after a hang */
+
+	/* Cached CPU readback */
+	uint64_t cpu_maps;             /* Cached CPU mappings for CPU access */
+	uint64_t cpu_map_ns;           /* Time spent mapping (incl. GPU stalls) */
+	uint64_t detile_reads;         /* Tiled reads detiled in software */
+	uint64_t access_flushes_avoided; /* CPU accesses outside pending writes */
+
+	/* GetImage staging readback */
+	uint64_t readback_hits;        /* Bands served from a staging copy */
+	uint64_t readback_misses;      /* Bands that needed a new blit */
+
+	/* Hardware cursor */
+	uint64_t cursor_uploads;       /* Images written into a cursor bo */
+	uint64_t cursor_cache_hits;    /* Loads served by a cached cursor bo */
+
+	/* Output probing */
+	uint64_t connector_probes;     /* Connectors read from the kernel */
+	uint64_t connector_cache_hits; /* Detects answered from the cache */
+	uint64_t hotplug_events;       /* DRM hotplug uevents received */
+
+	/* DRI2 buffers */
+	uint64_t dri2_buffer_allocs;   /* New pixmaps (and flinks) for DRI2 */
+	uint64_t dri2_buffer_reuses;   /* Buffers served from the release cache */
+
+	/* BLT/render ring switches */
+	uint64_t ring_switches;        /* Switches that parked a batch */
+	uint64_t ring_switch_submits;  /* ... that had to submit the parked one */
+
+	/* Batch submission thread ("AsyncSubmit") */
+	uint64_t submit_queued;        /* Batches handed to the thread */
+	uint64_t submit_waits;         /* Times the server waited for it */
+	uint64_t submit_wait_ns;       /* Time spent in those waits */
+
+	/* Aperture checks before each operation */
+	uint64_t aperture_checks;
+	uint64_t aperture_check_hits;  /* ... answered without asking libdrm */
+
+	/* Core font text (ImageText, PolyText) */
+	uint64_t core_text_strings;    /* Strings drawn with mono expansion */
+
+	/* Tiled pixmaps too large for the GTT */
+	uint64_t access_shadows;       /* CPU accesses through a linear shadow */
+
+	/* Window moves and scrolls (CopyWindow) */
+	uint64_t copy_window_blits;    /* Boxes copied */
+	uint64_t copy_window_bytes;    /* Bytes damaged by those copies */
+
+	/* Unused, read as zero */
+	uint64_t reserved[6];
+} iegd_esc_perf_counters_t;
+
+
 #define GAMMA_FLAG          0x1
 #define BRIGHTNESS_FLAG     0x2
 #define CONTRAST_FLAG       0x4
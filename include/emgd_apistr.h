@@ -42,7 +42,7 @@
 #define EMGDNAME "Intel-EmbeddedGraphicsDriverExtension"
 
 #define EGD_ESC_MAJOR_VERSION	1	/* current version numbers */
-#define EGD_ESC_MINOR_VERSION	3
+#define EGD_ESC_MINOR_VERSION	4
 #define EGD_NUM_ERRORS 2
 #define EGD_BAD_CONTEXT 0
 #define EGD_BAD_SURFACE 1
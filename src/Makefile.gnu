@@ -54,6 +54,10 @@ SOURCES = emgd_ddx.c  \
 		  i965_render.c \
 		  i965_video.c \
 		  emgd_sprite.c \
+		  emgd_trace.c \
+		  emgd_capture.c \
+		  emgd_submit.c \
+		  emgd_tiling.c \
 
 #
 # Header files that cause source files to be recompiled.
@@ -64,6 +68,11 @@ HEADERS = emgd.h       \
 	emgd_dri2.h \
 	emgd_drm_bo.h \
 	emgd_video.h \
+	emgd_perf.h \
+	emgd_trace.h \
+	emgd_capture.h \
+	emgd_submit.h \
+	emgd_tiling.h \
 	brw_defines.h \
 	brw_structs.h \
 	intel_batchbuffer.h \
@@ -146,3 +155,224 @@ install::
 package::
 	mkdir -p $(EGD_PKG)/driver/$(XDDK_TYPE)
 	$(MAKE) EGD_INS=$(EGD_PKG)/driver/$(XDDK_TYPE) install
+
+#
+# Offline decoders for capture and trace files, see ../tools/.  They only
+# need the file layouts shared with the driver, not its build
+# dependencies.
+#
+#   make -f Makefile.gnu tools
+#
+TOOLS_DIR = $(EGD_ROOT)/tools
+TOOLS_OBJECT_PATH = $(PROJECT_OBJECT_PATH)/tools
+
+TOOLS = \
+	emgd_batch_decode \
+	emgd_trace_decode \
+
+TOOL_PROGS = $(addprefix $(TOOLS_OBJECT_PATH)/,$(TOOLS))
+
+$(TOOL_PROGS): $(TOOLS_OBJECT_PATH)/%: $(TOOLS_DIR)/%.c $(HEADERS)
+	echo -e "$(GREEN) Compiling $(TOOLS_DIR)/$*.c $(OFF)"
+	mkdir -p $(TOOLS_OBJECT_PATH)
+	$(CC) -O2 -Wall -I. -I$(EGD_ROOT)/include -o $@ $<
+
+tools:: $(TOOL_PROGS)
+
+clean::
+	rm -rf $(TOOLS_OBJECT_PATH)
+
+#
+# Unit tests and benchmarks, see tests/.  They run without a GPU or an X
+# server: driver objects are linked against tests/mock_drm.c instead of
+# libdrm_intel, and server symbols the tested paths never reach are left
+# unresolved, just as they are in the driver module until it is loaded.
+#
+#   make -f Makefile.gnu test      build and run the tests
+#   make -f Makefile.gnu bench     build and run the benchmarks
+#
+# For each program, <name>_OBJS lists the driver objects it links,
+# <name>_TEST_OBJS the test support objects and <name>_LIBS any libraries.
+# Tests exit with 77 when they can't run in the current environment.
+#
+TEST_DIR = tests
+TEST_OBJECT_PATH = $(PROJECT_OBJECT_PATH)/tests
+TEST_MOCK = emgd_test.o emgd_test_screen.o xserver_stubs.o mock_drm.o
+TEST_LDFLAGS = -pthread -Wl,--unresolved-symbols=ignore-all -Wl,-z,lazy \
+	-Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc
+TEST_BATCH_OBJS = intel_batchbuffer.o emgd_submit.o emgd_trace.o \
+	emgd_capture.o
+
+TESTS = \
+	test_batch_exec \
+	test_api \
+	test_access \
+	test_aperture \
+	test_tiling \
+	test_dri2 \
+	test_render_formats \
+	test_expand_bitmap \
+	test_get_image \
+	test_cursor \
+	test_hotplug \
+	test_rings \
+	test_submit \
+	test_mono \
+	test_core_text \
+	test_lines \
+	test_dual_source \
+	test_capture \
+
+BENCHES = \
+	bench_batch \
+	bench_readback \
+	bench_aperture \
+	bench_tiling \
+	bench_dri2 \
+	bench_copy_window \
+	bench_get_image \
+	bench_mono \
+	bench_core_text \
+	bench_lines \
+	bench_trace \
+
+test_batch_exec_OBJS = $(TEST_BATCH_OBJS)
+test_batch_exec_TEST_OBJS = $(TEST_MOCK)
+
+# Includes emgd_api.c itself for the static dispatch functions
+test_api_TEST_OBJS = emgd_test.o xserver_stubs.o mock_drm.o
+test_api_LIBS = -Wl,--wrap=WriteToClient
+
+# Includes emgd_uxa.c itself for the static UXA hooks
+test_access_OBJS = $(TEST_BATCH_OBJS) emgd_tiling.o
+test_access_TEST_OBJS = $(TEST_MOCK)
+
+test_aperture_OBJS = $(TEST_BATCH_OBJS) emgd_uxa.o
+test_aperture_TEST_OBJS = $(TEST_MOCK)
+
+test_tiling_OBJS = emgd_tiling.o
+test_tiling_TEST_OBJS = emgd_test.o
+
+# Includes emgd_dri2.c itself for the static buffer hooks
+test_dri2_OBJS = $(TEST_BATCH_OBJS) emgd_uxa.o
+test_dri2_TEST_OBJS = $(TEST_MOCK)
+
+# Includes i965_render.c itself for the static format tables
+test_render_formats_OBJS = $(TEST_BATCH_OBJS)
+test_render_formats_TEST_OBJS = $(TEST_MOCK)
+
+# Includes uxa-render.c itself for the static extents function
+test_expand_bitmap_TEST_OBJS = emgd_test.o
+test_expand_bitmap_LIBS = -lpixman-1 -lm
+
+# Includes emgd_uxa.c itself for the static GetImage hooks
+test_get_image_OBJS = $(TEST_BATCH_OBJS) emgd_tiling.o
+test_get_image_TEST_OBJS = $(TEST_MOCK)
+
+# Includes emgd_crtc.c itself for the static cursor hooks
+test_cursor_OBJS = $(TEST_BATCH_OBJS) emgd_drm_bo.o
+test_cursor_TEST_OBJS = $(TEST_MOCK)
+
+# Includes emgd_output.c itself for the static detect hook
+test_hotplug_TEST_OBJS = $(TEST_MOCK)
+
+test_rings_OBJS = $(TEST_BATCH_OBJS)
+test_rings_TEST_OBJS = $(TEST_MOCK)
+
+test_submit_OBJS = $(TEST_BATCH_OBJS)
+test_submit_TEST_OBJS = $(TEST_MOCK)
+
+# X clients, run against $EMGD_TEST_DISPLAY and $EMGD_REF_DISPLAY
+test_mono_TEST_OBJS = emgd_test.o emgd_xtest.o
+test_mono_LIBS = -lX11
+
+test_core_text_TEST_OBJS = emgd_test.o emgd_xtest.o
+test_core_text_LIBS = -lX11
+
+test_lines_TEST_OBJS = emgd_test.o emgd_xtest.o
+test_lines_LIBS = -lX11
+
+# Includes i965_render.c itself for the static kernels and blend tables
+test_dual_source_OBJS = $(TEST_BATCH_OBJS)
+test_dual_source_TEST_OBJS = $(TEST_MOCK)
+test_dual_source_LIBS = -lpixman-1
+
+# Includes i965_render.c and tools/emgd_batch_decode.c themselves
+test_capture_OBJS = $(TEST_BATCH_OBJS)
+test_capture_TEST_OBJS = $(TEST_MOCK)
+$(TEST_OBJECT_PATH)/test_capture.o: $(TOOLS_DIR)/emgd_batch_decode.c
+
+bench_batch_OBJS = $(TEST_BATCH_OBJS)
+bench_batch_TEST_OBJS = $(TEST_MOCK)
+
+# Includes emgd_uxa.c itself for the static access paths
+bench_readback_OBJS = $(TEST_BATCH_OBJS) emgd_tiling.o
+bench_readback_TEST_OBJS = $(TEST_MOCK)
+
+bench_aperture_OBJS = $(TEST_BATCH_OBJS) emgd_uxa.o
+bench_aperture_TEST_OBJS = $(TEST_MOCK)
+
+bench_tiling_OBJS = emgd_tiling.o
+bench_tiling_TEST_OBJS = emgd_test.o
+
+# Includes emgd_dri2.c itself for the static buffer hooks
+bench_dri2_OBJS = $(TEST_BATCH_OBJS) emgd_uxa.o
+bench_dri2_TEST_OBJS = $(TEST_MOCK)
+
+# X clients, run against $EMGD_TEST_DISPLAY
+bench_copy_window_TEST_OBJS = emgd_test.o emgd_xtest.o
+bench_copy_window_LIBS = -lX11
+
+# Includes emgd_uxa.c itself for the static GetImage hooks
+bench_get_image_OBJS = $(TEST_BATCH_OBJS) emgd_tiling.o
+bench_get_image_TEST_OBJS = $(TEST_MOCK)
+
+bench_mono_TEST_OBJS = emgd_test.o emgd_xtest.o
+bench_mono_LIBS = -lX11
+
+bench_core_text_TEST_OBJS = emgd_test.o emgd_xtest.o
+bench_core_text_LIBS = -lX11
+
+bench_lines_TEST_OBJS = emgd_test.o emgd_xtest.o
+bench_lines_LIBS = -lX11 -lm
+
+bench_trace_OBJS = $(TEST_BATCH_OBJS)
+bench_trace_TEST_OBJS = $(TEST_MOCK)
+
+TEST_PROGS = $(addprefix $(TEST_OBJECT_PATH)/,$(TESTS))
+BENCH_PROGS = $(addprefix $(TEST_OBJECT_PATH)/,$(BENCHES))
+
+$(TEST_OBJECT_PATH)/%.o: $(TEST_DIR)/%.c $(DEPENDS) \
+		$(TEST_DIR)/emgd_test.h $(TEST_DIR)/mock_drm.h \
+		$(TEST_DIR)/emgd_xtest.h
+	echo -e "$(GREEN) Compiling $(CURDIR)/$< $(OFF)"
+	mkdir -p $(TEST_OBJECT_PATH)
+	$(CC) $(CFLAGS) $(INCLUDES) -I$(TEST_DIR) -c $< -o$@
+
+.SECONDEXPANSION:
+$(TEST_PROGS) $(BENCH_PROGS): $(TEST_OBJECT_PATH)/%: $(TEST_OBJECT_PATH)/%.o \
+		$$(addprefix $(PROJECT_OBJECT_PATH)/,$$($$*_OBJS)) \
+		$$(addprefix $(TEST_OBJECT_PATH)/,$$($$*_TEST_OBJS))
+	echo -e "$(GREEN) Linking $@ $(OFF)"
+	$(CC) $(ARCH_FLAGS) -o $@ $^ $($*_LIBS) $(TEST_LDFLAGS)
+
+test:: $(TEST_PROGS)
+	pass=0; fail=0; skip=0; \
+	for t in $(TEST_PROGS); do \
+		$$t; ret=$$?; \
+		if [ $$ret -eq 0 ]; then pass=$$((pass + 1)); \
+		elif [ $$ret -eq 77 ]; then echo "SKIP: $$t"; skip=$$((skip + 1)); \
+		else fail=$$((fail + 1)); fi; \
+	done; \
+	echo "$$pass passed, $$fail failed, $$skip skipped"; \
+	[ $$fail -eq 0 ]
+
+bench:: $(BENCH_PROGS)
+	for b in $(BENCH_PROGS); do \
+		$$b; ret=$$?; \
+		if [ $$ret -eq 77 ]; then echo "SKIP: $$b"; \
+		elif [ $$ret -ne 0 ]; then exit 1; fi; \
+	done
+
+clean::
+	rm -rf $(TEST_OBJECT_PATH)
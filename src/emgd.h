@@ -342,6 +342,7 @@ typedef struct _config_info {
 	Bool punt_uxa_composite;
 	Bool punt_uxa_composite_1x1_mask;
 	Bool punt_uxa_composite_mask;
+	Bool punt_uxa_mono;
 
 	/* XVideo options. */
 	/* FIXME: these overlay specific attrs should go away.
@@ -383,6 +384,16 @@ typedef struct _config_info {
 	Bool fb_blend_ovl;
 	int sprite_assignment[4];
 	char *sprite_zorder;
+
+	/* Diagnostics */
+	Bool trace;
+	char *trace_file;
+	char *batch_capture;
+	int batch_capture_size;                /* MiB before rotating */
+	int batch_capture_bo_limit;            /* KiB snapshotted per bo */
+
+	/* Performance */
+	Bool async_submit;
 } emgd_config_info_t;
 
 
@@ -403,7 +414,8 @@ typedef struct emgd_priv_t {
 
 	dri_bufmgr *bufmgr;
 
-	uint32_t batch_ptr[4096];
+	/** Points into batch_store[], see intel_batch_switch_ring() */
+	uint32_t *batch_ptr;
 	/** Byte offset in batch_ptr for the next dword to be emitted. */
 	unsigned int batch_used;
 	/** Position in batch_ptr at the start of the current BEGIN_BATCH */
@@ -418,9 +430,55 @@ typedef struct emgd_priv_t {
 	struct LIST batch_pixmaps;
 	struct LIST flush_pixmaps;
 	struct LIST in_flight;
+
+	/*
+	 * Batch for the other ring, set aside rather than submitted when
+	 * rendering moves between the BLT and render rings.  parked.ring is
+	 * 0 when nothing is parked.  parked_dep is set once the current batch
+	 * uses a pixmap in a way that must follow the parked batch.
+	 */
+	struct intel_parked_batch {
+		dri_bo *bo;
+		uint32_t *ptr;
+		unsigned int used;
+		unsigned int ring;
+	} parked;
+	Bool parked_dep;
+	uint32_t batch_store[2][4096];
+
+	/*
+	 * Buffers already counted against the aperture for the current and
+	 * the parked batch, see intel_check_aperture().
+	 */
+#define INTEL_APERTURE_BOS	32
+	struct intel_aperture {
+		dri_bo *batch;		/* NULL when unused */
+		dri_bo *bos[INTEL_APERTURE_BOS];
+		int num_bos;
+		unsigned long size;	/* Batch plus every buffer counted */
+		Bool verified;		/* libdrm has accepted this batch */
+	} aperture[2];
+	unsigned long aperture_limit;
 	drm_intel_bo *wa_scratch_bo;
+	struct emgd_capture *capture;
+	struct emgd_submit *submit;	/* NULL unless AsyncSubmit is on */
 	OsTimerPtr cache_expire;
 
+	/* GetImage staging pixmaps, see intel_uxa_get_image() */
+	struct intel_readback {
+		PixmapPtr pixmap;	/* Linear staging pixmap */
+		dri_bo *src_bo;		/* Source the contents were copied from */
+		uint32_t src_serial;	/* Source write_serial at copy time */
+		int x, y, w, h;		/* Area held, in source coordinates */
+	} readback[2];
+	int readback_next;
+
+	/* Released DRI2 buffers kept for reuse, see emgd_dri2_cache_take() */
+	struct LIST dri2_cache;
+	unsigned long dri2_cache_bytes;
+	OsTimerPtr dri2_cache_expire;
+	DestroyWindowProcPtr DestroyWindow;	/* Wrapped to drop them */
+
 	/* For Xvideo */
 	Bool use_overlay;
 #ifdef INTEL_XVMC
@@ -455,6 +513,13 @@ typedef struct emgd_priv_t {
 	void (*vertex_flush) (struct emgd_priv_t *intel);
 	void (*batch_flush) (struct emgd_priv_t *intel);
 	void (*batch_commit_notify) (struct emgd_priv_t *intel);
+	/*
+	 * Hands a finished batch to the kernel.  Defaults to
+	 * intel_batch_exec(); replaced by test harnesses that run without
+	 * a GPU.
+	 */
+	int (*batch_exec) (struct emgd_priv_t *intel, dri_bo *bo,
+				int used, unsigned int ring);
 
 	uxa_driver_t *uxa_driver;
 	Bool need_sync;
@@ -571,6 +636,9 @@ typedef struct emgd_priv_t {
 	Bool use_pageflipping;
 	Bool use_triple_buffer;
 	Bool force_fallback;
+	int hang_count;
+	CARD32 last_recovery;
+	OsTimerPtr hang_recover;
 	Bool can_blt;
 	Bool has_kernel_flush;
 	Bool needs_flush;
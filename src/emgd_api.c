@@ -33,6 +33,8 @@
  *     Set sprite plane z-order
  *     Get driver info
  *     Get port info
+ *     Get / Reset runtime performance counters
+ *     Dump the binary event trace
  *     SplashScreen
  *
  *  Most of these may move to DRM IOCTL commands.  The exceptions would
@@ -55,9 +57,13 @@
 #include <extnsionst.h>
 #include <dixstruct.h>
 #include "emgd.h"
+#include "emgd_dri2.h"
+#include "emgd_crtc.h"
 #define _EMGD_SERVER_
 #include <emgd_apistr.h>
 #include "ddx_version.h"
+#include "emgd_perf.h"
+#include "emgd_trace.h"
 
 /* External function protypes */
 extern int emgd_drm_query_ovl(void * kms_display_handle, int fd, unsigned int flags);
@@ -67,6 +73,8 @@ static int driver_info(int *size, void **output);
 static int set_ovl_color_params(void *color_to_set);
 static int get_ovl_color_params(int *size, void **color_returned);
 static int get_debug(int *size, void **output);
+static int get_perf_counters(int *size, void **output);
+static int reset_perf_counters(void);
 #if DEBUG
 static int set_debug(void *input);
 #endif
@@ -87,6 +95,9 @@ extern PciChipsets emgd_PCIChipsets[];          /* from emgd_ddx.c */
 
 int emgd_init_generation = 0;
 
+/* Runtime performance counters, see emgd_perf.h */
+iegd_esc_perf_counters_t emgd_perf;
+
 static int emgd_error_base;
 static int emgd_req_code;
 static int emgd_screen[2];
@@ -270,6 +281,29 @@ static int emgd_api(ClientPtr client)
 		OS_DEBUG("  -> ESCAPE_GET_OVL_COLOR_PARAMS");
 		status = get_ovl_color_params(&out_size, &output);
 		break;
+	case EMGD_CONTROL_GET_PERF_COUNTERS:
+		OS_DEBUG("  -> ESCAPE_GET_PERF_COUNTERS");
+		status = get_perf_counters(&out_size, &output);
+		break;
+	case EMGD_CONTROL_RESET_PERF_COUNTERS:
+		OS_DEBUG("  -> ESCAPE_RESET_PERF_COUNTERS");
+		status = reset_perf_counters();
+		out_size = 0;
+		output = (void *)NULL;
+		break;
+	case EMGD_CONTROL_DUMP_TRACE:
+		OS_DEBUG("  -> ESCAPE_DUMP_TRACE");
+		status = emgd_trace_dump() ? EMGD_CONTROL_ERROR : EMGD_CONTROL_SUCCESS;
+		out_size = 0;
+		output = (void *)NULL;
+		break;
+	case EMGD_CONTROL_PROBE_OUTPUTS:
+		OS_DEBUG("  -> ESCAPE_PROBE_OUTPUTS");
+		emgd_output_force_probe(iptr->kms);
+		status = EMGD_CONTROL_SUCCESS;
+		out_size = 0;
+		output = (void *)NULL;
+		break;
 	default:
 		OS_DEBUG("  -> ESCAPE UNKNOWN");
 		output = (void *)NULL;
@@ -466,6 +500,38 @@ static int set_debug(void *input)
 #endif
 
 
+/*
+ * Get and reset performance counters
+ *
+ * The counters are a flat block of 64-bit values, so reading is a single
+ * copy and resetting is a single memset.  Both are cheap enough to poll
+ * from a monitoring client with the counters permanently enabled.
+ */
+static int get_perf_counters(int *size, void **output)
+{
+	iegd_esc_perf_counters_t *counters;
+
+	counters = (iegd_esc_perf_counters_t *)
+			malloc(sizeof(iegd_esc_perf_counters_t));
+	*output = (void *)counters;
+
+	if (counters == NULL) {
+		*size = 0;
+		return EMGD_CONTROL_ERROR;
+	}
+
+	memcpy(counters, &emgd_perf, sizeof(iegd_esc_perf_counters_t));
+	*size = sizeof(iegd_esc_perf_counters_t);
+	return EMGD_CONTROL_SUCCESS;
+}
+
+static int reset_perf_counters(void)
+{
+	memset(&emgd_perf, 0, sizeof(emgd_perf));
+	return EMGD_CONTROL_SUCCESS;
+}
+
+
 /*
  * set_ovl_color_params
  *
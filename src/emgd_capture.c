@@ -0,0 +1,358 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_capture.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Batchbuffer capture to a rotating file.  See emgd_capture.h for the
+ *  file layout.
+ *
+ *  Capture is a debugging aid: snapshots are read back with pread before
+ *  the batch is executed, which serializes against earlier rendering into
+ *  the same buffers.  Expect a significant slowdown while it is enabled.
+ *-----------------------------------------------------------------------------
+ */
+#define PER_MODULE_DEBUG
+#define MODULE_NAME ial.accel
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xf86.h>
+#include <intel_bufmgr.h>
+
+#include "emgd.h"
+#include "emgd_capture.h"
+#include "emgd_perf.h"
+
+typedef struct _capture_reloc {
+	drm_intel_bo *bo;
+	emgd_capture_reloc_t rec;
+} capture_reloc_t;
+
+struct emgd_capture {
+	FILE *file;
+	char *path;
+	unsigned long file_bytes;
+	unsigned long max_bytes;
+	unsigned long bo_limit;
+	emgd_capture_file_hdr_t hdr;
+	uint32_t seq;
+
+	/* Relocations emitted into the batch currently being built */
+	capture_reloc_t *relocs;
+	uint32_t num_relocs;
+	uint32_t max_relocs;
+
+	/* Buffers to snapshot for the current batch, deduplicated */
+	drm_intel_bo **bos;
+	uint32_t num_bos;
+
+	void *scratch;
+};
+
+
+static int capture_open(struct emgd_capture *capture)
+{
+	capture->file = fopen(capture->path, "wb");
+	if (!capture->file) {
+		OS_ERROR("Unable to open batch capture file %s", capture->path);
+		return -1;
+	}
+
+	if (fwrite(&capture->hdr, sizeof(capture->hdr), 1, capture->file) != 1) {
+		OS_ERROR("Unable to write batch capture file %s", capture->path);
+		fclose(capture->file);
+		capture->file = NULL;
+		return -1;
+	}
+
+	capture->file_bytes = sizeof(capture->hdr);
+	return 0;
+}
+
+
+/*
+ * capture_rotate
+ *
+ * Keep the previous file as <path>.1 and start a new one.  Only one old
+ * generation is kept so capture can be left running on a target without
+ * filling the disk.
+ */
+static int capture_rotate(struct emgd_capture *capture)
+{
+	char *old_path;
+
+	fclose(capture->file);
+	capture->file = NULL;
+
+	old_path = malloc(strlen(capture->path) + 3);
+	if (old_path) {
+		sprintf(old_path, "%s.1", capture->path);
+		rename(capture->path, old_path);
+		free(old_path);
+	}
+
+	return capture_open(capture);
+}
+
+
+/*
+ * emgd_capture_create
+ *
+ * Start capturing to path.  Returns NULL if the file can't be created, in
+ * which case the driver simply runs without capture.
+ */
+struct emgd_capture *emgd_capture_create(const char *path,
+	unsigned long max_bytes, unsigned long bo_limit,
+	uint32_t devid, uint32_t gen)
+{
+	struct emgd_capture *capture;
+
+	capture = calloc(1, sizeof(*capture));
+	if (!capture) {
+		return NULL;
+	}
+
+	capture->path = strdup(path);
+	capture->max_bytes = max_bytes;
+	capture->bo_limit = bo_limit;
+	capture->scratch = bo_limit ? malloc(bo_limit) : NULL;
+
+	memcpy(capture->hdr.magic, EMGD_CAPTURE_MAGIC, sizeof(EMGD_CAPTURE_MAGIC));
+	capture->hdr.version = EMGD_CAPTURE_VERSION;
+	capture->hdr.devid = devid;
+	capture->hdr.gen = gen;
+
+	if (!capture->path || (bo_limit && !capture->scratch) ||
+		capture_open(capture)) {
+		emgd_capture_destroy(capture);
+		return NULL;
+	}
+
+	OS_PRINT("Capturing batchbuffers to %s", path);
+	return capture;
+}
+
+
+void emgd_capture_destroy(struct emgd_capture *capture)
+{
+	if (!capture) {
+		return;
+	}
+
+	if (capture->file) {
+		fclose(capture->file);
+	}
+	free(capture->relocs);
+	free(capture->bos);
+	free(capture->scratch);
+	free(capture->path);
+	free(capture);
+}
+
+
+/* Batch and state relocations share one list, in emission order */
+static void capture_add_reloc(struct emgd_capture *capture,
+	uint32_t in_handle, uint32_t offset, drm_intel_bo *bo, uint32_t delta,
+	uint32_t read_domains, uint32_t write_domain)
+{
+	capture_reloc_t *reloc;
+
+	if (capture->num_relocs == capture->max_relocs) {
+		uint32_t max = capture->max_relocs ? capture->max_relocs * 2 : 256;
+		capture_reloc_t *relocs;
+
+		relocs = realloc(capture->relocs, max * sizeof(*relocs));
+		if (!relocs) {
+			return;
+		}
+		capture->relocs = relocs;
+		capture->max_relocs = max;
+	}
+
+	reloc = &capture->relocs[capture->num_relocs++];
+	reloc->bo = bo;
+	reloc->rec.offset = offset;
+	reloc->rec.handle = bo->handle;
+	reloc->rec.delta = delta;
+	reloc->rec.read_domains = read_domains;
+	reloc->rec.write_domain = write_domain;
+	reloc->rec.bo_index = EMGD_CAPTURE_NO_BO;
+	reloc->rec.in_handle = in_handle;
+	reloc->rec.reserved = 0;
+}
+
+
+/*
+ * emgd_capture_reloc
+ *
+ * Remember a relocation emitted into the current batch.  The target bo
+ * is not referenced here; the batch's own relocation keeps it alive until
+ * the batch has been submitted.
+ */
+void emgd_capture_reloc(struct emgd_capture *capture, drm_intel_bo *bo,
+	uint32_t offset, uint32_t delta,
+	uint32_t read_domains, uint32_t write_domain)
+{
+	capture_add_reloc(capture, 0, offset, bo, delta,
+		read_domains, write_domain);
+}
+
+
+/*
+ * emgd_capture_state_reloc
+ *
+ * Remember a relocation emitted into a state bo that the current batch
+ * points at.  The target stays alive through the state bo's relocation,
+ * and the state bo through the batch's.
+ */
+void emgd_capture_state_reloc(struct emgd_capture *capture,
+	drm_intel_bo *state_bo, uint32_t offset, drm_intel_bo *bo,
+	uint32_t delta, uint32_t read_domains, uint32_t write_domain)
+{
+	capture_add_reloc(capture, state_bo->handle, offset, bo, delta,
+		read_domains, write_domain);
+}
+
+
+/*
+ * Assign snapshot indices.  Only buffers the GPU reads are snapshotted;
+ * pure render targets carry no information for offline analysis.
+ */
+static void capture_collect_bos(struct emgd_capture *capture)
+{
+	uint32_t i, j;
+
+	capture->num_bos = 0;
+	if (!capture->num_relocs || !capture->bo_limit) {
+		return;
+	}
+
+	free(capture->bos);
+	capture->bos = malloc(capture->num_relocs * sizeof(*capture->bos));
+	if (!capture->bos) {
+		return;
+	}
+
+	for (i = 0; i < capture->num_relocs; i++) {
+		capture_reloc_t *reloc = &capture->relocs[i];
+
+		if (reloc->rec.read_domains == reloc->rec.write_domain) {
+			continue;
+		}
+
+		for (j = 0; j < capture->num_bos; j++) {
+			if (capture->bos[j] == reloc->bo) {
+				break;
+			}
+		}
+		if (j == capture->num_bos) {
+			capture->bos[capture->num_bos++] = reloc->bo;
+		}
+		reloc->rec.bo_index = j;
+	}
+}
+
+
+/*
+ * emgd_capture_batch
+ *
+ * Append the batch about to be executed to the capture file and reset
+ * the relocation list for the next batch.
+ */
+void emgd_capture_batch(struct emgd_capture *capture, uint32_t ring,
+	const uint32_t *batch, uint32_t bytes)
+{
+	emgd_capture_batch_hdr_t hdr;
+	emgd_capture_bo_t bo_hdr;
+	unsigned long record_bytes;
+	uint32_t i;
+	int ok = 1;
+
+	if (!capture->file) {
+		goto done;
+	}
+
+	capture_collect_bos(capture);
+
+	record_bytes = sizeof(hdr) + bytes +
+		capture->num_relocs * sizeof(emgd_capture_reloc_t) +
+		capture->num_bos * (sizeof(bo_hdr) + capture->bo_limit);
+	if (capture->file_bytes + record_bytes > capture->max_bytes &&
+		capture->file_bytes > sizeof(capture->hdr)) {
+		if (capture_rotate(capture)) {
+			goto done;
+		}
+	}
+
+	hdr.tag = EMGD_CAPTURE_TAG_BATCH;
+	hdr.seq = capture->seq++;
+	hdr.ring = ring;
+	hdr.batch_bytes = bytes;
+	hdr.num_relocs = capture->num_relocs;
+	hdr.num_bos = capture->num_bos;
+	hdr.ts = emgd_perf_now();
+
+	ok &= fwrite(&hdr, sizeof(hdr), 1, capture->file) == 1;
+	ok &= fwrite(batch, bytes, 1, capture->file) == 1;
+	capture->file_bytes += sizeof(hdr) + bytes;
+
+	for (i = 0; i < capture->num_relocs; i++) {
+		ok &= fwrite(&capture->relocs[i].rec,
+			sizeof(emgd_capture_reloc_t), 1, capture->file) == 1;
+	}
+	capture->file_bytes += capture->num_relocs * sizeof(emgd_capture_reloc_t);
+
+	for (i = 0; i < capture->num_bos; i++) {
+		drm_intel_bo *bo = capture->bos[i];
+		uint32_t len = bo->size < capture->bo_limit ?
+			bo->size : capture->bo_limit;
+
+		len &= ~3;
+		if (drm_intel_bo_get_subdata(bo, 0, len, capture->scratch)) {
+			len = 0;
+		}
+
+		bo_hdr.handle = bo->handle;
+		bo_hdr.size = bo->size;
+		bo_hdr.captured = len;
+		bo_hdr.reserved = 0;
+
+		ok &= fwrite(&bo_hdr, sizeof(bo_hdr), 1, capture->file) == 1;
+		if (len) {
+			ok &= fwrite(capture->scratch, len, 1, capture->file) == 1;
+		}
+		capture->file_bytes += sizeof(bo_hdr) + len;
+	}
+
+	if (!ok) {
+		OS_ERROR("Batch capture write failed, disabling capture");
+		fclose(capture->file);
+		capture->file = NULL;
+	}
+
+done:
+	capture->num_relocs = 0;
+	capture->num_bos = 0;
+}
@@ -0,0 +1,120 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_capture.h
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Opt-in batchbuffer capture.
+ *
+ *  When the "BatchCapture" option names a file, every submitted batch is
+ *  appended to it together with its ring, its relocation list and a
+ *  snapshot of the buffer objects it reads from (surface state, vertex
+ *  data, source pixmaps; each truncated to "BatchCaptureBoLimit").  The
+ *  file is rotated to <file>.1 once it grows past "BatchCaptureSize".
+ *
+ *  Relocations written into indirect state (surface state and binding
+ *  tables built in a separate bo) are recorded as well, tagged with the
+ *  handle of the bo holding them, so that the pixmaps a batch samples
+ *  are snapshotted even though the batch never points at them directly.
+ *
+ *  tools/emgd_batch_decode reads the resulting file.  The layouts below
+ *  are shared with it and must only change with EMGD_CAPTURE_VERSION.
+ *-----------------------------------------------------------------------------
+ */
+
+#ifndef _EMGD_CAPTURE_H_
+#define _EMGD_CAPTURE_H_
+
+#include <stdint.h>
+
+#define EMGD_CAPTURE_MAGIC      "EMGDBAT"
+#define EMGD_CAPTURE_VERSION    2
+#define EMGD_CAPTURE_TAG_BATCH  0x48435442   /* "BTCH" */
+#define EMGD_CAPTURE_NO_BO      0xffffffff
+
+/* Written once at the start of every capture file */
+typedef struct _emgd_capture_file_hdr {
+	char     magic[8];
+	uint32_t version;
+	uint32_t devid;
+	uint32_t gen;       /* INTEL_INFO(intel)->gen, e.g. 60 for Sandybridge */
+	uint32_t reserved;
+} emgd_capture_file_hdr_t;
+
+/*
+ * One per batch, followed by:
+ *   batch_bytes of batch contents,
+ *   num_relocs emgd_capture_reloc_t,
+ *   num_bos emgd_capture_bo_t, each followed by its captured bytes
+ *   rounded up to a multiple of 4.
+ */
+typedef struct _emgd_capture_batch_hdr {
+	uint32_t tag;
+	uint32_t seq;
+	uint32_t ring;      /* RENDER_BATCH or BLT_BATCH */
+	uint32_t batch_bytes;
+	uint32_t num_relocs;
+	uint32_t num_bos;
+	uint64_t ts;        /* CLOCK_MONOTONIC, nanoseconds */
+} emgd_capture_batch_hdr_t;
+
+typedef struct _emgd_capture_reloc {
+	uint32_t offset;        /* Byte offset of the relocated dword */
+	uint32_t handle;        /* GEM handle of the target */
+	uint32_t delta;
+	uint32_t read_domains;
+	uint32_t write_domain;
+	uint32_t bo_index;      /* Snapshot index, or EMGD_CAPTURE_NO_BO */
+	uint32_t in_handle;     /* GEM handle of the state bo holding the
+	                         * dword, 0 if it is in the batch itself */
+	uint32_t reserved;
+} emgd_capture_reloc_t;
+
+typedef struct _emgd_capture_bo {
+	uint32_t handle;
+	uint32_t size;
+	uint32_t captured;      /* Bytes of contents that follow */
+	uint32_t reserved;
+} emgd_capture_bo_t;
+
+
+#ifndef EMGD_CAPTURE_DECODER
+
+struct emgd_capture;
+
+extern struct emgd_capture *emgd_capture_create(const char *path,
+	unsigned long max_bytes, unsigned long bo_limit,
+	uint32_t devid, uint32_t gen);
+extern void emgd_capture_destroy(struct emgd_capture *capture);
+extern void emgd_capture_reloc(struct emgd_capture *capture, drm_intel_bo *bo,
+	uint32_t offset, uint32_t delta,
+	uint32_t read_domains, uint32_t write_domain);
+extern void emgd_capture_state_reloc(struct emgd_capture *capture,
+	drm_intel_bo *state_bo, uint32_t offset, drm_intel_bo *bo,
+	uint32_t delta, uint32_t read_domains, uint32_t write_domain);
+extern void emgd_capture_batch(struct emgd_capture *capture, uint32_t ring,
+	const uint32_t *batch, uint32_t bytes);
+
+#endif /* EMGD_CAPTURE_DECODER */
+
+#endif /* _EMGD_CAPTURE_H_ */
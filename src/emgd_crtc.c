@@ -49,6 +49,7 @@
 #include "emgd_uxa.h"
 #include "intel_batchbuffer.h"
 #include "emgd_sprite.h"
+#include "emgd_trace.h"
 
 /* From emgd_output.c */
 void emgd_output_dpms(xf86OutputPtr output, int mode);
@@ -322,8 +323,11 @@ static void emgd_crtc_show_cursor(xf86CrtcPtr crtc)
 
 	OS_TRACE_ENTER;
 
-	drmModeSetCursor(drmmode->fd, emgd_crtc->crtc->crtc_id,
-			emgd_crtc->cursor->handle, 64, 64);
+	if (emgd_crtc->cursor) {
+		drmModeSetCursor(drmmode->fd, emgd_crtc->crtc->crtc_id,
+				emgd_crtc->cursor->handle, 64, 64);
+		emgd_crtc->cursor_shown = TRUE;
+	}
 
 	OS_TRACE_EXIT;
 }
@@ -344,11 +348,65 @@ static void emgd_crtc_hide_cursor(xf86CrtcPtr crtc)
 
 	/* Set the cursor to a null handle */
 	drmModeSetCursor(drmmode->fd, emgd_crtc->crtc->crtc_id, 0, 64, 64);
+	emgd_crtc->cursor_shown = FALSE;
 
 	OS_TRACE_EXIT;
 }
 
 
+/*
+ * FNV-1a over the cursor image.  Only used to find a candidate slot; a
+ * match is confirmed against the slot's copy of the image.
+ */
+static uint32_t emgd_cursor_hash(const CARD32 *image)
+{
+	uint32_t hash = 2166136261u;
+	int i;
+
+	for (i = 0; i < 64 * 64; i++) {
+		hash = (hash ^ image[i]) * 16777619u;
+	}
+
+	return hash;
+}
+
+
+/*
+ * emgd_crtc_cursor_slot
+ *
+ * Find the cache slot holding image, or pick one to load it into.  The
+ * victim is the least recently used slot other than the one being
+ * scanned out, so a new image never overwrites the visible cursor.
+ */
+static emgd_cursor_slot_t *emgd_crtc_cursor_slot(emgd_crtc_priv_t *emgd_crtc,
+		const CARD32 *image, uint32_t hash, Bool *hit)
+{
+	emgd_cursor_slot_t *victim = NULL;
+	int i;
+
+	for (i = 0; i < EMGD_CURSOR_CACHE_SIZE; i++) {
+		emgd_cursor_slot_t *slot = &emgd_crtc->cursor_cache[i];
+
+		if (slot->bo && slot->hash == hash &&
+				memcmp(slot->image, image, 64 * 64 * 4) == 0) {
+			*hit = TRUE;
+			return slot;
+		}
+
+		if (slot->bo && slot->bo == emgd_crtc->cursor) {
+			continue;
+		}
+		if (!victim || (victim->bo &&
+				(!slot->bo || slot->last_use < victim->last_use))) {
+			victim = slot;
+		}
+	}
+
+	*hit = FALSE;
+	return victim;
+}
+
+
 /*
  * emgd_crtc_load_cursor_argb
  *
@@ -358,25 +416,51 @@ static void emgd_crtc_load_cursor_argb(xf86CrtcPtr crtc, CARD32 *image)
 {
 	emgd_crtc_priv_t *emgd_crtc = crtc->driver_private;
 	drmmode_t *drmmode = emgd_crtc->drmmode;
+	emgd_cursor_slot_t *slot;
+	uint32_t hash;
+	Bool hit;
 	int ret;
 
 	OS_TRACE_ENTER;
 
-	if (emgd_crtc->cursor == NULL) {
-		/* Need to allocate a cursor */
-		emgd_crtc->cursor = emgd_create_cursor(crtc->scrn, 64, 64);
-	}
+	hash = emgd_cursor_hash(image);
+	slot = emgd_crtc_cursor_slot(emgd_crtc, image, hash, &hit);
 
-	/* Copy cursor image into cursor memory. */
-	ret = drm_intel_bo_subdata(emgd_crtc->cursor, 0, (64 * 64 * 4), image);
-	if (ret) {
-		OS_ERROR("Failed to load ARGB cursor data");
-		return;
+	if (hit) {
+		EMGD_PERF_INC(cursor_cache_hits);
+	} else {
+		if (slot->bo == NULL) {
+			/* Need to allocate a cursor */
+			slot->bo = emgd_create_cursor(crtc->scrn, 64, 64);
+			if (!slot->image) {
+				slot->image = malloc(64 * 64 * 4);
+			}
+		}
+
+		/* Copy cursor image into cursor memory. */
+		ret = slot->bo && slot->image ?
+			drm_intel_bo_subdata(slot->bo, 0, (64 * 64 * 4), image) : -1;
+		if (ret) {
+			OS_ERROR("Failed to load ARGB cursor data");
+			/* Contents are unknown; drop the bo so nothing matches it */
+			emgd_destroy_cursor(crtc->scrn, slot->bo);
+			slot->bo = NULL;
+			OS_TRACE_EXIT;
+			return;
+		}
+		memcpy(slot->image, image, 64 * 64 * 4);
+		slot->hash = hash;
+		EMGD_PERF_INC(cursor_uploads);
 	}
+	slot->last_use = ++emgd_crtc->cursor_clock;
 
 	/* Turn on the cursor -- This should be removed. */
-	drmModeSetCursor(drmmode->fd, emgd_crtc->crtc->crtc_id,
-			emgd_crtc->cursor->handle, 64, 64);
+	if (slot->bo != emgd_crtc->cursor || !emgd_crtc->cursor_shown) {
+		drmModeSetCursor(drmmode->fd, emgd_crtc->crtc->crtc_id,
+				slot->bo->handle, 64, 64);
+		emgd_crtc->cursor = slot->bo;
+		emgd_crtc->cursor_shown = TRUE;
+	}
 
 	OS_TRACE_EXIT;
 }
@@ -410,15 +494,18 @@ static void emgd_crtc_destroy(xf86CrtcPtr crtc)
 {
 	emgd_crtc_priv_t *emgd_crtc = crtc->driver_private;
 	ScrnInfoPtr scrn = crtc->scrn;
+	int i;
 
 	OS_TRACE_ENTER;
-	/* Free cursor if it was allocated */
+	/* Free cursors if they were allocated */
 	if (emgd_crtc->cursor) {
 		emgd_crtc_hide_cursor(crtc);
-		emgd_destroy_cursor(scrn, emgd_crtc->cursor);
-		free(emgd_crtc->cursor);
 		emgd_crtc->cursor = NULL;
 	}
+	for (i = 0; i < EMGD_CURSOR_CACHE_SIZE; i++) {
+		emgd_destroy_cursor(scrn, emgd_crtc->cursor_cache[i].bo);
+		free(emgd_crtc->cursor_cache[i].image);
+	}
 
 	/* Free private data */
 	free(crtc->driver_private);
@@ -812,6 +899,8 @@ Bool drmmode_pre_init(ScrnInfoPtr scrn, int fd)
 	drmmode->fd = fd;
 	drmmode->fb_id = 0;
 	drmmode->flip_count = 0;
+	drmmode->scrn = scrn;
+	drmmode->probe_gen = 1;
 
 	/* Initialize CRTC support */
 	xf86CrtcConfigInit(scrn, &drmmode_xf86crtc_config_funcs);
@@ -833,6 +922,9 @@ Bool drmmode_pre_init(ScrnInfoPtr scrn, int fd)
 		drmmode_crtc_init(scrn, drmmode, i);
 	}
 
+	/* Watch for hotplug before the outputs are first probed */
+	emgd_output_hotplug_init(drmmode);
+
 	/* Initialize each output/connector */
 	for (i = 0; i < drmmode->mode_res->count_connectors; i++) {
 		drmmode_output_init(scrn, drmmode, i);
@@ -885,6 +977,8 @@ void drmmode_shutdown(emgd_priv_t *iptr)
 		drmModeRmFB(iptr->drm_fd, kms->fb_id);
 	}
 
+	emgd_output_hotplug_fini(kms);
+
 	/* Free KMS context */
 	free(kms);
 	iptr->kms = NULL;
@@ -942,6 +1036,7 @@ int emgd_crtc_schedule_flip(emgd_dri2_swap_record_t *swapinfo)
 	 * processed before the flip actually takes place.
 	 */
 	intel_batch_submit(pScrn);
+	intel_batch_wait_submitted(pScrn);
 
 	/*
 	 * Call the pageflip ioctl on all CRTC's with the appropriate framebuffer
@@ -995,5 +1090,8 @@ int emgd_crtc_schedule_flip(emgd_dri2_swap_record_t *swapinfo)
 	 */
 	drmmode->dri2_swapinfo = swapinfo;
 
+	EMGD_TRACE(FLIP_SCHEDULE, swapinfo->drawable_id, drmmode->fb_id,
+		swapinfo->framenum, 0);
+
 	return 1;
 }
@@ -74,6 +74,16 @@ typedef struct _drmmode {
 	/* Linked lists of all CRTC's and outputs being used */
 	struct LIST crtcs;
 	struct LIST outputs;
+
+	/*
+	 * Connector probe cache.  Outputs keep the connector and EDID they
+	 * fetched until probe_gen moves on, which happens on a hotplug uevent
+	 * or a forced probe.  If the uevent socket can't be opened every
+	 * detect probes the connector, as it did before the cache.
+	 */
+	ScrnInfoPtr scrn;
+	int uevent_fd;
+	uint32_t probe_gen;
 } drmmode_t;
 
 typedef struct _emgd_output_priv {
@@ -82,6 +92,9 @@ typedef struct _emgd_output_priv {
 	drmModeConnectorPtr output;
 	drmModeEncoderPtr encoder;
 	drmModePropertyBlobPtr edid;
+	Bool edid_valid;            /* edid matches the cached connector */
+	uint32_t probe_gen;         /* drmmode->probe_gen when output was read */
+	uint32_t dpms_prop_id;
 	int num_props;
 	drmmode_prop_t *props;
 	void *private_data;
@@ -97,10 +110,27 @@ typedef struct _emgd_output_priv {
 	struct LIST link;
 } emgd_output_priv_t;
 
+/*
+ * Cursor images recently loaded on a CRTC.  Toolkits and animated cursors
+ * cycle through a handful of images, so switching back to one of them is
+ * a SetCursor on a bo that already holds it rather than a new upload.
+ */
+#define EMGD_CURSOR_CACHE_SIZE  4
+
+typedef struct _emgd_cursor_slot {
+	drm_intel_bo *bo;
+	CARD32 *image;          /* Copy of the contents, to confirm hash hits */
+	uint32_t hash;
+	uint32_t last_use;
+} emgd_cursor_slot_t;
+
 typedef struct _emgd_crtc_priv {
 	drmmode_t *drmmode;
 	drmModeCrtcPtr crtc;
-	drm_intel_bo *cursor;
+	drm_intel_bo *cursor;   /* Cursor bo currently set on the CRTC */
+	Bool cursor_shown;
+	uint32_t cursor_clock;
+	emgd_cursor_slot_t cursor_cache[EMGD_CURSOR_CACHE_SIZE];
 	drmModeModeInfo k_mode;
 
 	/*
@@ -126,6 +156,10 @@ typedef struct _emgd_crtc_priv {
 Bool drmmode_pre_init(ScrnInfoPtr scrn, int fd);
 void drmmode_shutdown(emgd_priv_t*);
 void drmmode_output_init(ScrnInfoPtr scrn, drmmode_t *drmmode, int num);
+void emgd_output_hotplug_init(drmmode_t *drmmode);
+void emgd_output_hotplug_fini(drmmode_t *drmmode);
+void emgd_output_hotplug_handler(drmmode_t *drmmode);
+void emgd_output_force_probe(drmmode_t *drmmode);
 int emgd_crtc_schedule_flip(emgd_dri2_swap_record_t *swapinfo);
 
 #endif /* _EMGD_CRTC_H_ */
@@ -223,6 +223,7 @@ static Bool emgd_enter_vt(VT_FUNC_ARGS_DECL)
 {
 	DECLARE_SCREENINFOPTR(arg);
 	emgd_priv_t *iptr;
+	drmmode_t *kms;
 
 	oal_screen = scrn->scrnIndex;
 	OS_TRACE_ENTER;
@@ -236,6 +237,10 @@ static Bool emgd_enter_vt(VT_FUNC_ARGS_DECL)
 		}
 	}
 
+	/* Outputs may have changed while another VT had the device */
+	kms = iptr->kms;
+	kms->probe_gen++;
+
 	if (!xf86SetDesiredModes(scrn)) {
 		return FALSE;
 	}
@@ -539,6 +544,11 @@ static void emgd_drm_wakeup_handler(pointer data, int err, pointer p)
 	if (FD_ISSET(kms->fd, read_mask)) {
 		drmHandleEvent(kms->fd, &kms->event_context);
 	}
+
+	/* Connector hotplug: drop cached connector state and reprobe */
+	if (kms->uevent_fd >= 0 && FD_ISSET(kms->uevent_fd, read_mask)) {
+		emgd_output_hotplug_handler(kms);
+	}
 }
 
 
@@ -561,6 +571,8 @@ static void emgd_flush_callback(CallbackListPtr *list,
 	/* Only submit the batchbuffer if our VT is actually active. */
 	if (scrn->vtSema) {
 		intel_batch_submit(scrn);
+		/* Clients may be about to use what we rendered */
+		intel_batch_wait_submitted(scrn);
 	}
 }
 
@@ -798,12 +810,17 @@ static Bool emgd_close_screen(CLOSE_SCREEN_ARGS_DECL)
 	/* Unregister our flush callback */
 	DeleteCallback(&FlushCallback, emgd_flush_callback, scrn);
 
+	if (kms->uevent_fd >= 0) {
+		RemoveGeneralSocket(kms->uevent_fd);
+	}
+
 	/* Release bo cache cleanup timer */
 	TimerFree(iptr->cache_expire);
 	iptr->cache_expire = NULL;
 
 	/* Cleanup UXA */
 	if (iptr->uxa_driver) {
+		intel_uxa_fini(scrn->pScreen);
 		uxa_driver_fini(scrn->pScreen);
 		free(iptr->uxa_driver);
 		iptr->uxa_driver = NULL;
@@ -829,6 +846,7 @@ static Bool emgd_close_screen(CLOSE_SCREEN_ARGS_DECL)
 	/* Shut down DRI2 */
 	if (iptr->dri2_inuse) {
 		DRI2CloseScreen(scrn->pScreen);
+		emgd_dri2_cache_fini(scrn->pScreen);
 		free(iptr->dev_dri_name);
 		iptr->dev_dri_name = NULL;
 		iptr->dri2_inuse = 0;
@@ -1047,6 +1065,9 @@ static Bool emgd_screen_init(SCREEN_INIT_ARGS_DECL)
 	 * sends pageflip or vblank events to userspace.
 	 */
 	AddGeneralSocket(iptr->drm_fd);
+	if (kms->uevent_fd >= 0) {
+		AddGeneralSocket(kms->uevent_fd);
+	}
 
 	/*
 	 * Register block and wakeup handlers.  A BlockHandler is a callback that
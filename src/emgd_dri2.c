@@ -54,6 +54,7 @@
 #include "emgd_crtc.h"
 #include "emgd_uxa.h"
 #include "emgd_sprite.h"
+#include "emgd_trace.h"
 
 static DEV_PRIVATE_KEY_TYPE dri2_client_key;
 
@@ -95,6 +96,210 @@ static char* dri2_buffer_string(unsigned int type)
 }
 #endif
 
+/*
+ * DRI2 buffer cache.
+ *
+ * GL clients reallocate their buffers whenever a drawable changes size,
+ * and every new buffer costs a pixmap, a bo and a flink.  Released
+ * buffers are kept for a couple of seconds instead, within a byte
+ * budget, and handed back when the same drawable asks for the same
+ * attachment and geometry again.  The flinked name comes with the bo.
+ */
+#define EMGD_DRI2_CACHE_BYTES   (32 * 1024 * 1024)
+#define EMGD_DRI2_CACHE_AGE_MS  2000
+
+static void emgd_dri2_cache_evict(emgd_priv_t *iptr,
+		emgd_dri2_cache_entry_t *entry)
+{
+	LIST_DEL(&entry->link);
+	iptr->dri2_cache_bytes -= entry->size;
+	entry->pixmap->drawable.pScreen->DestroyPixmap(entry->pixmap);
+	free(entry);
+}
+
+static CARD32 emgd_dri2_cache_expire(OsTimerPtr timer, CARD32 now,
+		pointer data)
+{
+	emgd_priv_t *iptr = data;
+	emgd_dri2_cache_entry_t *entry, *tmp;
+	CARD32 next = 0;
+
+	LIST_FOR_EACH_ENTRY_SAFE(entry, tmp, &iptr->dri2_cache, link) {
+		CARD32 age = now - entry->released;
+
+		if (age >= EMGD_DRI2_CACHE_AGE_MS) {
+			emgd_dri2_cache_evict(iptr, entry);
+		} else if (!next || EMGD_DRI2_CACHE_AGE_MS - age < next) {
+			next = EMGD_DRI2_CACHE_AGE_MS - age;
+		}
+	}
+
+	/* Rearm for the next entry due, if any are left */
+	return next;
+}
+
+/*
+ * emgd_dri2_cache_put
+ *
+ * Keep a released buffer for reuse.  Returns FALSE if the caller should
+ * destroy the pixmap as before.  Buffers are only kept while their
+ * drawable still exists, and never when a flip has made the bo the
+ * scanout.
+ */
+static Bool emgd_dri2_cache_put(DrawablePtr drawable, DRI2Buffer2Ptr buffer)
+{
+	emgd_dri2_private_t *buffpriv = buffer->driverPrivate;
+	ScreenPtr screen = buffpriv->pixmap->drawable.pScreen;
+	emgd_priv_t *iptr = EMGDPTR(xf86Screens[screen->myNum]);
+	struct intel_pixmap *priv = intel_get_pixmap_private(buffpriv->pixmap);
+	emgd_dri2_cache_entry_t *entry, *tmp, *oldest;
+	Bool was_empty;
+
+	if (!drawable || !iptr->dri2_inuse || !priv || !priv->bo ||
+			priv->bo == iptr->front_buffer ||
+			priv->bo->size > EMGD_DRI2_CACHE_BYTES) {
+		return FALSE;
+	}
+
+	entry = malloc(sizeof(*entry));
+	if (!entry) {
+		return FALSE;
+	}
+
+	entry->pixmap = buffpriv->pixmap;
+	entry->name = buffer->name;
+	entry->drawable = drawable->id;
+	entry->attachment = buffer->attachment;
+	entry->format = buffer->format;
+	entry->width = buffpriv->width;
+	entry->height = buffpriv->height;
+	entry->cpp = buffpriv->cpp;
+	entry->size = priv->bo->size;
+	entry->released = GetTimeInMillis();
+
+	was_empty = LIST_IS_EMPTY(&iptr->dri2_cache);
+	LIST_ADD(&entry->link, &iptr->dri2_cache);
+	iptr->dri2_cache_bytes += entry->size;
+
+	/* Over budget: drop the oldest buffers (at the tail) */
+	while (iptr->dri2_cache_bytes > EMGD_DRI2_CACHE_BYTES) {
+		oldest = NULL;
+		LIST_FOR_EACH_ENTRY(tmp, &iptr->dri2_cache, link) {
+			oldest = tmp;
+		}
+		emgd_dri2_cache_evict(iptr, oldest);
+	}
+
+	if (was_empty) {
+		iptr->dri2_cache_expire = TimerSet(iptr->dri2_cache_expire, 0,
+				EMGD_DRI2_CACHE_AGE_MS, emgd_dri2_cache_expire, iptr);
+	}
+
+	return TRUE;
+}
+
+/*
+ * emgd_dri2_cache_take
+ *
+ * Look for a buffer the drawable released with the same attachment and
+ * pixmap geometry.  Returns its pixmap and sets *name, or NULL.
+ */
+static PixmapPtr emgd_dri2_cache_take(DrawablePtr drawable,
+		unsigned int attachment, unsigned int format,
+		int width, int height, int cpp, unsigned int *name)
+{
+	ScreenPtr screen = drawable->pScreen;
+	emgd_priv_t *iptr = EMGDPTR(xf86Screens[screen->myNum]);
+	emgd_dri2_cache_entry_t *entry, *tmp;
+	PixmapPtr pixmap;
+
+	LIST_FOR_EACH_ENTRY_SAFE(entry, tmp, &iptr->dri2_cache, link) {
+		if (entry->drawable != drawable->id ||
+				entry->attachment != attachment ||
+				entry->format != format ||
+				entry->width != width || entry->height != height ||
+				entry->cpp != cpp ||
+				intel_get_pixmap_bo(entry->pixmap) == iptr->front_buffer) {
+			continue;
+		}
+
+		pixmap = entry->pixmap;
+		*name = entry->name;
+
+		LIST_DEL(&entry->link);
+		iptr->dri2_cache_bytes -= entry->size;
+		free(entry);
+
+		EMGD_PERF_INC(dri2_buffer_reuses);
+		return pixmap;
+	}
+
+	return NULL;
+}
+
+/*
+ * emgd_dri2_cache_drop
+ *
+ * Release the buffers a drawable left in the cache.  Called when the
+ * drawable is destroyed: DRI2 releases its buffers just before that
+ * (DRI2DrawableGone), and nobody can ask for them again.
+ */
+void emgd_dri2_cache_drop(DrawablePtr drawable)
+{
+	emgd_priv_t *iptr = EMGDPTR(xf86Screens[drawable->pScreen->myNum]);
+	emgd_dri2_cache_entry_t *entry, *tmp;
+
+	if (!iptr->dri2_inuse || drawable->id == 0) {
+		return;
+	}
+
+	LIST_FOR_EACH_ENTRY_SAFE(entry, tmp, &iptr->dri2_cache, link) {
+		if (entry->drawable == drawable->id) {
+			emgd_dri2_cache_evict(iptr, entry);
+		}
+	}
+}
+
+static Bool emgd_dri2_destroy_window(WindowPtr window)
+{
+	ScreenPtr screen = window->drawable.pScreen;
+	emgd_priv_t *iptr = EMGDPTR(xf86Screens[screen->myNum]);
+	Bool ret;
+
+	emgd_dri2_cache_drop(&window->drawable);
+
+	screen->DestroyWindow = iptr->DestroyWindow;
+	ret = (*screen->DestroyWindow)(window);
+	iptr->DestroyWindow = screen->DestroyWindow;
+	screen->DestroyWindow = emgd_dri2_destroy_window;
+
+	return ret;
+}
+
+/*
+ * emgd_dri2_cache_fini
+ *
+ * Release every cached buffer.  Called at CloseScreen.
+ */
+void emgd_dri2_cache_fini(ScreenPtr screen)
+{
+	emgd_priv_t *iptr = EMGDPTR(xf86Screens[screen->myNum]);
+	emgd_dri2_cache_entry_t *entry, *tmp;
+
+	TimerFree(iptr->dri2_cache_expire);
+	iptr->dri2_cache_expire = NULL;
+
+	if (iptr->DestroyWindow) {
+		screen->DestroyWindow = iptr->DestroyWindow;
+		iptr->DestroyWindow = NULL;
+	}
+
+	LIST_FOR_EACH_ENTRY_SAFE(entry, tmp, &iptr->dri2_cache, link) {
+		emgd_dri2_cache_evict(iptr, entry);
+	}
+}
+
+
 /*
  * emgd_dri2_create_buffer()
  *
@@ -203,6 +408,16 @@ static DRI2Buffer2Ptr emgd_dri2_create_buffer(DrawablePtr drawable,
 				return NULL;
 		}
 
+		buffpriv->width = pixmap_width;
+		buffpriv->height = pixmap_height;
+		buffpriv->cpp = pixmap_cpp;
+
+		/* Reuse a buffer this drawable released with the same geometry */
+		pixmap = emgd_dri2_cache_take(drawable, attachment, format,
+			pixmap_width, pixmap_height, pixmap_cpp, &buffer->name);
+	}
+
+	if (pixmap == NULL) {
 		/* Okay, create the pixmap with the settings decided above */
 		pixmap = screen->CreatePixmap(screen, pixmap_width, pixmap_height,
 			pixmap_cpp, usage_flag);
@@ -212,6 +427,7 @@ static DRI2Buffer2Ptr emgd_dri2_create_buffer(DrawablePtr drawable,
 			free(buffer);
 			return NULL;
 		}
+		EMGD_PERF_INC(dri2_buffer_allocs);
 	}
 
 	/* Did we get a valid GEM-based pixmap? */
@@ -226,8 +442,9 @@ static DRI2Buffer2Ptr emgd_dri2_create_buffer(DrawablePtr drawable,
 		return NULL;
 	}
 
-	/* Create a unique global buffer name */
-	if (drm_intel_bo_flink(pixmap_priv->bo, &buffer->name) != 0) {
+	/* Create a unique global buffer name (cached buffers already have one) */
+	if (!buffer->name &&
+			drm_intel_bo_flink(pixmap_priv->bo, &buffer->name) != 0) {
 		OS_ERROR("Failed to generate unique name for DRI2 buffer");
 		if (attachment != DRI2BufferFrontLeft) {
 			screen->DestroyPixmap(pixmap);
@@ -282,12 +499,13 @@ void emgd_dri2_destroy_buffer(DrawablePtr drawable,
 	}
 
 	/*
-	 * Decrement reference count.  If 0, destroy the underlying pixmap and free
-	 * the buffer structures.
+	 * Decrement reference count.  If 0, cache or destroy the underlying
+	 * pixmap and free the buffer structures.
 	 */
 	buffpriv->refcnt--;
 	if (buffpriv->refcnt == 0) {
-		if (buffer->attachment != DRI2BufferFrontLeft) {
+		if (buffer->attachment != DRI2BufferFrontLeft &&
+				!emgd_dri2_cache_put(drawable, buffer)) {
 			buffpriv->pixmap->drawable.pScreen->DestroyPixmap(buffpriv->pixmap);
 		}
 		free(buffpriv);
@@ -740,6 +958,8 @@ void emgd_dri2_flip_complete(unsigned int frame,
 	}
 
 	/* Send the swap completion event to the DRI2 client process */
+	EMGD_TRACE(FLIP_COMPLETE, swapinfo->drawable_id, frame, 0, 0);
+	EMGD_PERF_INC(swap_flips);
 	DRI2SwapComplete(swapinfo->client, drawable, frame, tv_sec, tv_usec,
 		DRI2_FLIP_COMPLETE, swapinfo->callback, swapinfo->callback_data);
 	
@@ -866,6 +1086,8 @@ void emgd_dri2_vblank_handler(unsigned int frame,
 		goto vblank_del_swapinfo;
 	}
 
+	EMGD_TRACE(VBLANK, swapinfo->drawable_id, frame, swapinfo->type, 0);
+
 	planes[0] = swapinfo->plane_pointer[0];
 	planes[1] = swapinfo->plane_pointer[1];
 
@@ -915,6 +1137,7 @@ void emgd_dri2_vblank_handler(unsigned int frame,
 					}
 				}
 
+				EMGD_PERF_INC(swap_flips);
 				DRI2SwapComplete(swapinfo->client, drawable, frame, tv_sec, tv_usec,
 					DRI2_FLIP_COMPLETE, swapinfo->callback, swapinfo->callback_data);
 
@@ -939,6 +1162,7 @@ void emgd_dri2_vblank_handler(unsigned int frame,
 		}
 
 		/* Notify client that swap is complete */
+		EMGD_PERF_INC(swap_blits);
 		DRI2SwapComplete(swapinfo->client, drawable, frame, tv_sec, tv_usec,
 			DRI2_BLIT_COMPLETE, swapinfo->callback, swapinfo->callback_data);
 		break;
@@ -1484,6 +1708,7 @@ blit_fallback:
 	emgd_dri2_copy_region(drawable, &blitregion, front, back);
 
 	/* Notify client that swap is complete */
+	EMGD_PERF_INC(swap_blits);
 	DRI2SwapComplete(client, drawable, 0, 0, 0, DRI2_BLIT_COMPLETE,
 		callback, cbdata);
 
@@ -1672,6 +1897,9 @@ Bool emgd_dri2_screen_init(ScreenPtr screen)
 		return FALSE;
 	}
 
+	LIST_INIT(&iptr->dri2_cache);
+	iptr->dri2_cache_bytes = 0;
+
 	iptr->dev_dri_name = calloc(100, 1);
 	if (iptr->dev_dri_name == NULL) {
 		OS_ERROR("Failed to allocate /dev/dri/ name string");
@@ -1752,6 +1980,10 @@ Bool emgd_dri2_screen_init(ScreenPtr screen)
 	sprite_assignment_atom = MakeAtom("EMGD_SPRITE_ASSIGN", 18, 1);
 	iptr->dri2_inuse = 1;
 
+	/* Cached buffers of a destroyed window are dropped with it */
+	iptr->DestroyWindow = screen->DestroyWindow;
+	screen->DestroyWindow = emgd_dri2_destroy_window;
+
 	OS_TRACE_EXIT;
 	return DRI2ScreenInit(screen, &info);
 }
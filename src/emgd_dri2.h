@@ -43,8 +43,26 @@ typedef struct emgd_dri2_private {
 	DRI2Buffer2Ptr buffer;
 	unsigned long refcnt;
 	PixmapPtr pixmap;
+	int width, height, cpp;     /* CreatePixmap arguments, for the cache */
 } emgd_dri2_private_t;
 
+/*
+ * A released DRI2 buffer.  The pixmap and its flinked name are handed
+ * back out when the same drawable asks for the same attachment and
+ * geometry again, e.g. when a GL window is resized back and forth.
+ */
+typedef struct emgd_dri2_cache_entry {
+	struct LIST link;           /* In iptr->dri2_cache, newest first */
+	PixmapPtr pixmap;
+	unsigned int name;
+	XID drawable;
+	unsigned int attachment;
+	unsigned int format;
+	int width, height, cpp;
+	unsigned long size;
+	CARD32 released;            /* GetTimeInMillis() when cached */
+} emgd_dri2_cache_entry_t;
+
 
 /*
  * Record of scheduled DRI2 swap request.
@@ -99,6 +117,8 @@ void emgd_dri2_vblank_handler(unsigned int frame,
 	emgd_dri2_swap_record_t *swapinfo);
 void emgd_dri2_destroy_buffer(DrawablePtr drawable,
 	DRI2Buffer2Ptr buffer);
+void emgd_dri2_cache_drop(DrawablePtr drawable);
+void emgd_dri2_cache_fini(ScreenPtr screen);
 
 int crtc_for_drawable(ScrnInfoPtr scrn, DrawablePtr drawable);
 
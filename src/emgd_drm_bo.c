@@ -38,6 +38,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <string.h>
 #include <xf86drm.h>
 #include <xf86.h>
 
@@ -52,6 +53,7 @@
 Bool emgd_buffer_manager_init(emgd_priv_t *iptr)
 {
 	size_t aperture_size = iptr->PciInfo->regions[2].size;
+	struct drm_i915_gem_get_aperture aperture;
 
 	iptr->bufmgr = drm_intel_bufmgr_gem_init(iptr->drm_fd, EMGD_BATCH_SIZE);
 	if (!iptr->bufmgr) {
@@ -66,6 +68,18 @@ Bool emgd_buffer_manager_init(emgd_priv_t *iptr)
 	iptr->max_tiling_size = iptr->max_gtt_map_size;
 	iptr->max_bo_size = iptr->max_gtt_map_size;
 
+	/*
+	 * libdrm lets a batch use 3/4 of the available aperture; answer
+	 * aperture checks ourselves up to half of that (see
+	 * intel_check_aperture).  Zero sends every check to libdrm.
+	 */
+	memset(&aperture, 0, sizeof(aperture));
+	if (drmIoctl(iptr->drm_fd, DRM_IOCTL_I915_GEM_GET_APERTURE,
+			&aperture) == 0) {
+		iptr->aperture_limit = aperture.aper_available_size * 3 / 8;
+	}
+	memset(iptr->aperture, 0, sizeof(iptr->aperture));
+
 	drm_intel_bufmgr_gem_enable_reuse(iptr->bufmgr);
 	drm_intel_bufmgr_gem_set_vma_cache_size(iptr->bufmgr, 512);
 	drm_intel_bufmgr_gem_enable_fenced_relocs(iptr->bufmgr);
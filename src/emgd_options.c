@@ -41,6 +41,7 @@
 
 #include "emgd.h"
 #include "emgd_sprite.h"
+#include "emgd_trace.h"
 
 
 /* Enumeration of options */
@@ -54,6 +55,7 @@ typedef enum {
 	OPTION_UXA_COMPOSITE,
 	OPTION_UXA_1X1MASK,
 	OPTION_UXA_MASK,
+	OPTION_UXA_MONO,
 	OPTION_HW_CURSOR,
 	OPTION_XV_OVERLAY,
 	OPTION_XV_BLEND,
@@ -71,6 +73,12 @@ typedef enum {
 	OPTION_SPRITE_ASSIGNMENT_D1,
 	OPTION_SPRITE_ASSIGNMENT_D2,
 	OPTION_SPRITE_ZORDER,
+	OPTION_TRACE,
+	OPTION_TRACE_FILE,
+	OPTION_BATCH_CAPTURE,
+	OPTION_BATCH_CAPTURE_SIZE,
+	OPTION_BATCH_CAPTURE_BO_LIMIT,
+	OPTION_ASYNC_SUBMIT,
 } emgd_options_list;
 
 static OptionInfoRec emgd_options[] = {
@@ -83,6 +91,7 @@ static OptionInfoRec emgd_options[] = {
 	{OPTION_UXA_COMPOSITE, "UXAComposite",     OPTV_BOOLEAN, {0}, TRUE},
 	{OPTION_UXA_1X1MASK,   "UXAComposite1x1",  OPTV_BOOLEAN, {0}, TRUE},
 	{OPTION_UXA_MASK,      "UXACompositeMask", OPTV_BOOLEAN, {0}, TRUE},
+	{OPTION_UXA_MONO,      "UXAMono",          OPTV_BOOLEAN, {0}, TRUE},
 	{OPTION_HW_CURSOR,     "HWcursor",         OPTV_BOOLEAN, {0}, TRUE},
 	{OPTION_XV_OVERLAY,    "XVideo",           OPTV_BOOLEAN, {0}, TRUE},
 	{OPTION_XV_BLEND,      "XVideoBlend",      OPTV_BOOLEAN, {0}, TRUE},
@@ -101,6 +110,12 @@ static OptionInfoRec emgd_options[] = {
 	{OPTION_SPRITE_ASSIGNMENT_D1,   "SpriteAssignmentD1",   OPTV_ANYSTR, {0}, FALSE},
 	{OPTION_SPRITE_ASSIGNMENT_D2,   "SpriteAssignmentD2",   OPTV_ANYSTR, {0}, FALSE},
 	{OPTION_SPRITE_ZORDER, "SpriteZorder",     OPTV_ANYSTR,  {0}, FALSE},
+	{OPTION_TRACE,         "Trace",            OPTV_BOOLEAN, {0}, TRUE},
+	{OPTION_TRACE_FILE,    "TraceFile",        OPTV_ANYSTR,  {0}, FALSE},
+	{OPTION_BATCH_CAPTURE, "BatchCapture",     OPTV_ANYSTR,  {0}, FALSE},
+	{OPTION_BATCH_CAPTURE_SIZE,     "BatchCaptureSize",     OPTV_INTEGER, {64}, FALSE},
+	{OPTION_BATCH_CAPTURE_BO_LIMIT, "BatchCaptureBoLimit",  OPTV_INTEGER, {64}, FALSE},
+	{OPTION_ASYNC_SUBMIT,  "AsyncSubmit",      OPTV_BOOLEAN, {0}, FALSE},
 	{-1,                   NULL,               OPTV_NONE,    {0}, FALSE},
 };
 
@@ -153,6 +168,7 @@ void emgd_parse_options(ScrnInfoPtr scrn, const char *name)
 {
 	emgd_priv_t *iptr;
 	char *assignment_str;
+	char *trace_file;
 	int i;
 
 	iptr = EMGDPTR(scrn);
@@ -185,6 +201,7 @@ void emgd_parse_options(ScrnInfoPtr scrn, const char *name)
 	GetOptValBool(emgd_options, OPTION_UXA_COMPOSITE, &iptr->cfg.punt_uxa_composite);
 	GetOptValBool(emgd_options, OPTION_UXA_1X1MASK,   &iptr->cfg.punt_uxa_composite_1x1_mask);
 	GetOptValBool(emgd_options, OPTION_UXA_MASK,      &iptr->cfg.punt_uxa_composite_mask);
+	GetOptValBool(emgd_options, OPTION_UXA_MONO,      &iptr->cfg.punt_uxa_mono);
 
 	assignment_str = xf86GetOptValString(emgd_options, OPTION_SPRITE_ASSIGNMENT_D1);
 	if (assignment_str) {
@@ -228,6 +245,22 @@ void emgd_parse_options(ScrnInfoPtr scrn, const char *name)
 
 	iptr->cfg.sprite_zorder = xf86GetOptValString(emgd_options, OPTION_SPRITE_ZORDER);
 
+	GetOptValBool(emgd_options, OPTION_TRACE, &iptr->cfg.trace);
+	trace_file = xf86GetOptValString(emgd_options, OPTION_TRACE_FILE);
+	if (trace_file) {
+		iptr->cfg.trace_file = trace_file;
+	}
+	emgd_trace_init(iptr->cfg.trace, iptr->cfg.trace_file);
+
+	iptr->cfg.batch_capture =
+		xf86GetOptValString(emgd_options, OPTION_BATCH_CAPTURE);
+	xf86GetOptValInteger(emgd_options, OPTION_BATCH_CAPTURE_SIZE,
+		&iptr->cfg.batch_capture_size);
+	xf86GetOptValInteger(emgd_options, OPTION_BATCH_CAPTURE_BO_LIMIT,
+		&iptr->cfg.batch_capture_bo_limit);
+
+	GetOptValBool(emgd_options, OPTION_ASYNC_SUBMIT, &iptr->cfg.async_submit);
+
 	/*
 	 * If all acceleration is turned off, simply punt all the
 	 * 2D UXA functions.
@@ -239,6 +272,7 @@ void emgd_parse_options(ScrnInfoPtr scrn, const char *name)
 		iptr->cfg.punt_uxa_composite = TRUE;
 		iptr->cfg.punt_uxa_composite_1x1_mask = TRUE;
 		iptr->cfg.punt_uxa_composite_mask = TRUE;
+		iptr->cfg.punt_uxa_mono = TRUE;
 	}
 
 #if DEBUG
@@ -294,8 +328,25 @@ static void emgd_print_options (ScrnInfoPtr scrn, emgd_priv_t *iptr)
 			(iptr->cfg.punt_uxa_composite_1x1_mask) ? "Unaccelerated" : "Accelerated");
 	OS_PRINT("    Composite mask:       %s",
 			(iptr->cfg.punt_uxa_composite_mask) ? "Unaccelerated" : "Accelerated");
+	OS_PRINT("    Mono expansion:       %s",
+			(iptr->cfg.punt_uxa_mono) ? "Unaccelerated" : "Accelerated");
 	OS_PRINT("    HW Cursor:            %s",
 		(iptr->cfg.hw_cursor) ? "On" : "Off");
+	OS_PRINT("    Async submit:         %s",
+		(iptr->cfg.async_submit) ? "On" : "Off");
+
+	OS_PRINT("  DIAGNOSTIC OPTIONS");
+	OS_PRINT("    Event trace:          %s",
+		(iptr->cfg.trace) ? "On" : "Off");
+	OS_PRINT("    Trace file:           %s",
+		(iptr->cfg.trace_file) ? iptr->cfg.trace_file : "None");
+	if (iptr->cfg.batch_capture) {
+		OS_PRINT("    Batch capture:        %s (%d MiB, %d KiB/bo)",
+			iptr->cfg.batch_capture, iptr->cfg.batch_capture_size,
+			iptr->cfg.batch_capture_bo_limit);
+	} else {
+		OS_PRINT("    Batch capture:        Off");
+	}
 
 	OS_PRINT("  XVIDEO OPTIONS");
 	OS_PRINT("    XVideo:               %s",
@@ -360,6 +411,23 @@ static void initialize_config(ScrnInfoPtr scrn, emgd_priv_t *iptr)
 	iptr->cfg.punt_uxa_composite = FALSE;
 	iptr->cfg.punt_uxa_composite_1x1_mask = FALSE;
 	iptr->cfg.punt_uxa_composite_mask = FALSE;
+	iptr->cfg.punt_uxa_mono = FALSE;
+
+	/*
+	 * Binary event trace is cheap enough to leave on (see bench_trace),
+	 * but there is no default dump file: the server runs as root and a
+	 * fixed name in a shared directory is an easy symlink target.
+	 */
+	iptr->cfg.trace = TRUE;
+	iptr->cfg.trace_file = NULL;
+
+	/* Batch capture is opt-in; it stalls on every submitted batch */
+	iptr->cfg.batch_capture = NULL;
+	iptr->cfg.batch_capture_size = 64;
+	iptr->cfg.batch_capture_bo_limit = 64;
+
+	/* Off until the submission thread has seen wider testing */
+	iptr->cfg.async_submit = FALSE;
 }
 
 
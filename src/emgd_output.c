@@ -37,14 +37,19 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
 #include <xf86.h>
 #include <X11/Xatom.h>
 #include <X11/extensions/dpmsconst.h>
 #include <xf86DDC.h>
+#include <randrstr.h>
 
 #include "emgd.h"
 #include "emgd_dri2.h"
 #include "emgd_crtc.h" /* Use this for all typedefs */
+#include "emgd_perf.h"
 
 
 /*
@@ -452,6 +457,18 @@ void emgd_output_dpms(xf86OutputPtr output, int mode)
 	drmModePropertyPtr props;
 
 	OS_TRACE_ENTER;
+	/*
+	 * Property ids don't change for the life of a connector, so the DPMS
+	 * lookup is only done once.
+	 */
+	if (emgd_output->dpms_prop_id) {
+		drmModeConnectorSetProperty(drmmode->fd, emgd_output->output_id,
+				emgd_output->dpms_prop_id, mode);
+		emgd_output->dpms_mode = mode;
+		OS_TRACE_EXIT;
+		return;
+	}
+
 	/* Loop through the properties looking for the DPMS property */
 	for (i = 0; i < k_output->count_props; i++) {
 		props = drmModeGetProperty(drmmode->fd, k_output->props[i]);
@@ -466,6 +483,7 @@ void emgd_output_dpms(xf86OutputPtr output, int mode)
 					emgd_output->output_id,
 					props->prop_id,
 					mode);
+			emgd_output->dpms_prop_id = props->prop_id;
 
 			/* Change the backlight state */
 			if (mode == DPMSModeOn) {
@@ -501,18 +519,36 @@ void emgd_output_dpms(xf86OutputPtr output, int mode)
  * emgd_output_detect
  *
  * Get the output's status from the kernel and return the XRandR equivelent.
+ *
+ * Probing a connector can mean DDC transfers taking tens of milliseconds,
+ * and desktop environments ask for screen resources (and so a detect on
+ * every output) quite freely.  The connector read by the last probe is
+ * reused until a hotplug uevent or a forced probe invalidates it.
  */
 static xf86OutputStatus emgd_output_detect(xf86OutputPtr output)
 {
 	emgd_output_priv_t *emgd_output = output->driver_private;
 	drmmode_t *drmmode = emgd_output->drmmode;
+	drmModeConnectorPtr k_output;
 	xf86OutputStatus status;
 
 	OS_TRACE_ENTER;
-	drmModeFreeConnector(emgd_output->output);
+	if (drmmode->uevent_fd >= 0 &&
+			emgd_output->probe_gen == drmmode->probe_gen) {
+		EMGD_PERF_INC(connector_cache_hits);
+	} else {
+		k_output = drmModeGetConnector(drmmode->fd, emgd_output->output_id);
+		EMGD_PERF_INC(connector_probes);
+		if (!k_output) {
+			OS_TRACE_EXIT;
+			return XF86OutputStatusUnknown;
+		}
 
-	emgd_output->output =
-		drmModeGetConnector(drmmode->fd, emgd_output->output_id);
+		drmModeFreeConnector(emgd_output->output);
+		emgd_output->output = k_output;
+		emgd_output->probe_gen = drmmode->probe_gen;
+		emgd_output->edid_valid = FALSE;
+	}
 
 	switch (emgd_output->output->connection) {
 		case DRM_MODE_CONNECTED:
@@ -568,22 +604,32 @@ static DisplayModePtr emgd_output_get_modes(xf86OutputPtr output)
 	OS_TRACE_ENTER;
 	/*
 	 * If an EDID block is available for the output, make sure
-	 * XRandR knows about it.
+	 * XRandR knows about it.  The blob is only fetched again when
+	 * detect has read a new connector.
 	 */
-	for (i = 0; i < k_output->count_props; i++) {
-		props = drmModeGetProperty(drmmode->fd, k_output->props[i]);
-
-		if (!props) {
-			continue;
+	if (!emgd_output->edid_valid) {
+		if (emgd_output->edid) {
+			drmModeFreePropertyBlob(emgd_output->edid);
+			emgd_output->edid = NULL;
 		}
 
-		if ((props->flags & DRM_MODE_PROP_BLOB) &&
-				(strcmp(props->name, "EDID") == 0) ) {
-			emgd_output->edid = drmModeGetPropertyBlob(drmmode->fd,
-					k_output->prop_values[i]);
-			continue;  /* pick the first and bail early */
+		for (i = 0; i < k_output->count_props; i++) {
+			props = drmModeGetProperty(drmmode->fd, k_output->props[i]);
+
+			if (!props) {
+				continue;
+			}
+
+			if ((props->flags & DRM_MODE_PROP_BLOB) &&
+					(strcmp(props->name, "EDID") == 0) ) {
+				emgd_output->edid = drmModeGetPropertyBlob(drmmode->fd,
+						k_output->prop_values[i]);
+				drmModeFreeProperty(props);
+				break;  /* pick the first and bail early */
+			}
+			drmModeFreeProperty(props);
 		}
-		drmModeFreeProperty(props);
+		emgd_output->edid_valid = TRUE;
 	}
 
 	/* If we found EDID block, make sure XRandR uses it */
@@ -723,6 +769,7 @@ void drmmode_output_init(ScrnInfoPtr scrn, drmmode_t *drmmode, int num)
 
 	priv->output_id = drmmode->mode_res->connectors[num];
 	priv->output = k_output;
+	priv->probe_gen = drmmode->probe_gen;
 	priv->encoder = k_encoder;
 	priv->drmmode = drmmode;
 
@@ -736,3 +783,106 @@ void drmmode_output_init(ScrnInfoPtr scrn, drmmode_t *drmmode, int num)
 	return;
 }
 
+
+
+/****************************************************************************
+ * Hotplug notification.
+ *
+ * Connector changes are reported by the kernel as uevents on the
+ * NETLINK_KOBJECT_UEVENT socket.  A DRM hotplug event carries
+ * SUBSYSTEM=drm and HOTPLUG=1 among its NUL separated KEY=value strings.
+ */
+
+/*
+ * emgd_output_hotplug_init
+ *
+ * Open the uevent socket.  This is done before the initial probe so that
+ * a connector change between the probe and screen init isn't missed.
+ */
+void emgd_output_hotplug_init(drmmode_t *drmmode)
+{
+	struct sockaddr_nl addr;
+	int fd;
+
+	drmmode->uevent_fd = -1;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+			NETLINK_KOBJECT_UEVENT);
+	if (fd < 0) {
+		OS_DEBUG("No uevent socket (%s), probing outputs on every query",
+				strerror(errno));
+		return;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	addr.nl_groups = 1;     /* Kernel uevents */
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		OS_DEBUG("Unable to bind uevent socket (%s), probing outputs on "
+				"every query", strerror(errno));
+		close(fd);
+		return;
+	}
+
+	drmmode->uevent_fd = fd;
+}
+
+
+void emgd_output_hotplug_fini(drmmode_t *drmmode)
+{
+	if (drmmode->uevent_fd >= 0) {
+		close(drmmode->uevent_fd);
+		drmmode->uevent_fd = -1;
+	}
+}
+
+
+/*
+ * emgd_output_force_probe
+ *
+ * Drop every cached connector and have RandR probe the outputs again and
+ * tell clients about any change.
+ */
+void emgd_output_force_probe(drmmode_t *drmmode)
+{
+	drmmode->probe_gen++;
+	if (drmmode->scrn->pScreen) {
+		RRGetInfo(drmmode->scrn->pScreen, TRUE);
+	}
+}
+
+
+/*
+ * emgd_output_hotplug_handler
+ *
+ * Called from the wakeup handler when the uevent socket is readable.
+ * Drains every queued event and reprobes once if any of them was a DRM
+ * hotplug.
+ */
+void emgd_output_hotplug_handler(drmmode_t *drmmode)
+{
+	char buf[4096];
+	ssize_t len;
+	Bool hotplug = FALSE;
+
+	while ((len = recv(drmmode->uevent_fd, buf, sizeof(buf) - 1, 0)) > 0) {
+		Bool drm = FALSE, change = FALSE;
+		char *s = buf;
+
+		buf[len] = '\0';
+		while (s < buf + len) {
+			if (strcmp(s, "SUBSYSTEM=drm") == 0) {
+				drm = TRUE;
+			} else if (strcmp(s, "HOTPLUG=1") == 0) {
+				change = TRUE;
+			}
+			s += strlen(s) + 1;
+		}
+		hotplug |= drm && change;
+	}
+
+	if (hotplug) {
+		EMGD_PERF_INC(hotplug_events);
+		emgd_output_force_probe(drmmode);
+	}
+}
@@ -0,0 +1,66 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_perf.h
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Always-on runtime performance counters.
+ *
+ *  The counters are a single process-wide block that is updated with plain
+ *  increments from the X server thread (exec_ns from the batch submission
+ *  thread instead, when it is enabled) and read out (or cleared) through
+ *  the EMGD control extension.  There is no locking; a reader racing an
+ *  update may see a counter that is off by one, which is acceptable for
+ *  statistics.
+ *-----------------------------------------------------------------------------
+ */
+
+#ifndef _EMGD_PERF_H_
+#define _EMGD_PERF_H_
+
+#include <stdint.h>
+#include <time.h>
+#include "emgd_api.h"
+
+extern iegd_esc_perf_counters_t emgd_perf;
+
+#define EMGD_PERF_INC(field)      (emgd_perf.field++)
+#define EMGD_PERF_ADD(field, n)   (emgd_perf.field += (n))
+#define EMGD_PERF_MAX(field, n) \
+	do { if ((uint64_t)(n) > emgd_perf.field) emgd_perf.field = (n); } while (0)
+#define EMGD_PERF_FALLBACK(op) \
+	(emgd_perf.fallbacks[EMGD_PERF_FALLBACK_##op]++)
+
+/*
+ * Monotonic timestamp in nanoseconds.  CLOCK_MONOTONIC is serviced from
+ * the vDSO, so this is cheap enough to bracket ioctls on every call.
+ */
+static inline uint64_t emgd_perf_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#endif /* _EMGD_PERF_H_ */
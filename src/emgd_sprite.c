@@ -36,6 +36,7 @@
 #include <xvdix.h>
 
 #include "emgd_sprite.h"
+#include "intel_batchbuffer.h"
 #include "intel_bufmgr.h"
 
 #define U642VOID(x) ((void *)(unsigned long)(x))
@@ -757,6 +758,7 @@ int emgd_sprite_flip_core(
 		xf86XVFillKeyHelperDrawable(drawable, iptr->cfg.video_key,
 			&region);
 	} else {
+		intel_batch_wait_submitted(scrninfo);
 		if (drm_intel_gem_bo_map_gtt(iptr->front_buffer)) {
 			OS_DEBUG("Failed to map front_buffer, no color check");
 			REGION_UNINIT(scrninfo, &region);
@@ -0,0 +1,260 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_submit.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Batch submission thread.  See emgd_submit.h.
+ *
+ *  The worker only ever calls intel->batch_exec() and drops its reference
+ *  on the batch bo.  libdrm serializes execbuffer and bo release against
+ *  allocation with its bufmgr lock, and the X server thread never executes
+ *  a batch itself while the worker has one queued, so no other driver
+ *  state is shared.  Errors are handed back and reported from the X
+ *  server thread on its next submit or wait.
+ *-----------------------------------------------------------------------------
+ */
+#define PER_MODULE_DEBUG
+#define MODULE_NAME ial.accel
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <signal.h>
+#include <xf86.h>
+#include <intel_bufmgr.h>
+
+#include "emgd.h"
+#include "emgd_submit.h"
+#include "emgd_trace.h"
+
+typedef struct _submit_entry {
+	dri_bo *bo;
+	int used;
+	unsigned int ring;
+} submit_entry_t;
+
+struct emgd_submit {
+	intel_screen_private *intel;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t work;        /* Signalled when a batch is queued */
+	pthread_cond_t done;        /* Signalled when a batch was issued */
+
+	/* Entries head..tail-1 (mod EMGD_SUBMIT_DEPTH) are queued */
+	submit_entry_t queue[EMGD_SUBMIT_DEPTH];
+	unsigned int head;
+	unsigned int tail;
+	int error;                  /* First failure not yet reported */
+	Bool stop;
+};
+
+
+static void *submit_thread(void *data)
+{
+	struct emgd_submit *submit = data;
+	intel_screen_private *intel = submit->intel;
+
+	pthread_mutex_lock(&submit->lock);
+	for (;;) {
+		submit_entry_t entry;
+		uint64_t start, elapsed;
+		int ret;
+
+		while (submit->head == submit->tail && !submit->stop) {
+			pthread_cond_wait(&submit->work, &submit->lock);
+		}
+		if (submit->head == submit->tail) {
+			break;
+		}
+
+		/* The slot stays claimed until tail moves on */
+		entry = submit->queue[submit->tail % EMGD_SUBMIT_DEPTH];
+		pthread_mutex_unlock(&submit->lock);
+
+		start = emgd_perf_now();
+		ret = intel->batch_exec(intel, entry.bo, entry.used, entry.ring);
+		elapsed = emgd_perf_now() - start;
+		EMGD_TRACE(BATCH_SUBMIT, entry.ring, entry.used, elapsed / 1000, ret);
+		EMGD_PERF_ADD(exec_ns, elapsed);
+		dri_bo_unreference(entry.bo);
+
+		pthread_mutex_lock(&submit->lock);
+		if (ret != 0 && submit->error == 0) {
+			submit->error = ret;
+		}
+		submit->tail++;
+		pthread_cond_broadcast(&submit->done);
+	}
+	pthread_mutex_unlock(&submit->lock);
+
+	return NULL;
+}
+
+
+/*
+ * emgd_submit_create
+ *
+ * Start the submission thread.  Returns NULL if it can't be started, in
+ * which case batches are executed from the X server thread as before.
+ */
+struct emgd_submit *emgd_submit_create(intel_screen_private *intel)
+{
+	struct emgd_submit *submit;
+	sigset_t all, saved;
+	int ret;
+
+	submit = calloc(1, sizeof(*submit));
+	if (!submit) {
+		return NULL;
+	}
+
+	submit->intel = intel;
+	pthread_mutex_init(&submit->lock, NULL);
+	pthread_cond_init(&submit->work, NULL);
+	pthread_cond_init(&submit->done, NULL);
+
+	/* Signals (SIGIO input, the scheduler's SIGALRM) belong to the server */
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &saved);
+	ret = pthread_create(&submit->thread, NULL, submit_thread, submit);
+	pthread_sigmask(SIG_SETMASK, &saved, NULL);
+
+	if (ret) {
+		OS_ERROR("Unable to start batch submission thread: %s",
+			strerror(ret));
+		pthread_cond_destroy(&submit->done);
+		pthread_cond_destroy(&submit->work);
+		pthread_mutex_destroy(&submit->lock);
+		free(submit);
+		return NULL;
+	}
+
+	OS_PRINT("Submitting batchbuffers from a separate thread");
+	return submit;
+}
+
+
+/*
+ * emgd_submit_destroy
+ *
+ * Issue whatever is still queued and stop the thread.
+ */
+void emgd_submit_destroy(struct emgd_submit *submit)
+{
+	if (!submit) {
+		return;
+	}
+
+	pthread_mutex_lock(&submit->lock);
+	submit->stop = TRUE;
+	pthread_cond_signal(&submit->work);
+	pthread_mutex_unlock(&submit->lock);
+
+	pthread_join(submit->thread, NULL);
+
+	pthread_cond_destroy(&submit->done);
+	pthread_cond_destroy(&submit->work);
+	pthread_mutex_destroy(&submit->lock);
+	free(submit);
+}
+
+
+static int submit_take_error(struct emgd_submit *submit)
+{
+	int ret = submit->error;
+
+	submit->error = 0;
+	return ret;
+}
+
+
+/*
+ * emgd_submit_queue
+ *
+ * Queue an uploaded batch for execution, waiting for a free slot if the
+ * worker is EMGD_SUBMIT_DEPTH batches behind.  The queue holds its own
+ * reference to bo.  Returns the first error from a previously queued
+ * batch, if any.
+ */
+int emgd_submit_queue(struct emgd_submit *submit, dri_bo *bo,
+	int used, unsigned int ring)
+{
+	submit_entry_t *entry;
+	int ret;
+
+	dri_bo_reference(bo);
+
+	pthread_mutex_lock(&submit->lock);
+	if (submit->head - submit->tail == EMGD_SUBMIT_DEPTH) {
+		uint64_t start = emgd_perf_now();
+
+		while (submit->head - submit->tail == EMGD_SUBMIT_DEPTH) {
+			pthread_cond_wait(&submit->done, &submit->lock);
+		}
+		EMGD_PERF_INC(submit_waits);
+		EMGD_PERF_ADD(submit_wait_ns, emgd_perf_now() - start);
+	}
+
+	entry = &submit->queue[submit->head % EMGD_SUBMIT_DEPTH];
+	entry->bo = bo;
+	entry->used = used;
+	entry->ring = ring;
+	submit->head++;
+	pthread_cond_signal(&submit->work);
+
+	ret = submit_take_error(submit);
+	pthread_mutex_unlock(&submit->lock);
+
+	EMGD_PERF_INC(submit_queued);
+	return ret;
+}
+
+
+/*
+ * emgd_submit_wait
+ *
+ * Wait until every queued batch has been handed to the kernel.  This
+ * doesn't wait for the GPU, only for the ioctls.  Returns the first error
+ * from a queued batch, if any.
+ */
+int emgd_submit_wait(struct emgd_submit *submit)
+{
+	int ret;
+
+	pthread_mutex_lock(&submit->lock);
+	if (submit->head != submit->tail) {
+		uint64_t start = emgd_perf_now();
+
+		while (submit->head != submit->tail) {
+			pthread_cond_wait(&submit->done, &submit->lock);
+		}
+		EMGD_PERF_INC(submit_waits);
+		EMGD_PERF_ADD(submit_wait_ns, emgd_perf_now() - start);
+	}
+
+	ret = submit_take_error(submit);
+	pthread_mutex_unlock(&submit->lock);
+
+	return ret;
+}
@@ -0,0 +1,56 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_submit.h
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Optional batch submission thread.
+ *
+ *  With the "AsyncSubmit" option, intel_batch_submit() uploads the batch
+ *  and hands the bo to a worker thread that issues the execbuffer ioctl,
+ *  so relocation processing, eviction and throttling in the kernel no
+ *  longer stall the X server.  The CPU side of the batch is free again as
+ *  soon as it has been uploaded.
+ *
+ *  Until the worker has issued a queued batch the kernel knows nothing
+ *  about it: busy checks, maps and waits on buffers it uses would not see
+ *  the pending rendering.  Such paths call intel_batch_wait_submitted()
+ *  first, which returns once every queued batch is in the kernel.
+ *-----------------------------------------------------------------------------
+ */
+
+#ifndef _EMGD_SUBMIT_H_
+#define _EMGD_SUBMIT_H_
+
+/* Batches queued to the worker before the X server thread waits */
+#define EMGD_SUBMIT_DEPTH	4
+
+struct emgd_submit;
+
+extern struct emgd_submit *emgd_submit_create(intel_screen_private *intel);
+extern void emgd_submit_destroy(struct emgd_submit *submit);
+extern int emgd_submit_queue(struct emgd_submit *submit, dri_bo *bo,
+	int used, unsigned int ring);
+extern int emgd_submit_wait(struct emgd_submit *submit);
+
+#endif /* _EMGD_SUBMIT_H_ */
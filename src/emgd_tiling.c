@@ -0,0 +1,264 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_tiling.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Tiled <-> linear rectangle copies.
+ *
+ *  Each row of the rectangle is split into runs that are contiguous in the
+ *  tiled layout: up to 512 bytes for X tiling (64 bytes when bit 6 is
+ *  swizzled, as the swizzle flips every other 64 byte block) and exactly
+ *  one 16 byte OWord for Y tiling.  Consecutive OWords of a row in a Y
+ *  tiled surface are always 512 bytes apart, whether or not they cross a
+ *  tile boundary, so the Y path walks the row with a fixed stride and
+ *  moves each OWord with a single SSE2 load/store pair.
+ *-----------------------------------------------------------------------------
+ */
+
+#include <string.h>
+#include <i915_drm.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "emgd_tiling.h"
+
+#define Y_OWORD_STRIDE  (EMGD_TILE_Y_SPAN * EMGD_TILE_Y_HEIGHT)
+
+
+int emgd_tiling_supported(uint32_t tiling, uint32_t swizzle)
+{
+	if (tiling != I915_TILING_X && tiling != I915_TILING_Y) {
+		return 0;
+	}
+
+	switch (swizzle) {
+	case I915_BIT_6_SWIZZLE_NONE:
+	case I915_BIT_6_SWIZZLE_9:
+	case I915_BIT_6_SWIZZLE_9_10:
+	case I915_BIT_6_SWIZZLE_9_11:
+	case I915_BIT_6_SWIZZLE_9_10_11:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+
+/*
+ * Apply bit-6 swizzling to an offset within the surface.  Only valid for
+ * page aligned surfaces, where bits 9-11 of the offset match the address.
+ */
+static inline unsigned long swizzle_offset(unsigned long offset,
+	uint32_t swizzle)
+{
+	unsigned long bit;
+
+	switch (swizzle) {
+	case I915_BIT_6_SWIZZLE_9:
+		bit = offset >> 3;
+		break;
+	case I915_BIT_6_SWIZZLE_9_10:
+		bit = (offset >> 3) ^ (offset >> 4);
+		break;
+	case I915_BIT_6_SWIZZLE_9_11:
+		bit = (offset >> 3) ^ (offset >> 5);
+		break;
+	case I915_BIT_6_SWIZZLE_9_10_11:
+		bit = (offset >> 3) ^ (offset >> 4) ^ (offset >> 5);
+		break;
+	default:
+		return offset;
+	}
+
+	return offset ^ (bit & 64);
+}
+
+
+/* Move one OWord; the tiled side is always 16 byte aligned. */
+static inline void oword_to_linear(uint8_t *linear, const uint8_t *tiled)
+{
+#ifdef __SSE2__
+	_mm_storeu_si128((__m128i *)linear, _mm_load_si128((const __m128i *)tiled));
+#else
+	memcpy(linear, tiled, 16);
+#endif
+}
+
+static inline void oword_to_tiled(uint8_t *tiled, const uint8_t *linear)
+{
+#ifdef __SSE2__
+	_mm_store_si128((__m128i *)tiled, _mm_loadu_si128((const __m128i *)linear));
+#else
+	memcpy(tiled, linear, 16);
+#endif
+}
+
+
+static inline void copy_run(uint8_t *tiled, uint8_t *linear, int len,
+	const int to_tiled)
+{
+	if (to_tiled) {
+		memcpy(tiled, linear, len);
+	} else {
+		memcpy(linear, tiled, len);
+	}
+}
+
+
+static inline void copy_row_x(uint8_t *tiled, int tiles_per_row,
+	uint8_t *linear, uint32_t swizzle, int x, int y, int width,
+	const int to_tiled)
+{
+	unsigned long row_base;
+	int span = swizzle == I915_BIT_6_SWIZZLE_NONE ? EMGD_TILE_X_WIDTH : 64;
+	int cx, len;
+
+	row_base = (unsigned long)(y / EMGD_TILE_X_HEIGHT) * tiles_per_row *
+		EMGD_TILE_SIZE + (y % EMGD_TILE_X_HEIGHT) * EMGD_TILE_X_WIDTH;
+
+	for (cx = 0; cx < width; cx += len) {
+		int sx = x + cx;
+		unsigned long offset;
+
+		len = span - sx % span;
+		if (len > width - cx) {
+			len = width - cx;
+		}
+
+		offset = row_base + (unsigned long)(sx / EMGD_TILE_X_WIDTH) *
+			EMGD_TILE_SIZE + sx % EMGD_TILE_X_WIDTH;
+		copy_run(tiled + swizzle_offset(offset, swizzle), linear + cx,
+			len, to_tiled);
+	}
+}
+
+
+static inline void copy_row_y(uint8_t *tiled, int tiles_per_row,
+	uint8_t *linear, uint32_t swizzle, int x, int y, int width,
+	const int to_tiled)
+{
+	unsigned long offset;
+	int head = x % EMGD_TILE_Y_SPAN;
+	int tx = x % EMGD_TILE_Y_WIDTH;
+	int cx = 0;
+
+	/* Offset of the OWord column containing x, in this row */
+	offset = (unsigned long)(y / EMGD_TILE_Y_HEIGHT) * tiles_per_row *
+		EMGD_TILE_SIZE +
+		(unsigned long)(x / EMGD_TILE_Y_WIDTH) * EMGD_TILE_SIZE +
+		(tx / EMGD_TILE_Y_SPAN) * Y_OWORD_STRIDE +
+		(y % EMGD_TILE_Y_HEIGHT) * EMGD_TILE_Y_SPAN;
+
+	if (head) {
+		int len = EMGD_TILE_Y_SPAN - head;
+
+		if (len > width) {
+			len = width;
+		}
+		copy_run(tiled + swizzle_offset(offset, swizzle) + head, linear,
+			len, to_tiled);
+		cx = len;
+		offset += Y_OWORD_STRIDE;
+	}
+
+	if (swizzle == I915_BIT_6_SWIZZLE_NONE) {
+		for (; cx + 4 * EMGD_TILE_Y_SPAN <= width;
+			cx += 4 * EMGD_TILE_Y_SPAN, offset += 4 * Y_OWORD_STRIDE) {
+			uint8_t *t = tiled + offset;
+			uint8_t *l = linear + cx;
+
+			if (to_tiled) {
+				oword_to_tiled(t, l);
+				oword_to_tiled(t + Y_OWORD_STRIDE, l + 16);
+				oword_to_tiled(t + 2 * Y_OWORD_STRIDE, l + 32);
+				oword_to_tiled(t + 3 * Y_OWORD_STRIDE, l + 48);
+			} else {
+				oword_to_linear(l, t);
+				oword_to_linear(l + 16, t + Y_OWORD_STRIDE);
+				oword_to_linear(l + 32, t + 2 * Y_OWORD_STRIDE);
+				oword_to_linear(l + 48, t + 3 * Y_OWORD_STRIDE);
+			}
+		}
+	}
+
+	for (; cx + EMGD_TILE_Y_SPAN <= width;
+		cx += EMGD_TILE_Y_SPAN, offset += Y_OWORD_STRIDE) {
+		uint8_t *t = tiled + swizzle_offset(offset, swizzle);
+
+		if (to_tiled) {
+			oword_to_tiled(t, linear + cx);
+		} else {
+			oword_to_linear(linear + cx, t);
+		}
+	}
+
+	if (cx < width) {
+		copy_run(tiled + swizzle_offset(offset, swizzle), linear + cx,
+			width - cx, to_tiled);
+	}
+}
+
+
+static inline void tiling_copy(uint8_t *tiled, int tiled_pitch,
+	uint32_t tiling, uint32_t swizzle, uint8_t *linear, int linear_pitch,
+	int x, int y, int width, int height, const int to_tiled)
+{
+	int row;
+
+	if (tiling == I915_TILING_X) {
+		int tiles_per_row = tiled_pitch / EMGD_TILE_X_WIDTH;
+
+		for (row = 0; row < height; row++, linear += linear_pitch) {
+			copy_row_x(tiled, tiles_per_row, linear, swizzle,
+				x, y + row, width, to_tiled);
+		}
+	} else {
+		int tiles_per_row = tiled_pitch / EMGD_TILE_Y_WIDTH;
+
+		for (row = 0; row < height; row++, linear += linear_pitch) {
+			copy_row_y(tiled, tiles_per_row, linear, swizzle,
+				x, y + row, width, to_tiled);
+		}
+	}
+}
+
+
+void emgd_detile_rect(void *dst, int dst_pitch,
+	const void *tiled, int tiled_pitch, uint32_t tiling, uint32_t swizzle,
+	int x, int y, int width, int height)
+{
+	tiling_copy((uint8_t *)tiled, tiled_pitch, tiling, swizzle,
+		dst, dst_pitch, x, y, width, height, 0);
+}
+
+
+void emgd_tile_rect(void *tiled, int tiled_pitch,
+	uint32_t tiling, uint32_t swizzle,
+	const void *src, int src_pitch,
+	int x, int y, int width, int height)
+{
+	tiling_copy(tiled, tiled_pitch, tiling, swizzle,
+		(uint8_t *)src, src_pitch, x, y, width, height, 1);
+}
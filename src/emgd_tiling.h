@@ -0,0 +1,71 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_tiling.h
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Software conversion between tiled buffer layouts and linear memory.
+ *
+ *  Lets the driver access tiled buffers through a cached CPU mapping
+ *  instead of the uncached, fenced GTT aperture, which also lifts the
+ *  max_gtt_map_size limit on such accesses.  The CPU mapping exposes the
+ *  raw tiled layout including any bit-6 swizzling; swizzle modes that
+ *  depend on the physical address (bit 17) can't be undone here, so check
+ *  emgd_tiling_supported() first.
+ *-----------------------------------------------------------------------------
+ */
+
+#ifndef _EMGD_TILING_H_
+#define _EMGD_TILING_H_
+
+#include <stdint.h>
+
+/* X tiles are 512 bytes by 8 rows, Y tiles 128 bytes by 32 rows */
+#define EMGD_TILE_SIZE          4096
+#define EMGD_TILE_X_WIDTH       512
+#define EMGD_TILE_X_HEIGHT      8
+#define EMGD_TILE_Y_WIDTH       128
+#define EMGD_TILE_Y_HEIGHT      32
+#define EMGD_TILE_Y_SPAN        16      /* Bytes per OWord column in a Y tile */
+
+/*
+ * Returns non-zero if rectangles can be converted for this tiling and
+ * swizzle mode, as returned by drm_intel_bo_get_tiling().
+ */
+extern int emgd_tiling_supported(uint32_t tiling, uint32_t swizzle);
+
+/*
+ * Copy a rectangle out of / into a tiled surface.  x and width are in
+ * bytes and (x, y) addresses the tiled surface; tiled_pitch must be a
+ * whole number of tiles and the tiled surface must start on a page
+ * boundary, as a mapped bo does.
+ */
+extern void emgd_detile_rect(void *dst, int dst_pitch,
+	const void *tiled, int tiled_pitch, uint32_t tiling, uint32_t swizzle,
+	int x, int y, int width, int height);
+extern void emgd_tile_rect(void *tiled, int tiled_pitch,
+	uint32_t tiling, uint32_t swizzle,
+	const void *src, int src_pitch,
+	int x, int y, int width, int height);
+
+#endif /* _EMGD_TILING_H_ */
@@ -0,0 +1,187 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_trace.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Storage for the binary event trace ring and the code that writes it to
+ *  disk.  See emgd_trace.h for the record format.
+ *-----------------------------------------------------------------------------
+ */
+#define PER_MODULE_DEBUG
+#define MODULE_NAME ial.driver
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <xf86.h>
+
+#include "emgd.h"
+#include "emgd_trace.h"
+
+emgd_trace_rec_t emgd_trace_ring[EMGD_TRACE_RING_SIZE];
+uint32_t emgd_trace_head;
+int emgd_trace_enabled;
+
+/*
+ * The dump path, and the temporary file it is written through, are
+ * copied into static buffers at init time so the signal handler never has
+ * to touch the heap or the option list.  No path means no dumps.
+ */
+static char trace_path[256];
+static char trace_tmp_path[sizeof(trace_path) + 4];
+static int trace_signal_installed;
+
+
+/*
+ * write_all
+ *
+ * write(2) until the whole buffer is out.  Only uses async-signal-safe
+ * calls.
+ */
+static int write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+	ssize_t n;
+
+	while (len) {
+		n = write(fd, p, len);
+		if (n < 0) {
+			return -1;
+		}
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+
+/*
+ * emgd_trace_dump
+ *
+ * Write the ring to the configured trace file, replacing any previous
+ * dump.  This is called both from the SIGUSR2 handler and from the control
+ * extension, so it must remain async-signal-safe: no stdio, no malloc and
+ * no X server logging.
+ *
+ * The server runs as root and either path may sit in a shared directory,
+ * so the dump never opens an existing file: it creates <path>.tmp with
+ * O_EXCL | O_NOFOLLOW (removing a stale one first) and renames it over
+ * <path>.  A symlink planted at either name is replaced, not followed.
+ *
+ * Recording is not paused; records written during the dump may appear
+ * torn and are discarded by the decoder using their sequence number.
+ *
+ * Returns 0 on success, -1 on failure.
+ */
+int emgd_trace_dump(void)
+{
+	emgd_trace_file_hdr_t hdr;
+	int fd, ret;
+
+	if (!trace_path[0]) {
+		return -1;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, EMGD_TRACE_MAGIC, sizeof(EMGD_TRACE_MAGIC));
+	hdr.version = EMGD_TRACE_VERSION;
+	hdr.rec_size = sizeof(emgd_trace_rec_t);
+	hdr.num_recs = EMGD_TRACE_RING_SIZE;
+	hdr.head = emgd_trace_head;
+
+	unlink(trace_tmp_path);
+	fd = open(trace_tmp_path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW,
+		0600);
+	if (fd < 0) {
+		return -1;
+	}
+
+	ret = write_all(fd, &hdr, sizeof(hdr));
+	if (!ret) {
+		ret = write_all(fd, emgd_trace_ring, sizeof(emgd_trace_ring));
+	}
+	close(fd);
+
+	if (!ret) {
+		ret = rename(trace_tmp_path, trace_path);
+	}
+	if (ret) {
+		unlink(trace_tmp_path);
+	}
+
+	return ret;
+}
+
+
+static void emgd_trace_signal(int sig)
+{
+	int saved_errno = errno;
+
+	(void)sig;
+	emgd_trace_dump();
+	errno = saved_errno;
+}
+
+
+/*
+ * emgd_trace_init
+ *
+ * Enable or disable recording and set the dump file.  Without a dump file
+ * the ring is still recorded, but dump requests fail.  The SIGUSR2 handler
+ * is installed the first time tracing is enabled and is left in place for
+ * the life of the server; it is harmless while tracing is disabled.
+ */
+void emgd_trace_init(int enable, const char *path)
+{
+	struct sigaction sa;
+
+	if (path && strlen(path) < sizeof(trace_path)) {
+		strcpy(trace_path, path);
+		strcpy(trace_tmp_path, path);
+		strcat(trace_tmp_path, ".tmp");
+	} else {
+		if (path) {
+			OS_ERROR("Trace file name too long: %s", path);
+		}
+		trace_path[0] = '\0';
+		trace_tmp_path[0] = '\0';
+	}
+
+	emgd_trace_enabled = enable;
+	if (!enable || trace_signal_installed) {
+		return;
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = emgd_trace_signal;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART;
+	if (sigaction(SIGUSR2, &sa, NULL) == 0) {
+		trace_signal_installed = 1;
+	} else {
+		OS_ERROR("Unable to install SIGUSR2 trace dump handler");
+	}
+}
@@ -0,0 +1,139 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_trace.h
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Binary event trace ring.
+ *
+ *  Hot-path events (batch submission, page flips, vblank events, pixmap
+ *  migrations, Xv frames) are recorded as fixed 32 byte records into a
+ *  process-wide ring.  Recording claims a slot with a single atomic add and
+ *  fills in a handful of words, so it can stay enabled in production
+ *  builds, unlike OS_TRACE_ENTER/OS_DEBUG which format a log line per call.
+ *
+ *  The ring is written out on SIGUSR2 or EMGD_CONTROL_DUMP_TRACE and is
+ *  turned into a readable timeline by tools/emgd_trace_decode.
+ *
+ *  The record and file layouts below are shared with the decoder and must
+ *  only be changed together with EMGD_TRACE_VERSION.
+ *-----------------------------------------------------------------------------
+ */
+
+#ifndef _EMGD_TRACE_H_
+#define _EMGD_TRACE_H_
+
+#include <stdint.h>
+#include "emgd_perf.h"
+
+#define EMGD_TRACE_MAGIC        "EMGDTRC"
+#define EMGD_TRACE_VERSION      1
+
+/* Number of records in the ring; must be a power of two. */
+#define EMGD_TRACE_RING_SIZE    8192
+
+/*
+ * Event ids.  The meaning of arg[0..3] for each event is listed alongside;
+ * unused arguments are recorded as zero.
+ */
+#define EMGD_TRACE_BATCH_SUBMIT     1  /* ring, bytes, exec usec, status */
+#define EMGD_TRACE_FLIP_SCHEDULE    2  /* drawable, fb id, target msc */
+#define EMGD_TRACE_FLIP_COMPLETE    3  /* drawable, msc */
+#define EMGD_TRACE_VBLANK           4  /* drawable, msc, swap type */
+#define EMGD_TRACE_PIXMAP_MIGRATE   5  /* bo handle, bo size, access, map usec */
+#define EMGD_TRACE_XV_FRAME         6  /* path, fourcc, width, height */
+#define EMGD_TRACE_GPU_HANG         7  /* hang count, retry delay msec */
+#define EMGD_TRACE_GPU_RECOVER      8  /* hang count */
+#define EMGD_TRACE_NUM_EVENTS       9
+
+/* Values for the path argument of EMGD_TRACE_XV_FRAME */
+#define EMGD_TRACE_XV_OVERLAY       0
+#define EMGD_TRACE_XV_BLEND         1
+
+typedef struct _emgd_trace_rec {
+	uint64_t ts;        /* CLOCK_MONOTONIC, nanoseconds */
+	uint32_t event;     /* EMGD_TRACE_*; 0 while the slot is being written */
+	uint32_t seq;       /* Low 32 bits of the sequence number of this record */
+	uint32_t arg[4];
+} emgd_trace_rec_t;
+
+/*
+ * Dump file layout: this header followed by EMGD_TRACE_RING_SIZE records
+ * in ring order.  The oldest valid record is at (head - num_recs) if head
+ * is larger than num_recs, otherwise at slot 0.
+ */
+typedef struct _emgd_trace_file_hdr {
+	char     magic[8];
+	uint32_t version;
+	uint32_t rec_size;
+	uint32_t num_recs;
+	uint32_t head;      /* Sequence number of the next record to be written */
+} emgd_trace_file_hdr_t;
+
+
+#ifndef EMGD_TRACE_DECODER
+
+extern emgd_trace_rec_t emgd_trace_ring[EMGD_TRACE_RING_SIZE];
+extern uint32_t emgd_trace_head;
+extern int emgd_trace_enabled;
+
+extern void emgd_trace_init(int enable, const char *path);
+extern int emgd_trace_dump(void);
+
+/*
+ * Record one event.  The event id is stored last so that a dump taken
+ * while a record is half written (e.g. from the signal handler) sees an
+ * empty slot rather than a record with stale arguments.
+ */
+static inline void emgd_trace(uint32_t event,
+	uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+	emgd_trace_rec_t *rec;
+	uint32_t seq;
+
+	if (!emgd_trace_enabled) {
+		return;
+	}
+
+	seq = __sync_fetch_and_add(&emgd_trace_head, 1);
+	rec = &emgd_trace_ring[seq & (EMGD_TRACE_RING_SIZE - 1)];
+
+	rec->event = 0;
+	__asm__ __volatile__("" ::: "memory");
+	rec->ts = emgd_perf_now();
+	rec->seq = seq;
+	rec->arg[0] = a0;
+	rec->arg[1] = a1;
+	rec->arg[2] = a2;
+	rec->arg[3] = a3;
+	__asm__ __volatile__("" ::: "memory");
+	rec->event = event;
+}
+
+#define EMGD_TRACE(ev, a0, a1, a2, a3) \
+	emgd_trace(EMGD_TRACE_##ev, (uint32_t)(a0), (uint32_t)(a1), \
+		(uint32_t)(a2), (uint32_t)(a3))
+
+#endif /* EMGD_TRACE_DECODER */
+
+#endif /* _EMGD_TRACE_H_ */
@@ -45,7 +45,10 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "brw_defines.h"
 #include "emgd.h"
 #include "emgd_uxa.h"
+#include "emgd_dri2.h"
 #include "intel_batchbuffer.h"
+#include "emgd_trace.h"
+#include "emgd_tiling.h"
 
 static const int I830CopyROP[16] = {
 	ROP_0,			/* GXclear */
@@ -95,7 +98,108 @@ static void
 gen6_context_switch(intel_screen_private *intel,
 		    int new_mode)
 {
-	intel_batch_submit(intel->scrn);
+	intel_batch_switch_ring(intel->scrn, new_mode);
+}
+
+static struct intel_aperture *
+intel_aperture_for_batch(intel_screen_private *intel)
+{
+	struct intel_aperture *ap = &intel->aperture[0];
+
+	if (ap->batch != intel->batch_bo) {
+		ap = &intel->aperture[1];
+		if (ap->batch != intel->batch_bo) {
+			/* Keep the parked batch's entry, reuse the other */
+			if (ap->batch != NULL && ap->batch == intel->parked.bo)
+				ap = &intel->aperture[0];
+
+			ap->batch = intel->batch_bo;
+			ap->num_bos = 0;
+			ap->size = intel->batch_bo->size;
+			ap->verified = FALSE;
+		}
+	}
+
+	return ap;
+}
+
+/*
+ * intel_check_aperture
+ *
+ * Whether the buffers in bo_table, which must include the current batch,
+ * fit in the aperture together with everything the batch already uses.
+ *
+ * Consecutive operations mostly use the same buffers, so rather than
+ * asking libdrm (which walks the relocation trees) every time, the
+ * buffers are counted once per batch.  Once libdrm has accepted the
+ * batch, a check that only adds buffers, up to aperture_limit in total,
+ * is answered here.  The limit is half of what libdrm allows, leaving
+ * room for buffers reached only through relocations, such as the
+ * targets of surface state.  Tiled buffers may also need one of the
+ * few fence registers, which only libdrm accounts for, so a check that
+ * adds one always goes to libdrm.
+ */
+Bool
+intel_check_aperture(intel_screen_private *intel, drm_intel_bo **bo_table,
+		     int num_bos)
+{
+	struct intel_aperture *ap = intel_aperture_for_batch(intel);
+	drm_intel_bo *added[INTEL_APERTURE_BOS];
+	unsigned long size = 0;
+	int num_added = 0;
+	Bool fenced = FALSE;
+	int i, j;
+
+	EMGD_PERF_INC(aperture_checks);
+
+	for (i = 0; i < num_bos; i++) {
+		drm_intel_bo *bo = bo_table[i];
+
+		if (bo == NULL || bo == intel->batch_bo)
+			continue;
+
+		for (j = 0; j < ap->num_bos; j++) {
+			if (ap->bos[j] == bo)
+				break;
+		}
+		if (j < ap->num_bos)
+			continue;
+
+		for (j = 0; j < num_added; j++) {
+			if (added[j] == bo)
+				break;
+		}
+		if (j < num_added)
+			continue;
+
+		if (num_added < INTEL_APERTURE_BOS)
+			added[num_added++] = bo;
+		size += bo->size;
+
+		if (!fenced) {
+			uint32_t tiling, swizzle;
+
+			fenced = drm_intel_bo_get_tiling(bo, &tiling,
+							 &swizzle) == 0 &&
+				tiling != I915_TILING_NONE;
+		}
+	}
+
+	if (!ap->verified || fenced ||
+	    ap->size + size > intel->aperture_limit) {
+		if (drm_intel_bufmgr_check_aperture_space(bo_table, num_bos) != 0)
+			return FALSE;
+		ap->verified = TRUE;
+	} else {
+		EMGD_PERF_INC(aperture_check_hits);
+	}
+
+	/* Buffers that don't fit in bos[] are simply counted again later */
+	ap->size += size;
+	for (i = 0; i < num_added && ap->num_bos < INTEL_APERTURE_BOS; i++)
+		ap->bos[ap->num_bos++] = added[i];
+
+	return TRUE;
 }
 
 Bool
@@ -110,11 +214,10 @@ intel_get_aperture_space(ScrnInfoPtr scrn, drm_intel_bo ** bo_table,
 	}
 
 	bo_table[0] = intel->batch_bo;
-	if (drm_intel_bufmgr_check_aperture_space(bo_table, num_bos) != 0) {
+	if (!intel_check_aperture(intel, bo_table, num_bos)) {
 		intel_batch_submit(scrn);
 		bo_table[0] = intel->batch_bo;
-		if (drm_intel_bufmgr_check_aperture_space(bo_table, num_bos) !=
-		    0) {
+		if (!intel_check_aperture(intel, bo_table, num_bos)) {
 			intel_debug_fallback(scrn, "Couldn't get aperture "
 					    "space for BOs\n");
 			return FALSE;
@@ -317,6 +420,9 @@ static void intel_uxa_solid(PixmapPtr pixmap, int x1, int y1, int x2, int y2)
 		OUT_BATCH(intel->BR[16]);
 		ADVANCE_BATCH();
 	}
+
+	intel_pixmap_add_damage(intel_get_pixmap_private(pixmap),
+				x1, y1, x2, y2);
 }
 
 /**
@@ -477,6 +583,9 @@ intel_uxa_copy(PixmapPtr dest, int src_x1, int src_y1, int dst_x1,
 
 		ADVANCE_BATCH();
 	}
+
+	intel_pixmap_add_damage(intel_get_pixmap_private(dest),
+				dst_x1, dst_y1, dst_x2, dst_y2);
 }
 
 static void intel_uxa_done(PixmapPtr pixmap)
@@ -496,8 +605,259 @@ static void intel_uxa_done(PixmapPtr pixmap)
 	intel_debug_flush(scrn);
 }
 
+/*
+ * Mono expansion.  Bitmaps go inline with XY_MONO_SRC_COPY_IMMEDIATE and
+ * 8x8 patterns with XY_MONO_PAT.  The blitter wants the leftmost pixel in
+ * the most significant bit, so every source byte is reversed on its way
+ * into the batch.
+ */
+#define INTEL_MONO_IMM_DWORDS	248	/* Inline data per blit */
+#define INTEL_MONO_IMM_WIDTH	1024	/* Widest blit, in pixels */
+
+static inline uint8_t intel_byte_reverse(uint8_t b)
+{
+	return ((b * 0x0802UL & 0x22110UL) |
+		(b * 0x8020UL & 0x88440UL)) * 0x10101UL >> 16;
+}
+
+static Bool
+intel_uxa_check_mono(DrawablePtr drawable, int alu, Pixel planemask)
+{
+	ScrnInfoPtr scrn = xf86Screens[drawable->pScreen->myNum];
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+
+	if (!UXA_PM_IS_SOLID(drawable, planemask)) {
+		intel_debug_fallback(scrn, "planemask is not solid\n");
+		return FALSE;
+	}
+
+	if (intel->cfg.punt_uxa_mono) {
+		intel_debug_fallback(scrn, "Punting mono\n");
+		return FALSE;
+	}
+
+	switch (drawable->bitsPerPixel) {
+	case 8:
+	case 16:
+	case 32:
+		break;
+	default:
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 /**
- * Do any cleanup from the Composite operation.
+ * Sets up hardware state for a series of mono expansions.
+ */
+static Bool
+intel_uxa_prepare_mono(PixmapPtr pixmap, int alu, Pixel planemask,
+		       Pixel fg, Pixel bg, Bool opaque,
+		       const CARD8 *pattern, int pat_x, int pat_y)
+{
+	ScrnInfoPtr scrn = xf86Screens[pixmap->drawable.pScreen->myNum];
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+	drm_intel_bo *bo_table[] = {
+		NULL,		/* batch_bo */
+		intel_get_pixmap_bo(pixmap),
+	};
+	int i;
+
+	if (!intel_check_pitch_2d(pixmap))
+		return FALSE;
+
+	if (!intel_get_aperture_space(scrn, bo_table, ARRAY_SIZE(bo_table)))
+		return FALSE;
+
+	if (pattern) {
+		intel->BR[13] = (I830PatternROP[alu] & 0xff) << 16;
+		if (!opaque)
+			intel->BR[13] |= (1 << 28);
+
+		/* Seed the pattern so that its origin lands on pat_x,pat_y */
+		intel->BR[15] = ((-pat_x & 7) << 12) | ((-pat_y & 7) << 8);
+
+		intel->BR[18] = intel->BR[19] = 0;
+		for (i = 0; i < 4; i++) {
+			intel->BR[18] |=
+				(uint32_t)intel_byte_reverse(pattern[i]) << (i * 8);
+			intel->BR[19] |=
+				(uint32_t)intel_byte_reverse(pattern[i + 4]) << (i * 8);
+		}
+	} else {
+		intel->BR[13] = I830CopyROP[alu] << 16;
+		if (!opaque)
+			intel->BR[13] |= (1 << 29);
+	}
+
+	switch (pixmap->drawable.bitsPerPixel) {
+	case 8:
+		break;
+	case 16:
+		intel->BR[13] |= (1 << 24);
+		break;
+	case 32:
+		intel->BR[13] |= ((1 << 25) | (1 << 24));
+		break;
+	}
+	intel->BR[16] = fg;
+	intel->BR[17] = bg;
+
+	return TRUE;
+}
+
+static void
+intel_uxa_mono_imm(intel_screen_private *intel, PixmapPtr pixmap,
+		   int x, int y, int w, int h,
+		   const CARD8 *bits, int stride, int skip)
+{
+	ScrnInfoPtr scrn = intel->scrn;
+	uint8_t data[INTEL_MONO_IMM_DWORDS * 4];
+	int src_bytes = (skip + w + 7) >> 3;
+	int row_bytes = ALIGN(src_bytes, 2);	/* Rows start on a word */
+	int max_rows = sizeof(data) / row_bytes;
+	unsigned long pitch = intel_pixmap_pitch(pixmap);
+	uint32_t cmd;
+
+	cmd = XY_MONO_SRC_IMM_BLT_CMD | (skip << 17);
+	if (pixmap->drawable.bitsPerPixel == 32)
+		cmd |= XY_MONO_SRC_IMM_BLT_WRITE_ALPHA |
+		       XY_MONO_SRC_IMM_BLT_WRITE_RGB;
+	if (INTEL_INFO(intel)->gen >= 40 && intel_pixmap_tiled(pixmap)) {
+		assert((pitch % 512) == 0);
+		pitch >>= 2;
+		cmd |= XY_MONO_SRC_IMM_BLT_TILED;
+	}
+
+	while (h > 0) {
+		int rows = h < max_rows ? h : max_rows;
+		int len = ALIGN(rows * row_bytes, 8) / 4;
+		uint8_t *dst = data;
+		int i, j;
+
+		memset(data, 0, len * 4);
+		for (i = 0; i < rows; i++) {
+			for (j = 0; j < src_bytes; j++)
+				dst[j] = intel_byte_reverse(bits[j]);
+			dst += row_bytes;
+			bits += stride;
+		}
+
+		BEGIN_BATCH_BLT(7 + len);
+		OUT_BATCH(cmd | (5 + len));
+		OUT_BATCH(intel->BR[13] | pitch);
+		OUT_BATCH((y << 16) | (x & 0xffff));
+		OUT_BATCH(((y + rows) << 16) | ((x + w) & 0xffff));
+		OUT_RELOC_PIXMAP_FENCED(pixmap, I915_GEM_DOMAIN_RENDER,
+					I915_GEM_DOMAIN_RENDER, 0);
+		OUT_BATCH(intel->BR[17]);
+		OUT_BATCH(intel->BR[16]);
+		for (i = 0; i < len; i++) {
+			uint32_t dword;
+
+			memcpy(&dword, data + i * 4, 4);
+			OUT_BATCH(dword);
+		}
+		ADVANCE_BATCH();
+
+		y += rows;
+		h -= rows;
+	}
+}
+
+static void
+intel_uxa_mono(PixmapPtr pixmap, int x, int y, int w, int h,
+	       const CARD8 *bits, int stride, int src_x)
+{
+	ScrnInfoPtr scrn = xf86Screens[pixmap->drawable.pScreen->myNum];
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+	int x1, x2, y2;
+
+	if (x < 0)
+		src_x -= x, w += x, x = 0;
+	if (y < 0)
+		bits -= y * stride, h += y, y = 0;
+	if (x + w > pixmap->drawable.width)
+		w = pixmap->drawable.width - x;
+	if (y + h > pixmap->drawable.height)
+		h = pixmap->drawable.height - y;
+
+	if (w <= 0 || h <= 0)
+		return;
+
+	x1 = x;
+	x2 = x + w;
+	y2 = y + h;
+	while (w > 0) {
+		int cw = w < INTEL_MONO_IMM_WIDTH ? w : INTEL_MONO_IMM_WIDTH;
+
+		intel_uxa_mono_imm(intel, pixmap, x, y, cw, h,
+				   bits + (src_x >> 3), stride, src_x & 7);
+		x += cw;
+		src_x += cw;
+		w -= cw;
+	}
+
+	intel_pixmap_add_damage(intel_get_pixmap_private(pixmap),
+				x1, y, x2, y2);
+}
+
+static void
+intel_uxa_mono_pattern(PixmapPtr pixmap, int x1, int y1, int x2, int y2)
+{
+	ScrnInfoPtr scrn = xf86Screens[pixmap->drawable.pScreen->myNum];
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+	unsigned long pitch;
+	uint32_t cmd;
+
+	if (x1 < 0)
+		x1 = 0;
+	if (y1 < 0)
+		y1 = 0;
+	if (x2 > pixmap->drawable.width)
+		x2 = pixmap->drawable.width;
+	if (y2 > pixmap->drawable.height)
+		y2 = pixmap->drawable.height;
+
+	if (x2 <= x1 || y2 <= y1)
+		return;
+
+	pitch = intel_pixmap_pitch(pixmap);
+
+	{
+		BEGIN_BATCH_BLT(9);
+
+		cmd = XY_MONO_PAT_BLT_CMD | intel->BR[15];
+
+		if (pixmap->drawable.bitsPerPixel == 32)
+			cmd |=
+			    XY_MONO_PAT_BLT_WRITE_ALPHA | XY_MONO_PAT_BLT_WRITE_RGB;
+
+		if (INTEL_INFO(intel)->gen >= 40 && intel_pixmap_tiled(pixmap)) {
+			assert((pitch % 512) == 0);
+			pitch >>= 2;
+			cmd |= XY_MONO_PAT_BLT_TILED;
+		}
+
+		OUT_BATCH(cmd);
+
+		OUT_BATCH(intel->BR[13] | pitch);
+		OUT_BATCH((y1 << 16) | (x1 & 0xffff));
+		OUT_BATCH((y2 << 16) | (x2 & 0xffff));
+		OUT_RELOC_PIXMAP_FENCED(pixmap, I915_GEM_DOMAIN_RENDER,
+					I915_GEM_DOMAIN_RENDER, 0);
+		OUT_BATCH(intel->BR[17]);
+		OUT_BATCH(intel->BR[16]);
+		OUT_BATCH(intel->BR[18]);
+		OUT_BATCH(intel->BR[19]);
+		ADVANCE_BATCH();
+	}
+
+	intel_pixmap_add_damage(intel_get_pixmap_private(pixmap),
+				x1, y1, x2, y2);
+}
+
  *
  * This is shared between i830 through i965.
  */
@@ -661,6 +1021,7 @@ void intel_set_pixmap_bo(PixmapPtr pixmap, dri_bo * bo)
 		}
 
 		priv->tiling = tiling;
+		priv->swizzle = swizzle_mode;
 		priv->busy = -1;
 		priv->offscreen = 1;
 	} else {
@@ -679,22 +1040,293 @@ static Bool intel_uxa_pixmap_is_offscreen(PixmapPtr pixmap)
 	return intel_pixmap_is_offscreen(pixmap);
 }
 
-static Bool intel_uxa_prepare_access(PixmapPtr pixmap, uxa_access_t access)
+/*
+ * How CPU accesses to a pixmap are serviced.  The GTT mapping is uncached
+ * and write-combined, so reading through it is an order of magnitude
+ * slower than reading cached memory, and for tiled bos it needs one of the
+ * few fence registers and is limited to max_gtt_map_size.  A cached CPU
+ * mapping however moves the whole bo to the CPU domain, which only pays off
+ * when a good part of it is accessed, and exposes the raw tiled layout,
+ * which emgd_tiling converts while copying in or out.
+ */
+typedef enum {
+	INTEL_ACCESS_GTT,	/* Fenced GTT mapping */
+	INTEL_ACCESS_CPU,	/* Cached CPU mapping of a linear bo */
+	INTEL_ACCESS_TILED,	/* Cached CPU mapping, (de)tiled while copying */
+} intel_access_path_t;
+
+/* Use a cached mapping when at least 1/N of the bo is accessed */
+#define INTEL_ACCESS_CPU_MIN_FRACTION	8
+
+static intel_access_path_t intel_uxa_access_path(intel_screen_private *intel,
+						 struct intel_pixmap *priv,
+						 uxa_access_t access,
+						 unsigned long bytes)
+{
+	/* CPU writes to a scanout buffer must not linger in the cache */
+	if (access == UXA_ACCESS_RW && priv->pinned)
+		return INTEL_ACCESS_GTT;
+
+	if (priv->tiling == I915_TILING_NONE) {
+		if (priv->bo->size <= intel->max_gtt_map_size &&
+		    bytes * INTEL_ACCESS_CPU_MIN_FRACTION < priv->bo->size)
+			return INTEL_ACCESS_GTT;
+		return INTEL_ACCESS_CPU;
+	}
+
+	if (!emgd_tiling_supported(priv->tiling, priv->swizzle))
+		return INTEL_ACCESS_GTT;
+
+	/* Too large for the aperture, so a cached mapping is the only way */
+	if (priv->bo->size > intel->max_gtt_map_size ||
+	    bytes * INTEL_ACCESS_CPU_MIN_FRACTION >= priv->bo->size)
+		return INTEL_ACCESS_TILED;
+
+	return INTEL_ACCESS_GTT;
+}
+
+/*
+ * Does CPU access to box have to wait for the batch being built?  Writes
+ * must follow everything the batch reads from the pixmap as a source; both
+ * reads and writes must follow the batch's writes to the same pixels.
+ */
+static Bool intel_uxa_access_needs_flush(struct intel_pixmap *priv,
+					 BoxPtr box, uxa_access_t access)
+{
+	BoxPtr damage = &priv->batch_damage;
+
+	if (LIST_IS_EMPTY(&priv->batch))
+		return FALSE;
+
+	if (access == UXA_ACCESS_RW && priv->batch_read)
+		return TRUE;
+
+	if (!priv->batch_write)
+		return FALSE;
+
+	if (box == NULL)
+		return TRUE;
+
+	return box->x1 < box->x2 && box->y1 < box->y2 &&
+		box->x1 < damage->x2 && damage->x1 < box->x2 &&
+		box->y1 < damage->y2 && damage->y1 < box->y2;
+}
+
+/*
+ * Bytes of the bo that CPU access to box touches: every row the box spans,
+ * since it is the cache lines of those rows that a cached mapping pulls
+ * into the CPU domain.  No box means the whole pixmap.
+ */
+static unsigned long intel_uxa_access_bytes(PixmapPtr pixmap, BoxPtr box)
+{
+	struct intel_pixmap *priv = intel_get_pixmap_private(pixmap);
+	int y1, y2;
+
+	if (box == NULL)
+		return priv->bo->size;
+
+	y1 = box->y1 < 0 ? 0 : box->y1;
+	y2 = box->y2 > pixmap->drawable.height ?
+		pixmap->drawable.height : box->y2;
+	if (box->x1 >= box->x2 || y1 >= y2)
+		return 0;
+
+	return (unsigned long)(y2 - y1) * intel_pixmap_pitch(pixmap);
+}
+
+/* Detile rows y1 to y2 of a shadowed pixmap into its shadow */
+static void intel_uxa_shadow_rows(PixmapPtr pixmap, int y1, int y2)
+{
+	struct intel_pixmap *priv = intel_get_pixmap_private(pixmap);
+	int pitch = intel_pixmap_pitch(pixmap);
+
+	emgd_detile_rect((char *)priv->shadow + y1 * pitch, pitch,
+			 priv->bo->virtual, pitch, priv->tiling, priv->swizzle,
+			 0, y1,
+			 (pixmap->drawable.width *
+			  pixmap->drawable.bitsPerPixel + 7) / 8,
+			 y2 - y1);
+}
+
+/*
+ * A tiled bo larger than max_gtt_map_size can't be fenced, so fb gets a
+ * linear shadow with the pixmap's pitch instead.  Only the rows of the
+ * accessed box are detiled into it; what RW accesses may have changed is
+ * tiled back when the last access finishes.  Nested accesses, such as a
+ * copy within the pixmap, share the shadow.
+ */
+static int intel_uxa_prepare_shadow(PixmapPtr pixmap, BoxPtr box,
+				    uxa_access_t access)
+{
+	struct intel_pixmap *priv = intel_get_pixmap_private(pixmap);
+	BoxRec extents;
+	int ret;
+
+	extents.x1 = 0;
+	extents.y1 = 0;
+	extents.x2 = pixmap->drawable.width;
+	extents.y2 = pixmap->drawable.height;
+	if (box) {
+		if (box->x1 > extents.x1)
+			extents.x1 = box->x1;
+		if (box->y1 > extents.y1)
+			extents.y1 = box->y1;
+		if (box->x2 < extents.x2)
+			extents.x2 = box->x2;
+		if (box->y2 < extents.y2)
+			extents.y2 = box->y2;
+	}
+
+	if (priv->shadow == NULL) {
+		priv->shadow = malloc((size_t)intel_pixmap_pitch(pixmap) *
+				      pixmap->drawable.height);
+		if (priv->shadow == NULL)
+			return -ENOMEM;
+		priv->shadow_y1 = priv->shadow_y2 = 0;
+		priv->shadow_damage.x1 = priv->shadow_damage.y1 = 0;
+		priv->shadow_damage.x2 = priv->shadow_damage.y2 = 0;
+	}
+
+	if (extents.y1 < extents.y2 &&
+	    (extents.y1 < priv->shadow_y1 || extents.y2 > priv->shadow_y2)) {
+		ret = intel_bo_map_cpu(priv->bo, FALSE);
+		if (ret) {
+			if (priv->shadow_users == 0) {
+				free(priv->shadow);
+				priv->shadow = NULL;
+			}
+			return ret;
+		}
+
+		/* Keep the valid rows contiguous */
+		if (priv->shadow_y1 == priv->shadow_y2) {
+			intel_uxa_shadow_rows(pixmap, extents.y1, extents.y2);
+			priv->shadow_y1 = extents.y1;
+			priv->shadow_y2 = extents.y2;
+		} else {
+			if (extents.y1 < priv->shadow_y1) {
+				intel_uxa_shadow_rows(pixmap, extents.y1,
+						      priv->shadow_y1);
+				priv->shadow_y1 = extents.y1;
+			}
+			if (extents.y2 > priv->shadow_y2) {
+				intel_uxa_shadow_rows(pixmap, priv->shadow_y2,
+						      extents.y2);
+				priv->shadow_y2 = extents.y2;
+			}
+		}
+		drm_intel_bo_unmap(priv->bo);
+	}
+
+	if (access == UXA_ACCESS_RW && extents.x1 < extents.x2 &&
+	    extents.y1 < extents.y2) {
+		BoxPtr damage = &priv->shadow_damage;
+
+		if (damage->x1 >= damage->x2) {
+			*damage = extents;
+		} else {
+			if (extents.x1 < damage->x1)
+				damage->x1 = extents.x1;
+			if (extents.y1 < damage->y1)
+				damage->y1 = extents.y1;
+			if (extents.x2 > damage->x2)
+				damage->x2 = extents.x2;
+			if (extents.y2 > damage->y2)
+				damage->y2 = extents.y2;
+		}
+	}
+
+	priv->shadow_users++;
+	EMGD_PERF_INC(access_shadows);
+	return 0;
+}
+
+/* Tile the shadow's damage back into the bo once nobody accesses it */
+static void intel_uxa_finish_shadow(PixmapPtr pixmap)
+{
+	struct intel_pixmap *priv = intel_get_pixmap_private(pixmap);
+	BoxPtr damage = &priv->shadow_damage;
+	int pitch = intel_pixmap_pitch(pixmap);
+	int bpp = pixmap->drawable.bitsPerPixel;
+	int x1, x2;
+
+	if (--priv->shadow_users)
+		return;
+
+	if (damage->x1 < damage->x2) {
+		x1 = damage->x1 * bpp / 8;
+		x2 = (damage->x2 * bpp + 7) / 8;
+		if (intel_bo_map_cpu(priv->bo, TRUE) == 0) {
+			emgd_tile_rect(priv->bo->virtual, pitch,
+				       priv->tiling, priv->swizzle,
+				       (char *)priv->shadow +
+				       damage->y1 * pitch + x1, pitch,
+				       x1, damage->y1,
+				       x2 - x1, damage->y2 - damage->y1);
+			drm_intel_bo_unmap(priv->bo);
+		} else {
+			ScrnInfoPtr scrn =
+				xf86Screens[pixmap->drawable.pScreen->myNum];
+
+			xf86DrvMsg(scrn->scrnIndex, X_WARNING,
+				   "%s: bo map failed, software rendering "
+				   "to a %dx%d pixmap lost\n", __FUNCTION__,
+				   pixmap->drawable.width,
+				   pixmap->drawable.height);
+		}
+	}
+
+	free(priv->shadow);
+	priv->shadow = NULL;
+	pixmap->devPrivate.ptr = NULL;
+}
+
+static Bool intel_uxa_prepare_access(PixmapPtr pixmap, BoxPtr box,
+				     uxa_access_t access)
 {
 	ScrnInfoPtr scrn = xf86Screens[pixmap->drawable.pScreen->myNum];
 	intel_screen_private *intel = intel_get_screen_private(scrn);
 	struct intel_pixmap *priv = intel_get_pixmap_private(pixmap);
 	dri_bo *bo = priv->bo;
+	intel_access_path_t path;
+	uint64_t start;
+	void *ptr;
 	int ret;
 
 	OS_TRACE_ENTER;
 
-	if (!LIST_IS_EMPTY(&priv->batch) &&
-	    (access == UXA_ACCESS_RW || priv->batch_write))
+	start = emgd_perf_now();
+	if (intel_uxa_access_needs_flush(priv, box, access))
 		intel_batch_submit(scrn);
-
-	assert(bo->size <= intel->max_gtt_map_size);
-	ret = drm_intel_gem_bo_map_gtt(bo);
+	else if (!LIST_IS_EMPTY(&priv->batch))
+		EMGD_PERF_INC(access_flushes_avoided);
+	intel_batch_wait_submitted(scrn);
+
+	if (access == UXA_ACCESS_RW)
+		priv->write_serial++;
+
+	/*
+	 * fb needs a linear view, so tiled pixmaps go through the fence, or
+	 * through a shadow when they don't fit in the aperture.  A small box
+	 * stays on the GTT too: moving the whole bo into the CPU domain to
+	 * touch a few rows costs more than the uncached access.
+	 */
+	path = intel_uxa_access_path(intel, priv, access,
+				     intel_uxa_access_bytes(pixmap, box));
+	if (path == INTEL_ACCESS_CPU) {
+		ret = intel_bo_map_cpu(bo, access == UXA_ACCESS_RW);
+		ptr = bo->virtual;
+	} else if (bo->size > intel->max_gtt_map_size) {
+		/* No shadow for unsupported swizzling or pinned scanout */
+		ret = path == INTEL_ACCESS_TILED ?
+			intel_uxa_prepare_shadow(pixmap, box, access) : -E2BIG;
+		ptr = priv->shadow;
+	} else {
+		ret = intel_bo_map_gtt(bo);
+		ptr = bo->virtual;
+	}
+	EMGD_TRACE(PIXMAP_MIGRATE, bo->handle, bo->size, access,
+		(emgd_perf_now() - start) / 1000);
 	if (ret) {
 		xf86DrvMsg(scrn->scrnIndex, X_WARNING,
 			   "%s: bo map (use gtt? %d, access %d) failed: %s\n",
@@ -706,8 +1338,10 @@ static Bool intel_uxa_prepare_access(PixmapPtr pixmap, uxa_access_t access)
 		return FALSE;
 	}
 
-	pixmap->devPrivate.ptr = bo->virtual;
-	priv->busy = 0;
+	pixmap->devPrivate.ptr = ptr;
+	/* Still busy if the batch has writes to pixels outside box */
+	if (LIST_IS_EMPTY(&priv->batch))
+		priv->busy = 0;
 
 	OS_TRACE_EXIT;
 	return TRUE;
@@ -717,13 +1351,18 @@ static void intel_uxa_finish_access(PixmapPtr pixmap, uxa_access_t access)
 {
 	struct intel_pixmap *priv;
 
-	if (access == UXA_ACCESS_RW || access == UXA_ACCESS_RO)
-		return;
-
 	priv = intel_get_pixmap_private(pixmap);
 	if (priv == NULL)
 		return;
 
+	if (priv->shadow) {
+		intel_uxa_finish_shadow(pixmap);
+		return;
+	}
+
+	if (access == UXA_ACCESS_RW || access == UXA_ACCESS_RO)
+		return;
+
 	drm_intel_gem_bo_unmap_gtt(priv->bo);
 	pixmap->devPrivate.ptr = NULL;
 }
@@ -732,6 +1371,8 @@ static Bool intel_uxa_pixmap_put_image(PixmapPtr pixmap,
 				       char *src, int src_pitch,
 				       int x, int y, int w, int h)
 {
+	ScrnInfoPtr scrn = xf86Screens[pixmap->drawable.pScreen->myNum];
+	intel_screen_private *intel = intel_get_screen_private(scrn);
 	struct intel_pixmap *priv = intel_get_pixmap_private(pixmap);
 	int stride = intel_pixmap_pitch(pixmap);
 	int cpp = pixmap->drawable.bitsPerPixel/8;
@@ -742,12 +1383,25 @@ static Bool intel_uxa_pixmap_put_image(PixmapPtr pixmap,
 	if (priv == NULL || priv->bo == NULL)
 		return FALSE;
 
+	priv->write_serial++;
+
 	if (priv->tiling == I915_TILING_NONE &&
 	    (h == 1 || (src_pitch == stride && w == pixmap->drawable.width))) {
 		ret = drm_intel_bo_subdata(priv->bo, y*stride + x*cpp, stride*(h-1) + w*cpp, src) == 0;
 		OS_TRACE_EXIT;
 		return ret;
-	} else if (drm_intel_gem_bo_map_gtt(priv->bo) == 0) {
+	} else if (priv->tiling != I915_TILING_NONE &&
+		   intel_uxa_access_path(intel, priv, UXA_ACCESS_RW,
+					 (unsigned long)h * stride) == INTEL_ACCESS_TILED) {
+		if (intel_bo_map_cpu(priv->bo, TRUE) == 0) {
+			emgd_tile_rect(priv->bo->virtual, stride,
+				       priv->tiling, priv->swizzle,
+				       src, src_pitch,
+				       x * cpp, y, w * cpp, h);
+			drm_intel_bo_unmap(priv->bo);
+			ret = TRUE;
+		}
+	} else if (intel_bo_map_gtt(priv->bo) == 0) {
 		char *dst = priv->bo->virtual;
 		int row_length = w * cpp;
 		int num_rows = h;
@@ -774,6 +1428,8 @@ static Bool intel_uxa_put_image(PixmapPtr pixmap,
 {
 	struct intel_pixmap *priv;
 
+	intel_batch_wait_submitted(xf86Screens[pixmap->drawable.pScreen->myNum]);
+
 	priv = intel_get_pixmap_private(pixmap);
 	if (!intel_pixmap_is_busy(priv)) {
 		/* bo is not busy so can be replaced without a stall, upload in-place. */
@@ -800,6 +1456,7 @@ static Bool intel_uxa_put_image(PixmapPtr pixmap,
 			bo = drm_intel_bo_alloc(intel->bufmgr, "pixmap", size, 0);
 			if (bo == NULL)
 				return FALSE;
+			EMGD_PERF_INC(bo_allocs);
 
 			if (tiling != I915_TILING_NONE)
 				drm_intel_bo_set_tiling(bo, &tiling, stride);
@@ -857,39 +1514,202 @@ static Bool intel_uxa_pixmap_get_image(PixmapPtr pixmap,
 				       int x, int y, int w, int h,
 				       char *dst, int dst_pitch)
 {
+	ScrnInfoPtr scrn = xf86Screens[pixmap->drawable.pScreen->myNum];
+	intel_screen_private *intel = intel_get_screen_private(scrn);
 	struct intel_pixmap *priv = intel_get_pixmap_private(pixmap);
 	int stride = intel_pixmap_pitch(pixmap);
 	int cpp = pixmap->drawable.bitsPerPixel/8;
+	intel_access_path_t path;
 	Bool ret;
 
 	OS_TRACE_ENTER;
 
-	/* assert(priv->tiling == I915_TILING_NONE); */
-	if (h == 1 || (dst_pitch == stride && w == pixmap->drawable.width)) {
+	if (!LIST_IS_EMPTY(&priv->batch) && priv->batch_write)
+		intel_batch_submit(scrn);
+	intel_batch_wait_submitted(scrn);
+
+	if (priv->tiling == I915_TILING_NONE &&
+	    (h == 1 || (dst_pitch == stride && w == pixmap->drawable.width))) {
 		ret = drm_intel_bo_get_subdata(priv->bo, y*stride + x*cpp, (h-1)*stride + w*cpp, dst) == 0;
 		OS_TRACE_EXIT;
 		return ret;
-	} else {
-		char *src;
+	}
 
-		if (drm_intel_gem_bo_map_gtt(priv->bo)) {
-			OS_TRACE_EXIT;
-		    return FALSE;
-		}
+	path = intel_uxa_access_path(intel, priv, UXA_ACCESS_RO,
+				     (unsigned long)h * stride);
+	if (path == INTEL_ACCESS_GTT)
+		ret = intel_bo_map_gtt(priv->bo);
+	else
+		ret = intel_bo_map_cpu(priv->bo, FALSE);
+	if (ret) {
+		OS_TRACE_EXIT;
+		return FALSE;
+	}
+
+	if (path == INTEL_ACCESS_TILED) {
+		emgd_detile_rect(dst, dst_pitch, priv->bo->virtual, stride,
+				 priv->tiling, priv->swizzle,
+				 x * cpp, y, w * cpp, h);
+		EMGD_PERF_INC(detile_reads);
+	} else {
+		char *src = (char *) priv->bo->virtual + y * stride + x * cpp;
 
-		src = (char *) priv->bo->virtual + y * stride + x * cpp;
 		w *= cpp;
 		do {
 			memcpy(dst, src, w);
 			src += stride;
 			dst += dst_pitch;
 		} while (--h);
+	}
 
+	if (path == INTEL_ACCESS_GTT)
 		drm_intel_gem_bo_unmap_gtt(priv->bo);
+	else
+		drm_intel_bo_unmap(priv->bo);
 
-		OS_TRACE_EXIT;
-		return TRUE;
+	OS_TRACE_EXIT;
+	return TRUE;
+}
+
+/*
+ * GetImage readback through staging pixmaps.
+ *
+ * dix splits GetImage into bands of a few KiB and calls us once per band,
+ * so a screen grab turns into hundreds of small requests for consecutive
+ * rows.  Instead of a blit and a full GPU stall per band, each miss blits
+ * a chunk of up to INTEL_READBACK_CHUNK bytes starting at the band into a
+ * linear staging pixmap.  Following bands are then copied straight out of
+ * its cached CPU mapping.  When a band reaches the end of its chunk, the
+ * next chunk is blitted into the other staging pixmap before copying out,
+ * so the GPU copy overlaps with the CPU one.
+ *
+ * A staging copy stays valid while the source keeps the same bo and its
+ * write_serial does not change.
+ */
+#define INTEL_READBACK_CHUNK	(2 * 1024 * 1024)
+
+static void intel_readback_release(struct intel_readback *rb)
+{
+	if (rb->src_bo) {
+		dri_bo_unreference(rb->src_bo);
+		rb->src_bo = NULL;
+	}
+}
+
+static struct intel_readback *
+intel_readback_lookup(intel_screen_private *intel, struct intel_pixmap *priv,
+		      int x, int y, int w, int h)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(intel->readback); i++) {
+		struct intel_readback *rb = &intel->readback[i];
+
+		if (rb->src_bo != priv->bo ||
+		    rb->src_serial != priv->write_serial)
+			continue;
+
+		if (x >= rb->x && x + w <= rb->x + rb->w &&
+		    y >= rb->y && y + h <= rb->y + rb->h)
+			return rb;
 	}
+
+	return NULL;
+}
+
+/*
+ * Queue a blit of w x h at (x, y) and up to a chunk's worth of the rows
+ * below it into the next staging pixmap, and submit it.
+ */
+static struct intel_readback *
+intel_readback_fill(intel_screen_private *intel, PixmapPtr pixmap,
+		    int x, int y, int w, int h)
+{
+	ScreenPtr screen = pixmap->drawable.pScreen;
+	struct intel_pixmap *priv = intel_get_pixmap_private(pixmap);
+	struct intel_readback *rb;
+	int cpp = pixmap->drawable.bitsPerPixel / 8;
+	int rows;
+	GCPtr gc;
+
+	rows = INTEL_READBACK_CHUNK / (w * cpp);
+	if (rows < h)
+		rows = h;
+	if (rows > pixmap->drawable.height - y)
+		rows = pixmap->drawable.height - y;
+
+	rb = &intel->readback[intel->readback_next];
+	intel->readback_next = (intel->readback_next + 1) % ARRAY_SIZE(intel->readback);
+	intel_readback_release(rb);
+
+	if (rb->pixmap &&
+	    (rb->pixmap->drawable.depth != pixmap->drawable.depth ||
+	     rb->pixmap->drawable.width < w ||
+	     rb->pixmap->drawable.height < rows)) {
+		screen->DestroyPixmap(rb->pixmap);
+		rb->pixmap = NULL;
+	}
+
+	if (rb->pixmap == NULL) {
+		rb->pixmap = screen->CreatePixmap(screen, w, rows,
+						  pixmap->drawable.depth,
+						  INTEL_CREATE_PIXMAP_TILING_NONE);
+		if (rb->pixmap == NULL)
+			return NULL;
+
+		if (!intel_uxa_pixmap_is_offscreen(rb->pixmap)) {
+			screen->DestroyPixmap(rb->pixmap);
+			rb->pixmap = NULL;
+			return NULL;
+		}
+	}
+
+	gc = GetScratchGC(pixmap->drawable.depth, screen);
+	if (!gc)
+		return NULL;
+
+	ValidateGC(&pixmap->drawable, gc);
+	gc->ops->CopyArea(&pixmap->drawable, &rb->pixmap->drawable,
+			  gc, x, y, w, rows, 0, 0);
+	FreeScratchGC(gc);
+
+	intel_batch_submit(xf86Screens[screen->myNum]);
+
+	dri_bo_reference(priv->bo);
+	rb->src_bo = priv->bo;
+	rb->src_serial = priv->write_serial;
+	rb->x = x;
+	rb->y = y;
+	rb->w = w;
+	rb->h = rows;
+
+	return rb;
+}
+
+static Bool intel_readback_copy(struct intel_readback *rb,
+				int x, int y, int w, int h,
+				char *dst, int dst_pitch)
+{
+	PixmapPtr staging = rb->pixmap;
+	dri_bo *bo = intel_get_pixmap_bo(staging);
+	int stride = intel_pixmap_pitch(staging);
+	int cpp = staging->drawable.bitsPerPixel / 8;
+	char *src;
+
+	/* Waits for the blit; the staging bo stays in the CPU domain */
+	if (intel_bo_map_cpu(bo, FALSE))
+		return FALSE;
+
+	src = (char *) bo->virtual + (y - rb->y) * stride + (x - rb->x) * cpp;
+	w *= cpp;
+	do {
+		memcpy(dst, src, w);
+		src += stride;
+		dst += dst_pitch;
+	} while (--h);
+
+	drm_intel_bo_unmap(bo);
+	return TRUE;
 }
 
 static Bool intel_uxa_get_image(PixmapPtr pixmap,
@@ -897,60 +1717,65 @@ static Bool intel_uxa_get_image(PixmapPtr pixmap,
 				int w, int h,
 				char *dst, int dst_pitch)
 {
+	intel_screen_private *intel =
+		intel_get_screen_private(xf86Screens[pixmap->drawable.pScreen->myNum]);
 	struct intel_pixmap *priv;
-	PixmapPtr scratch = NULL;
-	Bool ret;
+	struct intel_readback *rb;
 
 	/* The presumption is that we wish to keep the target hot, so
 	 * copy to a new bo and move that to the CPU in preference to
 	 * causing ping-pong of the original.
 	 *
-	 * Also the gpu is much faster at detiling.
+	 * Also the gpu is much faster at detiling than reads through the
+	 * GTT, unless the pixmap can be detiled from a cached mapping.
 	 */
 
-	priv = intel_get_pixmap_private(pixmap);
-	if (intel_pixmap_is_busy(priv) || priv->tiling != I915_TILING_NONE) {
-		ScreenPtr screen = pixmap->drawable.pScreen;
-		GCPtr gc;
+	intel_batch_wait_submitted(intel->scrn);
 
+	priv = intel_get_pixmap_private(pixmap);
+	rb = intel_readback_lookup(intel, priv, x, y, w, h);
+	if (rb) {
+		EMGD_PERF_INC(readback_hits);
+	} else if (intel_pixmap_is_busy(priv) ||
+		   (priv->tiling != I915_TILING_NONE &&
+		    intel_uxa_access_path(intel, priv, UXA_ACCESS_RO,
+					  (unsigned long)h * intel_pixmap_pitch(pixmap)) != INTEL_ACCESS_TILED)) {
 		/* Copy to a linear buffer and pull.  */
-		scratch = screen->CreatePixmap(screen, w, h,
-					       pixmap->drawable.depth,
-					       INTEL_CREATE_PIXMAP_TILING_NONE);
-		if (!scratch)
-			return FALSE;
-
-		if (!intel_uxa_pixmap_is_offscreen(scratch)) {
-			screen->DestroyPixmap(scratch);
-			return FALSE;
-		}
-
-		gc = GetScratchGC(pixmap->drawable.depth, screen);
-		if (!gc) {
-			screen->DestroyPixmap(scratch);
+		rb = intel_readback_fill(intel, pixmap, x, y, w, h);
+		if (rb == NULL)
 			return FALSE;
-		}
+		EMGD_PERF_INC(readback_misses);
+	} else {
+		return intel_uxa_pixmap_get_image(pixmap, x, y, w, h, dst, dst_pitch);
+	}
 
-		ValidateGC(&pixmap->drawable, gc);
+	/* The next band won't fit: start fetching it before copying this one */
+	if (y + 2 * h > rb->y + rb->h && rb->y + rb->h < pixmap->drawable.height &&
+	    &intel->readback[intel->readback_next] != rb)
+		intel_readback_fill(intel, pixmap, rb->x, y + h, rb->w, h);
 
-		gc->ops->CopyArea(&pixmap->drawable,
-				  &scratch->drawable,
-				  gc, x, y, w, h, 0, 0);
+	intel_batch_wait_submitted(intel->scrn);
+	return intel_readback_copy(rb, x, y, w, h, dst, dst_pitch);
+}
 
-		FreeScratchGC(gc);
+/*
+ * Release the GetImage staging pixmaps.
+ */
+void intel_uxa_fini(ScreenPtr screen)
+{
+	intel_screen_private *intel =
+		intel_get_screen_private(xf86Screens[screen->myNum]);
+	int i;
 
-		intel_batch_submit(xf86Screens[screen->myNum]);
+	for (i = 0; i < ARRAY_SIZE(intel->readback); i++) {
+		struct intel_readback *rb = &intel->readback[i];
 
-		x = y = 0;
-		pixmap = scratch;
+		intel_readback_release(rb);
+		if (rb->pixmap) {
+			screen->DestroyPixmap(rb->pixmap);
+			rb->pixmap = NULL;
+		}
 	}
-
-	ret = intel_uxa_pixmap_get_image(pixmap, x, y, w, h, dst, dst_pitch);
-
-	if (scratch)
-		scratch->drawable.pScreen->DestroyPixmap(scratch);
-
-	return ret;
 }
 
 static CARD32 intel_cache_expire(OsTimerPtr timer, CARD32 now, pointer data)
@@ -977,6 +1802,7 @@ static void intel_flush_rendering(intel_screen_private *intel)
 
 	if (intel->has_kernel_flush) {
 		intel_batch_submit(intel->scrn);
+		intel_batch_wait_submitted(intel->scrn);
 		drm_intel_bo_busy(intel->front_buffer);
 	} else {
 		intel_batch_emit_flush(intel->scrn);
@@ -1095,6 +1921,7 @@ intel_uxa_create_pixmap(ScreenPtr screen, int w, int h, int depth,
 				}
 
 				LIST_DEL(&priv->in_flight);
+				EMGD_PERF_INC(bo_cache_hits);
 				screen->ModifyPixmapHeader(pixmap, w, h, 0, 0, stride, NULL);
 				intel_set_pixmap_private(pixmap, priv);
 				return pixmap;
@@ -1122,6 +1949,7 @@ intel_uxa_create_pixmap(ScreenPtr screen, int w, int h, int depth,
 			fbDestroyPixmap(pixmap);
 			return NullPixmap;
 		}
+		EMGD_PERF_INC(bo_allocs);
 
 		if (tiling != I915_TILING_NONE)
 			drm_intel_bo_set_tiling(priv->bo, &tiling, stride);
@@ -1141,8 +1969,11 @@ intel_uxa_create_pixmap(ScreenPtr screen, int w, int h, int depth,
 
 static Bool intel_uxa_destroy_pixmap(PixmapPtr pixmap)
 {
-	if (pixmap->refcnt == 1)
+	if (pixmap->refcnt == 1) {
+		/* A GLX pixmap's cached DRI2 buffers go with it */
+		emgd_dri2_cache_drop(&pixmap->drawable);
 		intel_set_pixmap_bo(pixmap, NULL);
+	}
 	fbDestroyPixmap(pixmap);
 	return TRUE;
 }
@@ -1238,6 +2069,77 @@ intel_limits_init(intel_screen_private *intel)
 	OS_TRACE_EXIT;
 }
 
+/* UXA_COUNT_FALLBACK_* to the matching emgd_perf.fallbacks[] slot */
+static const int intel_uxa_fallback_counter[UXA_COUNT_NUM_FALLBACKS] = {
+	[UXA_COUNT_FALLBACK_FILL_SPANS] = EMGD_PERF_FALLBACK_FILL_SPANS,
+	[UXA_COUNT_FALLBACK_SET_SPANS] = EMGD_PERF_FALLBACK_SET_SPANS,
+	[UXA_COUNT_FALLBACK_PUT_IMAGE] = EMGD_PERF_FALLBACK_PUT_IMAGE,
+	[UXA_COUNT_FALLBACK_COPY_AREA] = EMGD_PERF_FALLBACK_COPY_AREA,
+	[UXA_COUNT_FALLBACK_COPY_PLANE] = EMGD_PERF_FALLBACK_COPY_PLANE,
+	[UXA_COUNT_FALLBACK_POLY_POINT] = EMGD_PERF_FALLBACK_POLY_POINT,
+	[UXA_COUNT_FALLBACK_POLY_LINES] = EMGD_PERF_FALLBACK_POLY_LINES,
+	[UXA_COUNT_FALLBACK_POLY_SEGMENT] = EMGD_PERF_FALLBACK_POLY_SEGMENT,
+	[UXA_COUNT_FALLBACK_POLY_ARC] = EMGD_PERF_FALLBACK_POLY_ARC,
+	[UXA_COUNT_FALLBACK_POLY_FILL_RECT] = EMGD_PERF_FALLBACK_POLY_FILL_RECT,
+	[UXA_COUNT_FALLBACK_IMAGE_GLYPH_BLT] = EMGD_PERF_FALLBACK_IMAGE_GLYPH_BLT,
+	[UXA_COUNT_FALLBACK_POLY_GLYPH_BLT] = EMGD_PERF_FALLBACK_POLY_GLYPH_BLT,
+	[UXA_COUNT_FALLBACK_PUSH_PIXELS] = EMGD_PERF_FALLBACK_PUSH_PIXELS,
+	[UXA_COUNT_FALLBACK_GET_SPANS] = EMGD_PERF_FALLBACK_GET_SPANS,
+	[UXA_COUNT_FALLBACK_COMPOSITE] = EMGD_PERF_FALLBACK_COMPOSITE,
+	[UXA_COUNT_FALLBACK_ADD_TRAPS] = EMGD_PERF_FALLBACK_ADD_TRAPS,
+};
+
+/*
+ * uxa_driver_t count hook: UXA reports its fallbacks and cache behaviour
+ * here, and they end up in the counters read by EMGD_CONTROL_GET_PERF_COUNTERS.
+ */
+static void intel_uxa_count(ScreenPtr screen, int event)
+{
+	if (event < UXA_COUNT_NUM_FALLBACKS) {
+		emgd_perf.fallbacks[intel_uxa_fallback_counter[event]]++;
+		return;
+	}
+
+	switch (event) {
+	case UXA_COUNT_GLYPH_CACHE_HIT:
+		EMGD_PERF_INC(glyph_cache_hits);
+		break;
+	case UXA_COUNT_GLYPH_CACHE_MISS:
+		EMGD_PERF_INC(glyph_cache_misses);
+		break;
+	case UXA_COUNT_SOLID_CACHE_HIT:
+		EMGD_PERF_INC(solid_cache_hits);
+		break;
+	case UXA_COUNT_SOLID_CACHE_MISS:
+		EMGD_PERF_INC(solid_cache_misses);
+		break;
+	case UXA_COUNT_CORE_TEXT:
+		EMGD_PERF_INC(core_text_strings);
+		break;
+	}
+}
+
+/*
+ * uxa_driver_t copy_window_damage hook: a window move or scroll, as the
+ * boxes it copied.  Only counted: ShadowFB and TearFB are forced off, so
+ * nothing downstream has to repeat the move.
+ */
+static void intel_uxa_copy_window_damage(PixmapPtr pixmap, RegionPtr region,
+					 int dx, int dy)
+{
+	BoxPtr box = REGION_RECTS(region);
+	int n = REGION_NUM_RECTS(region);
+	uint64_t pixels = 0;
+
+	EMGD_PERF_ADD(copy_window_blits, n);
+	while (n--) {
+		pixels += (uint64_t)(box->x2 - box->x1) * (box->y2 - box->y1);
+		box++;
+	}
+	EMGD_PERF_ADD(copy_window_bytes,
+		      pixels * pixmap->drawable.bitsPerPixel / 8);
+}
+
 Bool intel_uxa_init(ScreenPtr screen)
 {
 	ScrnInfoPtr scrn = xf86Screens[screen->myNum];
@@ -1290,9 +2192,17 @@ Bool intel_uxa_init(ScreenPtr screen)
 	intel->uxa_driver->copy = intel_uxa_copy;
 	intel->uxa_driver->done_copy = intel_uxa_done;
 
+	/* Mono expansion */
+	intel->uxa_driver->check_mono = intel_uxa_check_mono;
+	intel->uxa_driver->prepare_mono = intel_uxa_prepare_mono;
+	intel->uxa_driver->mono = intel_uxa_mono;
+	intel->uxa_driver->mono_pattern = intel_uxa_mono_pattern;
+	intel->uxa_driver->done_mono = intel_uxa_done;
+
 	/* Composite */
 	intel->uxa_driver->check_composite = i965_check_composite;
 	intel->uxa_driver->check_composite_texture = i965_check_composite_texture;
+	intel->uxa_driver->check_texture_format = i965_check_texture_format;
 	intel->uxa_driver->prepare_composite = i965_prepare_composite;
 	intel->uxa_driver->composite = i965_composite;
 	intel->uxa_driver->done_composite = i830_done_composite;
@@ -1309,6 +2219,8 @@ Bool intel_uxa_init(ScreenPtr screen)
 	intel->uxa_driver->prepare_access = intel_uxa_prepare_access;
 	intel->uxa_driver->finish_access = intel_uxa_finish_access;
 	intel->uxa_driver->pixmap_is_offscreen = intel_uxa_pixmap_is_offscreen;
+	intel->uxa_driver->count = intel_uxa_count;
+	intel->uxa_driver->copy_window_damage = intel_uxa_copy_window_damage;
 
 	screen->CreatePixmap = intel_uxa_create_pixmap;
 	screen->DestroyPixmap = intel_uxa_destroy_pixmap;
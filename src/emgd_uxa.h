@@ -36,6 +36,7 @@
 #include <i915_drm.h>
 #include <intel_bufmgr.h>
 #include <list.h>
+#include "emgd_perf.h"
 
 /*
  * OTC's UXA code (which we use as-is) assumes different names for several
@@ -61,10 +62,30 @@ typedef struct _emgd_pixmap {
 
 	struct LIST flush, batch, in_flight;
 
+	/* Bounding box of the writes queued in the current batch */
+	BoxRec batch_damage;
+
+	/* Bumped on every CPU or GPU write, for cached readbacks */
+	uint32_t write_serial;
+
+	/*
+	 * Linear copy that fb works on while it accesses a tiled bo too large
+	 * for the GTT.  Rows shadow_y1 to shadow_y2 hold the bo's pixels;
+	 * shadow_damage bounds what RW accesses may have changed.
+	 */
+	void *shadow;
+	BoxRec shadow_damage;
+	int16_t shadow_y1, shadow_y2;
+	uint8_t shadow_users;
+
 	uint16_t stride;
 	uint8_t tiling;
+	uint8_t swizzle;
 	int8_t busy :2;
 	int8_t batch_write :1;
+	int8_t batch_read :1;	/* Read (not as a destination) by the batch */
+	uint8_t ring_write;	/* 1 << ring of each pending batch writing it */
+	uint8_t ring_read;	/* ... and of each one reading it */
 	int8_t offscreen :1;
 	int8_t pinned :1;
 } emgd_pixmap_t;
@@ -81,6 +102,77 @@ static inline Bool intel_pixmap_is_busy(struct intel_pixmap *priv)
 	return priv->busy;
 }
 
+/*
+ * GPU writes are tracked at this granularity so that CPU access to pixels
+ * outside the damage never shares a cache line or OWord with them.
+ */
+#define INTEL_DAMAGE_ALIGN	32
+
+/*
+ * Record a GPU write to the pixmap queued in the current batch.  Every
+ * operation that marks a pixmap as written by the batch must report the
+ * area it writes, as intel_uxa_prepare_access() relies on it to decide
+ * whether the batch has to be flushed.
+ */
+static inline void intel_pixmap_add_damage(struct intel_pixmap *priv,
+					   int x1, int y1, int x2, int y2)
+{
+	BoxPtr damage = &priv->batch_damage;
+
+	x1 &= ~(INTEL_DAMAGE_ALIGN - 1);
+	y1 &= ~(INTEL_DAMAGE_ALIGN - 1);
+	x2 = ALIGN(x2, INTEL_DAMAGE_ALIGN);
+	y2 = ALIGN(y2, INTEL_DAMAGE_ALIGN);
+
+	if (damage->x1 >= damage->x2 || damage->y1 >= damage->y2) {
+		damage->x1 = x1;
+		damage->y1 = y1;
+		damage->x2 = x2;
+		damage->y2 = y2;
+		return;
+	}
+
+	if (x1 < damage->x1)
+		damage->x1 = x1;
+	if (y1 < damage->y1)
+		damage->y1 = y1;
+	if (x2 > damage->x2)
+		damage->x2 = x2;
+	if (y2 > damage->y2)
+		damage->y2 = y2;
+}
+
+/*
+ * Map a bo through the GTT for CPU access, accounting the time spent
+ * (including any stall waiting for the GPU) in the performance counters.
+ */
+static inline int intel_bo_map_gtt(drm_intel_bo *bo)
+{
+	uint64_t start = emgd_perf_now();
+	int ret;
+
+	ret = drm_intel_gem_bo_map_gtt(bo);
+	EMGD_PERF_INC(gtt_maps);
+	EMGD_PERF_ADD(gtt_map_ns, emgd_perf_now() - start);
+	return ret;
+}
+
+/*
+ * Map a bo through a cached CPU mapping.  This moves the bo to the CPU
+ * domain, so on parts without a shared LLC the whole object is clflushed
+ * now and again when the GPU next uses it.
+ */
+static inline int intel_bo_map_cpu(drm_intel_bo *bo, int write_enable)
+{
+	uint64_t start = emgd_perf_now();
+	int ret;
+
+	ret = drm_intel_bo_map(bo, write_enable);
+	EMGD_PERF_INC(cpu_maps);
+	EMGD_PERF_ADD(cpu_map_ns, emgd_perf_now() - start);
+	return ret;
+}
+
 static inline void intel_set_pixmap_private(PixmapPtr pixmap, struct intel_pixmap *intel)
 {
 	dixSetPrivate(&pixmap->devPrivates, &uxa_pixmap_index, intel);
@@ -132,6 +224,7 @@ Bool i965_check_composite(int op,
 			  PicturePtr sourcec, PicturePtr mask, PicturePtr dest,
 			  int width, int height);
 Bool i965_check_composite_texture(ScreenPtr screen, PicturePtr picture);
+Bool i965_check_texture_format(ScreenPtr screen, pixman_format_code_t format);
 Bool i965_prepare_composite(int op, PicturePtr sourcec, PicturePtr mask,
 				PicturePtr dest, PixmapPtr sourcecPixmap,
 				PixmapPtr maskPixmap, PixmapPtr destPixmap);
@@ -260,8 +353,11 @@ static inline Bool pixmap_is_scanout(PixmapPtr pixmap)
 const OptionInfoRec *intel_uxa_available_options(int chipid, int busid);
 
 Bool intel_uxa_init(ScreenPtr pScreen);
+void intel_uxa_fini(ScreenPtr pScreen);
 Bool intel_uxa_create_screen_resources(ScreenPtr pScreen);
 void intel_uxa_block_handler(emgd_priv_t *intel);
+Bool intel_check_aperture(emgd_priv_t *intel, drm_intel_bo **bo_table,
+			  int num_bos);
 Bool intel_get_aperture_space(ScrnInfoPtr scrn, drm_intel_bo ** bo_table,
 				  int num_bos);
 
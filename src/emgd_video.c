@@ -39,6 +39,8 @@
 #include "emgd_video.h"
 #include "emgd_sprite.h"
 #include "emgd_uxa.h"
+#include "intel_batchbuffer.h"
+#include "emgd_trace.h"
 
 #define USE_OVERLAY  0
 
@@ -1197,7 +1199,9 @@ static int copy_to_emgd_vid_mem(
 		}
 	}
 
-	/* map the destination surface into the GTT */
+	/* map the destination surface into the GTT; the last frame may still
+	 * be queued for the submission thread */
+	intel_batch_wait_submitted(scrn);
 	if (drm_intel_gem_bo_map_gtt(priv->buf)) {
 		return 0;
 	}
@@ -1696,6 +1700,8 @@ int emgd_overlay_put_image(
 
 		/* Tag out status as "VIDEO_ON"*/
 		xv_priv->video_status |= CLIENT_VIDEO_ON;
+		EMGD_PERF_INC(xv_overlay_frames);
+		EMGD_TRACE(XV_FRAME, EMGD_TRACE_XV_OVERLAY, id, width, height);
 	}
 
 	/* If everything go well, then record down the buffer that is currently been use. */
@@ -1787,8 +1793,12 @@ static int emgd_blend_put_image(
 			src_w, src_h,
 			drw_w, drw_h, dest);
 
+	/* The video shaders don't go through the pixmap domain tracking */
+	intel_get_pixmap_private(dest)->write_serial++;
 
 	DamageDamageRegion(pDraw, clipBoxes);
+	EMGD_PERF_INC(xv_blend_frames);
+	EMGD_TRACE(XV_FRAME, EMGD_TRACE_XV_BLEND, id, width, height);
 
 	OS_TRACE_EXIT;
 	return Success;
@@ -94,11 +94,17 @@
 #define XY_MONO_PAT_HORT_SEED		((1<<14)|(1<<13)|(1<<12))
 #define XY_MONO_PAT_BLT_WRITE_ALPHA	(1<<21)
 #define XY_MONO_PAT_BLT_WRITE_RGB	(1<<20)
+#define XY_MONO_PAT_BLT_TILED		(1<<11)
 
 #define XY_MONO_SRC_BLT_CMD		((0x2<<29)|(0x54<<22)|(0x6))
 #define XY_MONO_SRC_BLT_WRITE_ALPHA	(1<<21)
 #define XY_MONO_SRC_BLT_WRITE_RGB	(1<<20)
 
+#define XY_MONO_SRC_IMM_BLT_CMD		((0x2<<29)|(0x71<<22))
+#define XY_MONO_SRC_IMM_BLT_WRITE_ALPHA	(1<<21)
+#define XY_MONO_SRC_IMM_BLT_WRITE_RGB	(1<<20)
+#define XY_MONO_SRC_IMM_BLT_TILED	(1<<11)
+
 #define CMD_3D (0x3<<29)
 
 #define PRIM3D_INLINE		(CMD_3D | (0x1f<<24))
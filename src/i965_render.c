@@ -91,6 +91,12 @@ static const struct blendinfo {
  */
 #define BRW_BLENDFACTOR_COUNT (BRW_BLENDFACTOR_INV_DST_ALPHA + 1)
 
+/**
+ * Gen6+ blend states also cover the dual-source factors used for
+ * component alpha with source alpha and source value blending.
+ */
+#define GEN6_BLENDFACTOR_COUNT (BRW_BLENDFACTOR_INV_SRC1_COLOR + 1)
+
 /* FIXME: surface format defined in brw_defines.h, shared Sampling engine
  * 1.7.2
  */
@@ -106,15 +112,28 @@ static const struct formatinfo {
 	{PICT_r8g8b8, BRW_SURFACEFORMAT_R8G8B8_UNORM},
 	{PICT_r5g6b5, BRW_SURFACEFORMAT_B5G6R5_UNORM},
 	{PICT_a1r5g5b5, BRW_SURFACEFORMAT_B5G5R5A1_UNORM},
+	{PICT_x1r5g5b5, BRW_SURFACEFORMAT_B5G5R5X1_UNORM},
 #if XORG_VERSION_CURRENT >= 10699900
 	{PICT_a2r10g10b10, BRW_SURFACEFORMAT_B10G10R10A2_UNORM},
 	{PICT_x2r10g10b10, BRW_SURFACEFORMAT_B10G10R10X2_UNORM},
 	{PICT_a2b10g10r10, BRW_SURFACEFORMAT_R10G10B10A2_UNORM},
-	{PICT_x2r10g10b10, BRW_SURFACEFORMAT_B10G10R10X2_UNORM},
+	/* No R10G10B10X2_UNORM: x2b10g10r10 sources are converted */
 #endif
 	{PICT_a4r4g4b4, BRW_SURFACEFORMAT_B4G4R4A4_UNORM},
 };
 
+/*
+ * Component alpha that needs both the source alpha and the source value.
+ * Gen6+ feeds the mask times source alpha to the blender as a second
+ * source; older chips can't do it in a single pass.
+ */
+static Bool i965_blend_needs_dual_source(int op, PicturePtr mask)
+{
+	return mask && mask->componentAlpha && PICT_FORMAT_RGB(mask->format) &&
+		i965_blend_op[op].src_alpha &&
+		i965_blend_op[op].src_blend != BRW_BLENDFACTOR_ZERO;
+}
+
 static void i965_get_blend_cntl(int op, PicturePtr mask, uint32_t dst_format,
 				uint32_t * sblend, uint32_t * dblend)
 {
@@ -134,9 +153,16 @@ static void i965_get_blend_cntl(int op, PicturePtr mask, uint32_t dst_format,
 
 	/* If the source alpha is being used, then we should only be in a case where
 	 * the source blend factor is 0, and the source blend value is the mask
-	 * channels multiplied by the source picture's alpha.
+	 * channels multiplied by the source picture's alpha.  When the source
+	 * value is needed as well, that product is the second source output.
 	 */
-	if (mask && mask->componentAlpha && PICT_FORMAT_RGB(mask->format)
+	if (i965_blend_needs_dual_source(op, mask)) {
+		if (*dblend == BRW_BLENDFACTOR_SRC_ALPHA) {
+			*dblend = BRW_BLENDFACTOR_SRC1_COLOR;
+		} else if (*dblend == BRW_BLENDFACTOR_INV_SRC_ALPHA) {
+			*dblend = BRW_BLENDFACTOR_INV_SRC1_COLOR;
+		}
+	} else if (mask && mask->componentAlpha && PICT_FORMAT_RGB(mask->format)
 	    && i965_blend_op[op].src_alpha) {
 		if (*dblend == BRW_BLENDFACTOR_SRC_ALPHA) {
 			*dblend = BRW_BLENDFACTOR_SRC_COLOR;
@@ -160,6 +186,9 @@ static uint32_t i965_get_dest_format(PicturePtr dest_picture)
 	case PICT_a2r10g10b10:
 	case PICT_x2r10g10b10:
 		return BRW_SURFACEFORMAT_B10G10R10A2_UNORM;
+	case PICT_a2b10g10r10:
+	case PICT_x2b10g10r10:
+		return BRW_SURFACEFORMAT_R10G10B10A2_UNORM;
 #endif
 	case PICT_r5g6b5:
 		return BRW_SURFACEFORMAT_B5G6R5_UNORM;
@@ -209,20 +238,17 @@ i965_check_composite(int op,
 		return FALSE;
 	}
 
-	if (mask_picture && mask_picture->componentAlpha &&
-	    PICT_FORMAT_RGB(mask_picture->format)) {
-		/* Check if it's component alpha that relies on a source alpha and on
-		 * the source value.  We can only get one of those into the single
-		 * source value that we get to blend with.
-		 */
-		if (i965_blend_op[op].src_alpha &&
-		    (i965_blend_op[op].src_blend != BRW_BLENDFACTOR_ZERO)) {
-			intel_debug_fallback(scrn,
-					     "Component alpha not supported "
-					     "with source alpha and source "
-					     "value blending.\n");
-			return FALSE;
-		}
+	/* Check if it's component alpha that relies on a source alpha and on
+	 * the source value.  Before gen6 we can only get one of those into the
+	 * single source value that we get to blend with.
+	 */
+	if (INTEL_INFO(intel)->gen < 60 &&
+	    i965_blend_needs_dual_source(op, mask_picture)) {
+		intel_debug_fallback(scrn,
+				     "Component alpha not supported "
+				     "with source alpha and source "
+				     "value blending.\n");
+		return FALSE;
 	}
 
 	if (i965_get_dest_format(dest_picture) == -1) {
@@ -254,7 +280,7 @@ i965_check_composite_texture(ScreenPtr screen, PicturePtr picture)
 	}
 
 	if (picture->pDrawable) {
-		int w, h, i;
+		int w, h;
 
 		w = picture->pDrawable->width;
 		h = picture->pDrawable->height;
@@ -266,14 +292,7 @@ i965_check_composite_texture(ScreenPtr screen, PicturePtr picture)
 			return FALSE;
 		}
 
-		for (i = 0;
-		     i < sizeof(i965_tex_formats) / sizeof(i965_tex_formats[0]);
-		     i++) {
-			if (i965_tex_formats[i].fmt == picture->format)
-				break;
-		}
-		if (i == sizeof(i965_tex_formats) / sizeof(i965_tex_formats[0]))
-		{
+		if (!i965_check_texture_format(screen, picture->format)) {
 			ScrnInfoPtr scrn = xf86Screens[screen->myNum];
 			intel_debug_fallback(scrn,
 					     "Unsupported picture format "
@@ -288,6 +307,21 @@ i965_check_composite_texture(ScreenPtr screen, PicturePtr picture)
 	return FALSE;
 }
 
+Bool
+i965_check_texture_format(ScreenPtr screen, pixman_format_code_t format)
+{
+	int i;
+
+	for (i = 0;
+	     i < sizeof(i965_tex_formats) / sizeof(i965_tex_formats[0]);
+	     i++) {
+		if (i965_tex_formats[i].fmt == format)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
 
 #define BRW_GRF_BLOCKS(nreg)    ((nreg + 15) / 16 - 1)
 
@@ -556,6 +590,26 @@ static const uint32_t ps_kernel_masknoca_projective_static_gen6[][4] = {
 #include "exa_wm_write.g6b"
 };
 
+static const uint32_t ps_kernel_maskca_dual_affine_static_gen6[][4] = {
+#include "exa_wm_src_affine.g6b"
+#include "exa_wm_src_sample_argb.g6b"
+#include "exa_wm_mask_affine.g6b"
+#include "exa_wm_mask_sample_argb.g6b"
+#include "exa_wm_ca_dual.g6b"
+#include "exa_wm_ca.g6b"
+#include "exa_wm_write_dual.g6b"
+};
+
+static const uint32_t ps_kernel_maskca_dual_projective_static_gen6[][4] = {
+#include "exa_wm_src_projective.g6b"
+#include "exa_wm_src_sample_argb.g6b"
+#include "exa_wm_mask_projective.g6b"
+#include "exa_wm_mask_sample_argb.g6b"
+#include "exa_wm_ca_dual.g6b"
+#include "exa_wm_ca.g6b"
+#include "exa_wm_write_dual.g6b"
+};
+
 /* programs for GEN7 */
 static const uint32_t ps_kernel_nomask_affine_static_gen7[][4] = {
 #include "exa_wm_src_affine.g7b"
@@ -623,6 +677,26 @@ static const uint32_t ps_kernel_masknoca_projective_static_gen7[][4] = {
 #include "exa_wm_write.g7b"
 };
 
+static const uint32_t ps_kernel_maskca_dual_affine_static_gen7[][4] = {
+#include "exa_wm_src_affine.g7b"
+#include "exa_wm_src_sample_argb.g7b"
+#include "exa_wm_mask_affine.g7b"
+#include "exa_wm_mask_sample_argb.g7b"
+#include "exa_wm_ca_dual.g6b"
+#include "exa_wm_ca.g6b"
+#include "exa_wm_write_dual.g7b"
+};
+
+static const uint32_t ps_kernel_maskca_dual_projective_static_gen7[][4] = {
+#include "exa_wm_src_projective.g7b"
+#include "exa_wm_src_sample_argb.g7b"
+#include "exa_wm_mask_projective.g7b"
+#include "exa_wm_mask_sample_argb.g7b"
+#include "exa_wm_ca_dual.g6b"
+#include "exa_wm_ca.g6b"
+#include "exa_wm_write_dual.g7b"
+};
+
 
 typedef enum {
 	SS_INVALID_FILTER = -1,
@@ -649,6 +723,8 @@ typedef enum {
 	WM_KERNEL_MASKCA_SRCALPHA_PROJECTIVE,
 	WM_KERNEL_MASKNOCA_AFFINE,
 	WM_KERNEL_MASKNOCA_PROJECTIVE,
+	WM_KERNEL_MASKCA_DUAL_AFFINE,
+	WM_KERNEL_MASKCA_DUAL_PROJECTIVE,
 	KERNEL_COUNT
 } wm_kernel_t;
 
@@ -677,6 +753,11 @@ static const struct wm_kernel_info wm_kernels_gen4[] = {
 	       ps_kernel_masknoca_affine_static, TRUE),
 	KERNEL(WM_KERNEL_MASKNOCA_PROJECTIVE,
 	       ps_kernel_masknoca_projective_static, TRUE),
+	/* No dual-source blending; never selected */
+	KERNEL(WM_KERNEL_MASKCA_DUAL_AFFINE,
+	       ps_kernel_maskca_affine_static, TRUE),
+	KERNEL(WM_KERNEL_MASKCA_DUAL_PROJECTIVE,
+	       ps_kernel_maskca_projective_static, TRUE),
 };
 
 static const struct wm_kernel_info wm_kernels_gen5[] = {
@@ -696,6 +777,11 @@ static const struct wm_kernel_info wm_kernels_gen5[] = {
 	       ps_kernel_masknoca_affine_static_gen5, TRUE),
 	KERNEL(WM_KERNEL_MASKNOCA_PROJECTIVE,
 	       ps_kernel_masknoca_projective_static_gen5, TRUE),
+	/* No dual-source blending; never selected */
+	KERNEL(WM_KERNEL_MASKCA_DUAL_AFFINE,
+	       ps_kernel_maskca_affine_static_gen5, TRUE),
+	KERNEL(WM_KERNEL_MASKCA_DUAL_PROJECTIVE,
+	       ps_kernel_maskca_projective_static_gen5, TRUE),
 };
 
 static const struct wm_kernel_info wm_kernels_gen6[] = {
@@ -715,6 +801,10 @@ static const struct wm_kernel_info wm_kernels_gen6[] = {
 	       ps_kernel_masknoca_affine_static_gen6, TRUE),
 	KERNEL(WM_KERNEL_MASKNOCA_PROJECTIVE,
 	       ps_kernel_masknoca_projective_static_gen6, TRUE),
+	KERNEL(WM_KERNEL_MASKCA_DUAL_AFFINE,
+	       ps_kernel_maskca_dual_affine_static_gen6, TRUE),
+	KERNEL(WM_KERNEL_MASKCA_DUAL_PROJECTIVE,
+	       ps_kernel_maskca_dual_projective_static_gen6, TRUE),
 };
 
 static const struct wm_kernel_info wm_kernels_gen7[] = {
@@ -734,6 +824,10 @@ static const struct wm_kernel_info wm_kernels_gen7[] = {
 	       ps_kernel_masknoca_affine_static_gen7, TRUE),
 	KERNEL(WM_KERNEL_MASKNOCA_PROJECTIVE,
 	       ps_kernel_masknoca_projective_static_gen7, TRUE),
+	KERNEL(WM_KERNEL_MASKCA_DUAL_AFFINE,
+	       ps_kernel_maskca_dual_affine_static_gen7, TRUE),
+	KERNEL(WM_KERNEL_MASKCA_DUAL_PROJECTIVE,
+	       ps_kernel_maskca_dual_projective_static_gen7, TRUE),
 };
 
 #undef KERNEL
@@ -1343,12 +1437,11 @@ gen4_set_picture_surface_state(intel_screen_private *intel,
 	ss->ss3.tile_walk = 0;	/* Tiled X */
 	ss->ss3.tiled_surface = intel_pixmap_tiled(pixmap) ? 1 : 0;
 
-	dri_bo_emit_reloc(intel->surface_bo,
-			  read_domains, write_domain,
-			  0,
-			  intel->surface_used +
-			  offsetof(struct brw_surface_state, ss1),
-			  priv->bo);
+	intel_batch_emit_state_reloc(intel, intel->surface_bo,
+				     intel->surface_used +
+				     offsetof(struct brw_surface_state, ss1),
+				     priv->bo, 0,
+				     read_domains, write_domain);
 
 	offset = intel->surface_used;
 	intel->surface_used += SURFACE_STATE_PADDED_SIZE;
@@ -1397,12 +1490,11 @@ gen7_set_picture_surface_state(intel_screen_private *intel,
 	ss->ss2.width = pixmap->drawable.width - 1;
 	ss->ss3.pitch = intel_pixmap_pitch(pixmap) - 1;
 
-	dri_bo_emit_reloc(intel->surface_bo,
-			  read_domains, write_domain,
-			  0,
-			  intel->surface_used +
-			  offsetof(struct gen7_surface_state, ss1),
-			  priv->bo);
+	intel_batch_emit_state_reloc(intel, intel->surface_bo,
+				     intel->surface_used +
+				     offsetof(struct gen7_surface_state, ss1),
+				     priv->bo, 0,
+				     read_domains, write_domain);
 
 	offset = intel->surface_used;
 	intel->surface_used += SURFACE_STATE_PADDED_SIZE;
@@ -1713,13 +1805,15 @@ static void i965_emit_composite_state(struct intel_screen_private *intel)
 }
 
 /**
- * Returns whether the current set of composite state plus vertex buffer is
- * expected to fit in the aperture.
+ * Returns whether the current set of composite state, vertex buffer and
+ * pixmaps is expected to fit in the aperture.  The mask comes last so
+ * that it can be left out of the table when there is none.
  */
 static Bool i965_composite_check_aperture(intel_screen_private *intel)
 {
 	struct gen4_render_state *render_state = intel->gen4_render_state;
 	gen4_composite_op *composite_op = &render_state->composite_op;
+	int no_mask = intel->render_mask == NULL;
 	drm_intel_bo *bo_table[] = {
 		intel->batch_bo,
 		intel->vertex_bo,
@@ -1733,6 +1827,9 @@ static Bool i965_composite_check_aperture(intel_screen_private *intel)
 		    [composite_op->mask_filter]
 		    [composite_op->mask_extend],
 		render_state->cc_state_bo,
+		intel_get_pixmap_bo(intel->render_dest),
+		intel_get_pixmap_bo(intel->render_source),
+		no_mask ? NULL : intel_get_pixmap_bo(intel->render_mask),
 	};
 	drm_intel_bo *gen6_bo_table[] = {
 		intel->batch_bo,
@@ -1747,14 +1844,17 @@ static Bool i965_composite_check_aperture(intel_screen_private *intel)
 		render_state->cc_state_bo,
 		render_state->gen6_blend_bo,
 		render_state->gen6_depth_stencil_bo,
+		intel_get_pixmap_bo(intel->render_dest),
+		intel_get_pixmap_bo(intel->render_source),
+		no_mask ? NULL : intel_get_pixmap_bo(intel->render_mask),
 	};
 
 	if (INTEL_INFO(intel)->gen >= 60)
-		return drm_intel_bufmgr_check_aperture_space(gen6_bo_table,
-							ARRAY_SIZE(gen6_bo_table)) == 0;
+		return intel_check_aperture(intel, gen6_bo_table,
+					    ARRAY_SIZE(gen6_bo_table) - no_mask);
 	else
-		return drm_intel_bufmgr_check_aperture_space(bo_table,
-							ARRAY_SIZE(bo_table)) == 0;
+		return intel_check_aperture(intel, bo_table,
+					    ARRAY_SIZE(bo_table) - no_mask);
 }
 
 static void i965_surface_flush(struct intel_screen_private *intel)
@@ -1769,6 +1869,10 @@ static void i965_surface_flush(struct intel_screen_private *intel)
 				intel->surface_reloc * 4,
 				intel->surface_bo, BASE_ADDRESS_MODIFY,
 				I915_GEM_DOMAIN_INSTRUCTION, 0);
+	if (intel->capture)
+		emgd_capture_reloc(intel->capture, intel->surface_bo,
+				   intel->surface_reloc * 4, BASE_ADDRESS_MODIFY,
+				   I915_GEM_DOMAIN_INSTRUCTION, 0);
 	intel->surface_reloc = 0;
 
 	drm_intel_bo_unreference(intel->surface_bo);
@@ -2032,20 +2136,13 @@ i965_prepare_composite(int op, PicturePtr source_picture,
 	}
 
 	if (mask_picture) {
-		if (mask_picture->componentAlpha &&
-		    PICT_FORMAT_RGB(mask_picture->format)) {
-			/* Check if it's component alpha that relies on a source alpha and on
-			 * the source value.  We can only get one of those into the single
-			 * source value that we get to blend with.
-			 */
-			if (i965_blend_op[op].src_alpha &&
-			    (i965_blend_op[op].src_blend != BRW_BLENDFACTOR_ZERO)) {
-				intel_debug_fallback(scrn,
-						     "Component alpha not supported "
-						     "with source alpha and source "
-						     "value blending.\n");
-				return FALSE;
-			}
+		if (INTEL_INFO(intel)->gen < 60 &&
+		    i965_blend_needs_dual_source(op, mask_picture)) {
+			intel_debug_fallback(scrn,
+					     "Component alpha not supported "
+					     "with source alpha and source "
+					     "value blending.\n");
+			return FALSE;
 		}
 
 		composite_op->mask_filter =
@@ -2105,7 +2202,14 @@ i965_prepare_composite(int op, PicturePtr source_picture,
 	if (mask) {
 		if (mask_picture->componentAlpha &&
 		    PICT_FORMAT_RGB(mask_picture->format)) {
-			if (i965_blend_op[op].src_alpha) {
+			if (i965_blend_needs_dual_source(op, mask_picture)) {
+				if (composite_op->is_affine)
+					composite_op->wm_kernel =
+					    WM_KERNEL_MASKCA_DUAL_AFFINE;
+				else
+					composite_op->wm_kernel =
+					    WM_KERNEL_MASKCA_DUAL_PROJECTIVE;
+			} else if (i965_blend_op[op].src_alpha) {
 				if (composite_op->is_affine)
 					composite_op->wm_kernel =
 					    WM_KERNEL_MASKCA_SRCALPHA_AFFINE;
@@ -2293,6 +2397,9 @@ i965_composite(PixmapPtr dest, int srcX, int srcY, int maskX, int maskY,
 			 w, h);
 	intel->vertex_index += 3;
 
+	intel_pixmap_add_damage(intel_get_pixmap_private(dest),
+				dstX, dstY, dstX + w, dstY + h);
+
 	if (INTEL_INFO(intel)->gen < 50) {
 	    /* XXX OMG! */
 	    i965_vertex_flush(intel);
@@ -2500,14 +2607,14 @@ gen6_composite_create_blend_state(intel_screen_private *intel)
 
 	blend_bo = drm_intel_bo_alloc(intel->bufmgr,
 				"gen6 BLEND state",
-				BRW_BLENDFACTOR_COUNT * BRW_BLENDFACTOR_COUNT * GEN6_BLEND_STATE_PADDED_SIZE,
+				GEN6_BLENDFACTOR_COUNT * GEN6_BLENDFACTOR_COUNT * GEN6_BLEND_STATE_PADDED_SIZE,
 				4096);
 	drm_intel_bo_map(blend_bo, TRUE);
 	memset(blend_bo->virtual, 0, blend_bo->size);
 
-	for (src = 0; src < BRW_BLENDFACTOR_COUNT; src++) {
-		for (dst = 0; dst < BRW_BLENDFACTOR_COUNT; dst++) {
-			uint32_t blend_state_offset = (src * BRW_BLENDFACTOR_COUNT + dst) * GEN6_BLEND_STATE_PADDED_SIZE;
+	for (src = 0; src < GEN6_BLENDFACTOR_COUNT; src++) {
+		for (dst = 0; dst < GEN6_BLENDFACTOR_COUNT; dst++) {
+			uint32_t blend_state_offset = (src * GEN6_BLENDFACTOR_COUNT + dst) * GEN6_BLEND_STATE_PADDED_SIZE;
 			struct gen6_blend_state *blend;
 
 			blend = (struct gen6_blend_state *)((char *)blend_bo->virtual + blend_state_offset);
@@ -2635,6 +2742,7 @@ gen6_composite_sf_state(intel_screen_private *intel,
 static void
 gen6_composite_wm_state(intel_screen_private *intel,
 			Bool has_mask,
+			Bool dual_source,
 			drm_intel_bo *bo)
 {
 	int num_surfaces = has_mask ? 3 : 2;
@@ -2656,10 +2764,12 @@ gen6_composite_wm_state(intel_screen_private *intel,
 	if(IS_VALLEYVIEW(intel)){
 		OUT_BATCH(((16 - 1) << GEN6_3DSTATE_WM_MAX_THREADS_SHIFT) |
 			  GEN6_3DSTATE_WM_DISPATCH_ENABLE |
+			  (dual_source ? GEN6_3DSTATE_WM_DUAL_SOURCE_BLEND_ENABLE : 0) |
 			  GEN6_3DSTATE_WM_16_DISPATCH_ENABLE);
 	} else {
 		OUT_BATCH(((40 - 1) << GEN6_3DSTATE_WM_MAX_THREADS_SHIFT) |
 			  GEN6_3DSTATE_WM_DISPATCH_ENABLE |
+			  (dual_source ? GEN6_3DSTATE_WM_DUAL_SOURCE_BLEND_ENABLE : 0) |
 			  GEN6_3DSTATE_WM_16_DISPATCH_ENABLE);
 	}
 	OUT_BATCH((num_sf_outputs << GEN6_3DSTATE_WM_NUM_SF_OUTPUTS_SHIFT) |
@@ -2671,6 +2781,7 @@ gen6_composite_wm_state(intel_screen_private *intel,
 static void
 gen7_composite_wm_state(intel_screen_private *intel,
 			Bool has_mask,
+			Bool dual_source,
 			drm_intel_bo *bo)
 {
 	int num_surfaces = has_mask ? 3 : 2;
@@ -2695,15 +2806,18 @@ gen7_composite_wm_state(intel_screen_private *intel,
 		if(intel->PciInfo->device_id==PCI_CHIP_VLV2) {
 			OUT_BATCH(((VLVA0_PS_MAX_THREADS - 1) << GEN7_PS_MAX_THREADS_SHIFT) |
 			  GEN7_PS_ATTRIBUTE_ENABLE |
+			  (dual_source ? GEN7_PS_DUAL_SOURCE_BLEND_ENABLE : 0) |
 			  GEN7_PS_16_DISPATCH_ENABLE);
 		} else {
 			OUT_BATCH(((VLV_PS_MAX_THREADS - 1) << GEN7_PS_MAX_THREADS_SHIFT) |
 			  GEN7_PS_ATTRIBUTE_ENABLE |
+			  (dual_source ? GEN7_PS_DUAL_SOURCE_BLEND_ENABLE : 0) |
 			  GEN7_PS_16_DISPATCH_ENABLE);
 		}
 	} else {
 		OUT_BATCH(((86 - 1) << GEN7_PS_MAX_THREADS_SHIFT) |
 			  GEN7_PS_ATTRIBUTE_ENABLE |
+			  (dual_source ? GEN7_PS_DUAL_SOURCE_BLEND_ENABLE : 0) |
 			  GEN7_PS_16_DISPATCH_ENABLE);
 	}
 
@@ -2826,6 +2940,8 @@ gen6_emit_composite_state(struct intel_screen_private *intel)
 	sampler_state_extend_t mask_extend = composite_op->mask_extend;
 	Bool is_affine = composite_op->is_affine;
 	Bool has_mask = intel->render_mask != NULL;
+	Bool dual_source = composite_op->wm_kernel == WM_KERNEL_MASKCA_DUAL_AFFINE ||
+		composite_op->wm_kernel == WM_KERNEL_MASKCA_DUAL_PROJECTIVE;
 	Bool ivb = INTEL_INFO(intel)->gen >= 70;
 	uint32_t src, dst;
 	drm_intel_bo *ps_sampler_state_bo = render->ps_sampler_state_bo[src_filter][src_extend][mask_filter][mask_extend];
@@ -2863,15 +2979,15 @@ gen6_emit_composite_state(struct intel_screen_private *intel)
 		gen6_composite_state_base_address(intel);
 
 	gen6_composite_cc_state_pointers(intel,
-					(src * BRW_BLENDFACTOR_COUNT + dst) * GEN6_BLEND_STATE_PADDED_SIZE);
+					(src * GEN6_BLENDFACTOR_COUNT + dst) * GEN6_BLEND_STATE_PADDED_SIZE);
 	gen6_composite_sampler_state_pointers(intel, ps_sampler_state_bo);
 	gen6_composite_sf_state(intel, has_mask);
 	if (ivb) {
-		gen7_composite_wm_state(intel, has_mask,
+		gen7_composite_wm_state(intel, has_mask, dual_source,
 					render->wm_kernel_bo[composite_op->wm_kernel]);
 		gen7_upload_binding_table(intel, intel->surface_table);
 	} else {
-		gen6_composite_wm_state(intel, has_mask,
+		gen6_composite_wm_state(intel, has_mask, dual_source,
 					render->wm_kernel_bo[composite_op->wm_kernel]);
 		gen6_upload_binding_table(intel, intel->surface_table);
 	}
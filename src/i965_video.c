@@ -434,7 +434,8 @@ static void i965_create_dst_surface_state(ScrnInfoPtr scrn,
 
 
 	dest_surf_state.ss1.base_addr =
-	    intel_emit_reloc(surf_bo, offset + offsetof(struct brw_surface_state, ss1),
+	    intel_batch_emit_state_reloc(intel, surf_bo,
+			     offset + offsetof(struct brw_surface_state, ss1),
 			     pixmap_bo, 0, I915_GEM_DOMAIN_SAMPLER, I915_GEM_DOMAIN_RENDER);
 
 	dest_surf_state.ss2.height = pixmap->drawable.height - 1;
@@ -460,6 +461,7 @@ static void i965_create_src_surface_state(ScrnInfoPtr scrn,
 					drm_intel_bo *surface_bo,
 					uint32_t offset)
 {
+	intel_screen_private *intel = intel_get_screen_private(scrn);
 	struct brw_surface_state src_surf_state;
 
 	memset(&src_surf_state, 0, sizeof(src_surf_state));
@@ -485,7 +487,7 @@ static void i965_create_src_surface_state(ScrnInfoPtr scrn,
 
 	if (src_bo) {
 		src_surf_state.ss1.base_addr =
-		    intel_emit_reloc(surface_bo,
+		    intel_batch_emit_state_reloc(intel, surface_bo,
 				     offset + offsetof(struct brw_surface_state, ss1),
 				     src_bo, src_offset,
 				     I915_GEM_DOMAIN_SAMPLER, 0);
@@ -525,7 +527,7 @@ static void gen7_create_dst_surface_state(ScrnInfoPtr scrn,
 	}
 
 	dest_surf_state.ss1.base_addr =
-		intel_emit_reloc(surf_bo,
+		intel_batch_emit_state_reloc(intel, surf_bo,
 				offset + offsetof(struct gen7_surface_state, ss1),
 				pixmap_bo, 0,
 				I915_GEM_DOMAIN_SAMPLER, 0);
@@ -550,6 +552,7 @@ static void gen7_create_src_surface_state(ScrnInfoPtr scrn,
 					drm_intel_bo *surface_bo,
 					uint32_t offset)
 {
+	intel_screen_private *intel = intel_get_screen_private(scrn);
 	struct gen7_surface_state src_surf_state;
 
 	memset(&src_surf_state, 0, sizeof(src_surf_state));
@@ -559,7 +562,7 @@ static void gen7_create_src_surface_state(ScrnInfoPtr scrn,
 
 	if (src_bo) {
 		src_surf_state.ss1.base_addr =
-			intel_emit_reloc(surface_bo,
+			intel_batch_emit_state_reloc(intel, surface_bo,
 					offset + offsetof(struct gen7_surface_state, ss1),
 					src_bo, src_offset,
 					I915_GEM_DOMAIN_SAMPLER, 0);
@@ -1309,9 +1312,8 @@ I965DisplayVideoTextured(ScrnInfoPtr scrn,
 		/* If this command won't fit in the current batch, flush.
 		 * Assume that it does after being flushed.
 		 */
-		if (drm_intel_bufmgr_check_aperture_space(bo_table,
-							  ARRAY_SIZE(bo_table))
-		    < 0) {
+		if (!intel_check_aperture(intel, bo_table,
+					  ARRAY_SIZE(bo_table))) {
 			intel_batch_submit(scrn);
 		}
 
@@ -1962,7 +1964,7 @@ void Gen6DisplayVideoTextured(ScrnInfoPtr scrn,
 		/* If this command won't fit in the current batch, flush.
 		 * Assume that it does after being flushed.
 		 */
-		if (drm_intel_bufmgr_check_aperture_space(bo_table, ARRAY_SIZE(bo_table)) < 0)
+		if (!intel_check_aperture(intel, bo_table, ARRAY_SIZE(bo_table)))
 			intel_batch_submit(scrn);
 
 		intel_batch_start_atomic(scrn, 200);
@@ -2033,6 +2035,7 @@ static void gen7_create_yuv_dst_surface_state(ScrnInfoPtr scrn,
 					drm_intel_bo *surf_bo,
 					uint32_t offset)
 {
+	intel_screen_private *intel = intel_get_screen_private(scrn);
 	struct gen7_surface_state dest_surf_state;
 	drm_intel_bo *pixmap_bo = intel_get_pixmap_bo(pixmap);
 
@@ -2050,7 +2053,7 @@ static void gen7_create_yuv_dst_surface_state(ScrnInfoPtr scrn,
 	}
 
 	dest_surf_state.ss1.base_addr =
-		intel_emit_reloc(surf_bo,
+		intel_batch_emit_state_reloc(intel, surf_bo,
 				offset + offsetof(struct gen7_surface_state, ss1),
 				pixmap_bo, 0,
 				I915_GEM_DOMAIN_SAMPLER, 0);
@@ -2284,7 +2287,7 @@ void Gen7ConvertVideoTextured(ScrnInfoPtr scrn,
 		/* If this command won't fit in the current batch, flush.
 		 * Assume that it does after being flushed.
 		 */
-		if (drm_intel_bufmgr_check_aperture_space(bo_table, ARRAY_SIZE(bo_table)) < 0)
+		if (!intel_check_aperture(intel, bo_table, ARRAY_SIZE(bo_table)))
 			intel_batch_submit(scrn);
 
 		intel_batch_start_atomic(scrn, 200);
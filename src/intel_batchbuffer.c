@@ -38,11 +38,13 @@
 #include "emgd.h"
 #include "emgd_uxa.h"
 #include "intel_batchbuffer.h"
+#include "emgd_trace.h"
+#include "emgd_submit.h"
 #include "i830_reg.h"
 #include "i915_drm.h"
 #include "i965_reg.h"
 
-#define DUMP_BATCHBUFFERS NULL // "/tmp/i915-batchbuffers.dump"
+void i965_free_video(ScrnInfoPtr scrn);
 
 static void intel_end_vertex(intel_screen_private *intel)
 {
@@ -65,14 +67,23 @@ void intel_next_vertex(intel_screen_private *intel)
 
 	intel->vertex_bo =
 		dri_bo_alloc(intel->bufmgr, "vertex", sizeof (intel->vertex_ptr), 4096);
+	EMGD_PERF_INC(bo_allocs);
 }
 
 static void intel_next_batch(ScrnInfoPtr scrn)
 {
 	intel_screen_private *intel = intel_get_screen_private(scrn);
+	int i;
 
 	intel->batch_bo =
 	    dri_bo_alloc(intel->bufmgr, "batch", 4096 * 4, 4096);
+	EMGD_PERF_INC(bo_allocs);
+
+	/* libdrm hands out recycled bos; don't inherit their accounting */
+	for (i = 0; i < ARRAY_SIZE(intel->aperture); i++) {
+		if (intel->aperture[i].batch == intel->batch_bo)
+			intel->aperture[i].batch = NULL;
+	}
 
 	intel->batch_used = 0;
 
@@ -82,6 +93,182 @@ static void intel_next_batch(ScrnInfoPtr scrn)
 	intel->last_3d = LAST_3D_OTHER;
 }
 
+/*
+ * Default batch_exec hook: execute the batch on the requested ring.
+ */
+int intel_batch_exec(intel_screen_private *intel, dri_bo *bo,
+		     int used, unsigned int ring)
+{
+	return drm_intel_bo_mrb_exec(bo, used, NULL, 0, 0xffffffff, ring);
+}
+
+/*
+ * GPU hang recovery.
+ *
+ * A batch failing with -EIO means the kernel declared the GPU hung.  We
+ * drop to software rendering immediately and schedule a retry.  When the
+ * timer fires we probe the GPU with an empty batch; once the kernel has
+ * reset it, the render/video state and the UXA caches (whose contents may
+ * have been left half written by the hung batch) are rebuilt and
+ * acceleration is re-enabled.
+ *
+ * Each hang that follows a recovery within HANG_STABLE_MS doubles the
+ * retry delay, from 1 s up to 64 s.  After HANG_MAX_RECOVERIES such hangs,
+ * one per step of that schedule, we give up and stay in software fallback
+ * for the life of the server, as before.
+ */
+#define HANG_BACKOFF_MIN_MS	1000
+#define HANG_BACKOFF_MAX_MS	64000
+#define HANG_STABLE_MS		60000
+#define HANG_MAX_RECOVERIES	7
+
+static CARD32 intel_hang_backoff(intel_screen_private *intel)
+{
+	CARD32 delay = HANG_BACKOFF_MIN_MS;
+	int i;
+
+	for (i = 1; i < intel->hang_count && delay < HANG_BACKOFF_MAX_MS; i++)
+		delay *= 2;
+
+	return delay < HANG_BACKOFF_MAX_MS ? delay : HANG_BACKOFF_MAX_MS;
+}
+
+/*
+ * Submit an empty batch and wait for it.  Returns TRUE once the kernel
+ * accepts work again, i.e. the GPU has been reset.
+ */
+static Bool intel_gpu_probe(intel_screen_private *intel)
+{
+	uint32_t probe[2] = { MI_BATCH_BUFFER_END, MI_NOOP };
+	dri_bo *bo;
+	int ret;
+
+	/* Anything still queued ran (or failed) before the probe */
+	intel_batch_wait_submitted(intel->scrn);
+
+	bo = dri_bo_alloc(intel->bufmgr, "hang probe", 4096, 4096);
+	if (bo == NULL)
+		return FALSE;
+
+	ret = dri_bo_subdata(bo, 0, sizeof(probe), probe);
+	if (ret == 0)
+		ret = intel->batch_exec(intel, bo, sizeof(probe), RENDER_BATCH);
+	if (ret == 0)
+		drm_intel_bo_wait_rendering(bo);
+
+	dri_bo_unreference(bo);
+	return ret == 0;
+}
+
+static void intel_gpu_recover(ScrnInfoPtr scrn)
+{
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+	ScreenPtr screen = screenInfo.screens[scrn->scrnIndex];
+
+	/* Flush anything queued while in fallback before freeing state */
+	intel_batch_submit(scrn);
+
+	gen4_render_state_cleanup(scrn);
+	gen4_render_state_init(scrn);
+	i965_free_video(scrn);
+
+	/* Pixmap allocation checks force_fallback, so clear it first */
+	intel->force_fallback = FALSE;
+	uxa_reset_caches(screen);
+	uxa_set_force_fallback(screen, FALSE);
+	intel->last_recovery = GetTimeInMillis();
+
+	EMGD_PERF_INC(gpu_recoveries);
+	EMGD_TRACE(GPU_RECOVER, intel->hang_count, 0, 0, 0);
+	xf86DrvMsg(scrn->scrnIndex, X_INFO,
+		   "GPU recovered from hang, re-enabling acceleration.\n");
+}
+
+static CARD32 intel_hang_recover_timer(OsTimerPtr timer, CARD32 now,
+				       pointer data)
+{
+	intel_screen_private *intel = data;
+
+	if (!intel_gpu_probe(intel)) {
+		/* Reset still in progress; try again after the same delay */
+		return intel_hang_backoff(intel);
+	}
+
+	intel_gpu_recover(intel->scrn);
+	return 0;
+}
+
+static void intel_gpu_hang(ScrnInfoPtr scrn)
+{
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+	CARD32 now = GetTimeInMillis();
+	CARD32 delay;
+
+	EMGD_PERF_INC(gpu_hangs);
+
+	/* Batches submitted while already in fallback may fail as well */
+	if (intel->force_fallback)
+		return;
+
+	/* Stable since the last recovery: start over at the shortest delay */
+	if (intel->hang_count && now - intel->last_recovery > HANG_STABLE_MS)
+		intel->hang_count = 0;
+	intel->hang_count++;
+
+	uxa_set_force_fallback(screenInfo.screens[scrn->scrnIndex], TRUE);
+	intel->force_fallback = TRUE;
+
+	if (intel->hang_count > HANG_MAX_RECOVERIES) {
+		xf86DrvMsg(scrn->scrnIndex, X_ERROR,
+			   "GPU hung %d times in a row, disabling acceleration.\n",
+			   intel->hang_count);
+		xf86DrvMsg(scrn->scrnIndex, X_ERROR,
+			   "When reporting this, please include i915_error_state from debugfs and the full dmesg.\n");
+		EMGD_TRACE(GPU_HANG, intel->hang_count, 0, 0, 0);
+		return;
+	}
+
+	delay = intel_hang_backoff(intel);
+	xf86DrvMsg(scrn->scrnIndex, X_WARNING,
+		   "Detected a hung GPU, using software rendering for %u ms.\n",
+		   (unsigned int)delay);
+	EMGD_TRACE(GPU_HANG, intel->hang_count, delay, 0, 0);
+
+	intel->hang_recover = TimerSet(intel->hang_recover, 0, delay,
+				       intel_hang_recover_timer, intel);
+}
+
+static void intel_batch_report(ScrnInfoPtr scrn, int ret)
+{
+	if (ret == 0)
+		return;
+
+	if (ret == -EIO) {
+		intel_gpu_hang(scrn);
+	} else {
+		xf86DrvMsg(scrn->scrnIndex, X_ERROR,
+			   "Failed to submit batch buffer, expect rendering corruption "
+			   "or even a frozen display: %s.\n",
+			   strerror(-ret));
+	}
+}
+
+/*
+ * intel_batch_wait_submitted
+ *
+ * With the submission thread enabled, wait until every batch submitted
+ * so far has reached the kernel.  Must precede anything that relies on
+ * the kernel knowing about earlier rendering: CPU access to buffers the
+ * GPU may use, busy checks, page flips and handing buffers to clients.
+ */
+void intel_batch_wait_submitted(ScrnInfoPtr scrn)
+{
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+
+	if (intel->submit)
+		intel_batch_report(scrn, emgd_submit_wait(intel->submit));
+}
+
 void intel_batch_init(ScrnInfoPtr scrn)
 {
 	intel_screen_private *intel = intel_get_screen_private(scrn);
@@ -90,6 +277,24 @@ void intel_batch_init(ScrnInfoPtr scrn)
 	intel->batch_emitting = 0;
 	intel->vertex_id = 0;
 
+	intel->batch_ptr = intel->batch_store[0];
+	memset(&intel->parked, 0, sizeof(intel->parked));
+	intel->parked_dep = FALSE;
+
+	if (intel->batch_exec == NULL)
+		intel->batch_exec = intel_batch_exec;
+
+	if (intel->cfg.batch_capture)
+		intel->capture = emgd_capture_create(intel->cfg.batch_capture,
+				(unsigned long)intel->cfg.batch_capture_size << 20,
+				(unsigned long)intel->cfg.batch_capture_bo_limit << 10,
+				intel->PciInfo->device_id,
+				INTEL_INFO(intel)->gen);
+
+	/* Capture snapshots buffers right before each batch executes */
+	if (intel->cfg.async_submit && intel->capture == NULL)
+		intel->submit = emgd_submit_create(intel);
+
 	intel_next_batch(scrn);
 }
 
@@ -97,16 +302,30 @@ void intel_batch_teardown(ScrnInfoPtr scrn)
 {
 	intel_screen_private *intel = intel_get_screen_private(scrn);
 
+	emgd_submit_destroy(intel->submit);
+	intel->submit = NULL;
+
 	if (intel->batch_bo != NULL) {
 		dri_bo_unreference(intel->batch_bo);
 		intel->batch_bo = NULL;
 	}
 
+	if (intel->parked.bo != NULL) {
+		dri_bo_unreference(intel->parked.bo);
+		memset(&intel->parked, 0, sizeof(intel->parked));
+	}
+
 	if (intel->vertex_bo) {
 		dri_bo_unreference(intel->vertex_bo);
 		intel->vertex_bo = NULL;
 	}
 
+	emgd_capture_destroy(intel->capture);
+	intel->capture = NULL;
+
+	TimerFree(intel->hang_recover);
+	intel->hang_recover = NULL;
+
 	while (!LIST_IS_EMPTY(&intel->batch_pixmaps))
 		LIST_DEL(intel->batch_pixmaps.next);
 
@@ -206,19 +425,27 @@ void intel_batch_emit_flush(ScrnInfoPtr scrn)
 	intel_batch_do_flush(scrn);
 }
 
-void intel_batch_submit(ScrnInfoPtr scrn)
+/*
+ * Execute the batch in intel->batch_* and release its bo.  The caller
+ * sets up the next batch.
+ */
+static void intel_batch_exec_current(ScrnInfoPtr scrn)
 {
 	intel_screen_private *intel = intel_get_screen_private(scrn);
+	struct intel_pixmap *entry, *tmp;
+	uint8_t keep;
 	int ret;
 
-	assert (!intel->in_batch_atomic);
-
-	if (intel->vertex_flush)
-		intel->vertex_flush(intel);
-	intel_end_vertex(intel);
+	/* The vertex, surface and render state hooks all belong to the
+	 * render batch; leave them alone while it is parked. */
+	if (intel->parked.ring != RENDER_BATCH) {
+		if (intel->vertex_flush)
+			intel->vertex_flush(intel);
+		intel_end_vertex(intel);
 
-	if (intel->batch_flush)
-		intel->batch_flush(intel);
+		if (intel->batch_flush)
+			intel->batch_flush(intel);
+	}
 
 	if (intel->batch_used == 0)
 		return;
@@ -229,84 +456,190 @@ void intel_batch_submit(ScrnInfoPtr scrn)
 	if (intel->batch_used & 1)
 		OUT_BATCH(MI_NOOP);
 
-	if (DUMP_BATCHBUFFERS) {
-	    FILE *file = fopen(DUMP_BATCHBUFFERS, "a");
-	    if (file) {
-		size_t bytes_fwrite;
-		bytes_fwrite = fwrite (intel->batch_ptr, intel->batch_used*4, 1, file);
-		if(!bytes_fwrite){
-			OS_ERROR("fwrite failed !");
-		}
-		fclose(file);
-	    }
-	}
+	if (intel->capture)
+		emgd_capture_batch(intel->capture, intel->current_batch,
+				   intel->batch_ptr, intel->batch_used*4);
 
 	ret = dri_bo_subdata(intel->batch_bo, 0, intel->batch_used*4, intel->batch_ptr);
-	if (ret == 0) {
-		ret = drm_intel_bo_mrb_exec(intel->batch_bo,
-				intel->batch_used*4,
-				NULL, 0, 0xffffffff, intel->current_batch);
+	if (ret == 0 && intel->submit) {
+		/* May report a failure of an earlier batch */
+		ret = emgd_submit_queue(intel->submit, intel->batch_bo,
+				intel->batch_used*4, intel->current_batch);
+		EMGD_PERF_INC(batch_submits);
+		EMGD_PERF_ADD(batch_bytes, intel->batch_used*4);
+		EMGD_PERF_MAX(batch_max_bytes, intel->batch_used*4);
+	} else if (ret == 0) {
+		uint64_t start = emgd_perf_now();
+		uint64_t elapsed;
+
+		ret = intel->batch_exec(intel, intel->batch_bo,
+				intel->batch_used*4, intel->current_batch);
+
+		elapsed = emgd_perf_now() - start;
+		EMGD_TRACE(BATCH_SUBMIT, intel->current_batch, intel->batch_used*4,
+				elapsed / 1000, ret);
+		EMGD_PERF_ADD(exec_ns, elapsed);
+		EMGD_PERF_INC(batch_submits);
+		EMGD_PERF_ADD(batch_bytes, intel->batch_used*4);
+		EMGD_PERF_MAX(batch_max_bytes, intel->batch_used*4);
 	}
 
-	if (ret != 0) {
-		if (ret == -EIO) {
-			static int once;
-
-			/* The GPU has hung and unlikely to recover by this point. */
-			if (!once) {
-				xf86DrvMsg(scrn->scrnIndex, X_ERROR, "Detected a hung GPU, disabling acceleration.\n");
-				xf86DrvMsg(scrn->scrnIndex, X_ERROR, "When reporting this, please include i915_error_state from debugfs and the full dmesg.\n");
-				uxa_set_force_fallback(screenInfo.screens[scrn->scrnIndex], TRUE);
-				intel->force_fallback = TRUE;
-				once = 1;
-			}
-		} else {
-			xf86DrvMsg(scrn->scrnIndex, X_ERROR,
-				   "Failed to submit batch buffer, expect rendering corruption "
-				   "or even a frozen display: %s.\n",
-				   strerror(-ret));
+	intel_batch_report(scrn, ret);
+
+	/* Everything not in the parked batch was in this one */
+	keep = intel->parked.ring ? 1 << intel->parked.ring : 0;
+	LIST_FOR_EACH_ENTRY_SAFE(entry, tmp, &intel->batch_pixmaps, batch) {
+		entry->ring_write &= keep;
+		entry->ring_read &= keep;
+		if (entry->ring_write | entry->ring_read) {
+			entry->batch_write = entry->ring_write != 0;
+			entry->batch_read = entry->ring_read != 0;
+			continue;
 		}
-	}
-
-	while (!LIST_IS_EMPTY(&intel->batch_pixmaps)) {
-		struct intel_pixmap *entry;
-
-		entry = LIST_FIRST_ENTRY(&intel->batch_pixmaps,
-					 struct intel_pixmap,
-					 batch);
 
 		entry->busy = -1;
 		entry->batch_write = 0;
+		entry->batch_read = 0;
+		entry->batch_damage.x1 = entry->batch_damage.x2 = 0;
 		LIST_DEL(&entry->batch);
 	}
 
-	while (!LIST_IS_EMPTY(&intel->flush_pixmaps))
-		LIST_DEL(intel->flush_pixmaps.next);
-
-	while (!LIST_IS_EMPTY(&intel->in_flight)) {
-		struct intel_pixmap *entry;
+	/* Render writes still pending in a parked batch may need a flush */
+	if (intel->parked.ring != RENDER_BATCH) {
+		while (!LIST_IS_EMPTY(&intel->flush_pixmaps))
+			LIST_DEL(intel->flush_pixmaps.next);
+	}
 
-		entry = LIST_FIRST_ENTRY(&intel->in_flight,
-					 struct intel_pixmap,
-					 in_flight);
+	LIST_FOR_EACH_ENTRY_SAFE(entry, tmp, &intel->in_flight, in_flight) {
+		if (!LIST_IS_EMPTY(&entry->batch))
+			continue;
 
 		dri_bo_unreference(entry->bo);
 		LIST_DEL(&entry->in_flight);
 		free(entry);
 	}
 
-	if (intel->debug_flush & DEBUG_FLUSH_WAIT)
+	if (intel->debug_flush & DEBUG_FLUSH_WAIT) {
+		intel_batch_wait_submitted(scrn);
 		drm_intel_bo_wait_rendering(intel->batch_bo);
+	}
 
 	dri_bo_unreference(intel->batch_bo);
-	intel_next_batch(scrn);
+	intel->batch_bo = NULL;
 
-	if (intel->batch_commit_notify)
+	if (intel->parked.ring != RENDER_BATCH && intel->batch_commit_notify)
 		intel->batch_commit_notify(intel);
+}
+
+static void intel_batch_swap_parked(intel_screen_private *intel)
+{
+	struct intel_parked_batch tmp = intel->parked;
+
+	intel->parked.bo = intel->batch_bo;
+	intel->parked.ptr = intel->batch_ptr;
+	intel->parked.used = intel->batch_used;
+	intel->parked.ring = intel->current_batch;
+
+	intel->batch_bo = tmp.bo;
+	intel->batch_ptr = tmp.ptr;
+	intel->batch_used = tmp.used;
+	intel->current_batch = tmp.ring;
+}
+
+/*
+ * Submit the parked batch, leaving the current one as it is.  Safe in
+ * the middle of emitting into the current batch: nothing but the batch
+ * state is swapped, and the parked batch always ends on a complete
+ * operation.
+ */
+static void intel_batch_submit_parked(ScrnInfoPtr scrn)
+{
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+
+	intel_batch_swap_parked(intel);
+	intel_batch_exec_current(scrn);
+	intel_batch_swap_parked(intel);
+
+	intel->parked.bo = NULL;
+	intel->parked.used = 0;
+	intel->parked.ring = 0;
+	intel->parked_dep = FALSE;
+}
+
+void intel_batch_submit(ScrnInfoPtr scrn)
+{
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+
+	assert (!intel->in_batch_atomic);
+
+	/* The current batch never has to run before the parked one */
+	if (intel->parked.ring)
+		intel_batch_submit_parked(scrn);
+
+	intel_batch_exec_current(scrn);
+	if (intel->batch_bo == NULL)
+		intel_next_batch(scrn);
 
 	intel->current_batch = 0;
 }
 
+/*
+ * intel_batch_switch_ring
+ *
+ * Called on gen6+ when the next command needs the other ring.  Rather
+ * than submitting, the current batch is parked and the other ring's
+ * parked batch (if any) resumes, so mixed BLT and render work builds up
+ * one batch per ring.
+ *
+ * Submission order only matters for buffers both batches touch.  The
+ * current batch never holds work that the parked one has to follow, so
+ * parked-then-current is always a valid order; when the current batch
+ * starts to depend on the parked one (parked_dep), the parked batch is
+ * submitted before the two trade places.
+ */
+void intel_batch_switch_ring(ScrnInfoPtr scrn, unsigned int ring)
+{
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+
+	/* Capture records one relocation list per submitted batch */
+	if (intel->capture) {
+		intel_batch_submit(scrn);
+		return;
+	}
+
+	if (intel->batch_used == 0) {
+		if (intel->parked.ring == ring) {
+			intel_batch_swap_parked(intel);
+			intel->parked.ring = 0;
+			dri_bo_unreference(intel->parked.bo);
+			intel->parked.bo = NULL;
+			intel->parked.used = 0;
+		}
+		intel->current_batch = ring;
+		return;
+	}
+
+	if (intel->parked.ring && intel->parked_dep) {
+		intel_batch_submit_parked(scrn);
+		EMGD_PERF_INC(ring_switch_submits);
+	}
+
+	if (intel->parked.ring == ring) {
+		intel_batch_swap_parked(intel);
+	} else {
+		intel->parked.bo = intel->batch_bo;
+		intel->parked.ptr = intel->batch_ptr;
+		intel->parked.used = intel->batch_used;
+		intel->parked.ring = intel->current_batch;
+
+		intel->batch_ptr = intel->batch_store[intel->batch_ptr ==
+						      intel->batch_store[0]];
+		intel_next_batch(scrn);
+		intel->current_batch = ring;
+	}
+	EMGD_PERF_INC(ring_switches);
+}
+
 void intel_debug_flush(ScrnInfoPtr scrn)
 {
 	intel_screen_private *intel = intel_get_screen_private(scrn);
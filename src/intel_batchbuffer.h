@@ -30,6 +30,8 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef _INTEL_BATCHBUFFER_H
 #define _INTEL_BATCHBUFFER_H
 
+#include "emgd_capture.h"
+
 #define BATCH_RESERVED		16
 
 
@@ -38,6 +40,10 @@ void intel_batch_teardown(ScrnInfoPtr scrn);
 void intel_batch_emit_flush(ScrnInfoPtr scrn);
 void intel_batch_do_flush(ScrnInfoPtr scrn);
 void intel_batch_submit(ScrnInfoPtr scrn);
+void intel_batch_switch_ring(ScrnInfoPtr scrn, unsigned int ring);
+void intel_batch_wait_submitted(ScrnInfoPtr scrn);
+int intel_batch_exec(intel_screen_private *intel, dri_bo *bo,
+		     int used, unsigned int ring);
 
 static inline int intel_batch_space(intel_screen_private *intel)
 {
@@ -119,9 +125,35 @@ intel_batch_emit_reloc(intel_screen_private *intel,
 					bo, delta,
 					read_domains, write_domains);
 
+	if (intel->capture)
+		emgd_capture_reloc(intel->capture, bo, intel->batch_used * 4,
+				   delta, read_domains, write_domains);
+
 	intel_batch_emit_dword(intel, bo->offset + delta);
 }
 
+/*
+ * Relocation in a state bo the current batch points at (surface state,
+ * binding tables).  Same as intel_emit_reloc(), but batch capture sees
+ * it too, so the pixmaps a batch only samples through surface state are
+ * snapshotted with it.
+ */
+static inline uint32_t
+intel_batch_emit_state_reloc(intel_screen_private *intel,
+			     dri_bo *state_bo, uint32_t offset,
+			     dri_bo *bo, uint32_t delta,
+			     uint32_t read_domains, uint32_t write_domain)
+{
+	drm_intel_bo_emit_reloc(state_bo, offset, bo, delta,
+				read_domains, write_domain);
+
+	if (intel->capture)
+		emgd_capture_state_reloc(intel->capture, state_bo, offset,
+					 bo, delta, read_domains, write_domain);
+
+	return bo->offset + delta;
+}
+
 static inline void
 intel_batch_mark_pixmap_domains(intel_screen_private *intel,
 				struct intel_pixmap *priv,
@@ -135,7 +167,25 @@ intel_batch_mark_pixmap_domains(intel_screen_private *intel,
 	if (write_domain && LIST_IS_EMPTY(&priv->flush))
 		LIST_ADD(&priv->flush, &intel->flush_pixmaps);
 
+	/* Anything the parked batch writes, or reads while we write it, has
+	 * to wait for the parked batch to be submitted first. */
+	if (intel->parked.ring) {
+		uint8_t parked = 1 << intel->parked.ring;
+
+		if ((priv->ring_write & parked) ||
+		    (write_domain && (priv->ring_read & parked)))
+			intel->parked_dep = TRUE;
+	}
+
+	if (write_domain)
+		priv->ring_write |= 1 << intel->current_batch;
+	else
+		priv->ring_read |= 1 << intel->current_batch;
+
 	priv->batch_write |= write_domain != 0;
+	priv->batch_read |= write_domain == 0;
+	if (write_domain)
+		priv->write_serial++;
 	priv->busy = 1;
 
 	intel->needs_flush |= write_domain != 0;
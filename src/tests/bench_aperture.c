@@ -0,0 +1,136 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: bench_aperture.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Replays operation traces through intel_get_aperture_space() and counts
+ *  the drm_intel_bufmgr_check_aperture_space() calls that reach libdrm per
+ *  operation, with the per-batch accounting and with aperture_limit = 0,
+ *  which sends every check to libdrm as before it existed:
+ *    - text: glyphs from a linear cache onto a tiled window,
+ *    - scrolling: a tiled window copied onto itself,
+ *    - thumbnails: 64 tiled sources onto one tiled destination,
+ *    - linear: copies between four linear pixmaps.
+ *
+ *  Usage: bench_aperture [iterations]
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+#include "intel_batchbuffer.h"
+
+#define MAX_SOURCES	64
+
+typedef struct {
+	const char *name;
+	uint32_t dst_tiling;
+	uint32_t src_tiling;
+	int num_sources;	/* 0: the destination is the source */
+	int num_dsts;
+} trace_t;
+
+static const trace_t traces[] = {
+	{ "text", I915_TILING_X, I915_TILING_NONE, 1, 1 },
+	{ "scrolling", I915_TILING_X, I915_TILING_X, 0, 1 },
+	{ "thumbnails", I915_TILING_X, I915_TILING_X, MAX_SOURCES, 1 },
+	{ "linear", I915_TILING_NONE, I915_TILING_NONE, 2, 2 },
+};
+
+static void bench_trace(const trace_t *trace, Bool cached, long iters)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr dsts[2], srcs[MAX_SOURCES];
+	unsigned long allocs, checks, execs;
+	uint64_t start, elapsed;
+	char name[64], extra[96];
+	long i;
+	int n;
+
+	mock_drm_reset();
+	mock_drm.record_execs = 0;
+	mock_drm.exec_ns = 0;
+	scrn = emgd_test_screen(70);
+	if (!cached)
+		EMGDPTR(scrn)->aperture_limit = 0;
+
+	for (n = 0; n < trace->num_dsts; n++)
+		dsts[n] = emgd_test_pixmap(scrn, 256, 256, 32,
+					   trace->dst_tiling);
+	for (n = 0; n < trace->num_sources; n++)
+		srcs[n] = emgd_test_pixmap(scrn, 64, 64, 32,
+					   trace->src_tiling);
+
+	allocs = emgd_test_allocs;
+	checks = mock_drm.stats.aperture_checks;
+	execs = mock_drm.stats.execs;
+	start = emgd_test_now();
+	for (i = 0; i < iters; i++) {
+		PixmapPtr dst = dsts[i % trace->num_dsts];
+		PixmapPtr src = trace->num_sources ?
+			srcs[i % trace->num_sources] : dst;
+		drm_intel_bo *bo_table[3];
+
+		bo_table[0] = NULL;
+		bo_table[1] = intel_get_pixmap_private(dst)->bo;
+		bo_table[2] = intel_get_pixmap_private(src)->bo;
+		if (!intel_get_aperture_space(scrn, bo_table, 3)) {
+			fprintf(stderr, "%s: no aperture space\n", trace->name);
+			exit(1);
+		}
+		emgd_test_blt_copy(scrn, src, dst, 0, 0, 16, 16);
+	}
+	intel_batch_submit(scrn);
+	elapsed = emgd_test_now() - start;
+
+	snprintf(name, sizeof(name), "%s, %s", trace->name,
+		cached ? "per-batch accounting" : "libdrm only");
+	snprintf(extra, sizeof(extra), "%.3f libdrm checks/op, %.4f submits/op",
+		(double)(mock_drm.stats.aperture_checks - checks) / iters,
+		(double)(mock_drm.stats.execs - execs) / iters);
+	emgd_bench_report(name, iters, elapsed, emgd_test_allocs - allocs,
+		extra);
+
+	for (n = 0; n < trace->num_dsts; n++)
+		emgd_test_pixmap_free(dsts[n]);
+	for (n = 0; n < trace->num_sources; n++)
+		emgd_test_pixmap_free(srcs[n]);
+	emgd_test_screen_free(scrn);
+}
+
+int main(int argc, char **argv)
+{
+	long iters = emgd_bench_iterations(argc, argv, 200000);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(traces); i++) {
+		bench_trace(&traces[i], TRUE, iters);
+		bench_trace(&traces[i], FALSE, iters);
+	}
+
+	return 0;
+}
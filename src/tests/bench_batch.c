@@ -0,0 +1,109 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: bench_batch.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  CPU cost of the batchbuffer layer, measured against mock_drm so that
+ *  only driver overhead is counted: ops/s, heap allocations per operation
+ *  and libdrm buffer allocations per operation for
+ *    - a BLT fill per batch (emit, upload, execbuffer, retire),
+ *    - 64 fills per batch,
+ *    - alternating BLT and render operations (ring parking),
+ *    - the same with the submission thread.
+ *
+ *  Usage: bench_batch [iterations]
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+#include "intel_batchbuffer.h"
+#include "emgd_submit.h"
+
+static void bench_case(const char *name, int gen, Bool async, long iters,
+	int ops_per_batch, Bool mixed)
+{
+	ScrnInfoPtr scrn;
+	emgd_priv_t *intel;
+	PixmapPtr a, b;
+	unsigned long allocs, bo_allocs;
+	uint64_t start, elapsed;
+	char extra[64];
+	long i;
+
+	mock_drm_reset();
+	mock_drm.record_execs = 0;
+	mock_drm.exec_ns = 0;
+
+	scrn = emgd_test_screen(gen);
+	intel = EMGDPTR(scrn);
+	if (async) {
+		/* What intel_batch_init() does for AsyncSubmit */
+		intel->submit = emgd_submit_create(intel);
+	}
+	a = emgd_test_pixmap(scrn, 256, 256, 32, I915_TILING_X);
+	b = emgd_test_pixmap(scrn, 256, 256, 32, I915_TILING_X);
+
+	allocs = emgd_test_allocs;
+	bo_allocs = mock_drm.stats.bo_allocs;
+	start = emgd_test_now();
+	for (i = 0; i < iters; i++) {
+		if (mixed && (i & 1))
+			emgd_test_render_copy(scrn, a, b, 0, 0, 64, 64);
+		else
+			emgd_test_blt_fill(scrn, a, 0, 0, 64, 64);
+
+		if ((i + 1) % ops_per_batch == 0)
+			intel_batch_submit(scrn);
+	}
+	intel_batch_submit(scrn);
+	intel_batch_wait_submitted(scrn);
+	elapsed = emgd_test_now() - start;
+
+	snprintf(extra, sizeof(extra), "%.3f bo allocs/op",
+		(double)(mock_drm.stats.bo_allocs - bo_allocs) / iters);
+	emgd_bench_report(name, iters, elapsed, emgd_test_allocs - allocs,
+		extra);
+
+	emgd_test_pixmap_free(a);
+	emgd_test_pixmap_free(b);
+	emgd_test_screen_free(scrn);
+}
+
+int main(int argc, char **argv)
+{
+	long iters = emgd_bench_iterations(argc, argv, 200000);
+
+	bench_case("blt fill, 1 op/batch", 70, FALSE, iters, 1, FALSE);
+	bench_case("blt fill, 64 ops/batch", 70, FALSE, iters, 64, FALSE);
+	bench_case("blt/render mixed, 64 ops/batch", 70, FALSE, iters, 64, TRUE);
+	bench_case("blt/render mixed, async submit", 70, TRUE, iters, 64, TRUE);
+	bench_case("blt fill, 1 op/batch, gen6", 60, FALSE, iters, 1, FALSE);
+
+	return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: bench_copy_window.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Replays window drags through uxa_copy_window() on a live server: a
+ *  640x480 window with content is moved a few pixels at a time, back and
+ *  forth, so every move copies the window onto itself.  Unobscured, the
+ *  moved region is one box; under a sibling it is several boxes, which
+ *  uxa_copy_window() orders into bands for the direction of the move.
+ *  Reports moves per second, server round trip included every 16 moves,
+ *  and from the driver's counters the blits and damaged bytes per move.
+ *
+ *  Runs against $EMGD_TEST_DISPLAY, see emgd_xtest.h.
+ *
+ *  Usage: bench_copy_window [iterations]
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+
+#include "emgd_test.h"
+#include "emgd_xtest.h"
+
+#define BENCH_WIDTH	640
+#define BENCH_HEIGHT	480
+
+static const struct {
+	const char *name;
+	int dx, dy;
+	Bool obscured;
+} traces[] = {
+	{ "scroll down", 0, 4, False },
+	{ "scroll up", 0, -4, False },
+	{ "drag down-right", 3, 2, False },
+	{ "drag up-left", -3, -2, False },
+	{ "drag up-right", 3, -2, False },
+	{ "drag down-right, obscured", 3, 2, True },
+	{ "drag up-left, obscured", -3, -2, True },
+};
+
+static void bench_trace(Display *dpy, int i, long iters)
+{
+	Window win, sibling = None;
+	GC gc;
+	iegd_esc_perf_counters_t before, after;
+	Bool perf;
+	uint64_t start, elapsed;
+	char name[64], extra[128];
+	long n;
+	int x = 64, y = 64, step;
+
+	win = emgd_xtest_window(dpy, x, y, BENCH_WIDTH, BENCH_HEIGHT);
+	gc = XCreateGC(dpy, win, 0, NULL);
+	for (step = 0; step < BENCH_HEIGHT; step += 16) {
+		XSetForeground(dpy, gc, 0x10101 * (step & 0xff));
+		XFillRectangle(dpy, win, gc, 0, step, BENCH_WIDTH, 16);
+	}
+	if (traces[i].obscured)
+		sibling = emgd_xtest_window(dpy, x + BENCH_WIDTH / 3,
+			y + BENCH_HEIGHT / 3, BENCH_WIDTH / 3, BENCH_HEIGHT / 3);
+	XSync(dpy, True);
+
+	perf = emgd_xtest_perf(dpy, &before);
+	start = emgd_test_now();
+	for (n = 0; n < iters; n++) {
+		/* Back and forth over 32 steps, so the window stays put */
+		step = (n / 32) & 1 ? -1 : 1;
+		x += step * traces[i].dx;
+		y += step * traces[i].dy;
+		XMoveWindow(dpy, win, x, y);
+		if ((n & 15) == 15)
+			XSync(dpy, True);
+	}
+	XSync(dpy, True);
+	elapsed = emgd_test_now() - start;
+
+	if (perf && emgd_xtest_perf(dpy, &after)) {
+		snprintf(extra, sizeof(extra), "%.2f blits/move, "
+			 "%.0f damaged bytes/move",
+			 (double)(after.copy_window_blits -
+				  before.copy_window_blits) / iters,
+			 (double)(after.copy_window_bytes -
+				  before.copy_window_bytes) / iters);
+	} else {
+		snprintf(extra, sizeof(extra), "no EMGD counters");
+	}
+	snprintf(name, sizeof(name), "%s", traces[i].name);
+	emgd_bench_report(name, iters, elapsed, 0, extra);
+
+	if (sibling != None)
+		XDestroyWindow(dpy, sibling);
+	XFreeGC(dpy, gc);
+	XDestroyWindow(dpy, win);
+}
+
+int main(int argc, char **argv)
+{
+	long iters = emgd_bench_iterations(argc, argv, 4096);
+	Display *dpy = emgd_xtest_open();
+	int i;
+
+	if (dpy == NULL)
+		return EMGD_TEST_SKIP;
+
+	for (i = 0; i < sizeof(traces) / sizeof(traces[0]); i++)
+		bench_trace(dpy, i, iters);
+
+	XCloseDisplay(dpy);
+	return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: bench_core_text.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Replays xterm scrolling through a build log on a live server: an 80x24
+ *  terminal in the "fixed" font, where every new line scrolls the window
+ *  up one row with CopyArea, clears the bottom row and draws the line
+ *  with ImageText.  The coloured variant draws each line as three
+ *  ImageText runs in different colours, as "ls --color" or a compiler's
+ *  diagnostics do.  Reports lines per second and, when the server has the
+ *  EMGD extension, glyph blt fallbacks, GTT mappings and accelerated
+ *  strings per line.
+ *
+ *  Runs against $EMGD_TEST_DISPLAY, see emgd_xtest.h.
+ *
+ *  Usage: bench_core_text [iterations]
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "emgd_test.h"
+#include "emgd_xtest.h"
+
+#define BENCH_COLS	80
+#define BENCH_ROWS	24
+
+/* Recorded from "make -f Makefile.gnu" */
+static const char *log_lines[] = {
+	" Compiling /build/emgd/src/emgd_driver.c",
+	" Compiling /build/emgd/src/emgd_uxa.c",
+	"emgd_uxa.c: In function 'intel_uxa_prepare_access':",
+	"emgd_uxa.c:812:13: warning: unused variable 'priv' [-Wunused-variable]",
+	" Compiling /build/emgd/src/intel_batchbuffer.c",
+	" Compiling /build/emgd/src/i965_render.c",
+	" Compiling /build/emgd/uxa/uxa-accel.c",
+	" Compiling /build/emgd/uxa/uxa-glyphs.c",
+	"",
+	" Linking /build/emgd/objects/emgd_drv.so",
+	"make[1]: Leaving directory '/build/emgd/src'",
+	"gcc -O2 -fPIC -Wall -I../include -I/usr/include/xorg -c uxa-render.c",
+};
+
+static void bench_trace(Display *dpy, Bool colour, long iters)
+{
+	unsigned long colours[3];
+	iegd_esc_perf_counters_t before, after;
+	XFontStruct *font;
+	Window win;
+	GC gc;
+	uint64_t start, elapsed;
+	char extra[128];
+	int cw, ch, ascent, width, height;
+	Bool perf;
+	long n;
+
+	font = XLoadQueryFont(dpy, "fixed");
+	if (font == NULL) {
+		fprintf(stderr, "no \"fixed\" font\n");
+		exit(EMGD_TEST_SKIP);
+	}
+	cw = font->max_bounds.width;
+	ascent = font->ascent;
+	ch = font->ascent + font->descent;
+	width = BENCH_COLS * cw;
+	height = BENCH_ROWS * ch;
+
+	win = emgd_xtest_window(dpy, 0, 0, width, height);
+	gc = XCreateGC(dpy, win, 0, NULL);
+	XSetFont(dpy, gc, font->fid);
+	colours[0] = BlackPixel(dpy, DefaultScreen(dpy));
+	colours[1] = 0x00cd0000;
+	colours[2] = 0x000000ee;
+	XSetBackground(dpy, gc, WhitePixel(dpy, DefaultScreen(dpy)));
+	XSetGraphicsExposures(dpy, gc, False);
+	XSync(dpy, True);
+
+	perf = emgd_xtest_perf(dpy, &before);
+	start = emgd_test_now();
+	for (n = 0; n < iters; n++) {
+		const char *line = log_lines[n % (sizeof(log_lines) /
+						  sizeof(log_lines[0]))];
+		int len = strlen(line);
+		int y = height - ch;
+
+		XCopyArea(dpy, win, win, gc, 0, ch, width, y, 0, 0);
+		XSetForeground(dpy, gc, WhitePixel(dpy, DefaultScreen(dpy)));
+		XFillRectangle(dpy, win, gc, 0, y, width, ch);
+
+		if (!colour) {
+			XSetForeground(dpy, gc, colours[0]);
+			XDrawImageString(dpy, win, gc, 0, y + ascent, line,
+					 len);
+		} else {
+			int i, x = 0;
+
+			for (i = 0; i < 3; i++) {
+				int run = i < 2 ? len / 3 : len - 2 * (len / 3);
+
+				XSetForeground(dpy, gc, colours[i]);
+				XDrawImageString(dpy, win, gc, x * cw,
+						 y + ascent, line + x, run);
+				x += run;
+			}
+		}
+		if ((n & 15) == 15)
+			XSync(dpy, True);
+	}
+	XSync(dpy, True);
+	elapsed = emgd_test_now() - start;
+
+	if (perf && emgd_xtest_perf(dpy, &after)) {
+		const uint64_t *a = after.fallbacks, *b = before.fallbacks;
+
+		snprintf(extra, sizeof(extra), "%.3f glyph blt fallbacks/line, "
+			 "%.3f GTT maps/line, %.2f strings/line",
+			 (double)(a[EMGD_PERF_FALLBACK_IMAGE_GLYPH_BLT] -
+				  b[EMGD_PERF_FALLBACK_IMAGE_GLYPH_BLT] +
+				  a[EMGD_PERF_FALLBACK_POLY_GLYPH_BLT] -
+				  b[EMGD_PERF_FALLBACK_POLY_GLYPH_BLT]) / iters,
+			 (double)(after.gtt_maps - before.gtt_maps) / iters,
+			 (double)(after.core_text_strings -
+				  before.core_text_strings) / iters);
+	} else {
+		snprintf(extra, sizeof(extra), "no EMGD counters");
+	}
+	emgd_bench_report(colour ? "xterm scroll, coloured" : "xterm scroll",
+			  iters, elapsed, 0, extra);
+
+	XFreeGC(dpy, gc);
+	XDestroyWindow(dpy, win);
+	XFreeFont(dpy, font);
+}
+
+int main(int argc, char **argv)
+{
+	long iters = emgd_bench_iterations(argc, argv, 4096);
+	Display *dpy = emgd_xtest_open();
+
+	if (dpy == NULL)
+		return EMGD_TEST_SKIP;
+
+	bench_trace(dpy, False, iters);
+	bench_trace(dpy, True, iters);
+
+	XCloseDisplay(dpy);
+	return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: bench_dri2.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  GetBuffers/DestroyBuffers churn as a GL client resizing its window
+ *  produces it: each step creates back and depth buffers at the new size
+ *  and releases the previous ones, cycling through a few sizes.  Reports
+ *  bo allocations, new flink names and GEM create/close/flink ioctls per
+ *  step, with the DRI2 buffer cache and without it.  libdrm never reuses
+ *  a flinked bo, so without the cache each of these reaches the kernel.
+ *
+ *  emgd_dri2.c is included for its static buffer hooks.
+ *
+ *  Usage: bench_dri2 [iterations]
+ *-----------------------------------------------------------------------------
+ */
+
+#include "../emgd_dri2.c"
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+
+static const struct {
+	int width, height;
+} sizes[] = {
+	{ 640, 480 },
+	{ 800, 600 },
+	{ 1024, 768 },
+};
+
+static const unsigned int attachments[] = {
+	DRI2BufferBackLeft,
+	DRI2BufferDepth,
+};
+
+#define NUM_ATTACHMENTS	ARRAY_SIZE(attachments)
+
+static PixmapPtr bench_create_pixmap(ScreenPtr screen, int w, int h,
+	int depth, unsigned usage)
+{
+	uint32_t tiling = I915_TILING_NONE;
+
+	if (usage & INTEL_CREATE_PIXMAP_TILING_X)
+		tiling = I915_TILING_X;
+	else if (usage & INTEL_CREATE_PIXMAP_TILING_Y)
+		tiling = I915_TILING_Y;
+
+	return emgd_test_pixmap(xf86Screens[screen->myNum], w, h,
+		depth == 24 ? 32 : depth, tiling);
+}
+
+static Bool bench_destroy_pixmap(PixmapPtr pixmap)
+{
+	emgd_test_pixmap_free(pixmap);
+	return TRUE;
+}
+
+static void bench_churn(Bool cached, long iters)
+{
+	ScrnInfoPtr scrn;
+	ScreenPtr screen;
+	DrawableRec drawable;
+	DRI2Buffer2Ptr buffers[NUM_ATTACHMENTS], old[NUM_ATTACHMENTS];
+	unsigned long allocs, bo_allocs, flinks, ioctls;
+	uint64_t start, elapsed;
+	char name[64], extra[96];
+	long i;
+	int j;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	screen = scrn->pScreen;
+	screen->CreatePixmap = bench_create_pixmap;
+	screen->DestroyPixmap = bench_destroy_pixmap;
+	EMGDPTR(scrn)->dri2_inuse = cached;
+
+	memset(&drawable, 0, sizeof(drawable));
+	drawable.type = DRAWABLE_WINDOW;
+	drawable.id = 0x200001;
+	drawable.pScreen = screen;
+	drawable.depth = 24;
+	drawable.bitsPerPixel = 32;
+	memset(old, 0, sizeof(old));
+
+	allocs = emgd_test_allocs;
+	bo_allocs = mock_drm.stats.bo_allocs;
+	flinks = mock_drm.stats.flinks;
+	ioctls = mock_drm.stats.bo_allocs + mock_drm.stats.bo_frees +
+		mock_drm.stats.flinks;
+	start = emgd_test_now();
+	for (i = 0; i < iters; i++) {
+		drawable.width = sizes[i % ARRAY_SIZE(sizes)].width;
+		drawable.height = sizes[i % ARRAY_SIZE(sizes)].height;
+
+		/* DRI2 allocates the new set before releasing the old one */
+		for (j = 0; j < NUM_ATTACHMENTS; j++) {
+			buffers[j] = emgd_dri2_create_buffer(&drawable,
+				attachments[j], 0);
+			if (buffers[j] == NULL) {
+				fprintf(stderr, "buffer allocation failed\n");
+				exit(1);
+			}
+		}
+		for (j = 0; j < NUM_ATTACHMENTS; j++) {
+			emgd_dri2_destroy_buffer(&drawable, old[j]);
+			old[j] = buffers[j];
+		}
+	}
+	elapsed = emgd_test_now() - start;
+
+	snprintf(name, sizeof(name), "resize churn, %s",
+		cached ? "buffer cache" : "no cache");
+	snprintf(extra, sizeof(extra),
+		"%.3f bo allocs/op, %.3f flinks/op, %.3f ioctls/op",
+		(double)(mock_drm.stats.bo_allocs - bo_allocs) / iters,
+		(double)(mock_drm.stats.flinks - flinks) / iters,
+		(double)(mock_drm.stats.bo_allocs + mock_drm.stats.bo_frees +
+			 mock_drm.stats.flinks - ioctls) / iters);
+	emgd_bench_report(name, iters, elapsed, emgd_test_allocs - allocs,
+		extra);
+
+	for (j = 0; j < NUM_ATTACHMENTS; j++)
+		emgd_dri2_destroy_buffer(&drawable, old[j]);
+	emgd_dri2_cache_fini(screen);
+	emgd_test_screen_free(scrn);
+}
+
+int main(int argc, char **argv)
+{
+	long iters = emgd_bench_iterations(argc, argv, 100000);
+
+	bench_churn(TRUE, iters);
+	bench_churn(FALSE, iters);
+
+	return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: bench_get_image.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Full-screen grabs of a 1920x1080 X-tiled pixmap that the GPU has just
+ *  drawn to, read in the 8-row bands dix splits a 64 KiB GetImage buffer
+ *  into.  Compares intel_uxa_get_image(), which reads through the staging
+ *  pixmaps, with reading each band straight from the source.  Reports
+ *  MB/s and, per grab, submits, stalls and the simulated GPU wait.
+ *
+ *  mock_drm mappings are cached memory and its blits are instantaneous
+ *  memcpys, so the MB/s figures only compare the CPU side.
+ *
+ *  emgd_uxa.c is included for its static UXA hooks.
+ *
+ *  Usage: bench_get_image [iterations]
+ *-----------------------------------------------------------------------------
+ */
+
+#include "../emgd_uxa.c"
+
+#include <stdlib.h>
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+
+#define BENCH_WIDTH	1920
+#define BENCH_HEIGHT	1080
+#define BENCH_BAND	(65536 / (BENCH_WIDTH * 4))
+
+static void bench_case(const char *name, Bool staging, long iters)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr pixmap;
+	mock_drm_stats_t before;
+	unsigned long allocs;
+	uint64_t start, elapsed;
+	char extra[128];
+	char *dst;
+	long i;
+	int y, h;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	pixmap = emgd_test_pixmap(scrn, BENCH_WIDTH, BENCH_HEIGHT, 32,
+		I915_TILING_X);
+	dst = malloc(BENCH_WIDTH * 4 * BENCH_BAND);
+
+	before = mock_drm.stats;
+	allocs = emgd_test_allocs;
+	start = emgd_test_now();
+	for (i = 0; i < iters; i++) {
+		/* Something was just drawn */
+		emgd_test_blt_fill(scrn, pixmap, 0, 0, 64, 64);
+		intel_batch_submit(scrn);
+
+		for (y = 0; y < BENCH_HEIGHT; y += h) {
+			Bool ret;
+
+			h = BENCH_HEIGHT - y < BENCH_BAND ?
+				BENCH_HEIGHT - y : BENCH_BAND;
+			if (staging)
+				ret = intel_uxa_get_image(pixmap, 0, y,
+					BENCH_WIDTH, h, dst, BENCH_WIDTH * 4);
+			else
+				ret = intel_uxa_pixmap_get_image(pixmap, 0, y,
+					BENCH_WIDTH, h, dst, BENCH_WIDTH * 4);
+			if (!ret) {
+				fprintf(stderr, "%s: get_image failed\n", name);
+				exit(1);
+			}
+		}
+	}
+	elapsed = emgd_test_now() - start;
+
+	snprintf(extra, sizeof(extra),
+		"%.0f MB/s, %.1f submits/grab, %.1f stalls/grab, "
+		"%.3f ms GPU wait/grab",
+		(double)BENCH_WIDTH * BENCH_HEIGHT * 4 * iters /
+			(1024 * 1024) / ((elapsed ? elapsed : 1) / 1e9),
+		(double)(mock_drm.stats.execs - before.execs) / iters,
+		(double)(mock_drm.stats.stalls - before.stalls) / iters,
+		(double)(mock_drm.stats.stall_ns - before.stall_ns) / iters /
+			1e6);
+	emgd_bench_report(name, iters, elapsed, emgd_test_allocs - allocs,
+		extra);
+
+	intel_uxa_fini(scrn->pScreen);
+	free(dst);
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+int main(int argc, char **argv)
+{
+	long iters = emgd_bench_iterations(argc, argv, 200);
+
+	bench_case("1920x1080 grab, staging", TRUE, iters);
+	bench_case("1920x1080 grab, direct", FALSE, iters);
+
+	return 0;
+}
@@ -0,0 +1,180 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: bench_lines.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Replays what instrument-panel clients draw on a live server, a frame
+ *  at a time:
+ *    - gauge: a 3 pixel wide 270 degree dial arc, 28 diagonal tick
+ *      segments, a 5 pixel wide round-capped needle and a filled hub,
+ *    - trend: a dashed grid and a 400 point thin polyline plot.
+ *  Each frame clears the area first.  Reports frames per second and,
+ *  when the server has the EMGD extension, software fallbacks and GTT
+ *  mappings per frame.
+ *
+ *  Runs against $EMGD_TEST_DISPLAY, see emgd_xtest.h.
+ *
+ *  Usage: bench_lines [iterations]
+ *-----------------------------------------------------------------------------
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "emgd_test.h"
+#include "emgd_xtest.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BENCH_SIZE	400
+#define BENCH_TICKS	28
+#define BENCH_PLOT	400
+
+static void draw_gauge(Display *dpy, Window win, GC gc, long frame)
+{
+	int cx = BENCH_SIZE / 2, cy = BENCH_SIZE / 2, r = BENCH_SIZE / 2 - 20;
+	double needle = (225 - 270 * (frame % 100) / 100.0) * M_PI / 180;
+	XSegment ticks[BENCH_TICKS];
+	int i;
+
+	XSetLineAttributes(dpy, gc, 3, LineSolid, CapButt, JoinMiter);
+	XDrawArc(dpy, win, gc, cx - r, cy - r, 2 * r, 2 * r,
+		 -45 * 64, 270 * 64);
+
+	for (i = 0; i < BENCH_TICKS; i++) {
+		double a = (225 - 270.0 * i / (BENCH_TICKS - 1)) * M_PI / 180;
+		int len = i % 3 ? 8 : 16;
+
+		ticks[i].x1 = cx + (r - 4) * cos(a);
+		ticks[i].y1 = cy - (r - 4) * sin(a);
+		ticks[i].x2 = cx + (r - 4 - len) * cos(a);
+		ticks[i].y2 = cy - (r - 4 - len) * sin(a);
+	}
+	XSetLineAttributes(dpy, gc, 2, LineSolid, CapButt, JoinMiter);
+	XDrawSegments(dpy, win, gc, ticks, BENCH_TICKS);
+
+	XSetLineAttributes(dpy, gc, 5, LineSolid, CapRound, JoinRound);
+	XDrawLine(dpy, win, gc, cx, cy, cx + (r - 30) * cos(needle),
+		  cy - (r - 30) * sin(needle));
+	XFillArc(dpy, win, gc, cx - 10, cy - 10, 20, 20, 0, 360 * 64);
+}
+
+static void draw_trend(Display *dpy, Window win, GC gc, long frame)
+{
+	static const char dashes[] = { 2, 4 };
+	XSegment grid[18];
+	XPoint plot[BENCH_PLOT];
+	int i;
+
+	for (i = 0; i < 9; i++) {
+		grid[i].x1 = 0;
+		grid[i].x2 = BENCH_SIZE;
+		grid[i].y1 = grid[i].y2 = (i + 1) * BENCH_SIZE / 10;
+		grid[9 + i].y1 = 0;
+		grid[9 + i].y2 = BENCH_SIZE;
+		grid[9 + i].x1 = grid[9 + i].x2 = (i + 1) * BENCH_SIZE / 10;
+	}
+	XSetLineAttributes(dpy, gc, 0, LineOnOffDash, CapButt, JoinMiter);
+	XSetDashes(dpy, gc, 0, dashes, 2);
+	XDrawSegments(dpy, win, gc, grid, 18);
+
+	for (i = 0; i < BENCH_PLOT; i++) {
+		double t = (i + frame) * 0.05;
+
+		plot[i].x = i * BENCH_SIZE / BENCH_PLOT;
+		plot[i].y = BENCH_SIZE / 2 +
+			(BENCH_SIZE / 3) * sin(t) * cos(t * 0.13);
+	}
+	XSetLineAttributes(dpy, gc, 0, LineSolid, CapButt, JoinMiter);
+	XDrawLines(dpy, win, gc, plot, BENCH_PLOT, CoordModeOrigin);
+}
+
+static const struct {
+	const char *name;
+	void (*draw)(Display *dpy, Window win, GC gc, long frame);
+} traces[] = {
+	{ "gauge", draw_gauge },
+	{ "trend", draw_trend },
+};
+
+static void bench_trace(Display *dpy, int i, long iters)
+{
+	unsigned long black = BlackPixel(dpy, DefaultScreen(dpy));
+	unsigned long white = WhitePixel(dpy, DefaultScreen(dpy));
+	iegd_esc_perf_counters_t before, after;
+	Window win;
+	GC gc;
+	uint64_t start, elapsed;
+	char extra[96];
+	Bool perf;
+	long n;
+
+	win = emgd_xtest_window(dpy, 0, 0, BENCH_SIZE, BENCH_SIZE);
+	gc = XCreateGC(dpy, win, 0, NULL);
+	XSync(dpy, True);
+
+	perf = emgd_xtest_perf(dpy, &before);
+	start = emgd_test_now();
+	for (n = 0; n < iters; n++) {
+		XSetForeground(dpy, gc, white);
+		XFillRectangle(dpy, win, gc, 0, 0, BENCH_SIZE, BENCH_SIZE);
+		XSetForeground(dpy, gc, black);
+		traces[i].draw(dpy, win, gc, n);
+		if ((n & 15) == 15)
+			XSync(dpy, True);
+	}
+	XSync(dpy, True);
+	elapsed = emgd_test_now() - start;
+
+	if (perf && emgd_xtest_perf(dpy, &after))
+		snprintf(extra, sizeof(extra),
+			 "%.3f fallbacks/frame, %.3f GTT maps/frame",
+			 (double)(emgd_xtest_fallbacks(&after) -
+				  emgd_xtest_fallbacks(&before)) / iters,
+			 (double)(after.gtt_maps - before.gtt_maps) / iters);
+	else
+		snprintf(extra, sizeof(extra), "no EMGD counters");
+	emgd_bench_report(traces[i].name, iters, elapsed, 0, extra);
+
+	XFreeGC(dpy, gc);
+	XDestroyWindow(dpy, win);
+}
+
+int main(int argc, char **argv)
+{
+	long iters = emgd_bench_iterations(argc, argv, 2048);
+	Display *dpy = emgd_xtest_open();
+	int i;
+
+	if (dpy == NULL)
+		return EMGD_TEST_SKIP;
+
+	for (i = 0; i < sizeof(traces) / sizeof(traces[0]); i++)
+		bench_trace(dpy, i, iters);
+
+	XCloseDisplay(dpy);
+	return 0;
+}
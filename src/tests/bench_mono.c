@@ -0,0 +1,177 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: bench_mono.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Replays what a Motif or Xt client draws with 1-bpp stipples and bitmaps
+ *  on a live server, one kind of operation at a time:
+ *    - buttons: 96x32 FillOpaqueStippled with the 8x8 50% grey,
+ *    - backdrop: a 320x240 FillStippled area with a 16x16 pattern,
+ *    - icons: 32x32 bitmaps put with CopyPlane,
+ *    - insensitive labels: text through a stippled GC, which fb draws
+ *      with PushPixels.
+ *  Reports operations per second and, when the server has the EMGD
+ *  extension, software fallbacks and GTT mappings per operation.
+ *
+ *  Runs against $EMGD_TEST_DISPLAY, see emgd_xtest.h.
+ *
+ *  Usage: bench_mono [iterations]
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+
+#include "emgd_test.h"
+#include "emgd_xtest.h"
+
+#define BENCH_WIDTH	640
+#define BENCH_HEIGHT	480
+
+static const char grey_bits[] = {
+	0x55, 0xaa, 0x55, 0xaa, 0x55, 0xaa, 0x55, 0xaa,
+};
+
+static const char weave_bits[] = {
+	0x11, 0x11, 0xb8, 0xb8, 0x7c, 0x7c, 0x3a, 0x3a,
+	0x11, 0x11, 0xa3, 0xa3, 0xc7, 0xc7, 0x8b, 0x8b,
+	0x11, 0x11, 0xb8, 0xb8, 0x7c, 0x7c, 0x3a, 0x3a,
+	0x11, 0x11, 0xa3, 0xa3, 0xc7, 0xc7, 0x8b, 0x8b,
+};
+
+enum { BENCH_BUTTON, BENCH_BACKDROP, BENCH_ICON, BENCH_LABEL };
+
+static const struct {
+	const char *name;
+	int op;
+} traces[] = {
+	{ "buttons", BENCH_BUTTON },
+	{ "backdrop", BENCH_BACKDROP },
+	{ "icons", BENCH_ICON },
+	{ "insensitive labels", BENCH_LABEL },
+};
+
+static void bench_trace(Display *dpy, int i, long iters)
+{
+	iegd_esc_perf_counters_t before, after;
+	Window win;
+	Pixmap grey, weave, icon;
+	Font font;
+	GC gc;
+	char icon_bits[32 * 32 / 8];
+	uint64_t start, elapsed;
+	char extra[96];
+	Bool perf;
+	long n;
+	int j;
+
+	win = emgd_xtest_window(dpy, 0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+	gc = XCreateGC(dpy, win, 0, NULL);
+	grey = XCreateBitmapFromData(dpy, win, grey_bits, 8, 8);
+	weave = XCreateBitmapFromData(dpy, win, weave_bits, 16, 16);
+	for (j = 0; j < sizeof(icon_bits); j++)
+		icon_bits[j] = j * 37;
+	icon = XCreateBitmapFromData(dpy, win, icon_bits, 32, 32);
+	font = XLoadFont(dpy, "fixed");
+
+	XSetForeground(dpy, gc, BlackPixel(dpy, DefaultScreen(dpy)));
+	XSetBackground(dpy, gc, WhitePixel(dpy, DefaultScreen(dpy)));
+	XSetFont(dpy, gc, font);
+	switch (traces[i].op) {
+	case BENCH_BUTTON:
+		XSetStipple(dpy, gc, grey);
+		XSetFillStyle(dpy, gc, FillOpaqueStippled);
+		break;
+	case BENCH_BACKDROP:
+		XSetStipple(dpy, gc, weave);
+		XSetFillStyle(dpy, gc, FillStippled);
+		break;
+	case BENCH_LABEL:
+		XSetStipple(dpy, gc, grey);
+		XSetFillStyle(dpy, gc, FillStippled);
+		break;
+	}
+	XSync(dpy, True);
+
+	perf = emgd_xtest_perf(dpy, &before);
+	start = emgd_test_now();
+	for (n = 0; n < iters; n++) {
+		/* Walk a 4x8 grid of widgets */
+		int x = (n & 3) * 160;
+		int y = ((n >> 2) & 7) * 60;
+
+		switch (traces[i].op) {
+		case BENCH_BUTTON:
+			XFillRectangle(dpy, win, gc, x + 8, y + 8, 96, 32);
+			break;
+		case BENCH_BACKDROP:
+			XFillRectangle(dpy, win, gc, x / 2, y / 2, 320, 240);
+			break;
+		case BENCH_ICON:
+			XCopyPlane(dpy, icon, win, gc, 0, 0, 32, 32,
+				   x + 8, y + 8, 1);
+			break;
+		case BENCH_LABEL:
+			XDrawString(dpy, win, gc, x + 8, y + 24,
+				    "Cancel Operation", 16);
+			break;
+		}
+		if ((n & 15) == 15)
+			XSync(dpy, True);
+	}
+	XSync(dpy, True);
+	elapsed = emgd_test_now() - start;
+
+	if (perf && emgd_xtest_perf(dpy, &after))
+		snprintf(extra, sizeof(extra),
+			 "%.3f fallbacks/op, %.3f GTT maps/op",
+			 (double)(emgd_xtest_fallbacks(&after) -
+				  emgd_xtest_fallbacks(&before)) / iters,
+			 (double)(after.gtt_maps - before.gtt_maps) / iters);
+	else
+		snprintf(extra, sizeof(extra), "no EMGD counters");
+	emgd_bench_report(traces[i].name, iters, elapsed, 0, extra);
+
+	XUnloadFont(dpy, font);
+	XFreePixmap(dpy, grey);
+	XFreePixmap(dpy, weave);
+	XFreePixmap(dpy, icon);
+	XFreeGC(dpy, gc);
+	XDestroyWindow(dpy, win);
+}
+
+int main(int argc, char **argv)
+{
+	long iters = emgd_bench_iterations(argc, argv, 8192);
+	Display *dpy = emgd_xtest_open();
+	int i;
+
+	if (dpy == NULL)
+		return EMGD_TEST_SKIP;
+
+	for (i = 0; i < sizeof(traces) / sizeof(traces[0]); i++)
+		bench_trace(dpy, i, iters);
+
+	XCloseDisplay(dpy);
+	return 0;
+}
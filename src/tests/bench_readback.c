@@ -0,0 +1,120 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: bench_readback.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Read throughput of intel_uxa_pixmap_get_image() for each access path it
+ *  picks: pread of whole rows, a GTT mapping for small rectangles, a cached
+ *  CPU mapping for large linear ones and detiling out of a cached mapping
+ *  for large X/Y-tiled ones.  Each case prints MB/s and the mappings and
+ *  preads per read, so a change in the path selection shows up as well as
+ *  a change in the copy loops.
+ *
+ *  mock_drm mappings are ordinary cached memory, so the GTT figures are an
+ *  upper bound: on hardware they pay the uncached read penalty that the
+ *  other paths avoid.
+ *
+ *  Usage: bench_readback [iterations]
+ *-----------------------------------------------------------------------------
+ */
+
+#include "../emgd_uxa.c"
+
+#include <stdlib.h>
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+
+#define BENCH_WIDTH	1024
+#define BENCH_HEIGHT	768
+
+static void bench_case(const char *name, uint32_t tiling, int w, int h,
+	Bool full_rows, long iters)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr pixmap;
+	mock_drm_stats_t before;
+	unsigned long allocs;
+	uint64_t start, elapsed;
+	char extra[128];
+	int dst_pitch;
+	char *dst;
+	long i;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	pixmap = emgd_test_pixmap(scrn, BENCH_WIDTH, BENCH_HEIGHT, 32, tiling);
+	dst_pitch = full_rows ? intel_pixmap_pitch(pixmap) : w * 4;
+	dst = malloc((size_t)dst_pitch * h);
+
+	before = mock_drm.stats;
+	allocs = emgd_test_allocs;
+	start = emgd_test_now();
+	for (i = 0; i < iters; i++) {
+		/* Walk down the pixmap so consecutive reads don't overlap */
+		int y = (i * h) % (BENCH_HEIGHT - h + 1);
+
+		if (!intel_uxa_pixmap_get_image(pixmap, 0, y, w, h,
+						dst, dst_pitch)) {
+			fprintf(stderr, "%s: get_image failed\n", name);
+			exit(1);
+		}
+	}
+	elapsed = emgd_test_now() - start;
+
+	snprintf(extra, sizeof(extra),
+		"%.0f MB/s, %.2f gtt maps/op, %.2f cpu maps/op, %.2f preads/op",
+		(double)w * h * 4 * iters / (1024 * 1024) /
+			((elapsed ? elapsed : 1) / 1e9),
+		(double)(mock_drm.stats.gtt_maps - before.gtt_maps) / iters,
+		(double)(mock_drm.stats.cpu_maps - before.cpu_maps) / iters,
+		(double)(mock_drm.stats.get_subdata - before.get_subdata) / iters);
+	emgd_bench_report(name, iters, elapsed, emgd_test_allocs - allocs,
+		extra);
+
+	free(dst);
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+int main(int argc, char **argv)
+{
+	long iters = emgd_bench_iterations(argc, argv, 2000);
+
+	bench_case("linear, full rows (pread)", I915_TILING_NONE,
+		BENCH_WIDTH, 64, TRUE, iters);
+	bench_case("linear, 64x64 (gtt)", I915_TILING_NONE,
+		64, 64, FALSE, iters);
+	bench_case("linear, 512x768 (cpu)", I915_TILING_NONE,
+		512, BENCH_HEIGHT, FALSE, iters);
+	bench_case("X-tiled, 64x64 (gtt)", I915_TILING_X,
+		64, 64, FALSE, iters);
+	bench_case("X-tiled, 512x768 (detile)", I915_TILING_X,
+		512, BENCH_HEIGHT, FALSE, iters);
+	bench_case("Y-tiled, 512x768 (detile)", I915_TILING_Y,
+		512, BENCH_HEIGHT, FALSE, iters);
+
+	return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: bench_tiling.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  GB/s of emgd_detile_rect() and emgd_tile_rect() for X and Y tiling,
+ *  with and without bit-6 swizzling, on a whole 1920x1080x32 surface and
+ *  on 64x64 rectangles.  A plain memcpy of the same rows is the baseline.
+ *
+ *  Usage: bench_tiling [iterations]
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <i915_drm.h>
+
+#include "emgd_test.h"
+#include "emgd_tiling.h"
+
+#define BENCH_PITCH	(8 * 1024)	/* 1920 * 4 rounded up to X and Y tiles */
+#define BENCH_HEIGHT	1088		/* 1080 rounded up to Y tiles */
+
+enum { BENCH_MEMCPY, BENCH_DETILE, BENCH_TILE };
+
+static uint8_t *tiled, *linear;
+
+static void bench_case(const char *name, int op, uint32_t tiling,
+	uint32_t swizzle, int w, int h, long iters)
+{
+	unsigned long allocs;
+	uint64_t start, elapsed;
+	char extra[32];
+	long i;
+	int j;
+
+	allocs = emgd_test_allocs;
+	start = emgd_test_now();
+	for (i = 0; i < iters; i++) {
+		/* Move small rectangles around so they don't stay in L1 */
+		int x = w < 1920 ? (i * 4 * w) % (1920 * 4 - w * 4) : 0;
+		int y = h < 1080 ? (i * h) % (1080 - h) : 0;
+
+		switch (op) {
+		case BENCH_MEMCPY:
+			for (j = 0; j < h; j++)
+				memcpy(linear + j * w * 4,
+				       tiled + (y + j) * BENCH_PITCH + x, w * 4);
+			break;
+		case BENCH_DETILE:
+			emgd_detile_rect(linear, w * 4, tiled, BENCH_PITCH,
+					 tiling, swizzle, x, y, w * 4, h);
+			break;
+		case BENCH_TILE:
+			emgd_tile_rect(tiled, BENCH_PITCH, tiling, swizzle,
+				       linear, w * 4, x, y, w * 4, h);
+			break;
+		}
+	}
+	elapsed = emgd_test_now() - start;
+
+	snprintf(extra, sizeof(extra), "%.2f GB/s",
+		(double)w * h * 4 * iters / (elapsed ? elapsed : 1));
+	emgd_bench_report(name, iters, elapsed, emgd_test_allocs - allocs,
+		extra);
+}
+
+static void bench_size(const char *size, int w, int h, long iters)
+{
+	static const struct {
+		const char *name;
+		uint32_t tiling;
+		uint32_t swizzle;
+	} layouts[] = {
+		{ "X", I915_TILING_X, I915_BIT_6_SWIZZLE_NONE },
+		{ "X swizzled", I915_TILING_X, I915_BIT_6_SWIZZLE_9_10 },
+		{ "Y", I915_TILING_Y, I915_BIT_6_SWIZZLE_NONE },
+		{ "Y swizzled", I915_TILING_Y, I915_BIT_6_SWIZZLE_9 },
+	};
+	char name[64];
+	int i;
+
+	snprintf(name, sizeof(name), "memcpy, %s", size);
+	bench_case(name, BENCH_MEMCPY, I915_TILING_NONE, 0, w, h, iters);
+
+	for (i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+		snprintf(name, sizeof(name), "detile %s, %s",
+			 layouts[i].name, size);
+		bench_case(name, BENCH_DETILE, layouts[i].tiling,
+			   layouts[i].swizzle, w, h, iters);
+		snprintf(name, sizeof(name), "tile %s, %s",
+			 layouts[i].name, size);
+		bench_case(name, BENCH_TILE, layouts[i].tiling,
+			   layouts[i].swizzle, w, h, iters);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	long iters = emgd_bench_iterations(argc, argv, 200);
+
+	if (posix_memalign((void **)&tiled, 4096,
+			   (size_t)BENCH_PITCH * BENCH_HEIGHT) ||
+	    posix_memalign((void **)&linear, 4096,
+			   (size_t)BENCH_PITCH * BENCH_HEIGHT))
+		return 1;
+	memset(tiled, 0x5a, (size_t)BENCH_PITCH * BENCH_HEIGHT);
+	memset(linear, 0xa5, (size_t)BENCH_PITCH * BENCH_HEIGHT);
+
+	bench_size("1920x1080", 1920, 1080, iters);
+	bench_size("64x64", 64, 64, iters * 500);
+
+	free(tiled);
+	free(linear);
+	return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: bench_trace.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Cost of the event trace, with recording on and off:
+ *    - emgd_trace() on its own, the price of one record,
+ *    - a BLT fill per batch through intel_batch_submit(), which records a
+ *      BATCH_SUBMIT event per batch, measured against mock_drm so that
+ *      only driver overhead is counted.
+ *  The difference between the two submit cases is what leaving the
+ *  "Trace" option on costs on the hottest traced path.
+ *
+ *  Usage: bench_trace [iterations]
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+#include "intel_batchbuffer.h"
+#include "emgd_trace.h"
+
+static void bench_record(const char *name, int enable, long iters)
+{
+	unsigned long allocs;
+	uint64_t start, elapsed;
+	char extra[64];
+	long i;
+
+	emgd_trace_init(enable, NULL);
+
+	allocs = emgd_test_allocs;
+	start = emgd_test_now();
+	for (i = 0; i < iters; i++) {
+		EMGD_TRACE(BATCH_SUBMIT, 0, i, 0, 0);
+		/* Keep the disabled check in the loop, as it is in the driver */
+		__asm__ __volatile__("" ::: "memory");
+	}
+	elapsed = emgd_test_now() - start;
+
+	snprintf(extra, sizeof(extra), "%.1f ns/event",
+		(double)elapsed / iters);
+	emgd_bench_report(name, iters, elapsed, emgd_test_allocs - allocs,
+		extra);
+}
+
+static void bench_submit(const char *name, int enable, long iters)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr pixmap;
+	unsigned long allocs;
+	uint32_t head;
+	uint64_t start, elapsed;
+	char extra[64];
+	long i;
+
+	mock_drm_reset();
+	mock_drm.record_execs = 0;
+	mock_drm.exec_ns = 0;
+
+	emgd_trace_init(enable, NULL);
+	scrn = emgd_test_screen(70);
+	pixmap = emgd_test_pixmap(scrn, 256, 256, 32, I915_TILING_X);
+
+	head = emgd_trace_head;
+	allocs = emgd_test_allocs;
+	start = emgd_test_now();
+	for (i = 0; i < iters; i++) {
+		emgd_test_blt_fill(scrn, pixmap, 0, 0, 64, 64);
+		intel_batch_submit(scrn);
+	}
+	elapsed = emgd_test_now() - start;
+
+	snprintf(extra, sizeof(extra), "%.1f ns/batch, %.2f events/batch",
+		(double)elapsed / iters, (double)(emgd_trace_head - head) / iters);
+	emgd_bench_report(name, iters, elapsed, emgd_test_allocs - allocs,
+		extra);
+
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+int main(int argc, char **argv)
+{
+	long iters = emgd_bench_iterations(argc, argv, 200000);
+
+	bench_record("emgd_trace, recording off", 0, iters * 10);
+	bench_record("emgd_trace, recording on", 1, iters * 10);
+	bench_submit("blt fill + submit, trace off", 0, iters);
+	bench_submit("blt fill + submit, trace on", 1, iters);
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_test.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Result reporting, timing and allocation counting for the tests and
+ *  benchmarks.  See emgd_test.h.
+ *
+ *  Every test program is linked with --wrap for malloc, calloc and
+ *  realloc so that benchmarks can report heap allocations per operation.
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "emgd_test.h"
+
+int emgd_test_failures;
+unsigned long emgd_test_allocs;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+	__sync_fetch_and_add(&emgd_test_allocs, 1);
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+	__sync_fetch_and_add(&emgd_test_allocs, 1);
+	return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+	__sync_fetch_and_add(&emgd_test_allocs, 1);
+	return __real_realloc(ptr, size);
+}
+
+int emgd_test_done(const char *name)
+{
+	if (emgd_test_failures) {
+		printf("FAIL: %s (%d failed checks)\n", name, emgd_test_failures);
+		return 1;
+	}
+
+	printf("PASS: %s\n", name);
+	return 0;
+}
+
+uint64_t emgd_test_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+long emgd_bench_iterations(int argc, char **argv, long def)
+{
+	long n;
+
+	if (argc < 2)
+		return def;
+
+	n = strtol(argv[1], NULL, 0);
+	return n > 0 ? n : def;
+}
+
+void emgd_bench_report(const char *name, long ops, uint64_t ns,
+	unsigned long allocs, const char *extra)
+{
+	double secs = ns / 1e9;
+
+	printf("%-36s %12.0f ops/s %8.2f allocs/op%s%s\n", name,
+		secs > 0 ? ops / secs : 0.0,
+		ops ? (double)allocs / ops : 0.0,
+		extra ? "  " : "", extra ? extra : "");
+}
@@ -0,0 +1,136 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_test.h
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Checks, fixtures and timing helpers shared by the driver unit tests and
+ *  benchmarks.
+ *
+ *  Tests call CHECK*() as often as they like and return emgd_test_done()
+ *  from main(); a test that can't run in the current environment returns
+ *  EMGD_TEST_SKIP.  Benchmarks time a loop with emgd_test_now() and print
+ *  one line per case with emgd_bench_report().
+ *
+ *  The fixture is a single screen backed by mock_drm: a ScrnInfoRec with
+ *  an emgd_priv_t set up the way emgd_buffer_manager_init() and
+ *  intel_batch_init() would, and pixmaps that carry an intel_pixmap
+ *  private with a mock bo, without a running server.
+ *-----------------------------------------------------------------------------
+ */
+
+#ifndef _EMGD_TEST_H_
+#define _EMGD_TEST_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define EMGD_TEST_SKIP	77	/* Exit status for "not run" */
+
+extern int emgd_test_failures;
+extern unsigned long emgd_test_allocs;	/* malloc/calloc/realloc calls */
+
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		fprintf(stderr, "%s:%d: %s: check failed: %s\n", \
+			__FILE__, __LINE__, __func__, #cond); \
+		emgd_test_failures++; \
+	} \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+	long long _a = (long long)(a), _b = (long long)(b); \
+	if (_a != _b) { \
+		fprintf(stderr, "%s:%d: %s: check failed: %s == %s " \
+			"(%lld != %lld)\n", __FILE__, __LINE__, __func__, \
+			#a, #b, _a, _b); \
+		emgd_test_failures++; \
+	} \
+} while (0)
+
+/* Print the result and turn it into an exit status. */
+extern int emgd_test_done(const char *name);
+
+/* CLOCK_MONOTONIC in nanoseconds, for benchmarks. */
+extern uint64_t emgd_test_now(void);
+
+/* Iterations for benchmarks: argv[1] if given, else def. */
+extern long emgd_bench_iterations(int argc, char **argv, long def);
+
+/* "<name>: <ops/s> ops/s, <allocs/op> allocs/op[, <extra>]" */
+extern void emgd_bench_report(const char *name, long ops, uint64_t ns,
+	unsigned long allocs, const char *extra);
+
+/*
+ * Anything below needs the driver headers, so only tests and benchmarks
+ * that link driver objects include them (EMGD_TEST_DRIVER).
+ */
+#ifdef EMGD_TEST_DRIVER
+
+#include <xf86.h>
+#include "emgd.h"
+#include "emgd_uxa.h"
+
+/* Create the screen for a given INTEL_INFO()->gen (60, 70 ...). */
+extern ScrnInfoPtr emgd_test_screen(int gen);
+extern void emgd_test_screen_free(ScrnInfoPtr scrn);
+
+/* A w x h pixmap of bpp bits in a mock bo with the given tiling. */
+extern PixmapPtr emgd_test_pixmap(ScrnInfoPtr scrn, int w, int h, int bpp,
+	uint32_t tiling);
+extern void emgd_test_pixmap_free(PixmapPtr pixmap);
+
+/*
+ * Read or write a rectangle of a test pixmap's bo directly, in its tiled
+ * layout, as the GPU sees it.  Pitches are in bytes.
+ */
+extern void emgd_test_pixmap_read(PixmapPtr pixmap, int x, int y, int w,
+	int h, void *dst, int dst_pitch);
+extern void emgd_test_pixmap_write(PixmapPtr pixmap, int x, int y, int w,
+	int h, const void *src, int src_pitch);
+
+/*
+ * The test screen's CreatePixmap and DestroyPixmap hand out test pixmaps,
+ * tiled as the INTEL_CREATE_PIXMAP_TILING_* hint asks.  GetScratchGC()
+ * returns a GC whose CopyArea does what the blitter would: it queues an
+ * XY_SRC_COPY with emgd_test_blt_copy() and moves the pixels between the
+ * mock bos (the tests using it link emgd_tiling.o).
+ */
+
+/*
+ * Queue a solid fill or a copy on the BLT ring, or a copy on the render
+ * ring, the way the UXA hooks do: same relocations, domains and damage.
+ */
+extern void emgd_test_blt_fill(ScrnInfoPtr scrn, PixmapPtr dst,
+	int x1, int y1, int x2, int y2);
+extern void emgd_test_blt_copy(ScrnInfoPtr scrn, PixmapPtr src, PixmapPtr dst,
+	int x1, int y1, int x2, int y2);
+extern void emgd_test_render_copy(ScrnInfoPtr scrn, PixmapPtr src,
+	PixmapPtr dst, int x1, int y1, int x2, int y2);
+
+/* Fire the TimerSet() timers that are due on the mock_drm timeline. */
+extern void emgd_test_run_timers(void);
+
+#endif /* EMGD_TEST_DRIVER */
+
+#endif /* _EMGD_TEST_H_ */
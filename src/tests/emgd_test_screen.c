@@ -0,0 +1,340 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_test_screen.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Single-screen fixture on top of mock_drm.  See emgd_test.h.
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <xf86.h>
+#include <scrnintstr.h>
+#include <pixmapstr.h>
+#include <gcstruct.h>
+
+#define EMGD_TEST_DRIVER
+#include "emgd.h"
+#include "emgd_uxa.h"
+#include "intel_batchbuffer.h"
+#include "i830_reg.h"
+#include "emgd_tiling.h"
+#include "emgd_test.h"
+#include "mock_drm.h"
+
+/*
+ * emgd_perf lives in emgd_api.c and uxa_pixmap_index in emgd_uxa.c; tests
+ * that don't link (or include) those get these.
+ */
+iegd_esc_perf_counters_t emgd_perf __attribute__((weak));
+DEV_PRIVATE_KEY_TYPE uxa_pixmap_index __attribute__((weak));
+
+/* As gen6_context_switch() in emgd_uxa.c */
+static void test_context_switch(intel_screen_private *intel, int new_mode)
+{
+	intel_batch_switch_ring(intel->scrn, new_mode);
+}
+
+typedef struct _test_screen {
+	ScrnInfoRec scrn;
+	ScreenRec screen;
+	emgd_priv_t intel;
+	struct intel_device_info info;
+	ScrnInfoPtr screens[1];
+} test_screen_t;
+
+static PixmapPtr test_create_pixmap(ScreenPtr screen, int w, int h,
+	int depth, unsigned usage)
+{
+	uint32_t tiling = I915_TILING_NONE;
+
+	if (usage & INTEL_CREATE_PIXMAP_TILING_X)
+		tiling = I915_TILING_X;
+	else if (usage & INTEL_CREATE_PIXMAP_TILING_Y)
+		tiling = I915_TILING_Y;
+
+	return emgd_test_pixmap(xf86Screens[screen->myNum], w, h,
+		depth == 24 ? 32 : depth, tiling);
+}
+
+static Bool test_destroy_pixmap(PixmapPtr pixmap)
+{
+	emgd_test_pixmap_free(pixmap);
+	return TRUE;
+}
+
+ScrnInfoPtr emgd_test_screen(int gen)
+{
+	test_screen_t *ts = calloc(1, sizeof(*ts));
+	emgd_priv_t *intel;
+
+	if (ts == NULL)
+		return NULL;
+
+	ts->info.gen = gen;
+	ts->scrn.scrnIndex = 0;
+	ts->scrn.pScreen = &ts->screen;
+	ts->scrn.driverPrivate = &ts->intel;
+	ts->screen.myNum = 0;
+	ts->screen.CreatePixmap = test_create_pixmap;
+	ts->screen.DestroyPixmap = test_destroy_pixmap;
+	ts->screens[0] = &ts->scrn;
+	xf86Screens = ts->screens;
+	screenInfo.screens[0] = &ts->screen;
+	screenInfo.numScreens = 1;
+
+	dixRegisterPrivateKey(&uxa_pixmap_index, PRIVATE_PIXMAP, 0);
+
+	/* What emgd_buffer_manager_init() sets up */
+	intel = &ts->intel;
+	intel->scrn = &ts->scrn;
+	intel->chipset.info = &ts->info;
+	intel->cpp = 4;
+	intel->bufmgr = mock_drm_bufmgr();
+	intel->max_gtt_map_size = 64 << 20;
+	intel->max_tiling_size = intel->max_gtt_map_size;
+	intel->max_bo_size = intel->max_gtt_map_size;
+	intel->aperture_limit = mock_drm.aperture_size / 2;
+	intel->can_blt = TRUE;
+	LIST_INIT(&intel->batch_pixmaps);
+	LIST_INIT(&intel->flush_pixmaps);
+	LIST_INIT(&intel->in_flight);
+	LIST_INIT(&intel->dri2_cache);
+	LIST_INIT(&intel->sprite_planes);
+	intel->context_switch = test_context_switch;
+	if (gen == 60)
+		intel->wa_scratch_bo = drm_intel_bo_alloc(intel->bufmgr,
+			"wa scratch", 4096, 4096);
+
+	intel_batch_init(&ts->scrn);
+	return &ts->scrn;
+}
+
+void emgd_test_screen_free(ScrnInfoPtr scrn)
+{
+	emgd_priv_t *intel = EMGDPTR(scrn);
+
+	intel_batch_teardown(scrn);
+	drm_intel_bo_unreference(intel->wa_scratch_bo);
+	free(scrn);	/* First member of test_screen_t */
+}
+
+PixmapPtr emgd_test_pixmap(ScrnInfoPtr scrn, int w, int h, int bpp,
+	uint32_t tiling)
+{
+	emgd_priv_t *intel = EMGDPTR(scrn);
+	struct intel_pixmap *priv;
+	unsigned long pitch;
+	PixmapPtr pixmap;
+
+	/* One private slot right behind the pixmap, see dixRegisterPrivateKey */
+	pixmap = calloc(1, sizeof(*pixmap) + sizeof(void *));
+	priv = calloc(1, sizeof(*priv));
+	if (pixmap == NULL || priv == NULL) {
+		free(pixmap);
+		free(priv);
+		return NULL;
+	}
+
+	priv->bo = drm_intel_bo_alloc_tiled(intel->bufmgr, "pixmap", w, h,
+		bpp / 8, &tiling, &pitch, 0);
+	if (priv->bo == NULL) {
+		free(pixmap);
+		free(priv);
+		return NULL;
+	}
+	priv->stride = pitch;
+	priv->tiling = tiling;
+	priv->busy = -1;
+	priv->offscreen = 1;
+	LIST_INIT(&priv->batch);
+	LIST_INIT(&priv->flush);
+
+	pixmap->drawable.type = DRAWABLE_PIXMAP;
+	pixmap->drawable.pScreen = scrn->pScreen;
+	pixmap->drawable.width = w;
+	pixmap->drawable.height = h;
+	pixmap->drawable.bitsPerPixel = bpp;
+	pixmap->drawable.depth = bpp == 32 ? 24 : bpp;
+	pixmap->devKind = pitch;
+	pixmap->refcnt = 1;
+	pixmap->devPrivates = (PrivateRec *)(pixmap + 1);
+	intel_set_pixmap_private(pixmap, priv);
+
+	return pixmap;
+}
+
+void emgd_test_pixmap_free(PixmapPtr pixmap)
+{
+	struct intel_pixmap *priv = intel_get_pixmap_private(pixmap);
+
+	if (!LIST_IS_EMPTY(&priv->batch))
+		LIST_DEL(&priv->batch);
+	if (!LIST_IS_EMPTY(&priv->flush))
+		LIST_DEL(&priv->flush);
+	drm_intel_bo_unreference(priv->bo);
+	free(priv);
+	free(pixmap);
+}
+
+void emgd_test_pixmap_read(PixmapPtr pixmap, int x, int y, int w, int h,
+	void *dst, int dst_pitch)
+{
+	struct intel_pixmap *priv = intel_get_pixmap_private(pixmap);
+	int cpp = pixmap->drawable.bitsPerPixel / 8;
+	char *src = priv->bo->virtual;
+	int i;
+
+	if (priv->tiling != I915_TILING_NONE) {
+		emgd_detile_rect(dst, dst_pitch, src, priv->stride,
+			priv->tiling, priv->swizzle, x * cpp, y, w * cpp, h);
+		return;
+	}
+
+	for (i = 0; i < h; i++)
+		memcpy((char *)dst + i * dst_pitch,
+		       src + (y + i) * priv->stride + x * cpp, w * cpp);
+}
+
+void emgd_test_pixmap_write(PixmapPtr pixmap, int x, int y, int w, int h,
+	const void *src, int src_pitch)
+{
+	struct intel_pixmap *priv = intel_get_pixmap_private(pixmap);
+	int cpp = pixmap->drawable.bitsPerPixel / 8;
+	char *dst = priv->bo->virtual;
+	int i;
+
+	if (priv->tiling != I915_TILING_NONE) {
+		emgd_tile_rect(dst, priv->stride, priv->tiling, priv->swizzle,
+			src, src_pitch, x * cpp, y, w * cpp, h);
+		return;
+	}
+
+	for (i = 0; i < h; i++)
+		memcpy(dst + (y + i) * priv->stride + x * cpp,
+		       (const char *)src + i * src_pitch, w * cpp);
+}
+
+static RegionPtr test_copy_area(DrawablePtr src, DrawablePtr dst, GCPtr gc,
+	int sx, int sy, int w, int h, int dx, int dy)
+{
+	ScrnInfoPtr scrn = xf86Screens[dst->pScreen->myNum];
+	int pitch = w * src->bitsPerPixel / 8;
+	char *tmp = malloc((size_t)pitch * h);
+
+	if (tmp == NULL)
+		return NULL;
+
+	emgd_test_blt_copy(scrn, (PixmapPtr)src, (PixmapPtr)dst,
+		dx, dy, dx + w, dy + h);
+	emgd_test_pixmap_read((PixmapPtr)src, sx, sy, w, h, tmp, pitch);
+	emgd_test_pixmap_write((PixmapPtr)dst, dx, dy, w, h, tmp, pitch);
+	free(tmp);
+	return NULL;
+}
+
+static GCOps test_gc_ops = {
+	.CopyArea = test_copy_area,
+};
+
+GCPtr GetScratchGC(unsigned depth, ScreenPtr screen)
+{
+	GCPtr gc = calloc(1, sizeof(*gc));
+
+	if (gc == NULL)
+		return NULL;
+	gc->depth = depth;
+	gc->pScreen = screen;
+	gc->alu = GXcopy;
+	gc->planemask = ~0;
+	gc->ops = &test_gc_ops;
+	return gc;
+}
+
+void FreeScratchGC(GCPtr gc)
+{
+	free(gc);
+}
+
+void ValidateGC(DrawablePtr drawable, GCPtr gc)
+{
+}
+
+void emgd_test_blt_fill(ScrnInfoPtr scrn, PixmapPtr dst,
+	int x1, int y1, int x2, int y2)
+{
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+
+	BEGIN_BATCH_BLT(6);
+	OUT_BATCH(XY_COLOR_BLT_CMD | XY_COLOR_BLT_WRITE_ALPHA |
+		XY_COLOR_BLT_WRITE_RGB);
+	OUT_BATCH((0xf0 << 16) | (3 << 24) | intel_pixmap_pitch(dst));
+	OUT_BATCH((y1 << 16) | x1);
+	OUT_BATCH((y2 << 16) | x2);
+	OUT_RELOC_PIXMAP_FENCED(dst, I915_GEM_DOMAIN_RENDER,
+		I915_GEM_DOMAIN_RENDER, 0);
+	OUT_BATCH(0xffffffff);
+	ADVANCE_BATCH();
+
+	intel_pixmap_add_damage(intel_get_pixmap_private(dst), x1, y1, x2, y2);
+}
+
+void emgd_test_blt_copy(ScrnInfoPtr scrn, PixmapPtr src, PixmapPtr dst,
+	int x1, int y1, int x2, int y2)
+{
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+
+	BEGIN_BATCH_BLT(8);
+	OUT_BATCH(XY_SRC_COPY_BLT_CMD | XY_SRC_COPY_BLT_WRITE_ALPHA |
+		XY_SRC_COPY_BLT_WRITE_RGB);
+	OUT_BATCH((0xcc << 16) | (3 << 24) | intel_pixmap_pitch(dst));
+	OUT_BATCH((y1 << 16) | x1);
+	OUT_BATCH((y2 << 16) | x2);
+	OUT_RELOC_PIXMAP_FENCED(dst, I915_GEM_DOMAIN_RENDER,
+		I915_GEM_DOMAIN_RENDER, 0);
+	OUT_BATCH((y1 << 16) | x1);
+	OUT_BATCH(intel_pixmap_pitch(src));
+	OUT_RELOC_PIXMAP_FENCED(src, I915_GEM_DOMAIN_RENDER, 0, 0);
+	ADVANCE_BATCH();
+
+	intel_pixmap_add_damage(intel_get_pixmap_private(dst), x1, y1, x2, y2);
+}
+
+void emgd_test_render_copy(ScrnInfoPtr scrn, PixmapPtr src, PixmapPtr dst,
+	int x1, int y1, int x2, int y2)
+{
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+
+	/* Stands in for surface state plus a 3DPRIMITIVE */
+	BEGIN_BATCH(4);
+	OUT_BATCH(MI_NOOP);
+	OUT_RELOC_PIXMAP(src, I915_GEM_DOMAIN_SAMPLER, 0, 0);
+	OUT_RELOC_PIXMAP(dst, I915_GEM_DOMAIN_RENDER,
+		I915_GEM_DOMAIN_RENDER, 0);
+	OUT_BATCH(MI_NOOP);
+	ADVANCE_BATCH();
+
+	intel_pixmap_add_damage(intel_get_pixmap_private(dst), x1, y1, x2, y2);
+}
@@ -0,0 +1,254 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_xtest.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  X client helpers for the tests and benchmarks.  See emgd_xtest.h.
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xlibint.h>
+#include <X11/Xutil.h>
+
+#include "emgd_xtest.h"
+#include "emgd_apistr.h"
+
+static Display *emgd_xtest_open_env(const char *var)
+{
+	const char *name = getenv(var);
+	Display *dpy;
+
+	if (name == NULL || *name == '\0') {
+		fprintf(stderr, "%s is not set\n", var);
+		return NULL;
+	}
+
+	dpy = XOpenDisplay(name);
+	if (dpy == NULL)
+		fprintf(stderr, "can't open %s=%s\n", var, name);
+	return dpy;
+}
+
+Display *emgd_xtest_open(void)
+{
+	return emgd_xtest_open_env("EMGD_TEST_DISPLAY");
+}
+
+Display *emgd_xtest_open_ref(void)
+{
+	return emgd_xtest_open_env("EMGD_REF_DISPLAY");
+}
+
+Window emgd_xtest_window(Display *dpy, int x, int y, int w, int h)
+{
+	XSetWindowAttributes attr;
+	Window win;
+	XEvent ev;
+
+	attr.override_redirect = True;
+	attr.background_pixel = BlackPixel(dpy, DefaultScreen(dpy));
+	attr.event_mask = ExposureMask;
+	win = XCreateWindow(dpy, DefaultRootWindow(dpy), x, y, w, h, 0,
+		CopyFromParent, InputOutput, CopyFromParent,
+		CWOverrideRedirect | CWBackPixel | CWEventMask, &attr);
+	XMapRaised(dpy, win);
+
+	/* Drawing before the first Expose could be lost */
+	XWindowEvent(dpy, win, ExposureMask, &ev);
+	XSelectInput(dpy, win, 0);
+	XSync(dpy, True);
+	return win;
+}
+
+Bool emgd_xtest_pair_open(emgd_xtest_pair_t *pair, int w, int h)
+{
+	uint32_t *pixels;
+	int i, j;
+
+	memset(pair, 0, sizeof(*pair));
+	pair->dpy[0] = emgd_xtest_open();
+	pair->dpy[1] = emgd_xtest_open_ref();
+	if (pair->dpy[0] == NULL || pair->dpy[1] == NULL) {
+		emgd_xtest_pair_close(pair);
+		return False;
+	}
+
+	pair->width = w;
+	pair->height = h;
+	pair->depth = DefaultDepth(pair->dpy[0], DefaultScreen(pair->dpy[0]));
+	if (pair->depth != DefaultDepth(pair->dpy[1],
+					DefaultScreen(pair->dpy[1]))) {
+		fprintf(stderr, "the servers' default depths differ\n");
+		emgd_xtest_pair_close(pair);
+		return False;
+	}
+
+	pixels = malloc((size_t)w * h * sizeof(*pixels));
+	if (pixels == NULL) {
+		emgd_xtest_pair_close(pair);
+		return False;
+	}
+	for (j = 0; j < w * h; j++)
+		pixels[j] = (rand() << 16) ^ rand();
+
+	for (i = 0; i < 2; i++) {
+		Display *dpy = pair->dpy[i];
+		XImage *image;
+
+		pair->pixmap[i] = XCreatePixmap(dpy, DefaultRootWindow(dpy),
+						w, h, pair->depth);
+		pair->gc[i] = XCreateGC(dpy, pair->pixmap[i], 0, NULL);
+
+		/* Same pixels on both, whatever their image byte order */
+		image = XCreateImage(dpy, DefaultVisual(dpy, DefaultScreen(dpy)),
+				     pair->depth, ZPixmap, 0, NULL, w, h, 32, 0);
+		image->data = malloc((size_t)image->bytes_per_line * h);
+		for (j = 0; j < w * h; j++)
+			XPutPixel(image, j % w, j / w, pixels[j]);
+		XPutImage(dpy, pair->pixmap[i], pair->gc[i], image, 0, 0,
+			  0, 0, w, h);
+		XDestroyImage(image);
+		XSync(dpy, False);
+	}
+
+	free(pixels);
+	return True;
+}
+
+void emgd_xtest_pair_close(emgd_xtest_pair_t *pair)
+{
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		if (pair->dpy[i] == NULL)
+			continue;
+		if (pair->gc[i])
+			XFreeGC(pair->dpy[i], pair->gc[i]);
+		if (pair->pixmap[i])
+			XFreePixmap(pair->dpy[i], pair->pixmap[i]);
+		XCloseDisplay(pair->dpy[i]);
+	}
+	memset(pair, 0, sizeof(*pair));
+}
+
+void emgd_xtest_pair_draw(emgd_xtest_pair_t *pair, unsigned int seed,
+	emgd_xtest_draw_t draw)
+{
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		srand(seed);
+		draw(pair->dpy[i], pair->pixmap[i], pair->gc[i]);
+		XSync(pair->dpy[i], False);
+	}
+}
+
+long emgd_xtest_pair_compare(emgd_xtest_pair_t *pair, int *x, int *y)
+{
+	unsigned long mask = pair->depth < 32 ?
+		(1UL << pair->depth) - 1 : 0xffffffffUL;
+	XImage *image[2];
+	long diff = 0;
+	int i, j;
+
+	for (i = 0; i < 2; i++)
+		image[i] = XGetImage(pair->dpy[i], pair->pixmap[i], 0, 0,
+				     pair->width, pair->height, AllPlanes,
+				     ZPixmap);
+	if (image[0] == NULL || image[1] == NULL) {
+		*x = *y = -1;
+		diff = -1;
+		goto out;
+	}
+
+	for (j = 0; j < pair->height; j++) {
+		for (i = 0; i < pair->width; i++) {
+			if (((XGetPixel(image[0], i, j) ^
+			      XGetPixel(image[1], i, j)) & mask) == 0)
+				continue;
+			if (diff++ == 0) {
+				*x = i;
+				*y = j;
+			}
+		}
+	}
+
+out:
+	for (i = 0; i < 2; i++) {
+		if (image[i])
+			XDestroyImage(image[i]);
+	}
+	return diff;
+}
+
+Bool emgd_xtest_perf(Display *dpy, iegd_esc_perf_counters_t *perf)
+{
+	xEMGDControlReq *req;
+	xEMGDControlReply rep;
+	int opcode, event, error;
+	long len;
+	Bool ret = False;
+
+	if (!XQueryExtension(dpy, EMGDNAME, &opcode, &event, &error))
+		return False;
+
+	LockDisplay(dpy);
+	GetReq(EMGDControl, req);
+	req->reqType = opcode;
+	req->emgdReqType = X_EMGDControl;
+	req->api_function = EMGD_CONTROL_GET_PERF_COUNTERS;
+	req->in_size = 0;
+	req->do_reply = 1;
+	if (_XReply(dpy, (xReply *)&rep, 0, xFalse)) {
+		len = (long)rep.length << 2;
+		memset(perf, 0, sizeof(*perf));
+		if (rep.status == EMGD_CONTROL_SUCCESS) {
+			long size = len < (long)sizeof(*perf) ?
+				len : (long)sizeof(*perf);
+
+			_XRead(dpy, (char *)perf, size);
+			len -= size;
+			ret = True;
+		}
+		if (len > 0)
+			_XEatData(dpy, len);
+	}
+	UnlockDisplay(dpy);
+	SyncHandle();
+
+	return ret;
+}
+
+uint64_t emgd_xtest_fallbacks(const iegd_esc_perf_counters_t *perf)
+{
+	uint64_t sum = 0;
+	int i;
+
+	for (i = 0; i < EMGD_PERF_NUM_FALLBACKS; i++)
+		sum += perf->fallbacks[i];
+	return sum;
+}
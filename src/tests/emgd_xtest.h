@@ -0,0 +1,89 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_xtest.h
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Helpers for tests and benchmarks that run as X clients against a live
+ *  server: the driver under test on $EMGD_TEST_DISPLAY and, for pixel
+ *  comparisons, a server rendering with fb on $EMGD_REF_DISPLAY (e.g.
+ *  Xvfb).  Programs return EMGD_TEST_SKIP when a display they need isn't
+ *  set or can't be opened.
+ *-----------------------------------------------------------------------------
+ */
+
+#ifndef _EMGD_XTEST_H_
+#define _EMGD_XTEST_H_
+
+#include <stdint.h>
+#include <X11/Xlib.h>
+
+#include "emgd_api.h"
+
+/* The server under test, or NULL. */
+extern Display *emgd_xtest_open(void);
+/* The fb reference server, or NULL. */
+extern Display *emgd_xtest_open_ref(void);
+
+/* A mapped, exposed override-redirect window on the default screen. */
+extern Window emgd_xtest_window(Display *dpy, int x, int y, int w, int h);
+
+/*
+ * The same pixmap on both servers, for drawing the same requests on each
+ * and comparing the results.  Index 0 is the server under test, 1 the
+ * reference.
+ */
+typedef struct {
+	Display *dpy[2];
+	Pixmap pixmap[2];
+	GC gc[2];
+	int width, height, depth;
+} emgd_xtest_pair_t;
+
+/*
+ * Open both servers and a pixmap of the default depth on each, filled
+ * with the same random pixels.  FALSE if a server is missing or their
+ * default depths differ.
+ */
+extern Bool emgd_xtest_pair_open(emgd_xtest_pair_t *pair, int w, int h);
+extern void emgd_xtest_pair_close(emgd_xtest_pair_t *pair);
+
+/*
+ * Call draw once per server with rand() seeded the same, so a draw that
+ * picks its requests with rand() sends both the same ones.
+ */
+typedef void (*emgd_xtest_draw_t)(Display *dpy, Drawable d, GC gc);
+extern void emgd_xtest_pair_draw(emgd_xtest_pair_t *pair, unsigned int seed,
+	emgd_xtest_draw_t draw);
+/* Pixels that differ; the first one found is returned in *x, *y. */
+extern long emgd_xtest_pair_compare(emgd_xtest_pair_t *pair, int *x, int *y);
+
+/*
+ * The driver's counters, through EMGD_CONTROL_GET_PERF_COUNTERS.  FALSE
+ * if the server doesn't have the EMGD extension.
+ */
+extern Bool emgd_xtest_perf(Display *dpy, iegd_esc_perf_counters_t *perf);
+/* Fallbacks counted in perf, all kinds together. */
+extern uint64_t emgd_xtest_fallbacks(const iegd_esc_perf_counters_t *perf);
+
+#endif
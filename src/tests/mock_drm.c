@@ -0,0 +1,837 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: mock_drm.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Mock libdrm_intel and KMS.  See mock_drm.h.
+ *
+ *  The batch submission thread calls into libdrm from a second thread, so
+ *  every entry point takes mock_lock, just as libdrm takes its bufmgr lock.
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <i915_drm.h>
+
+#include "mock_drm.h"
+
+#define MOCK_GTT_BASE	0x100000UL
+#define MOCK_FD		42
+
+struct _drm_intel_bufmgr {
+	int fd;
+};
+
+mock_drm_t mock_drm = {
+	.exec_ns = 100000,
+	.aperture_size = 256UL << 20,
+	.record_execs = 1,
+	.next_fb = 1,
+};
+
+static drm_intel_bufmgr mock_bufmgr = { MOCK_FD };
+static pthread_mutex_t mock_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long mock_gtt_next = MOCK_GTT_BASE;
+static int mock_handle_next = 1;
+
+#define ALIGN_UP(v, a)	(((v) + (a) - 1) & ~((unsigned long)(a) - 1))
+
+mock_bo_t *mock_bo(drm_intel_bo *bo)
+{
+	return (mock_bo_t *)bo;
+}
+
+drm_intel_bufmgr *mock_drm_bufmgr(void)
+{
+	return &mock_bufmgr;
+}
+
+/* Called with mock_lock held from here on down to the public entry points */
+
+static void mock_stall(mock_bo_t *bo)
+{
+	if (bo->busy_until > mock_drm.now) {
+		mock_drm.stats.stalls++;
+		mock_drm.stats.stall_ns += bo->busy_until - mock_drm.now;
+		mock_drm.now = bo->busy_until;
+	}
+}
+
+static mock_bo_t *mock_alloc(const char *name, unsigned long size)
+{
+	mock_bo_t *bo;
+
+	if (mock_drm.fail_alloc)
+		return NULL;
+
+	bo = calloc(1, sizeof(*bo));
+	if (bo == NULL)
+		return NULL;
+
+	size = ALIGN_UP(size, 4096);
+	bo->base.virtual = NULL;
+	bo->base.size = size;
+	bo->base.align = 4096;
+	bo->base.offset = mock_gtt_next;
+	bo->base.bufmgr = &mock_bufmgr;
+	bo->base.handle = mock_handle_next++;
+	bo->refcount = 1;
+	bo->reusable = 1;
+
+	/* Backing storage stays put for the life of the bo */
+	bo->base.virtual = calloc(1, size);
+	if (bo->base.virtual == NULL) {
+		free(bo);
+		return NULL;
+	}
+	mock_gtt_next += size;
+
+	bo->next = mock_drm.bos;
+	mock_drm.bos = bo;
+	mock_drm.stats.bo_allocs++;
+	mock_drm.stats.bo_live++;
+	return bo;
+}
+
+static void mock_unref(mock_bo_t *bo)
+{
+	mock_bo_t **p;
+	int i;
+
+	if (--bo->refcount > 0)
+		return;
+
+	for (i = 0; i < bo->num_relocs; i++)
+		mock_unref(bo->relocs[i]);
+	free(bo->relocs);
+	free(bo->reloc_writes);
+
+	for (p = &mock_drm.bos; *p; p = &(*p)->next) {
+		if (*p == bo) {
+			*p = bo->next;
+			break;
+		}
+	}
+
+	mock_drm.stats.bo_frees++;
+	mock_drm.stats.bo_live--;
+	free(bo->base.virtual);
+	free(bo);
+}
+
+static void mock_free_execs(void)
+{
+	unsigned long i;
+
+	for (i = 0; i < mock_drm.num_execs; i++) {
+		free(mock_drm.execs[i].batch);
+		free(mock_drm.execs[i].targets);
+		free(mock_drm.execs[i].writes);
+	}
+	free(mock_drm.execs);
+	mock_drm.execs = NULL;
+	mock_drm.num_execs = 0;
+	mock_drm.max_execs = 0;
+}
+
+static void mock_record_exec(mock_bo_t *batch, int used, unsigned int ring)
+{
+	mock_exec_t *exec;
+	int i;
+
+	if (mock_drm.num_execs == mock_drm.max_execs) {
+		unsigned long max = mock_drm.max_execs ? 2 * mock_drm.max_execs : 64;
+		mock_exec_t *execs = realloc(mock_drm.execs, max * sizeof(*execs));
+
+		if (execs == NULL)
+			return;
+		mock_drm.execs = execs;
+		mock_drm.max_execs = max;
+	}
+
+	exec = &mock_drm.execs[mock_drm.num_execs];
+	memset(exec, 0, sizeof(*exec));
+	exec->seq = mock_drm.stats.execs - 1;
+	exec->time = mock_drm.now;
+	exec->handle = batch->base.handle;
+	exec->ring = ring;
+	exec->used = used;
+	exec->batch = malloc(used);
+	if (exec->batch)
+		memcpy(exec->batch, batch->base.virtual, used);
+	exec->targets = malloc(batch->num_relocs * sizeof(int) + 1);
+	exec->writes = malloc(batch->num_relocs * sizeof(uint32_t) + 1);
+	if (exec->targets && exec->writes) {
+		for (i = 0; i < batch->num_relocs; i++) {
+			exec->targets[i] = batch->relocs[i]->base.handle;
+			exec->writes[i] = batch->reloc_writes[i];
+		}
+		exec->num_targets = batch->num_relocs;
+	}
+	mock_drm.num_execs++;
+}
+
+
+void mock_drm_reset(void)
+{
+	mock_bo_t *bo;
+
+	pthread_mutex_lock(&mock_lock);
+	for (bo = mock_drm.bos; bo; bo = bo->next) {
+		fprintf(stderr, "mock_drm: leaked bo %d (%lu bytes, %d refs)\n",
+			bo->base.handle, bo->base.size, bo->refcount);
+	}
+	mock_free_execs();
+	memset(&mock_drm.stats, 0, sizeof(mock_drm.stats));
+	memset(mock_drm.cursor, 0, sizeof(mock_drm.cursor));
+	mock_drm.stats.bo_live = 0;
+	for (bo = mock_drm.bos; bo; bo = bo->next)
+		mock_drm.stats.bo_live++;
+	mock_drm.exec_ns = 100000;
+	mock_drm.exec_error = 0;
+	mock_drm.exec_error_count = 0;
+	mock_drm.aperture_size = 256UL << 20;
+	mock_drm.record_execs = 1;
+	mock_drm.fail_alloc = 0;
+	mock_drm.gpu_tail = mock_drm.now;
+	pthread_mutex_unlock(&mock_lock);
+}
+
+void mock_drm_clear_execs(void)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_free_execs();
+	pthread_mutex_unlock(&mock_lock);
+}
+
+void mock_drm_advance(uint64_t ns)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.now += ns;
+	pthread_mutex_unlock(&mock_lock);
+}
+
+void mock_drm_idle(void)
+{
+	pthread_mutex_lock(&mock_lock);
+	if (mock_drm.gpu_tail > mock_drm.now)
+		mock_drm.now = mock_drm.gpu_tail;
+	pthread_mutex_unlock(&mock_lock);
+}
+
+int mock_bo_busy(drm_intel_bo *bo)
+{
+	int busy;
+
+	pthread_mutex_lock(&mock_lock);
+	busy = mock_bo(bo)->busy_until > mock_drm.now;
+	pthread_mutex_unlock(&mock_lock);
+	return busy;
+}
+
+long mock_drm_find_exec(int handle, unsigned long from)
+{
+	unsigned long i;
+	int j;
+
+	for (i = from; i < mock_drm.num_execs; i++) {
+		mock_exec_t *exec = &mock_drm.execs[i];
+
+		for (j = 0; j < exec->num_targets; j++) {
+			if (exec->targets[j] == handle)
+				return i;
+		}
+	}
+	return -1;
+}
+
+
+/*
+ * libdrm_intel
+ */
+
+drm_intel_bufmgr *drm_intel_bufmgr_gem_init(int fd, int batch_size)
+{
+	mock_bufmgr.fd = fd;
+	return &mock_bufmgr;
+}
+
+void drm_intel_bufmgr_destroy(drm_intel_bufmgr *bufmgr)
+{
+}
+
+void drm_intel_bufmgr_gem_enable_reuse(drm_intel_bufmgr *bufmgr)
+{
+}
+
+void drm_intel_bufmgr_gem_enable_fenced_relocs(drm_intel_bufmgr *bufmgr)
+{
+}
+
+void drm_intel_bufmgr_gem_set_vma_cache_size(drm_intel_bufmgr *bufmgr,
+	int limit)
+{
+}
+
+drm_intel_bo *drm_intel_bo_alloc(drm_intel_bufmgr *bufmgr, const char *name,
+	unsigned long size, unsigned int alignment)
+{
+	mock_bo_t *bo;
+
+	pthread_mutex_lock(&mock_lock);
+	bo = mock_alloc(name, size);
+	pthread_mutex_unlock(&mock_lock);
+	return bo ? &bo->base : NULL;
+}
+
+drm_intel_bo *drm_intel_bo_alloc_for_render(drm_intel_bufmgr *bufmgr,
+	const char *name, unsigned long size, unsigned int alignment)
+{
+	return drm_intel_bo_alloc(bufmgr, name, size, alignment);
+}
+
+drm_intel_bo *drm_intel_bo_alloc_tiled(drm_intel_bufmgr *bufmgr,
+	const char *name, int x, int y, int cpp, uint32_t *tiling_mode,
+	unsigned long *pitch, unsigned long flags)
+{
+	unsigned long stride, height;
+	mock_bo_t *bo;
+
+	switch (*tiling_mode) {
+	case I915_TILING_X:
+		stride = ALIGN_UP((unsigned long)x * cpp, 512);
+		height = ALIGN_UP(y, 8);
+		break;
+	case I915_TILING_Y:
+		stride = ALIGN_UP((unsigned long)x * cpp, 128);
+		height = ALIGN_UP(y, 32);
+		break;
+	default:
+		stride = ALIGN_UP((unsigned long)x * cpp, 64);
+		height = y;
+		break;
+	}
+
+	pthread_mutex_lock(&mock_lock);
+	bo = mock_alloc(name, stride * height);
+	if (bo) {
+		bo->tiling = *tiling_mode;
+		bo->stride = *tiling_mode ? stride : 0;
+		bo->swizzle = *tiling_mode ? I915_BIT_6_SWIZZLE_9_10 :
+			I915_BIT_6_SWIZZLE_NONE;
+	}
+	pthread_mutex_unlock(&mock_lock);
+
+	*pitch = stride;
+	return bo ? &bo->base : NULL;
+}
+
+void drm_intel_bo_reference(drm_intel_bo *bo)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_bo(bo)->refcount++;
+	pthread_mutex_unlock(&mock_lock);
+}
+
+void drm_intel_bo_unreference(drm_intel_bo *bo)
+{
+	if (bo == NULL)
+		return;
+
+	pthread_mutex_lock(&mock_lock);
+	mock_unref(mock_bo(bo));
+	pthread_mutex_unlock(&mock_lock);
+}
+
+int drm_intel_bo_map(drm_intel_bo *bo, int write_enable)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_stall(mock_bo(bo));
+	mock_bo(bo)->map_count++;
+	mock_drm.stats.cpu_maps++;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drm_intel_bo_unmap(drm_intel_bo *bo)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_bo(bo)->map_count--;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drm_intel_gem_bo_map_gtt(drm_intel_bo *bo)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_stall(mock_bo(bo));
+	mock_bo(bo)->map_count++;
+	mock_drm.stats.gtt_maps++;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drm_intel_gem_bo_unmap_gtt(drm_intel_bo *bo)
+{
+	return drm_intel_bo_unmap(bo);
+}
+
+int drm_intel_bo_subdata(drm_intel_bo *bo, unsigned long offset,
+	unsigned long size, const void *data)
+{
+	if (offset + size > bo->size)
+		return -EINVAL;
+
+	pthread_mutex_lock(&mock_lock);
+	mock_stall(mock_bo(bo));
+	memcpy((char *)bo->virtual + offset, data, size);
+	mock_drm.stats.subdata++;
+	mock_drm.stats.subdata_bytes += size;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drm_intel_bo_get_subdata(drm_intel_bo *bo, unsigned long offset,
+	unsigned long size, void *data)
+{
+	if (offset + size > bo->size)
+		return -EINVAL;
+
+	pthread_mutex_lock(&mock_lock);
+	mock_stall(mock_bo(bo));
+	memcpy(data, (char *)bo->virtual + offset, size);
+	mock_drm.stats.get_subdata++;
+	mock_drm.stats.get_subdata_bytes += size;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+void drm_intel_bo_wait_rendering(drm_intel_bo *bo)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.waits++;
+	mock_stall(mock_bo(bo));
+	pthread_mutex_unlock(&mock_lock);
+}
+
+int drm_intel_bo_busy(drm_intel_bo *bo)
+{
+	int busy;
+
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.busy_queries++;
+	busy = mock_bo(bo)->busy_until > mock_drm.now;
+	pthread_mutex_unlock(&mock_lock);
+	return busy;
+}
+
+int drm_intel_bo_set_tiling(drm_intel_bo *bo, uint32_t *tiling_mode,
+	uint32_t stride)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.set_tiling++;
+	mock_bo(bo)->tiling = *tiling_mode;
+	mock_bo(bo)->stride = *tiling_mode ? stride : 0;
+	mock_bo(bo)->swizzle = *tiling_mode ? I915_BIT_6_SWIZZLE_9_10 :
+		I915_BIT_6_SWIZZLE_NONE;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drm_intel_bo_get_tiling(drm_intel_bo *bo, uint32_t *tiling_mode,
+	uint32_t *swizzle_mode)
+{
+	pthread_mutex_lock(&mock_lock);
+	*tiling_mode = mock_bo(bo)->tiling;
+	*swizzle_mode = mock_bo(bo)->swizzle;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drm_intel_bo_flink(drm_intel_bo *bo, uint32_t *name)
+{
+	pthread_mutex_lock(&mock_lock);
+	if (mock_bo(bo)->flink == 0) {
+		mock_bo(bo)->flink = 0x1000 + bo->handle;
+		mock_bo(bo)->reusable = 0;
+		mock_drm.stats.flinks++;
+	}
+	*name = mock_bo(bo)->flink;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drm_intel_bo_disable_reuse(drm_intel_bo *bo)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_bo(bo)->reusable = 0;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drm_intel_bo_is_reusable(drm_intel_bo *bo)
+{
+	return mock_bo(bo)->reusable;
+}
+
+static int mock_emit_reloc(drm_intel_bo *bo, uint32_t offset,
+	drm_intel_bo *target_bo, uint32_t write_domain)
+{
+	mock_bo_t *batch = mock_bo(bo);
+
+	if (offset + 4 > bo->size)
+		return -EINVAL;
+
+	pthread_mutex_lock(&mock_lock);
+	if (batch->num_relocs == batch->max_relocs) {
+		int max = batch->max_relocs ? 2 * batch->max_relocs : 16;
+		mock_bo_t **relocs;
+		uint32_t *writes;
+
+		relocs = realloc(batch->relocs, max * sizeof(*relocs));
+		if (relocs)
+			batch->relocs = relocs;
+		writes = realloc(batch->reloc_writes, max * sizeof(*writes));
+		if (writes)
+			batch->reloc_writes = writes;
+		if (relocs == NULL || writes == NULL) {
+			pthread_mutex_unlock(&mock_lock);
+			return -ENOMEM;
+		}
+		batch->max_relocs = max;
+	}
+	mock_bo(target_bo)->refcount++;
+	batch->relocs[batch->num_relocs] = mock_bo(target_bo);
+	batch->reloc_writes[batch->num_relocs] = write_domain;
+	batch->num_relocs++;
+	mock_drm.stats.relocs++;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drm_intel_bo_emit_reloc(drm_intel_bo *bo, uint32_t offset,
+	drm_intel_bo *target_bo, uint32_t target_offset,
+	uint32_t read_domains, uint32_t write_domain)
+{
+	return mock_emit_reloc(bo, offset, target_bo, write_domain);
+}
+
+int drm_intel_bo_emit_reloc_fence(drm_intel_bo *bo, uint32_t offset,
+	drm_intel_bo *target_bo, uint32_t target_offset,
+	uint32_t read_domains, uint32_t write_domain)
+{
+	int ret = mock_emit_reloc(bo, offset, target_bo, write_domain);
+
+	if (ret == 0) {
+		pthread_mutex_lock(&mock_lock);
+		mock_drm.stats.fenced_relocs++;
+		pthread_mutex_unlock(&mock_lock);
+	}
+	return ret;
+}
+
+int drm_intel_bufmgr_check_aperture_space(drm_intel_bo **bo_array, int count)
+{
+	unsigned long total = 0;
+	int i, ret;
+
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.aperture_checks++;
+	for (i = 0; i < count; i++) {
+		mock_bo_t *bo;
+		int j;
+
+		/* As libdrm, unused slots of a table may be NULL */
+		if (bo_array[i] == NULL)
+			continue;
+
+		bo = mock_bo(bo_array[i]);
+		total += bo->base.size;
+		for (j = 0; j < bo->num_relocs; j++)
+			total += bo->relocs[j]->base.size;
+	}
+	ret = total > mock_drm.aperture_size ? -ENOSPC : 0;
+	pthread_mutex_unlock(&mock_lock);
+	return ret;
+}
+
+int drm_intel_bo_mrb_exec(drm_intel_bo *bo, int used,
+	struct drm_clip_rect *cliprects, int num_cliprects, int DR4,
+	unsigned int flags)
+{
+	mock_bo_t *batch = mock_bo(bo);
+	uint64_t start;
+	int i;
+
+	if (used <= 0 || used > bo->size)
+		return -EINVAL;
+
+	pthread_mutex_lock(&mock_lock);
+	if (mock_drm.exec_error_count > 0) {
+		mock_drm.exec_error_count--;
+		pthread_mutex_unlock(&mock_lock);
+		return mock_drm.exec_error;
+	}
+
+	mock_drm.stats.execs++;
+	start = mock_drm.gpu_tail > mock_drm.now ?
+		mock_drm.gpu_tail : mock_drm.now;
+	mock_drm.gpu_tail = start + mock_drm.exec_ns;
+
+	batch->busy_until = mock_drm.gpu_tail;
+	for (i = 0; i < batch->num_relocs; i++)
+		batch->relocs[i]->busy_until = mock_drm.gpu_tail;
+
+	if (mock_drm.record_execs)
+		mock_record_exec(batch, used, flags & I915_EXEC_RING_MASK);
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drm_intel_bo_exec(drm_intel_bo *bo, int used,
+	struct drm_clip_rect *cliprects, int num_cliprects, int DR4)
+{
+	return drm_intel_bo_mrb_exec(bo, used, cliprects, num_cliprects, DR4,
+		I915_EXEC_RENDER);
+}
+
+
+/*
+ * libdrm core and KMS
+ */
+
+int drmIoctl(int fd, unsigned long request, void *arg)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.ioctls++;
+	pthread_mutex_unlock(&mock_lock);
+
+	if (request == DRM_IOCTL_I915_GETPARAM) {
+		drm_i915_getparam_t *gp = arg;
+
+		*gp->value = 1;
+	}
+	return 0;
+}
+
+int drmCommandWriteRead(int fd, unsigned long drmCommandIndex, void *data,
+	unsigned long size)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.ioctls++;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drmWaitVBlank(int fd, drmVBlankPtr vbl)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.ioctls++;
+	vbl->reply.sequence = (unsigned int)(mock_drm.now / 16666667);
+	vbl->reply.tval_sec = mock_drm.now / 1000000000;
+	vbl->reply.tval_usec = (mock_drm.now / 1000) % 1000000;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drmSetMaster(int fd)
+{
+	return 0;
+}
+
+int drmDropMaster(int fd)
+{
+	return 0;
+}
+
+void *drmMalloc(int size)
+{
+	return calloc(1, size);
+}
+
+void drmFree(void *pt)
+{
+	free(pt);
+}
+
+void *drmAllocCpy(char *array, int count, int entry_size)
+{
+	void *copy = malloc((size_t)count * entry_size);
+
+	if (copy)
+		memcpy(copy, array, (size_t)count * entry_size);
+	return copy;
+}
+
+int drmModeSetCursor(int fd, uint32_t crtcId, uint32_t bo_handle,
+	uint32_t width, uint32_t height)
+{
+	if (crtcId >= MOCK_DRM_MAX_CRTCS)
+		return -EINVAL;
+
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.cursor_sets++;
+	mock_drm.cursor[crtcId].handle = bo_handle;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drmModeMoveCursor(int fd, uint32_t crtcId, int x, int y)
+{
+	if (crtcId >= MOCK_DRM_MAX_CRTCS)
+		return -EINVAL;
+
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.cursor_moves++;
+	mock_drm.cursor[crtcId].x = x;
+	mock_drm.cursor[crtcId].y = y;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+drmModeConnectorPtr drmModeGetConnector(int fd, uint32_t connectorId)
+{
+	drmModeConnectorPtr connector;
+	mock_connector_t *mock = NULL;
+	int i;
+
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.connector_probes++;
+	for (i = 0; i < mock_drm.num_connectors; i++) {
+		if (mock_drm.connectors[i].id == connectorId)
+			mock = &mock_drm.connectors[i];
+	}
+	pthread_mutex_unlock(&mock_lock);
+	if (mock == NULL)
+		return NULL;
+
+	connector = calloc(1, sizeof(*connector));
+	if (connector == NULL)
+		return NULL;
+
+	connector->connector_id = mock->id;
+	connector->encoder_id = mock->encoder_id;
+	connector->connection = mock->connection;
+	connector->count_modes = mock->num_modes;
+	connector->modes = calloc(mock->num_modes + 1, sizeof(drmModeModeInfo));
+	if (connector->modes)
+		memcpy(connector->modes, mock->modes,
+			mock->num_modes * sizeof(drmModeModeInfo));
+	return connector;
+}
+
+void drmModeFreeConnector(drmModeConnectorPtr ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	free(ptr->modes);
+	free(ptr->props);
+	free(ptr->prop_values);
+	free(ptr->encoders);
+	free(ptr);
+}
+
+drmModePropertyPtr drmModeGetProperty(int fd, uint32_t propertyId)
+{
+	return NULL;
+}
+
+void drmModeFreeProperty(drmModePropertyPtr ptr)
+{
+	free(ptr);
+}
+
+drmModePropertyBlobPtr drmModeGetPropertyBlob(int fd, uint32_t blob_id)
+{
+	return NULL;
+}
+
+void drmModeFreePropertyBlob(drmModePropertyBlobPtr ptr)
+{
+	free(ptr);
+}
+
+int drmModeConnectorSetProperty(int fd, uint32_t connector_id,
+	uint32_t property_id, uint64_t value)
+{
+	return 0;
+}
+
+int drmModeAddFB(int fd, uint32_t width, uint32_t height, uint8_t depth,
+	uint8_t bpp, uint32_t pitch, uint32_t bo_handle, uint32_t *buf_id)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.fb_adds++;
+	*buf_id = mock_drm.next_fb++;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drmModeRmFB(int fd, uint32_t bufferId)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.fb_removes++;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drmModeSetCrtc(int fd, uint32_t crtcId, uint32_t bufferId,
+	uint32_t x, uint32_t y, uint32_t *connectors, int count,
+	drmModeModeInfoPtr mode)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.crtc_sets++;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+int drmModePageFlip(int fd, uint32_t crtc_id, uint32_t fb_id,
+	uint32_t flags, void *user_data)
+{
+	pthread_mutex_lock(&mock_lock);
+	mock_drm.stats.page_flips++;
+	pthread_mutex_unlock(&mock_lock);
+	return 0;
+}
+
+drmModeEncoderPtr drmModeGetEncoder(int fd, uint32_t encoder_id)
+{
+	drmModeEncoderPtr encoder = calloc(1, sizeof(*encoder));
+
+	if (encoder) {
+		encoder->encoder_id = encoder_id;
+		encoder->possible_crtcs = (1 << MOCK_DRM_MAX_CRTCS) - 1;
+	}
+	return encoder;
+}
+
+void drmModeFreeEncoder(drmModeEncoderPtr ptr)
+{
+	free(ptr);
+}
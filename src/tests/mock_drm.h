@@ -0,0 +1,171 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: mock_drm.h
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Link-time replacement for libdrm_intel and the libdrm KMS calls used by
+ *  the driver, for the unit tests and benchmarks in this directory.
+ *
+ *  Buffer objects are plain malloc'ed memory.  The GPU is modelled as a
+ *  single simulated timeline (mock_drm.now, in nanoseconds): executing a
+ *  batch keeps it and every buffer it relocates busy until exec_ns after
+ *  the previous batch retired.  Mapping, waiting on or reading back a busy
+ *  buffer is counted as a stall and moves the clock up to the moment the
+ *  buffer goes idle, so tests can assert on stalls and submissions without
+ *  depending on wall-clock time.
+ *
+ *  Every execbuffer is recorded together with a copy of the batch, the
+ *  handles it relocates and its ring, so tests can check what reached the
+ *  "kernel" and in which order.
+ *-----------------------------------------------------------------------------
+ */
+
+#ifndef _MOCK_DRM_H_
+#define _MOCK_DRM_H_
+
+#include <stdint.h>
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+#include <intel_bufmgr.h>
+
+#define MOCK_DRM_MAX_CRTCS		4
+#define MOCK_DRM_MAX_CONNECTORS		8
+
+typedef struct _mock_bo {
+	drm_intel_bo base;		/* Handed out to the driver */
+	int refcount;
+	uint32_t tiling;
+	uint32_t swizzle;
+	uint32_t stride;
+	int reusable;
+	int map_count;
+	uint64_t busy_until;		/* Timeline value at which it retires */
+	uint32_t flink;
+	struct _mock_bo **relocs;	/* Targets, referenced, in emit order */
+	uint32_t *reloc_writes;		/* Write domain of each */
+	int num_relocs;
+	int max_relocs;
+	struct _mock_bo *next;		/* Live bo list */
+} mock_bo_t;
+
+typedef struct _mock_exec {
+	uint64_t seq;			/* 0, 1, 2 ... in submission order */
+	uint64_t time;			/* Timeline value at submission */
+	int handle;			/* Batch bo */
+	unsigned int ring;
+	int used;			/* Bytes */
+	uint32_t *batch;		/* Copy of the batch, used bytes long */
+	int *targets;			/* Relocated handles ... */
+	uint32_t *writes;		/* ... and their write domains */
+	int num_targets;
+} mock_exec_t;
+
+typedef struct _mock_drm_stats {
+	unsigned long bo_allocs;
+	unsigned long bo_frees;
+	unsigned long bo_live;
+	unsigned long cpu_maps;
+	unsigned long gtt_maps;
+	unsigned long subdata;
+	unsigned long get_subdata;
+	unsigned long subdata_bytes;
+	unsigned long get_subdata_bytes;
+	unsigned long busy_queries;
+	unsigned long waits;
+	unsigned long stalls;		/* Map/wait/read of a busy bo */
+	uint64_t stall_ns;		/* Simulated time spent stalled */
+	unsigned long relocs;
+	unsigned long fenced_relocs;
+	unsigned long execs;
+	unsigned long aperture_checks;
+	unsigned long set_tiling;
+	unsigned long flinks;		/* New names; libdrm caches the rest */
+	unsigned long ioctls;
+	unsigned long cursor_sets;
+	unsigned long cursor_moves;
+	unsigned long connector_probes;
+	unsigned long crtc_sets;
+	unsigned long fb_adds;
+	unsigned long fb_removes;
+	unsigned long page_flips;
+} mock_drm_stats_t;
+
+typedef struct _mock_connector {
+	uint32_t id;
+	drmModeConnection connection;
+	int num_modes;
+	drmModeModeInfo modes[4];
+	uint32_t encoder_id;
+} mock_connector_t;
+
+typedef struct _mock_drm {
+	/* Configuration, may be changed between calls */
+	uint64_t exec_ns;		/* GPU time per batch */
+	int exec_error;			/* Returned by the next exec if nonzero */
+	int exec_error_count;		/* ... for this many execs */
+	unsigned long aperture_size;	/* Bytes check_aperture accepts */
+	int record_execs;		/* Keep mock_exec_t records */
+	int fail_alloc;			/* Fail bo allocations while set */
+
+	/* Simulated GPU */
+	uint64_t now;
+	uint64_t gpu_tail;		/* When the last batch retires */
+
+	/* Recorded state */
+	mock_drm_stats_t stats;
+	mock_exec_t *execs;
+	unsigned long num_execs;
+	unsigned long max_execs;
+	mock_bo_t *bos;			/* Live buffers */
+
+	/* KMS */
+	struct {
+		uint32_t handle;	/* Cursor bo handle, 0 when hidden */
+		int x, y;
+	} cursor[MOCK_DRM_MAX_CRTCS];
+	mock_connector_t connectors[MOCK_DRM_MAX_CONNECTORS];
+	int num_connectors;
+	uint32_t next_fb;
+} mock_drm_t;
+
+extern mock_drm_t mock_drm;
+
+/* Reset all state; frees every recorded exec and warns about leaked bos. */
+extern void mock_drm_reset(void);
+/* A bufmgr for intel->bufmgr. */
+extern drm_intel_bufmgr *mock_drm_bufmgr(void);
+/* Move the simulated clock forward, retiring work. */
+extern void mock_drm_advance(uint64_t ns);
+/* Let the GPU finish everything submitted so far. */
+extern void mock_drm_idle(void);
+/* Downcast a bo handed out by the mock. */
+extern mock_bo_t *mock_bo(drm_intel_bo *bo);
+/* Nonzero while bo is busy on the simulated timeline. */
+extern int mock_bo_busy(drm_intel_bo *bo);
+/* Index of the first recorded exec relocating handle at or after from. */
+extern long mock_drm_find_exec(int handle, unsigned long from);
+/* Drop the recorded execs but keep bos and the clock. */
+extern void mock_drm_clear_execs(void);
+
+#endif /* _MOCK_DRM_H_ */
@@ -0,0 +1,318 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_access.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Box-scoped intel_uxa_prepare_access(), counted on the mock_drm timeline:
+ *    - CPU access outside the batch's pending writes neither submits the
+ *      batch nor stalls, access overlapping them does both,
+ *    - writes still wait for a batch that reads the pixmap as a source,
+ *    - the mapping follows the size of the box, so small read-modify-write
+ *      fallbacks stay on the GTT,
+ *    - a fallback trace (GPU fill, CPU access elsewhere, repeated) costs no
+ *      submits or stalls, where whole-pixmap access costs one of each per
+ *      step,
+ *    - tiled pixmaps larger than the GTT are accessed through a linear
+ *      shadow that holds the accessed rows and writes back only what RW
+ *      accesses may have changed; swizzling it can't undo fails the access.
+ *
+ *  emgd_uxa.c is included for its static UXA hooks.
+ *-----------------------------------------------------------------------------
+ */
+
+#include "../emgd_uxa.c"
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+
+#define TRACE_STEPS	100
+
+static Bool test_access(PixmapPtr pixmap, BoxPtr box, uxa_access_t access)
+{
+	Bool ret = intel_uxa_prepare_access(pixmap, box, access);
+
+	if (ret)
+		intel_uxa_finish_access(pixmap, access);
+	return ret;
+}
+
+static void test_disjoint(void)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr pixmap;
+	BoxRec box = { 256, 256, 272, 272 };
+
+	mock_drm_reset();
+	memset(&emgd_perf, 0, sizeof(emgd_perf));
+	scrn = emgd_test_screen(70);
+	pixmap = emgd_test_pixmap(scrn, 512, 512, 32, I915_TILING_X);
+
+	emgd_test_blt_fill(scrn, pixmap, 0, 0, 16, 16);
+	CHECK(test_access(pixmap, &box, UXA_ACCESS_RO));
+	CHECK(test_access(pixmap, &box, UXA_ACCESS_RW));
+	CHECK_EQ(mock_drm.stats.execs, 0);
+	CHECK_EQ(mock_drm.stats.stalls, 0);
+	CHECK_EQ(emgd_perf.access_flushes_avoided, 2);
+	/* The fill is still queued */
+	CHECK(!LIST_IS_EMPTY(&intel_get_pixmap_private(pixmap)->batch));
+
+	intel_batch_submit(scrn);
+	CHECK_EQ(mock_drm.stats.execs, 1);
+
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+static void test_overlap(void)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr pixmap;
+	BoxRec box = { 8, 8, 24, 24 };
+	BoxRec empty = { 8, 8, 8, 24 };
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	pixmap = emgd_test_pixmap(scrn, 512, 512, 32, I915_TILING_X);
+
+	/* An empty box never overlaps */
+	emgd_test_blt_fill(scrn, pixmap, 0, 0, 16, 16);
+	CHECK(test_access(pixmap, &empty, UXA_ACCESS_RO));
+	CHECK_EQ(mock_drm.stats.execs, 0);
+
+	/* Reading pixels the batch writes waits for the GPU */
+	CHECK(test_access(pixmap, &box, UXA_ACCESS_RO));
+	CHECK_EQ(mock_drm.stats.execs, 1);
+	CHECK_EQ(mock_drm.stats.stalls, 1);
+	CHECK_EQ(mock_drm.stats.stall_ns, mock_drm.exec_ns);
+	CHECK(LIST_IS_EMPTY(&intel_get_pixmap_private(pixmap)->batch));
+
+	/* So does access to the whole pixmap */
+	emgd_test_blt_fill(scrn, pixmap, 256, 256, 272, 272);
+	CHECK(test_access(pixmap, NULL, UXA_ACCESS_RO));
+	CHECK_EQ(mock_drm.stats.execs, 2);
+	CHECK_EQ(mock_drm.stats.stalls, 2);
+
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+static void test_source(void)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr src, dst;
+	BoxRec box = { 256, 256, 272, 272 };
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	src = emgd_test_pixmap(scrn, 512, 512, 32, I915_TILING_X);
+	dst = emgd_test_pixmap(scrn, 512, 512, 32, I915_TILING_X);
+
+	emgd_test_blt_copy(scrn, src, dst, 0, 0, 16, 16);
+
+	/* Reading a source alongside the GPU is fine ... */
+	CHECK(test_access(src, &box, UXA_ACCESS_RO));
+	CHECK_EQ(mock_drm.stats.execs, 0);
+
+	/* ... writing anywhere in it is not: the copy must read first */
+	CHECK(test_access(src, &box, UXA_ACCESS_RW));
+	CHECK_EQ(mock_drm.stats.execs, 1);
+
+	emgd_test_pixmap_free(src);
+	emgd_test_pixmap_free(dst);
+	emgd_test_screen_free(scrn);
+}
+
+static void test_mapping(void)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr linear, tiled;
+	BoxRec rows = { 0, 0, 16, 16 };
+	BoxRec most = { 0, 0, 16, 768 };
+	BoxRec clipped = { 0, -4096, 16, 16 };
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	linear = emgd_test_pixmap(scrn, 1024, 768, 32, I915_TILING_NONE);
+	tiled = emgd_test_pixmap(scrn, 1024, 768, 32, I915_TILING_X);
+
+	/* A few rows of a read-modify-write fallback: GTT */
+	CHECK(test_access(linear, &rows, UXA_ACCESS_RW));
+	CHECK_EQ(mock_drm.stats.gtt_maps, 1);
+	CHECK_EQ(mock_drm.stats.cpu_maps, 0);
+
+	/* Boxes reaching outside the pixmap only count the rows inside */
+	CHECK(test_access(linear, &clipped, UXA_ACCESS_RW));
+	CHECK_EQ(mock_drm.stats.gtt_maps, 2);
+
+	/* Most of the pixmap, or all of it: cached mapping */
+	CHECK(test_access(linear, &most, UXA_ACCESS_RW));
+	CHECK(test_access(linear, NULL, UXA_ACCESS_RO));
+	CHECK_EQ(mock_drm.stats.gtt_maps, 2);
+	CHECK_EQ(mock_drm.stats.cpu_maps, 2);
+
+	/* fb can't read tiled memory, so tiled pixmaps always use the fence */
+	CHECK(test_access(tiled, NULL, UXA_ACCESS_RW));
+	CHECK_EQ(mock_drm.stats.gtt_maps, 3);
+	CHECK_EQ(mock_drm.stats.cpu_maps, 2);
+
+	emgd_test_pixmap_free(linear);
+	emgd_test_pixmap_free(tiled);
+	emgd_test_screen_free(scrn);
+}
+
+static void test_shadow(void)
+{
+	static uint32_t ref[256 * 128], out[256 * 128];
+	ScrnInfoPtr scrn;
+	PixmapPtr pixmap;
+	struct intel_pixmap *priv;
+	BoxRec box = { 8, 40, 72, 56 };
+	BoxRec below = { 0, 60, 32, 70 };
+	char *shadow;
+	int pitch, i, y;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	EMGDPTR(scrn)->max_gtt_map_size = 64 << 10;
+	pixmap = emgd_test_pixmap(scrn, 256, 128, 32, I915_TILING_X);
+	priv = intel_get_pixmap_private(pixmap);
+	pitch = intel_pixmap_pitch(pixmap);
+	CHECK(priv->bo->size > EMGDPTR(scrn)->max_gtt_map_size);
+
+	for (i = 0; i < 256 * 128; i++)
+		ref[i] = i * 2654435761u;
+	emgd_test_pixmap_write(pixmap, 0, 0, 256, 128, ref, 256 * 4);
+	memset(&emgd_perf, 0, sizeof(emgd_perf));
+
+	/* The box's rows come back detiled, at the pixmap's pitch */
+	CHECK(intel_uxa_prepare_access(pixmap, &box, UXA_ACCESS_RO));
+	shadow = pixmap->devPrivate.ptr;
+	CHECK(shadow != NULL && shadow == priv->shadow);
+	for (y = box.y1; y < box.y2; y++)
+		CHECK(memcmp(shadow + y * pitch, &ref[y * 256], 256 * 4) == 0);
+
+	/* A nested RW access shares the shadow, rows in between included */
+	CHECK(intel_uxa_prepare_access(pixmap, &below, UXA_ACCESS_RW));
+	CHECK(pixmap->devPrivate.ptr == shadow);
+	for (y = box.y2; y < below.y2; y++)
+		CHECK(memcmp(shadow + y * pitch, &ref[y * 256], 256 * 4) == 0);
+
+	for (y = below.y1; y < below.y2; y++) {
+		uint32_t *row = (uint32_t *)(shadow + y * pitch);
+
+		for (i = below.x1; i < below.x2; i++) {
+			row[i] = ~row[i];
+			ref[y * 256 + i] = row[i];
+		}
+	}
+	/* Never written back: outside what the RW access covers */
+	memset(shadow + 90 * pitch, 0xff, pitch);
+
+	intel_uxa_finish_access(pixmap, UXA_ACCESS_RW);
+	CHECK(priv->shadow == shadow);
+	intel_uxa_finish_access(pixmap, UXA_ACCESS_RO);
+	CHECK(priv->shadow == NULL);
+	CHECK(pixmap->devPrivate.ptr == NULL);
+
+	emgd_test_pixmap_read(pixmap, 0, 0, 256, 128, out, 256 * 4);
+	CHECK(memcmp(out, ref, sizeof(ref)) == 0);
+	CHECK_EQ(emgd_perf.access_shadows, 2);
+	CHECK_EQ(mock_drm.stats.gtt_maps, 0);
+
+	/* Bit 17 swizzling can't be undone: fail rather than map the GTT */
+	priv->swizzle = I915_BIT_6_SWIZZLE_9_10_17;
+	CHECK(!intel_uxa_prepare_access(pixmap, &box, UXA_ACCESS_RO));
+	CHECK(priv->shadow == NULL);
+	CHECK_EQ(mock_drm.stats.gtt_maps, 0);
+	priv->swizzle = I915_BIT_6_SWIZZLE_NONE;
+
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+/*
+ * A fallback trace as a terminal produces it: the GPU clears the cursor
+ * cell, then a fallback draws elsewhere.  Returns submits and stalls.
+ */
+static void test_run_trace(Bool scoped, unsigned long *execs,
+	unsigned long *stalls)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr pixmap;
+	int i;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	pixmap = emgd_test_pixmap(scrn, 1024, 768, 32, I915_TILING_X);
+
+	for (i = 0; i < TRACE_STEPS; i++) {
+		BoxRec box;
+
+		box.x1 = 64 + (i % 32) * 16;
+		box.y1 = 64 + (i / 32) * 16;
+		box.x2 = box.x1 + 16;
+		box.y2 = box.y1 + 16;
+
+		emgd_test_blt_fill(scrn, pixmap, 0, 0, 16, 16);
+		CHECK(test_access(pixmap, scoped ? &box : NULL,
+				  UXA_ACCESS_RW));
+	}
+
+	*execs = mock_drm.stats.execs;
+	*stalls = mock_drm.stats.stalls;
+
+	intel_batch_submit(scrn);
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+static void test_trace(void)
+{
+	unsigned long execs, stalls, whole_execs, whole_stalls;
+
+	test_run_trace(TRUE, &execs, &stalls);
+	test_run_trace(FALSE, &whole_execs, &whole_stalls);
+
+	CHECK_EQ(execs, 0);
+	CHECK_EQ(stalls, 0);
+	CHECK_EQ(whole_execs, TRACE_STEPS);
+	CHECK_EQ(whole_stalls, TRACE_STEPS);
+
+	printf("fallback trace, %d steps: %lu submits, %lu stalls "
+		"(whole pixmap: %lu submits, %lu stalls)\n",
+		TRACE_STEPS, execs, stalls, whole_execs, whole_stalls);
+}
+
+int main(int argc, char **argv)
+{
+	test_disjoint();
+	test_overlap();
+	test_source();
+	test_mapping();
+	test_shadow();
+	test_trace();
+
+	return emgd_test_done("access");
+}
@@ -0,0 +1,154 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_aperture.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  When intel_check_aperture() answers a check itself and when it has to
+ *  ask libdrm: the first check of a batch, any check adding a tiled buffer
+ *  (fence registers are only accounted by libdrm) and any check going past
+ *  aperture_limit go to libdrm; repeated and linear-only checks don't.
+ *-----------------------------------------------------------------------------
+ */
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+#include "intel_batchbuffer.h"
+
+static Bool test_check(ScrnInfoPtr scrn, PixmapPtr a, PixmapPtr b)
+{
+	drm_intel_bo *bo_table[3];
+
+	bo_table[0] = NULL;	/* The batch */
+	bo_table[1] = intel_get_pixmap_private(a)->bo;
+	bo_table[2] = b ? intel_get_pixmap_private(b)->bo : NULL;
+	return intel_get_aperture_space(scrn, bo_table, 3);
+}
+
+static void test_linear(void)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr a, b, c;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	a = emgd_test_pixmap(scrn, 256, 256, 32, I915_TILING_NONE);
+	b = emgd_test_pixmap(scrn, 256, 256, 32, I915_TILING_NONE);
+	c = emgd_test_pixmap(scrn, 256, 256, 32, I915_TILING_NONE);
+
+	/* The first check of a batch always asks libdrm ... */
+	CHECK(test_check(scrn, a, b));
+	CHECK_EQ(mock_drm.stats.aperture_checks, 1);
+
+	/* ... later ones only adding linear buffers don't */
+	CHECK(test_check(scrn, a, b));
+	CHECK(test_check(scrn, b, c));
+	CHECK(test_check(scrn, c, NULL));
+	CHECK_EQ(mock_drm.stats.aperture_checks, 1);
+
+	/* A new batch starts over */
+	emgd_test_blt_fill(scrn, a, 0, 0, 16, 16);
+	intel_batch_submit(scrn);
+	CHECK(test_check(scrn, a, b));
+	CHECK_EQ(mock_drm.stats.aperture_checks, 2);
+
+	emgd_test_pixmap_free(a);
+	emgd_test_pixmap_free(b);
+	emgd_test_pixmap_free(c);
+	emgd_test_screen_free(scrn);
+}
+
+static void test_tiled(void)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr linear, x, y;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	linear = emgd_test_pixmap(scrn, 256, 256, 32, I915_TILING_NONE);
+	x = emgd_test_pixmap(scrn, 256, 256, 32, I915_TILING_X);
+	y = emgd_test_pixmap(scrn, 256, 256, 32, I915_TILING_Y);
+
+	CHECK(test_check(scrn, linear, NULL));
+	CHECK_EQ(mock_drm.stats.aperture_checks, 1);
+
+	/* Each tiled buffer may need a fence: libdrm decides */
+	CHECK(test_check(scrn, linear, x));
+	CHECK_EQ(mock_drm.stats.aperture_checks, 2);
+	CHECK(test_check(scrn, y, NULL));
+	CHECK_EQ(mock_drm.stats.aperture_checks, 3);
+
+	/* Once counted, they are answered locally like any other */
+	CHECK(test_check(scrn, x, y));
+	CHECK(test_check(scrn, linear, y));
+	CHECK_EQ(mock_drm.stats.aperture_checks, 3);
+
+	emgd_test_pixmap_free(linear);
+	emgd_test_pixmap_free(x);
+	emgd_test_pixmap_free(y);
+	emgd_test_screen_free(scrn);
+}
+
+static void test_limit(void)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr a, b;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	a = emgd_test_pixmap(scrn, 256, 256, 32, I915_TILING_NONE);
+	b = emgd_test_pixmap(scrn, 256, 256, 32, I915_TILING_NONE);
+
+	/* Room for the batch and one pixmap only */
+	EMGDPTR(scrn)->aperture_limit = EMGDPTR(scrn)->batch_bo->size +
+		intel_get_pixmap_private(a)->bo->size;
+
+	CHECK(test_check(scrn, a, NULL));
+	CHECK_EQ(mock_drm.stats.aperture_checks, 1);
+	CHECK(test_check(scrn, a, b));
+	CHECK_EQ(mock_drm.stats.aperture_checks, 2);
+
+	/* Past the limit libdrm keeps being asked */
+	CHECK(test_check(scrn, a, b));
+	CHECK_EQ(mock_drm.stats.aperture_checks, 3);
+
+	/* And what libdrm refuses fails, after flushing the batch */
+	mock_drm.aperture_size = 0;
+	emgd_test_blt_fill(scrn, a, 0, 0, 16, 16);
+	CHECK(!test_check(scrn, a, b));
+	CHECK_EQ(mock_drm.stats.execs, 1);
+
+	emgd_test_pixmap_free(a);
+	emgd_test_pixmap_free(b);
+	emgd_test_screen_free(scrn);
+}
+
+int main(int argc, char **argv)
+{
+	test_linear();
+	test_tiled();
+	test_limit();
+
+	return emgd_test_done("aperture");
+}
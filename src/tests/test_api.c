@@ -0,0 +1,200 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_api.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  The EMGD control extension dispatch, driven with synthetic request
+ *  buffers: GET_PERF_COUNTERS replies with the counters block, RESET clears
+ *  it, unknown functions and a suspended server still produce a well formed
+ *  reply, and a request whose length doesn't match in_size is rejected
+ *  without writing anything.
+ *
+ *  emgd_api.c is included so that its static dispatch functions can be
+ *  called directly; replies are captured by wrapping WriteToClient.
+ *-----------------------------------------------------------------------------
+ */
+
+#include "../emgd_api.c"
+
+#include "emgd_test.h"
+
+static unsigned char reply_buf[4096];
+static int reply_len;
+static int reply_writes;
+
+/* Linked with --wrap=WriteToClient, see Makefile.gnu */
+int __wrap_WriteToClient(ClientPtr client, int count, const void *buf)
+{
+	if (reply_len + count <= (int)sizeof(reply_buf))
+		memcpy(reply_buf + reply_len, buf, count);
+	reply_len += count;
+	reply_writes++;
+	return count;
+}
+
+typedef struct {
+	xEMGDControlReq req;
+	CARD32 data[4];
+} test_request_t;
+
+static ClientRec client;
+static test_request_t request;
+
+static int test_dispatch(CARD32 function, CARD32 in_size, CARD32 do_reply)
+{
+	memset(&request, 0, sizeof(request));
+	request.req.reqType = 128;
+	request.req.emgdReqType = X_EMGDControl;
+	request.req.api_function = function;
+	request.req.in_size = in_size;
+	request.req.do_reply = do_reply;
+	request.req.length = (sz_xEMGDControlReq + in_size + 3) >> 2;
+
+	client.requestBuffer = &request;
+	client.req_len = request.req.length;
+	client.sequence++;
+
+	reply_len = 0;
+	reply_writes = 0;
+	return emgd_dispatch(&client);
+}
+
+static xEMGDControlReply *test_reply(void)
+{
+	return (xEMGDControlReply *)reply_buf;
+}
+
+static void test_get_perf_counters(void)
+{
+	iegd_esc_perf_counters_t *counters;
+	xEMGDControlReply *rep = test_reply();
+	unsigned long size = (sizeof(*counters) + 3) & ~3;
+
+	memset(&emgd_perf, 0, sizeof(emgd_perf));
+	emgd_perf.batch_submits = 42;
+	emgd_perf.fallbacks[EMGD_PERF_FALLBACK_COPY_AREA] = 3;
+	emgd_perf.glyph_cache_hits = 7;
+	emgd_perf.core_text_strings = 9;
+
+	CHECK_EQ(test_dispatch(EMGD_CONTROL_GET_PERF_COUNTERS, 0, 1), Success);
+	CHECK_EQ(reply_writes, 2);
+	CHECK_EQ(reply_len, sizeof(xEMGDControlReply) + size);
+	CHECK_EQ(rep->type, X_Reply);
+	CHECK_EQ(rep->sequenceNumber, client.sequence);
+	CHECK_EQ(rep->status, EMGD_CONTROL_SUCCESS);
+	CHECK_EQ(rep->out_length, size);
+	CHECK_EQ(rep->length, (sz_xEMGDControlReply - sz_xGenericReply + size) >> 2);
+
+	counters = (iegd_esc_perf_counters_t *)(reply_buf + sizeof(*rep));
+	CHECK_EQ(counters->batch_submits, 42);
+	CHECK_EQ(counters->fallbacks[EMGD_PERF_FALLBACK_COPY_AREA], 3);
+	CHECK_EQ(counters->glyph_cache_hits, 7);
+	CHECK_EQ(counters->core_text_strings, 9);
+	CHECK(memcmp(counters, &emgd_perf, sizeof(*counters)) == 0);
+}
+
+static void test_reset_perf_counters(void)
+{
+	iegd_esc_perf_counters_t zero;
+
+	emgd_perf.batch_submits = 42;
+	emgd_perf.solid_cache_misses = 5;
+
+	/* No reply requested: nothing goes back to the client */
+	CHECK_EQ(test_dispatch(EMGD_CONTROL_RESET_PERF_COUNTERS, 0, 0), Success);
+	CHECK_EQ(reply_writes, 0);
+
+	memset(&zero, 0, sizeof(zero));
+	CHECK(memcmp(&emgd_perf, &zero, sizeof(zero)) == 0);
+
+	CHECK_EQ(test_dispatch(EMGD_CONTROL_RESET_PERF_COUNTERS, 0, 1), Success);
+	CHECK_EQ(reply_writes, 1);
+	CHECK_EQ(test_reply()->status, EMGD_CONTROL_SUCCESS);
+	CHECK_EQ(test_reply()->out_length, 0);
+}
+
+static void test_unknown_function(void)
+{
+	/* Input data is carried along and ignored */
+	CHECK_EQ(test_dispatch(0x2ffff, 8, 1), Success);
+	CHECK_EQ(reply_writes, 1);
+	CHECK_EQ(reply_len, sizeof(xEMGDControlReply));
+	CHECK_EQ(test_reply()->status, EMGD_CONTROL_ERROR);
+	CHECK_EQ(test_reply()->out_length, 0);
+	CHECK_EQ(test_reply()->length,
+		(sz_xEMGDControlReply - sz_xGenericReply) >> 2);
+}
+
+static void test_bad_length(void)
+{
+	test_dispatch(EMGD_CONTROL_GET_PERF_COUNTERS, 0, 1);
+
+	/* in_size claims more data than the request carries */
+	request.req.in_size = 64;
+	reply_writes = 0;
+	CHECK_EQ(emgd_dispatch(&client), BadLength);
+	CHECK_EQ(reply_writes, 0);
+
+	/* Not an EMGD minor opcode at all */
+	request.req.in_size = 0;
+	request.req.emgdReqType = 0x7f;
+	CHECK_EQ(emgd_dispatch(&client), BadRequest);
+	CHECK_EQ(reply_writes, 0);
+}
+
+static void test_suspended(emgd_priv_t *iptr)
+{
+	emgd_perf.batch_submits = 1;
+
+	iptr->suspended = TRUE;
+	CHECK_EQ(test_dispatch(EMGD_CONTROL_RESET_PERF_COUNTERS, 0, 1), Success);
+	CHECK_EQ(reply_writes, 1);
+	CHECK_EQ(test_reply()->status, EMGD_CONTROL_ERROR);
+	CHECK_EQ(test_reply()->out_length, 0);
+	/* Ignored, not executed */
+	CHECK_EQ(emgd_perf.batch_submits, 1);
+
+	CHECK_EQ(test_dispatch(EMGD_CONTROL_RESET_PERF_COUNTERS, 0, 0), Success);
+	CHECK_EQ(reply_writes, 0);
+	iptr->suspended = FALSE;
+}
+
+int main(int argc, char **argv)
+{
+	static ScrnInfoRec scrn;
+	static emgd_priv_t iptr;
+	static ScrnInfoPtr screens[1];
+
+	scrn.driverPrivate = &iptr;
+	screens[0] = &scrn;
+	xf86Screens = screens;
+
+	test_get_perf_counters();
+	test_reset_perf_counters();
+	test_unknown_function();
+	test_bad_length();
+	test_suspended(&iptr);
+
+	return emgd_test_done("api");
+}
@@ -0,0 +1,301 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_batch_exec.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  The batch_exec hook: the default hook reaches the (mock) execbuffer with
+ *  the batch as emitted, a replacement hook sees every batch instead, and
+ *  an -EIO from the hook starts hang recovery, which probes the GPU
+ *  through the same hook once the backoff timer fires.  The hang and
+ *  recovery counters, the doubling delay and the final give-up are
+ *  checked on the mock timeline.
+ *-----------------------------------------------------------------------------
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+#include "intel_batchbuffer.h"
+#include "i830_reg.h"
+
+static int hook_calls;
+static unsigned int hook_ring;
+static int hook_used;
+static int hook_ret;
+static Bool force_fallback;
+
+/* uxa.c isn't linked; hang handling only flips this */
+void uxa_set_force_fallback(ScreenPtr screen, Bool value)
+{
+	force_fallback = value;
+}
+
+void uxa_reset_caches(ScreenPtr screen)
+{
+}
+
+void gen4_render_state_init(ScrnInfoPtr scrn)
+{
+}
+
+void gen4_render_state_cleanup(ScrnInfoPtr scrn)
+{
+}
+
+void i965_free_video(ScrnInfoPtr scrn)
+{
+}
+
+static int test_hook(intel_screen_private *intel, dri_bo *bo, int used,
+	unsigned int ring)
+{
+	hook_calls++;
+	hook_ring = ring;
+	hook_used = used;
+	if (hook_ret)
+		return hook_ret;
+	return intel_batch_exec(intel, bo, used, ring);
+}
+
+static void test_default_hook(void)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr pixmap;
+	mock_exec_t *exec;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	pixmap = emgd_test_pixmap(scrn, 64, 64, 32, I915_TILING_X);
+
+	CHECK(EMGDPTR(scrn)->batch_exec == intel_batch_exec);
+
+	emgd_test_blt_fill(scrn, pixmap, 0, 0, 16, 16);
+	intel_batch_submit(scrn);
+
+	CHECK_EQ(mock_drm.num_execs, 1);
+	exec = &mock_drm.execs[0];
+	CHECK_EQ(exec->ring, BLT_BATCH);
+	/* 6 dwords, MI_BATCH_BUFFER_END and the qword padding */
+	CHECK_EQ(exec->used, 8 * 4);
+	CHECK_EQ(exec->batch[0] >> 22, XY_COLOR_BLT_CMD >> 22);
+	CHECK_EQ(exec->batch[6], MI_BATCH_BUFFER_END);
+	CHECK_EQ(exec->num_targets, 1);
+	CHECK_EQ(exec->targets[0],
+		intel_get_pixmap_private(pixmap)->bo->handle);
+	CHECK(mock_bo_busy(intel_get_pixmap_private(pixmap)->bo));
+
+	/* Nothing queued: no empty batch reaches the kernel */
+	intel_batch_submit(scrn);
+	CHECK_EQ(mock_drm.num_execs, 1);
+
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+static void test_replaced_hook(void)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr src, dst;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	EMGDPTR(scrn)->batch_exec = test_hook;
+	src = emgd_test_pixmap(scrn, 64, 64, 32, I915_TILING_X);
+	dst = emgd_test_pixmap(scrn, 64, 64, 32, I915_TILING_X);
+
+	hook_calls = 0;
+	emgd_test_render_copy(scrn, src, dst, 0, 0, 64, 64);
+	intel_batch_submit(scrn);
+	CHECK_EQ(hook_calls, 1);
+	CHECK_EQ(hook_ring, RENDER_BATCH);
+	CHECK_EQ(hook_used, 6 * 4);
+	CHECK_EQ(mock_drm.num_execs, 1);
+
+	emgd_test_pixmap_free(src);
+	emgd_test_pixmap_free(dst);
+	emgd_test_screen_free(scrn);
+}
+
+static void hang(ScrnInfoPtr scrn, PixmapPtr pixmap)
+{
+	hook_ret = -EIO;
+	emgd_test_blt_fill(scrn, pixmap, 0, 0, 16, 16);
+	intel_batch_submit(scrn);
+}
+
+static void test_hang(void)
+{
+	ScrnInfoPtr scrn;
+	emgd_priv_t *intel;
+	PixmapPtr pixmap;
+
+	mock_drm_reset();
+	memset(&emgd_perf, 0, sizeof(emgd_perf));
+	scrn = emgd_test_screen(70);
+	intel = EMGDPTR(scrn);
+	intel->batch_exec = test_hook;
+	pixmap = emgd_test_pixmap(scrn, 64, 64, 32, I915_TILING_X);
+
+	hook_calls = 0;
+	force_fallback = FALSE;
+	hang(scrn, pixmap);
+	CHECK(force_fallback);
+	CHECK(intel->force_fallback);
+	CHECK_EQ(intel->hang_count, 1);
+	CHECK_EQ(mock_drm.num_execs, 0);
+	CHECK_EQ(emgd_perf.gpu_hangs, 1);
+	CHECK_EQ(emgd_perf.gpu_recoveries, 0);
+
+	/* A batch failing while in fallback is counted, but isn't a new hang */
+	hang(scrn, pixmap);
+	CHECK_EQ(intel->hang_count, 1);
+	CHECK_EQ(emgd_perf.gpu_hangs, 2);
+
+	/* The probe fails while the "reset" is still in progress */
+	hook_calls = 0;
+	mock_drm_advance(1000 * 1000000ULL);
+	emgd_test_run_timers();
+	CHECK_EQ(hook_calls, 1);
+	CHECK(intel->force_fallback);
+	CHECK_EQ(emgd_perf.gpu_recoveries, 0);
+
+	/* Then succeeds, after the same delay, and acceleration comes back */
+	hook_ret = 0;
+	mock_drm_advance(999 * 1000000ULL);
+	emgd_test_run_timers();
+	CHECK_EQ(hook_calls, 1);
+	mock_drm_advance(1 * 1000000ULL);
+	emgd_test_run_timers();
+	CHECK_EQ(hook_calls, 2);
+	CHECK(!intel->force_fallback);
+	CHECK(!force_fallback);
+	CHECK_EQ(emgd_perf.gpu_recoveries, 1);
+
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+/*
+ * Hangs in a row double the delay before the first probe, 1 s up to
+ * 64 s; the one after that gives up for good.  A minute without a hang
+ * after a recovery starts the schedule over.
+ */
+static void test_hang_backoff(void)
+{
+	ScrnInfoPtr scrn;
+	emgd_priv_t *intel;
+	PixmapPtr pixmap;
+	uint64_t delay;
+	int calls, i;
+
+	mock_drm_reset();
+	memset(&emgd_perf, 0, sizeof(emgd_perf));
+	scrn = emgd_test_screen(70);
+	intel = EMGDPTR(scrn);
+	intel->batch_exec = test_hook;
+	pixmap = emgd_test_pixmap(scrn, 64, 64, 32, I915_TILING_X);
+
+	for (i = 1, delay = 1000; i <= 7; i++, delay *= 2) {
+		hang(scrn, pixmap);
+		CHECK_EQ(intel->hang_count, i);
+		CHECK(intel->force_fallback);
+
+		calls = hook_calls;
+		hook_ret = 0;
+		mock_drm_advance((delay - 1) * 1000000ULL);
+		emgd_test_run_timers();
+		if (hook_calls != calls)
+			fprintf(stderr, "hang %d: probed before %llu ms\n", i,
+				(unsigned long long)delay);
+		CHECK_EQ(hook_calls, calls);
+
+		mock_drm_advance(1 * 1000000ULL);
+		emgd_test_run_timers();
+		if (hook_calls != calls + 1)
+			fprintf(stderr, "hang %d: not probed at %llu ms\n", i,
+				(unsigned long long)delay);
+		CHECK_EQ(hook_calls, calls + 1);
+		CHECK(!intel->force_fallback);
+		CHECK_EQ(emgd_perf.gpu_recoveries, i);
+	}
+	CHECK_EQ(delay, 128000);
+
+	/* The eighth hang in a row stays in software */
+	hang(scrn, pixmap);
+	CHECK_EQ(intel->hang_count, 8);
+	CHECK_EQ(emgd_perf.gpu_hangs, 8);
+	calls = hook_calls;
+	hook_ret = 0;
+	mock_drm_advance(600 * 1000 * 1000000ULL);
+	emgd_test_run_timers();
+	CHECK_EQ(hook_calls, calls);
+	CHECK(intel->force_fallback);
+	CHECK(force_fallback);
+	CHECK_EQ(emgd_perf.gpu_recoveries, 7);
+
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+
+	/* Stable for over a minute: the next hang waits 1 s again */
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	intel = EMGDPTR(scrn);
+	intel->batch_exec = test_hook;
+	pixmap = emgd_test_pixmap(scrn, 64, 64, 32, I915_TILING_X);
+
+	for (i = 0; i < 3; i++) {
+		hang(scrn, pixmap);
+		hook_ret = 0;
+		mock_drm_advance(4000 * 1000000ULL);
+		emgd_test_run_timers();
+		CHECK(!intel->force_fallback);
+	}
+	CHECK_EQ(intel->hang_count, 3);
+
+	mock_drm_advance(61 * 1000 * 1000000ULL);
+	hang(scrn, pixmap);
+	CHECK_EQ(intel->hang_count, 1);
+	calls = hook_calls;
+	hook_ret = 0;
+	mock_drm_advance(1000 * 1000000ULL);
+	emgd_test_run_timers();
+	CHECK_EQ(hook_calls, calls + 1);
+	CHECK(!intel->force_fallback);
+
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+int main(int argc, char **argv)
+{
+	test_default_hook();
+	test_replaced_hook();
+	test_hang();
+	test_hang_backoff();
+
+	return emgd_test_done("batch_exec");
+}
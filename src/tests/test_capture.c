@@ -0,0 +1,197 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_capture.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Batch capture round trip: a render batch whose source pixmap is only
+ *  reached through gen7 surface state is captured, and the capture file
+ *  is read back with tools/emgd_batch_decode.  The decoder must list the
+ *  surface state relocations against the surface bo, snapshot the
+ *  sampled source but not the render target, and find the batch's
+ *  relocation of the surface bo even though it is emitted last.
+ *
+ *  i965_render.c is included for its static surface state functions and
+ *  the decoder for its static parser, with its main() renamed.
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../i965_render.c"
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+
+#define main emgd_batch_decode_main
+#include "../../tools/emgd_batch_decode.c"
+#undef main
+
+/* Run the decoder with -v on path and return what it printed */
+static char *decode(const char *path)
+{
+	char out_path[] = "/tmp/emgd_decode_XXXXXX";
+	char *argv[] = { "emgd_batch_decode", "-v", (char *)path, NULL };
+	char *out;
+	off_t len;
+	int fd, saved;
+
+	fd = mkstemp(out_path);
+	if (fd < 0)
+		return NULL;
+	unlink(out_path);
+
+	fflush(stdout);
+	saved = dup(1);
+	dup2(fd, 1);
+	CHECK_EQ(emgd_batch_decode_main(3, argv), 0);
+	fflush(stdout);
+	dup2(saved, 1);
+	close(saved);
+
+	len = lseek(fd, 0, SEEK_END);
+	out = calloc(1, len + 1);
+	if (out && pread(fd, out, len, 0) != len) {
+		free(out);
+		out = NULL;
+	}
+	close(fd);
+	return out;
+}
+
+static void test_round_trip(ScrnInfoPtr scrn)
+{
+	intel_screen_private *intel = intel_get_screen_private(scrn);
+	char capture_path[] = "/tmp/emgd_capture_XXXXXX";
+	PixmapPtr src = emgd_test_pixmap(scrn, 64, 64, 32, I915_TILING_X);
+	PixmapPtr dst = emgd_test_pixmap(scrn, 64, 64, 32, I915_TILING_X);
+	drm_intel_bo *src_bo = intel_get_pixmap_bo(src);
+	drm_intel_bo *dst_bo = intel_get_pixmap_bo(dst);
+	PictureRec src_picture, dst_picture;
+	uint32_t surface_handle;
+	int src_offset, dst_offset;
+	char expect[256];
+	char *out;
+	int fd;
+
+	fd = mkstemp(capture_path);
+	CHECK(fd >= 0);
+	close(fd);
+
+	intel->capture = emgd_capture_create(capture_path, 1 << 20, 64 << 10,
+		0x0162, 70);
+	CHECK(intel->capture != NULL);
+	if (intel->capture == NULL) {
+		unlink(capture_path);
+		return;
+	}
+
+	/* What gen4_render_state_init() and intel_uxa_init() set up */
+	intel->surface_bo = drm_intel_bo_alloc(intel->bufmgr, "surface data",
+		sizeof(intel->surface_data), 4096);
+	intel->surface_used = 0;
+	intel->batch_flush = i965_batch_flush;
+	surface_handle = intel->surface_bo->handle;
+
+	memset(&src_picture, 0, sizeof(src_picture));
+	src_picture.pDrawable = &src->drawable;
+	src_picture.format = PICT_a8r8g8b8;
+	dst_picture = src_picture;
+	dst_picture.pDrawable = &dst->drawable;
+
+	dst_offset = gen7_set_picture_surface_state(intel, &dst_picture, dst,
+		TRUE);
+	src_offset = gen7_set_picture_surface_state(intel, &src_picture, src,
+		FALSE);
+
+	/* The batch itself only points at the surface bo */
+	BEGIN_BATCH(10);
+	gen6_composite_state_base_address(intel);
+	ADVANCE_BATCH();
+	intel_batch_submit(scrn);
+
+	emgd_capture_destroy(intel->capture);
+	intel->capture = NULL;
+
+	out = decode(capture_path);
+	CHECK(out != NULL);
+	if (out == NULL)
+		goto done;
+
+	snprintf(expect, sizeof(expect),
+		"state handle %u + 0x%05x  -> handle %u + 0x0 (r 0x%x w 0x0) [bo ",
+		surface_handle,
+		src_offset + (int)offsetof(struct gen7_surface_state, ss1),
+		src_bo->handle, I915_GEM_DOMAIN_SAMPLER);
+	CHECK(strstr(out, expect) != NULL);
+
+	snprintf(expect, sizeof(expect),
+		"state handle %u + 0x%05x  -> handle %u + 0x0 (r 0x%x w 0x%x)\n",
+		surface_handle,
+		dst_offset + (int)offsetof(struct gen7_surface_state, ss1),
+		dst_bo->handle, I915_GEM_DOMAIN_RENDER, I915_GEM_DOMAIN_RENDER);
+	CHECK(strstr(out, expect) != NULL);
+
+	snprintf(expect, sizeof(expect),
+		"  -> handle %u + 0x%x (r 0x%x w 0x0) [bo ",
+		surface_handle, BASE_ADDRESS_MODIFY, I915_GEM_DOMAIN_INSTRUCTION);
+	CHECK(strstr(out, expect) != NULL);
+
+	snprintf(expect, sizeof(expect), "handle %u, %lu of %lu bytes\n",
+		src_bo->handle, src_bo->size, src_bo->size);
+	CHECK(strstr(out, expect) != NULL);
+
+	snprintf(expect, sizeof(expect), "handle %u, ", dst_bo->handle);
+	CHECK(strstr(out, expect) == NULL);
+
+	CHECK(strstr(out, "\n1 batches, ") != NULL);
+	CHECK(strstr(out, " relocs (+2 in state), 2 bos\n") != NULL);
+
+	if (emgd_test_failures)
+		fputs(out, stderr);
+	free(out);
+
+done:
+	unlink(capture_path);
+	drm_intel_bo_unreference(intel->surface_bo);
+	intel->surface_bo = NULL;
+	intel->batch_flush = NULL;
+	emgd_test_pixmap_free(src);
+	emgd_test_pixmap_free(dst);
+}
+
+int main(int argc, char **argv)
+{
+	ScrnInfoPtr scrn;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+
+	test_round_trip(scrn);
+
+	emgd_test_screen_free(scrn);
+	return emgd_test_done("capture");
+}
@@ -0,0 +1,211 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_core_text.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Core font text drawn on the driver and on an fb reference server,
+ *  compared pixel for pixel after every round: ImageText and PolyText
+ *  with random strings in several fonts, at positions reaching past the
+ *  pixmap edges, with random colours, clip lists and planemasks.
+ *  PolyText also gets every alu, with one glyph and with many (which the
+ *  glyph path only takes for rops where overlapping ink doesn't matter),
+ *  and stippled fills, which it leaves to fb.  Only fonts both servers
+ *  have are used.
+ *
+ *  Runs against $EMGD_TEST_DISPLAY and $EMGD_REF_DISPLAY, see emgd_xtest.h.
+ *  EMGD_TEST_SEED picks the random sequence; it is printed on failure,
+ *  with the round.
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+
+#include "emgd_test.h"
+#include "emgd_xtest.h"
+
+#define ARRAY_SIZE(x) (int)(sizeof(x) / sizeof((x)[0]))
+
+#define TEST_ROUNDS	400
+#define TEST_WIDTH	256
+#define TEST_HEIGHT	128
+
+static const char *font_names[] = {
+	"fixed",
+	"6x13",
+	"8x13bold",
+	"9x15bold",
+	"10x20",
+	"-misc-fixed-medium-r-normal--7-*-*-*-*-*-iso8859-1",
+	"-adobe-helvetica-bold-o-normal--18-*-*-*-*-*-iso8859-1",
+	"-adobe-times-medium-i-normal--24-*-*-*-*-*-iso8859-1",
+};
+
+/* The fonts of font_names both servers have */
+static const char *fonts[ARRAY_SIZE(font_names)];
+static int num_fonts;
+
+static int random_coord(int size)
+{
+	return rand() % (size + 64) - 32;
+}
+
+static void random_gc(Display *dpy, GC gc)
+{
+	XGCValues values;
+
+	values.function = rand() % 16;
+	values.plane_mask = rand() % 4 ? AllPlanes :
+		((unsigned long)rand() << 16) ^ rand();
+	values.foreground = ((unsigned long)rand() << 16) ^ rand();
+	values.background = ((unsigned long)rand() << 16) ^ rand();
+	values.fill_style = FillSolid;
+	XChangeGC(dpy, gc, GCFunction | GCPlaneMask | GCForeground |
+		  GCBackground | GCFillStyle, &values);
+
+	if (rand() % 3 == 0) {
+		XRectangle rects[4];
+		int i, n = 1 + rand() % ARRAY_SIZE(rects);
+
+		for (i = 0; i < n; i++) {
+			rects[i].x = random_coord(TEST_WIDTH);
+			rects[i].y = random_coord(TEST_HEIGHT);
+			rects[i].width = 1 + rand() % 128;
+			rects[i].height = 1 + rand() % 64;
+		}
+		XSetClipRectangles(dpy, gc, 0, 0, rects, n, Unsorted);
+	} else {
+		XSetClipMask(dpy, gc, None);
+	}
+}
+
+static void draw_text(Display *dpy, Drawable d, GC gc)
+{
+	Font font = XLoadFont(dpy, fonts[rand() % num_fonts]);
+	Pixmap stipple = None;
+	char text[80], bits[8];
+	int i, len = 1 + rand() % ARRAY_SIZE(text);
+	int x = random_coord(TEST_WIDTH);
+	int y = random_coord(TEST_HEIGHT);
+
+	random_gc(dpy, gc);
+	XSetFont(dpy, gc, font);
+
+	/* Mostly printable, some from the upper half and the control range */
+	for (i = 0; i < len; i++)
+		text[i] = rand() % 8 ? ' ' + rand() % 95 : rand() % 256;
+
+	switch (rand() % 4) {
+	case 0:
+	case 1:
+		XDrawImageString(dpy, d, gc, x, y, text, len);
+		break;
+	case 2:
+		XDrawString(dpy, d, gc, x, y, text, rand() % 4 ? 1 : len);
+		break;
+	case 3:
+		for (i = 0; i < 8; i++)
+			bits[i] = rand();
+		stipple = XCreateBitmapFromData(dpy, d, bits, 8, 8);
+		XSetStipple(dpy, gc, stipple);
+		XSetFillStyle(dpy, gc, FillOpaqueStippled);
+		XDrawString(dpy, d, gc, x, y, text, len);
+		break;
+	}
+
+	if (stipple != None)
+		XFreePixmap(dpy, stipple);
+	XUnloadFont(dpy, font);
+}
+
+static void find_fonts(emgd_xtest_pair_t *pair)
+{
+	int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(font_names); i++) {
+		Bool found = True;
+
+		for (j = 0; j < 2; j++) {
+			XFontStruct *font = XLoadQueryFont(pair->dpy[j],
+							   font_names[i]);
+
+			if (font == NULL)
+				found = False;
+			else
+				XFreeFont(pair->dpy[j], font);
+		}
+		if (found)
+			fonts[num_fonts++] = font_names[i];
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *env = getenv("EMGD_TEST_SEED");
+	unsigned int seed = env ? strtoul(env, NULL, 0) : 1;
+	iegd_esc_perf_counters_t before, after;
+	emgd_xtest_pair_t pair;
+	Bool perf;
+	int i;
+
+	srand(seed);
+	if (!emgd_xtest_pair_open(&pair, TEST_WIDTH, TEST_HEIGHT))
+		return EMGD_TEST_SKIP;
+	find_fonts(&pair);
+	CHECK(num_fonts > 0);
+	perf = emgd_xtest_perf(pair.dpy[0], &before);
+
+	for (i = 0; i < TEST_ROUNDS && num_fonts; i++) {
+		long diff;
+		int x, y;
+
+		emgd_xtest_pair_draw(&pair, seed + i, draw_text);
+		diff = emgd_xtest_pair_compare(&pair, &x, &y);
+		CHECK_EQ(diff, 0);
+		if (diff) {
+			fprintf(stderr, "seed %u, round %d: %ld pixels differ, "
+				"first at (%d, %d)\n", seed, i, diff, x, y);
+			break;
+		}
+	}
+
+	if (perf && emgd_xtest_perf(pair.dpy[0], &after)) {
+		const uint64_t *a = after.fallbacks, *b = before.fallbacks;
+
+		printf("%d rounds, %d fonts: %llu strings accelerated, "
+		       "%llu image and %llu poly glyph blt fallbacks, "
+		       "%llu GTT maps\n", i, num_fonts,
+		       (unsigned long long)(after.core_text_strings -
+					    before.core_text_strings),
+		       (unsigned long long)
+		       (a[EMGD_PERF_FALLBACK_IMAGE_GLYPH_BLT] -
+			b[EMGD_PERF_FALLBACK_IMAGE_GLYPH_BLT]),
+		       (unsigned long long)
+		       (a[EMGD_PERF_FALLBACK_POLY_GLYPH_BLT] -
+			b[EMGD_PERF_FALLBACK_POLY_GLYPH_BLT]),
+		       (unsigned long long)(after.gtt_maps - before.gtt_maps));
+	}
+
+	emgd_xtest_pair_close(&pair);
+	return emgd_test_done("core text");
+}
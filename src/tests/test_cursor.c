@@ -0,0 +1,262 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_cursor.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  The ARGB cursor cache of emgd_crtc_load_cursor_argb(), on mock KMS:
+ *    - switching back to a cached image is a SetCursor on its bo, with no
+ *      upload and no new bo,
+ *    - a new image goes into an empty slot first, then replaces the least
+ *      recently used one,
+ *    - the cursor being scanned out is never the victim, even when it looks
+ *      least recently used after cursor_clock wraps,
+ *    - a hash match with different contents is not a hit.
+ *
+ *  emgd_crtc.c is included for its static cursor hooks.
+ *-----------------------------------------------------------------------------
+ */
+
+#include "../emgd_crtc.c"
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+
+#define TEST_CRTC_ID	1
+#define TEST_IMAGES	6
+#define TRACE_FRAMES	100
+
+typedef struct {
+	ScrnInfoPtr scrn;
+	xf86CrtcRec crtc;
+	drmmode_t drmmode;
+	drmModeCrtc kcrtc;
+	emgd_crtc_priv_t *priv;
+} test_crtc_t;
+
+static CARD32 images[TEST_IMAGES][64 * 64];
+
+static void test_crtc_init(test_crtc_t *t)
+{
+	memset(t, 0, sizeof(*t));
+	mock_drm_reset();
+	memset(&emgd_perf, 0, sizeof(emgd_perf));
+	t->scrn = emgd_test_screen(70);
+	t->kcrtc.crtc_id = TEST_CRTC_ID;
+	t->priv = calloc(1, sizeof(*t->priv));
+	t->priv->drmmode = &t->drmmode;
+	t->priv->crtc = &t->kcrtc;
+	t->crtc.scrn = t->scrn;
+	t->crtc.driver_private = t->priv;
+}
+
+static void test_crtc_fini(test_crtc_t *t)
+{
+	emgd_crtc_destroy(&t->crtc);
+	CHECK_EQ(mock_drm.cursor[TEST_CRTC_ID].handle, 0);
+	emgd_test_screen_free(t->scrn);
+	CHECK_EQ(mock_drm.stats.bo_live, 0);
+}
+
+static void test_load(test_crtc_t *t, int image)
+{
+	emgd_crtc_load_cursor_argb(&t->crtc, images[image]);
+}
+
+/* The slot holding image, or NULL */
+static emgd_cursor_slot_t *test_slot(test_crtc_t *t, int image)
+{
+	int i;
+
+	for (i = 0; i < EMGD_CURSOR_CACHE_SIZE; i++) {
+		emgd_cursor_slot_t *slot = &t->priv->cursor_cache[i];
+
+		if (slot->bo && memcmp(slot->image, images[image],
+				       sizeof(images[image])) == 0)
+			return slot;
+	}
+	return NULL;
+}
+
+/* The CRTC scans out a bo holding image */
+static void test_visible(test_crtc_t *t, int image)
+{
+	static CARD32 contents[64 * 64];
+	drm_intel_bo *bo = t->priv->cursor;
+
+	CHECK(bo != NULL);
+	if (bo == NULL)
+		return;
+	CHECK_EQ(mock_drm.cursor[TEST_CRTC_ID].handle, bo->handle);
+	CHECK(drm_intel_bo_get_subdata(bo, 0, sizeof(contents),
+				       contents) == 0);
+	CHECK(memcmp(contents, images[image], sizeof(contents)) == 0);
+}
+
+static void test_hit(void)
+{
+	test_crtc_t t;
+
+	test_crtc_init(&t);
+
+	test_load(&t, 0);
+	test_load(&t, 1);
+	test_visible(&t, 1);
+	CHECK_EQ(emgd_perf.cursor_uploads, 2);
+	CHECK_EQ(mock_drm.stats.bo_allocs, 2);
+
+	/* Back to the first: only the SetCursor */
+	test_load(&t, 0);
+	test_visible(&t, 0);
+	CHECK_EQ(emgd_perf.cursor_uploads, 2);
+	CHECK_EQ(emgd_perf.cursor_cache_hits, 1);
+	CHECK_EQ(mock_drm.stats.bo_allocs, 2);
+	CHECK_EQ(mock_drm.stats.cursor_sets, 3);
+
+	/* Loading what is already shown doesn't touch KMS */
+	test_load(&t, 0);
+	CHECK_EQ(mock_drm.stats.cursor_sets, 3);
+
+	test_crtc_fini(&t);
+}
+
+static void test_lru(void)
+{
+	test_crtc_t t;
+	int i;
+
+	test_crtc_init(&t);
+
+	/* Empty slots are used first */
+	for (i = 0; i < EMGD_CURSOR_CACHE_SIZE; i++)
+		test_load(&t, i);
+	CHECK_EQ(mock_drm.stats.bo_allocs, EMGD_CURSOR_CACHE_SIZE);
+
+	/* Use 0 again: 1 is now the least recently used */
+	test_load(&t, 0);
+	test_load(&t, 4);
+	test_visible(&t, 4);
+	CHECK(test_slot(&t, 1) == NULL);
+	CHECK(test_slot(&t, 0) != NULL);
+	CHECK(test_slot(&t, 2) != NULL);
+	CHECK(test_slot(&t, 3) != NULL);
+	CHECK_EQ(mock_drm.stats.bo_allocs, EMGD_CURSOR_CACHE_SIZE);
+
+	/* Then 2 */
+	test_load(&t, 5);
+	CHECK(test_slot(&t, 2) == NULL);
+	CHECK_EQ(emgd_perf.cursor_uploads, EMGD_CURSOR_CACHE_SIZE + 2);
+	CHECK_EQ(emgd_perf.cursor_cache_hits, 1);
+
+	test_crtc_fini(&t);
+}
+
+static void test_scanout(void)
+{
+	test_crtc_t t;
+	emgd_cursor_slot_t *shown;
+	int i;
+
+	test_crtc_init(&t);
+
+	/* The last load gets last_use 0 */
+	t.priv->cursor_clock = UINT32_MAX - EMGD_CURSOR_CACHE_SIZE + 1;
+	for (i = 0; i < EMGD_CURSOR_CACHE_SIZE; i++)
+		test_load(&t, i);
+	shown = test_slot(&t, EMGD_CURSOR_CACHE_SIZE - 1);
+	CHECK(shown != NULL && shown->last_use == 0);
+
+	/* The oldest one that isn't on screen goes */
+	test_load(&t, EMGD_CURSOR_CACHE_SIZE);
+	test_visible(&t, EMGD_CURSOR_CACHE_SIZE);
+	CHECK(test_slot(&t, 0) == NULL);
+	CHECK(test_slot(&t, EMGD_CURSOR_CACHE_SIZE - 1) == shown);
+
+	test_crtc_fini(&t);
+}
+
+static void test_collision(void)
+{
+	test_crtc_t t;
+	emgd_cursor_slot_t *slot;
+	Bool hit;
+
+	test_crtc_init(&t);
+
+	test_load(&t, 0);
+	slot = test_slot(&t, 0);
+	CHECK(slot != NULL);
+	if (slot == NULL)
+		goto out;
+
+	/* Same hash, other contents */
+	CHECK(emgd_crtc_cursor_slot(t.priv, images[1], slot->hash, &hit) !=
+	      NULL);
+	CHECK(!hit);
+	CHECK(emgd_crtc_cursor_slot(t.priv, images[0], slot->hash, &hit) ==
+	      slot);
+	CHECK(hit);
+
+out:
+	test_crtc_fini(&t);
+}
+
+/* A 3-frame busy cursor animation: one upload per frame, ever */
+static void test_trace(void)
+{
+	test_crtc_t t;
+	int i;
+
+	test_crtc_init(&t);
+
+	for (i = 0; i < TRACE_FRAMES; i++)
+		test_load(&t, i % 3);
+	CHECK_EQ(emgd_perf.cursor_uploads, 3);
+	CHECK_EQ(emgd_perf.cursor_cache_hits, TRACE_FRAMES - 3);
+	CHECK_EQ(mock_drm.stats.bo_allocs, 3);
+	CHECK_EQ(mock_drm.stats.cursor_sets, TRACE_FRAMES);
+
+	printf("animated cursor, %d frames: %lu uploads, %lu SetCursor\n",
+		TRACE_FRAMES, (unsigned long)emgd_perf.cursor_uploads,
+		mock_drm.stats.cursor_sets);
+
+	test_crtc_fini(&t);
+}
+
+int main(int argc, char **argv)
+{
+	int i, j;
+
+	for (i = 0; i < TEST_IMAGES; i++)
+		for (j = 0; j < 64 * 64; j++)
+			images[i][j] = 0xff000000 | (i << 16) | j;
+
+	test_hit();
+	test_lru();
+	test_scanout();
+	test_collision();
+	test_trace();
+
+	return emgd_test_done("cursor");
+}
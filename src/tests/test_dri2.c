@@ -0,0 +1,195 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_dri2.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  The DRI2 buffer cache: a released buffer comes back, with its name, for
+ *  the same drawable, attachment and geometry only; a destroyed drawable
+ *  takes its cached buffers with it, through emgd_dri2_cache_drop() and
+ *  the DestroyWindow wrapper; CloseScreen releases the rest and unwraps.
+ *
+ *  emgd_dri2.c is included for its static buffer hooks.
+ *-----------------------------------------------------------------------------
+ */
+
+#include "../emgd_dri2.c"
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+
+static int destroyed_windows;
+
+static PixmapPtr test_create_pixmap(ScreenPtr screen, int w, int h,
+	int depth, unsigned usage)
+{
+	return emgd_test_pixmap(xf86Screens[screen->myNum], w, h,
+		depth == 24 ? 32 : depth,
+		usage & INTEL_CREATE_PIXMAP_TILING_X ? I915_TILING_X :
+		I915_TILING_NONE);
+}
+
+static Bool test_destroy_pixmap(PixmapPtr pixmap)
+{
+	emgd_test_pixmap_free(pixmap);
+	return TRUE;
+}
+
+static Bool test_destroy_window(WindowPtr window)
+{
+	destroyed_windows++;
+	return TRUE;
+}
+
+static ScrnInfoPtr test_screen(void)
+{
+	ScrnInfoPtr scrn;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+	scrn->pScreen->CreatePixmap = test_create_pixmap;
+	scrn->pScreen->DestroyPixmap = test_destroy_pixmap;
+	EMGDPTR(scrn)->dri2_inuse = 1;
+	return scrn;
+}
+
+static void test_window(WindowPtr window, ScrnInfoPtr scrn, XID id)
+{
+	memset(window, 0, sizeof(*window));
+	window->drawable.type = DRAWABLE_WINDOW;
+	window->drawable.id = id;
+	window->drawable.pScreen = scrn->pScreen;
+	window->drawable.width = 640;
+	window->drawable.height = 480;
+	window->drawable.depth = 24;
+	window->drawable.bitsPerPixel = 32;
+}
+
+/* Create and release a back buffer, returning its name */
+static unsigned int test_release(DrawablePtr drawable)
+{
+	DRI2Buffer2Ptr buffer;
+	unsigned int name;
+
+	buffer = emgd_dri2_create_buffer(drawable, DRI2BufferBackLeft, 0);
+	CHECK(buffer != NULL);
+	if (buffer == NULL)
+		return 0;
+	name = buffer->name;
+	emgd_dri2_destroy_buffer(drawable, buffer);
+	return name;
+}
+
+static void test_reuse(void)
+{
+	ScrnInfoPtr scrn = test_screen();
+	WindowRec a, b;
+	DRI2Buffer2Ptr buffer;
+	unsigned int name;
+
+	test_window(&a, scrn, 0x200001);
+	test_window(&b, scrn, 0x200002);
+
+	name = test_release(&a.drawable);
+	CHECK_EQ(mock_drm.stats.bo_allocs, 1);
+	CHECK(!LIST_IS_EMPTY(&EMGDPTR(scrn)->dri2_cache));
+
+	/* Another drawable, or another size, gets a new buffer */
+	test_release(&b.drawable);
+	a.drawable.width = 800;
+	test_release(&a.drawable);
+	CHECK_EQ(mock_drm.stats.bo_allocs, 3);
+
+	/* The same drawable and geometry gets the cached one, name and all */
+	a.drawable.width = 640;
+	buffer = emgd_dri2_create_buffer(&a.drawable, DRI2BufferBackLeft, 0);
+	CHECK(buffer != NULL);
+	CHECK_EQ(mock_drm.stats.bo_allocs, 3);
+	CHECK_EQ(mock_drm.stats.flinks, 3);
+	if (buffer) {
+		CHECK_EQ(buffer->name, name);
+		emgd_dri2_destroy_buffer(&a.drawable, buffer);
+	}
+
+	emgd_dri2_cache_fini(scrn->pScreen);
+	CHECK(LIST_IS_EMPTY(&EMGDPTR(scrn)->dri2_cache));
+	CHECK_EQ(EMGDPTR(scrn)->dri2_cache_bytes, 0);
+	CHECK_EQ(mock_drm.stats.bo_live, 0);
+	emgd_test_screen_free(scrn);
+}
+
+static void test_drop(void)
+{
+	ScrnInfoPtr scrn = test_screen();
+	emgd_priv_t *iptr = EMGDPTR(scrn);
+	ScreenPtr screen = scrn->pScreen;
+	WindowRec a, b;
+	PixmapRec gone;
+
+	test_window(&a, scrn, 0x200001);
+	test_window(&b, scrn, 0x200002);
+	test_release(&a.drawable);
+	test_release(&b.drawable);
+	CHECK_EQ(mock_drm.stats.bo_live, 2);
+
+	/* A drawable that was never cached, or has no id, drops nothing */
+	memset(&gone, 0, sizeof(gone));
+	gone.drawable.pScreen = screen;
+	emgd_dri2_cache_drop(&gone.drawable);
+	gone.drawable.id = 0x200003;
+	emgd_dri2_cache_drop(&gone.drawable);
+	CHECK_EQ(mock_drm.stats.bo_live, 2);
+
+	/* Destroying a window drops its buffers and calls down the chain */
+	screen->DestroyWindow = test_destroy_window;
+	iptr->DestroyWindow = screen->DestroyWindow;
+	screen->DestroyWindow = emgd_dri2_destroy_window;
+	destroyed_windows = 0;
+	CHECK((*screen->DestroyWindow)(&a));
+	CHECK_EQ(destroyed_windows, 1);
+	CHECK_EQ(mock_drm.stats.bo_live, 1);
+	CHECK(screen->DestroyWindow == emgd_dri2_destroy_window);
+
+	/* b's buffer is still there for b */
+	CHECK_EQ(iptr->dri2_cache_bytes,
+		LIST_FIRST_ENTRY(&iptr->dri2_cache, emgd_dri2_cache_entry_t,
+				 link)->size);
+	test_release(&b.drawable);
+	CHECK_EQ(mock_drm.stats.bo_allocs, 2);
+
+	/* CloseScreen unwraps */
+	emgd_dri2_cache_fini(screen);
+	CHECK(screen->DestroyWindow == test_destroy_window);
+	CHECK(iptr->DestroyWindow == NULL);
+	CHECK_EQ(mock_drm.stats.bo_live, 0);
+	emgd_test_screen_free(scrn);
+}
+
+int main(int argc, char **argv)
+{
+	test_reuse();
+	test_drop();
+
+	return emgd_test_done("dri2");
+}
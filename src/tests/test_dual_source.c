@@ -0,0 +1,550 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_dual_source.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Single-pass component alpha on gen6 and gen7, from the WM kernel to
+ *  the blender:
+ *    - the render target writes of the dual-source kernels are two SIMD8
+ *      dual-source messages, subspans 0 and 1 then 2 and 3, each the last
+ *      render target write for its pixels, headerless, 8 registers long,
+ *      and only the second one ends the thread,
+ *    - what the kernels compute after sampling, run instruction by
+ *      instruction on sampled source and mask values, is source * mask
+ *      in the first output and mask * source alpha in the second, and
+ *      each pixel is written exactly once,
+ *    - those outputs, blended with the factors i965_get_blend_cntl()
+ *      picks, match pixman for every op that needs both sources (Over,
+ *      Atop, AtopReverse and Xor) onto destinations with and without
+ *      alpha,
+ *    - i965_check_composite() takes these ops from gen6 on and still
+ *      leaves them to the two-pass path before.
+ *
+ *  i965_render.c is included for its static kernels and blend tables.
+ *  EMGD_TEST_SEED picks the random pixels; it is printed on failure.
+ *-----------------------------------------------------------------------------
+ */
+
+#include "../i965_render.c"
+
+#include <stdlib.h>
+#include <pixman.h>
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+
+#define TEST_PIXELS	16	/* One SIMD16 thread */
+#define TEST_ROUNDS	64
+#define TEST_TOLERANCE	2	/* pixman rounds every product to 8 bits */
+
+/* EU instruction fields, see the brw_instruction layout */
+#define INST_OPCODE(i)		((i)[0] & 0x7f)
+#define INST_ALIGN16(i)		(((i)[0] >> 8) & 1)
+#define INST_QTR(i)		(((i)[0] >> 12) & 3)
+#define INST_PREDICATE(i)	(((i)[0] >> 16) & 0x1f)
+#define INST_EXEC_SIZE(i)	(1 << (((i)[0] >> 21) & 7))
+#define INST_SFID(i)		(((i)[0] >> 24) & 0xf)
+#define INST_SATURATE(i)	((i)[0] >> 31)
+#define INST_DST_FILE(i)	((i)[1] & 3)
+#define INST_DST_TYPE(i)	(((i)[1] >> 2) & 7)
+#define INST_SRC0_FILE(i)	(((i)[1] >> 5) & 3)
+#define INST_SRC0_TYPE(i)	(((i)[1] >> 7) & 7)
+#define INST_SRC1_FILE(i)	(((i)[1] >> 10) & 3)
+#define INST_SRC1_TYPE(i)	(((i)[1] >> 12) & 7)
+#define INST_DST_SUBREG(i)	(((i)[1] >> 16) & 0x1f)
+#define INST_DST_REG(i)		(((i)[1] >> 21) & 0xff)
+#define INST_DST_HSTRIDE(i)	(((i)[1] >> 29) & 3)
+#define INST_DST_INDIRECT(i)	((i)[1] >> 31)
+/* Direct align1 sources, dword 2 for src0 and dword 3 for src1 */
+#define SRC_SUBREG(s)		((s) & 0x1f)
+#define SRC_REG(s)		(((s) >> 5) & 0xff)
+#define SRC_MODIFIERS(s)	(((s) >> 13) & 7)	/* abs, negate, indirect */
+#define SRC_REGION(s)		(((s) >> 16) & 0x1ff)
+
+#define OPCODE_MOV		0x01
+#define OPCODE_SEND		0x31
+#define OPCODE_MUL		0x41
+#define OPCODE_NOP		0x7e
+#define FILE_GRF		1
+#define FILE_MRF		2
+#define TYPE_F			7
+#define REGION_8_8_1		0x8d	/* vstride 8, width 8, hstride 1 */
+#define SFID_SAMPLER		2
+#define SFID_RENDER_CACHE	5
+#define MSG_RT_WRITE		12
+#define RT_WRITE_SIMD8_DUAL_LO	2
+#define RT_WRITE_SIMD8_DUAL_HI	3
+
+/* Where exa_wm.g4i keeps the sampled values */
+#define SRC_SAMPLE_REG		14
+#define MASK_SAMPLE_REG		22
+
+static const struct {
+	const char *name;
+	int gen;
+	const struct wm_kernel_info *kernel;
+} kernels[] = {
+	{ "gen6 affine", 60, &wm_kernels_gen6[WM_KERNEL_MASKCA_DUAL_AFFINE] },
+	{ "gen6 projective", 60,
+	  &wm_kernels_gen6[WM_KERNEL_MASKCA_DUAL_PROJECTIVE] },
+	{ "gen7 affine", 70, &wm_kernels_gen7[WM_KERNEL_MASKCA_DUAL_AFFINE] },
+	{ "gen7 projective", 70,
+	  &wm_kernels_gen7[WM_KERNEL_MASKCA_DUAL_PROJECTIVE] },
+};
+
+static const struct {
+	const char *name;
+	int op;
+} ops[] = {
+	{ "Over", PictOpOver },
+	{ "Atop", PictOpAtop },
+	{ "AtopReverse", PictOpAtopReverse },
+	{ "Xor", PictOpXor },
+};
+
+/* Render target write descriptor, gen6 and gen7 layouts */
+typedef struct {
+	int msg_control;	/* Subtype and slot group */
+	int msg_type;
+	int last_rt;
+	int header;
+	int rlen;
+	int mlen;
+	int eot;
+} rt_write_t;
+
+static void decode_rt_write(int gen, uint32_t desc, rt_write_t *w)
+{
+	w->msg_control = (desc >> 8) & 0xf;
+	w->last_rt = (desc >> 12) & 1;
+	w->msg_type = gen >= 70 ? (desc >> 14) & 0xf : (desc >> 13) & 0xf;
+	w->header = (desc >> 19) & 1;
+	w->rlen = (desc >> 20) & 0x1f;
+	w->mlen = (desc >> 25) & 0xf;
+	w->eot = desc >> 31;
+}
+
+/* What the kernel left for the blender, per pixel */
+typedef struct {
+	float grf[128][8];
+	float mrf[24][8];	/* gen6 has 24 MRFs */
+	float src0[TEST_PIXELS][4];
+	float src1[TEST_PIXELS][4];
+	int written[TEST_PIXELS];
+	int writes;
+} eu_t;
+
+/* A float mov or mul on direct <8,8,1> registers: all the kernels use */
+static Bool check_alu(const uint32_t *inst)
+{
+	Bool mul = INST_OPCODE(inst) == OPCODE_MUL;
+
+	return !INST_ALIGN16(inst) && !INST_PREDICATE(inst) &&
+		!INST_SATURATE(inst) &&
+		(INST_EXEC_SIZE(inst) == 8 ||
+		 (INST_EXEC_SIZE(inst) == 16 && INST_QTR(inst) == 0)) &&
+		(INST_DST_FILE(inst) == FILE_GRF ||
+		 INST_DST_FILE(inst) == FILE_MRF) &&
+		INST_DST_TYPE(inst) == TYPE_F && INST_DST_SUBREG(inst) == 0 &&
+		INST_DST_HSTRIDE(inst) == 1 && !INST_DST_INDIRECT(inst) &&
+		INST_SRC0_FILE(inst) == FILE_GRF &&
+		INST_SRC0_TYPE(inst) == TYPE_F &&
+		SRC_SUBREG(inst[2]) == 0 && SRC_MODIFIERS(inst[2]) == 0 &&
+		SRC_REGION(inst[2]) == REGION_8_8_1 &&
+		(!mul || (INST_SRC1_FILE(inst) == FILE_GRF &&
+			  INST_SRC1_TYPE(inst) == TYPE_F &&
+			  SRC_SUBREG(inst[3]) == 0 &&
+			  SRC_MODIFIERS(inst[3]) == 0 &&
+			  SRC_REGION(inst[3]) == REGION_8_8_1));
+}
+
+static float *eu_reg(eu_t *eu, int file, int reg)
+{
+	if (file == FILE_MRF)
+		return reg < 24 ? eu->mrf[reg] : NULL;
+	return reg < 128 ? eu->grf[reg] : NULL;
+}
+
+static Bool run_alu(eu_t *eu, const uint32_t *inst)
+{
+	int n = INST_EXEC_SIZE(inst);
+	int i;
+
+	for (i = 0; i < n; i += 8) {
+		float *dst = eu_reg(eu, INST_DST_FILE(inst),
+				    INST_DST_REG(inst) + i / 8);
+		float *a = eu_reg(eu, FILE_GRF, SRC_REG(inst[2]) + i / 8);
+		float *b = eu_reg(eu, FILE_GRF, SRC_REG(inst[3]) + i / 8);
+		int j;
+
+		if (dst == NULL || a == NULL || b == NULL)
+			return FALSE;
+		for (j = 0; j < 8; j++)
+			dst[j] = INST_OPCODE(inst) == OPCODE_MUL ?
+				a[j] * b[j] : a[j];
+	}
+	return TRUE;
+}
+
+/* A dual-source render target write of one half of the thread */
+static Bool run_rt_write(eu_t *eu, int gen, const uint32_t *inst)
+{
+	int file = gen >= 70 ? FILE_GRF : FILE_MRF;
+	int half = INST_QTR(inst);
+	rt_write_t w;
+	int c, p;
+
+	decode_rt_write(gen, inst[3], &w);
+	CHECK_EQ(INST_EXEC_SIZE(inst), 8);
+	CHECK(half == 0 || half == 1);
+	CHECK_EQ(w.msg_type, MSG_RT_WRITE);
+	CHECK_EQ(w.msg_control, half ? RT_WRITE_SIMD8_DUAL_HI :
+		 RT_WRITE_SIMD8_DUAL_LO);
+	CHECK(w.last_rt);
+	CHECK(!w.header);
+	CHECK_EQ(w.rlen, 0);
+	CHECK_EQ(w.mlen, 8);
+	CHECK_EQ(w.eot, eu->writes == 1);
+	CHECK_EQ(INST_SRC0_FILE(inst), file);
+	if (half > 1 || INST_SRC0_FILE(inst) != file)
+		return FALSE;
+
+	for (c = 0; c < 4; c++) {
+		float *s0 = eu_reg(eu, file, SRC_REG(inst[2]) + c);
+		float *s1 = eu_reg(eu, file, SRC_REG(inst[2]) + 4 + c);
+
+		if (s0 == NULL || s1 == NULL)
+			return FALSE;
+		for (p = 0; p < 8; p++) {
+			eu->src0[half * 8 + p][c] = s0[p];
+			eu->src1[half * 8 + p][c] = s1[p];
+		}
+	}
+	for (p = 0; p < 8; p++)
+		eu->written[half * 8 + p]++;
+	eu->writes++;
+	return TRUE;
+}
+
+/*
+ * Run the kernel from its last sampler message on, as if that had
+ * returned src and mask (rgba, 0..1) for the 16 pixels of the thread.
+ */
+static Bool run_kernel(const struct wm_kernel_info *kernel, int gen,
+	float src[TEST_PIXELS][4], float mask[TEST_PIXELS][4], eu_t *eu)
+{
+	const uint32_t (*insts)[4] = kernel->data;
+	int n = kernel->size / sizeof(insts[0]);
+	int i, c, p, start = 0;
+	Bool eot = FALSE;
+
+	for (i = 0; i < n; i++) {
+		if (INST_OPCODE(insts[i]) == OPCODE_SEND &&
+		    INST_SFID(insts[i]) == SFID_SAMPLER)
+			start = i + 1;
+	}
+	CHECK(start > 0);
+
+	memset(eu, 0, sizeof(*eu));
+	for (c = 0; c < 4; c++) {
+		for (p = 0; p < TEST_PIXELS; p++) {
+			eu->grf[SRC_SAMPLE_REG + 2 * c + p / 8][p % 8] =
+				src[p][c];
+			eu->grf[MASK_SAMPLE_REG + 2 * c + p / 8][p % 8] =
+				mask[p][c];
+		}
+	}
+
+	for (i = start; i < n; i++) {
+		const uint32_t *inst = insts[i];
+		Bool ok;
+
+		if (eot) {
+			ok = INST_OPCODE(inst) == OPCODE_NOP;
+		} else if (INST_OPCODE(inst) == OPCODE_MOV ||
+			   INST_OPCODE(inst) == OPCODE_MUL) {
+			ok = check_alu(inst) && run_alu(eu, inst);
+		} else if (INST_OPCODE(inst) == OPCODE_SEND &&
+			   INST_SFID(inst) == SFID_RENDER_CACHE) {
+			ok = run_rt_write(eu, gen, inst);
+			eot = inst[3] >> 31;
+		} else {
+			ok = FALSE;
+		}
+
+		CHECK(ok);
+		if (!ok) {
+			fprintf(stderr, "instruction %d: 0x%08x 0x%08x 0x%08x "
+				"0x%08x\n", i, inst[0], inst[1], inst[2],
+				inst[3]);
+			return FALSE;
+		}
+	}
+
+	CHECK(eot);
+	CHECK_EQ(eu->writes, 2);
+	for (p = 0; p < TEST_PIXELS; p++)
+		CHECK_EQ(eu->written[p], 1);
+	return eot && eu->writes == 2;
+}
+
+static float blend_factor(uint32_t factor, int c, const float *s0,
+	const float *s1, const float *d)
+{
+	switch (factor) {
+	case BRW_BLENDFACTOR_ZERO:		return 0;
+	case BRW_BLENDFACTOR_ONE:		return 1;
+	case BRW_BLENDFACTOR_SRC_COLOR:		return s0[c];
+	case BRW_BLENDFACTOR_INV_SRC_COLOR:	return 1 - s0[c];
+	case BRW_BLENDFACTOR_SRC_ALPHA:		return s0[3];
+	case BRW_BLENDFACTOR_INV_SRC_ALPHA:	return 1 - s0[3];
+	case BRW_BLENDFACTOR_DST_COLOR:		return d[c];
+	case BRW_BLENDFACTOR_INV_DST_COLOR:	return 1 - d[c];
+	case BRW_BLENDFACTOR_DST_ALPHA:		return d[3];
+	case BRW_BLENDFACTOR_INV_DST_ALPHA:	return 1 - d[3];
+	case BRW_BLENDFACTOR_SRC1_COLOR:	return s1[c];
+	case BRW_BLENDFACTOR_INV_SRC1_COLOR:	return 1 - s1[c];
+	case BRW_BLENDFACTOR_SRC1_ALPHA:	return s1[3];
+	case BRW_BLENDFACTOR_INV_SRC1_ALPHA:	return 1 - s1[3];
+	}
+	CHECK(!"unexpected blend factor");
+	return 0;
+}
+
+/* Where r, g, b and a are in an a8r8g8b8 pixel */
+static const int rgba_shift[4] = { 16, 8, 0, 24 };
+
+static void unpack(uint32_t pixel, float *rgba)
+{
+	int c;
+
+	for (c = 0; c < 4; c++)
+		rgba[c] = ((pixel >> rgba_shift[c]) & 0xff) / 255.f;
+}
+
+/* The blender: clamped, src * sblend + dst * dblend, then to UNORM8 */
+static uint32_t blend(uint32_t sblend, uint32_t dblend, const float *s0,
+	const float *s1, uint32_t dst)
+{
+	float d[4];
+	uint32_t out = 0;
+	int c;
+
+	unpack(dst, d);
+	for (c = 0; c < 4; c++) {
+		float v = s0[c] * blend_factor(sblend, c, s0, s1, d) +
+			d[c] * blend_factor(dblend, c, s0, s1, d);
+
+		v = v < 0 ? 0 : v > 1 ? 1 : v;
+		out |= (uint32_t)(v * 255 + .5f) << rgba_shift[c];
+	}
+	return out;
+}
+
+/* A premultiplied pixel, with a fair share of the 0 and 255 edges */
+static uint32_t random_pixel(void)
+{
+	int a = rand() % 4 ? rand() % 256 : rand() & 1 ? 255 : 0;
+	uint32_t p = a << 24;
+	int c;
+
+	for (c = 0; c < 3; c++)
+		p |= (rand() % (a + 1)) << 8 * c;
+	return p;
+}
+
+
+static int channel_diff(uint32_t a, uint32_t b, int shift)
+{
+	return abs((int)((a >> shift) & 0xff) - (int)((b >> shift) & 0xff));
+}
+
+static void test_round(unsigned int seed, int k, int o,
+	pixman_format_code_t dst_format)
+{
+	uint32_t src_bits[TEST_PIXELS], mask_bits[TEST_PIXELS];
+	uint32_t dst_bits[TEST_PIXELS], ref_bits[TEST_PIXELS];
+	float src[TEST_PIXELS][4], mask[TEST_PIXELS][4];
+	pixman_image_t *src_image, *mask_image, *ref_image;
+	uint32_t sblend, dblend;
+	PictureRec mask_picture;
+	eu_t eu;
+	int p, c;
+
+	for (p = 0; p < TEST_PIXELS; p++) {
+		src_bits[p] = random_pixel();
+		mask_bits[p] = rand() % 4 ? ((uint32_t)rand() << 16) ^ rand() :
+			rand() & 1 ? 0xffffffff : 0;
+		dst_bits[p] = ((uint32_t)rand() << 16) ^ rand();
+		if (PIXMAN_FORMAT_A(dst_format))
+			dst_bits[p] = random_pixel();
+		ref_bits[p] = dst_bits[p];
+		unpack(src_bits[p], src[p]);
+		unpack(mask_bits[p], mask[p]);
+	}
+
+	if (!run_kernel(kernels[k].kernel, kernels[k].gen, src, mask, &eu))
+		goto fail;
+
+	/* The kernel's outputs are exact products */
+	for (p = 0; p < TEST_PIXELS; p++) {
+		for (c = 0; c < 4; c++) {
+			CHECK(eu.src0[p][c] == src[p][c] * mask[p][c]);
+			CHECK(eu.src1[p][c] == mask[p][c] * src[p][3]);
+		}
+	}
+
+	src_image = pixman_image_create_bits(PIXMAN_a8r8g8b8, TEST_PIXELS, 1,
+					     src_bits, sizeof(src_bits));
+	mask_image = pixman_image_create_bits(PIXMAN_a8r8g8b8, TEST_PIXELS, 1,
+					      mask_bits, sizeof(mask_bits));
+	ref_image = pixman_image_create_bits(dst_format, TEST_PIXELS, 1,
+					     ref_bits, sizeof(ref_bits));
+	pixman_image_set_component_alpha(mask_image, TRUE);
+	pixman_image_composite32(ops[o].op, src_image, mask_image, ref_image,
+				 0, 0, 0, 0, 0, 0, TEST_PIXELS, 1);
+	pixman_image_unref(src_image);
+	pixman_image_unref(mask_image);
+	pixman_image_unref(ref_image);
+
+	memset(&mask_picture, 0, sizeof(mask_picture));
+	mask_picture.format = PICT_a8r8g8b8;
+	mask_picture.componentAlpha = TRUE;
+	i965_get_blend_cntl(ops[o].op, &mask_picture, dst_format,
+			    &sblend, &dblend);
+	CHECK(sblend < GEN6_BLENDFACTOR_COUNT);
+	CHECK(dblend < GEN6_BLENDFACTOR_COUNT);
+
+	for (p = 0; p < TEST_PIXELS; p++) {
+		uint32_t got = blend(sblend, dblend, eu.src0[p], eu.src1[p],
+				     dst_bits[p]);
+		int shift, diff = 0;
+
+		for (shift = 0; shift < (PIXMAN_FORMAT_A(dst_format) ? 32 : 24);
+		     shift += 8) {
+			int d = channel_diff(got, ref_bits[p], shift);
+
+			if (d > diff)
+				diff = d;
+		}
+		CHECK(diff <= TEST_TOLERANCE);
+		if (diff > TEST_TOLERANCE) {
+			fprintf(stderr, "pixel %d: src 0x%08x mask 0x%08x "
+				"dst 0x%08x: blended 0x%08x, pixman 0x%08x\n",
+				p, src_bits[p], mask_bits[p], dst_bits[p],
+				got, ref_bits[p]);
+			goto fail;
+		}
+	}
+	return;
+
+fail:
+	fprintf(stderr, "seed %u: %s, %s onto %s\n", seed, kernels[k].name,
+		ops[o].name, PIXMAN_FORMAT_A(dst_format) ?
+		"a8r8g8b8" : "x8r8g8b8");
+}
+
+/* Exactly the ops the kernels are for need both sources */
+static void test_ops(void)
+{
+	PictureRec mask;
+	int op, o;
+
+	memset(&mask, 0, sizeof(mask));
+	mask.format = PICT_a8r8g8b8;
+	mask.componentAlpha = TRUE;
+
+	for (op = 0; op < ARRAY_SIZE(i965_blend_op); op++) {
+		Bool listed = FALSE;
+
+		for (o = 0; o < ARRAY_SIZE(ops); o++)
+			listed |= ops[o].op == op;
+		CHECK_EQ(i965_blend_needs_dual_source(op, &mask), listed);
+	}
+
+	/* Without component alpha a single source does */
+	mask.componentAlpha = FALSE;
+	CHECK(!i965_blend_needs_dual_source(PictOpOver, &mask));
+	CHECK(!i965_blend_needs_dual_source(PictOpOver, NULL));
+}
+
+static void test_check(int gen)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr pixmap;
+	PictureRec src, mask, dst;
+	int o;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(gen);
+	pixmap = emgd_test_pixmap(scrn, 64, 64, 32, I915_TILING_NONE);
+
+	memset(&src, 0, sizeof(src));
+	src.pDrawable = &pixmap->drawable;
+	src.format = PICT_a8r8g8b8;
+	mask = src;
+	mask.componentAlpha = TRUE;
+	dst = src;
+
+	for (o = 0; o < ARRAY_SIZE(ops); o++)
+		CHECK_EQ(i965_check_composite(ops[o].op, &src, &mask, &dst,
+					      64, 64), gen >= 60);
+
+	/* Single-source component alpha is unaffected */
+	CHECK(i965_check_composite(PictOpOutReverse, &src, &mask, &dst,
+				   64, 64));
+	CHECK(i965_check_composite(PictOpAdd, &src, &mask, &dst, 64, 64));
+
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+int main(int argc, char **argv)
+{
+	const char *env = getenv("EMGD_TEST_SEED");
+	unsigned int seed = env ? strtoul(env, NULL, 0) : 1;
+	int i, k, o;
+
+	test_ops();
+	test_check(50);
+	test_check(60);
+	test_check(70);
+
+	srand(seed);
+	for (k = 0; k < ARRAY_SIZE(kernels); k++) {
+		for (o = 0; o < ARRAY_SIZE(ops); o++) {
+			for (i = 0; i < TEST_ROUNDS; i++) {
+				int failures = emgd_test_failures;
+
+				test_round(seed, k, o, i & 1 ? PIXMAN_x8r8g8b8 :
+					   PIXMAN_a8r8g8b8);
+				if (emgd_test_failures != failures)
+					break;
+			}
+		}
+	}
+
+	return emgd_test_done("dual source");
+}
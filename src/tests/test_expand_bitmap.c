@@ -0,0 +1,203 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_expand_bitmap.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Transformed depth-1 sources are expanded only over their sample
+ *  extents (uxa_bitmap_extents() in uxa_expand_bitmap()).  This checks the
+ *  extents against pixman: a random bitmap composited through a random
+ *  scale, rotation, shear or projective transform, with every filter and
+ *  repeat UXA hands to the GPU, must give the same pixels, within a
+ *  tolerance of TEST_TOLERANCE, when only the expanded rectangle is
+ *  sampled with the transform moved onto it.
+ *
+ *  EMGD_TEST_SEED picks the random sequence; it is printed on failure.
+ *  uxa-render.c is included for the static extents function.
+ *-----------------------------------------------------------------------------
+ */
+
+#include "../../uxa/uxa-render.c"
+
+#include <stdlib.h>
+#include <math.h>
+#include <pixman.h>
+
+#include "emgd_test.h"
+
+#define TEST_ROUNDS	2000
+#define TEST_TOLERANCE	1	/* Bilinear rounding */
+
+static unsigned long expanded, whole;
+
+static int test_rand(int min, int max)
+{
+	return min + rand() % (max - min + 1);
+}
+
+static double test_frand(double min, double max)
+{
+	return min + (max - min) * rand() / RAND_MAX;
+}
+
+static void test_transform(struct pixman_transform *t)
+{
+	double a, s;
+
+	pixman_transform_init_identity(t);
+	switch (rand() % 4) {
+	case 0:	/* Scale */
+		pixman_transform_scale(t, NULL,
+			pixman_double_to_fixed(test_frand(0.25, 4)),
+			pixman_double_to_fixed(test_frand(0.25, 4)));
+		break;
+	case 1:	/* Rotation */
+		a = test_frand(0, 6.2831853);
+		pixman_transform_rotate(t, NULL,
+			pixman_double_to_fixed(cos(a)),
+			pixman_double_to_fixed(sin(a)));
+		break;
+	case 2:	/* Shear */
+		s = test_frand(-1, 1);
+		t->matrix[0][1] = pixman_double_to_fixed(s);
+		break;
+	case 3:	/* Projective */
+		t->matrix[2][0] = pixman_double_to_fixed(test_frand(0, 0.005));
+		t->matrix[2][1] = pixman_double_to_fixed(test_frand(0, 0.005));
+		break;
+	}
+	pixman_transform_translate(t, NULL,
+		pixman_int_to_fixed(test_rand(-16, 16)),
+		pixman_int_to_fixed(test_rand(-16, 16)));
+}
+
+static int test_round(unsigned int seed)
+{
+	int bw = test_rand(8, 96), bh = test_rand(8, 96);
+	int stride = (bw + 31) / 32 * 4;
+	INT16 x = test_rand(-32, 64), y = test_rand(-32, 64);
+	CARD16 w = test_rand(1, 64), h = test_rand(1, 64);
+	pixman_filter_t filter = rand() & 1 ? PIXMAN_FILTER_NEAREST :
+		PIXMAN_FILTER_BILINEAR;
+	pixman_repeat_t repeat = rand() % 4;
+	struct pixman_transform t, moved;
+	pixman_image_t *bitmap, *src, *box_img, *ref, *out;
+	pixman_box16_t box;
+	uint32_t *bits;
+	Bool is_whole;
+	int failures = emgd_test_failures;
+	int i, j, max_diff = 0;
+
+	test_transform(&t);
+
+	bits = malloc(stride * bh);
+	for (i = 0; i < stride * bh; i++)
+		((uint8_t *)bits)[i] = rand();
+	bitmap = pixman_image_create_bits(PIXMAN_a1, bw, bh, bits, stride);
+	src = pixman_image_create_bits(PIXMAN_a1, bw, bh, bits, stride);
+	ref = pixman_image_create_bits(PIXMAN_a8, w, h, NULL, 0);
+	out = pixman_image_create_bits(PIXMAN_a8, w, h, NULL, 0);
+
+	/* The source as the client set it up */
+	pixman_image_set_transform(src, &t);
+	pixman_image_set_filter(src, filter, NULL, 0);
+	pixman_image_set_repeat(src, repeat);
+	pixman_image_composite32(PIXMAN_OP_SRC, src, NULL, ref,
+		x, y, 0, 0, 0, 0, w, h);
+
+	/* As uxa_expand_bitmap() expands and samples it */
+	is_whole = uxa_bitmap_extents(&t, repeat != PIXMAN_REPEAT_NONE,
+		bw, bh, x, y, w, h, &box);
+	CHECK(box.x1 >= 0 && box.y1 >= 0 && box.x2 <= bw && box.y2 <= bh);
+	CHECK(box.x1 < box.x2 && box.y1 < box.y2);
+	if (emgd_test_failures != failures)
+		goto out;
+
+	box_img = pixman_image_create_bits(PIXMAN_a8, box.x2 - box.x1,
+		box.y2 - box.y1, NULL, 0);
+	pixman_image_composite32(PIXMAN_OP_SRC, bitmap, NULL, box_img,
+		box.x1, box.y1, 0, 0, 0, 0,
+		box.x2 - box.x1, box.y2 - box.y1);
+	moved = t;
+	pixman_transform_translate(&moved, NULL,
+		pixman_int_to_fixed(-box.x1), pixman_int_to_fixed(-box.y1));
+	pixman_image_set_transform(box_img, &moved);
+	pixman_image_set_filter(box_img, filter, NULL, 0);
+	pixman_image_set_repeat(box_img, is_whole ? repeat :
+		PIXMAN_REPEAT_NONE);
+	pixman_image_composite32(PIXMAN_OP_SRC, box_img, NULL, out,
+		x, y, 0, 0, 0, 0, w, h);
+	pixman_image_unref(box_img);
+
+	for (j = 0; j < h; j++) {
+		uint8_t *a = (uint8_t *)pixman_image_get_data(ref) +
+			j * pixman_image_get_stride(ref);
+		uint8_t *b = (uint8_t *)pixman_image_get_data(out) +
+			j * pixman_image_get_stride(out);
+
+		for (i = 0; i < w; i++) {
+			int diff = abs(a[i] - b[i]);
+
+			if (diff > max_diff)
+				max_diff = diff;
+		}
+	}
+	CHECK(max_diff <= TEST_TOLERANCE);
+
+	expanded += (unsigned long)(box.x2 - box.x1) * (box.y2 - box.y1);
+	whole += (unsigned long)bw * bh;
+
+out:
+	if (emgd_test_failures != failures)
+		fprintf(stderr, "seed %u: %dx%d bitmap, %dx%d at (%d, %d), "
+			"filter %d, repeat %d, box (%d, %d)-(%d, %d), "
+			"max difference %d\n", seed, bw, bh, w, h, x, y,
+			filter, repeat, box.x1, box.y1, box.x2, box.y2,
+			max_diff);
+
+	pixman_image_unref(bitmap);
+	pixman_image_unref(src);
+	pixman_image_unref(ref);
+	pixman_image_unref(out);
+	free(bits);
+	return emgd_test_failures == failures;
+}
+
+int main(int argc, char **argv)
+{
+	const char *env = getenv("EMGD_TEST_SEED");
+	unsigned int seed = env ? strtoul(env, NULL, 0) : 1;
+	int i;
+
+	srand(seed);
+	for (i = 0; i < TEST_ROUNDS; i++) {
+		if (!test_round(seed))
+			break;
+	}
+
+	if (whole)
+		printf("expanded %.1f%% of the bitmap pixels\n",
+			100.0 * expanded / whole);
+
+	return emgd_test_done("expand bitmap");
+}
@@ -0,0 +1,158 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_get_image.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  intel_uxa_get_image() through the staging pixmaps, on the mock_drm
+ *  timeline, read in bands the way dix splits a GetImage:
+ *    - every band of a busy X-tiled pixmap comes back with the right
+ *      pixels, with one miss for the request, one blit and submit per
+ *      chunk and at most one stall per chunk,
+ *    - a GPU write to the source invalidates its staging copy,
+ *    - idle linear pixmaps are read directly, without staging.
+ *
+ *  emgd_uxa.c is included for its static UXA hooks.
+ *-----------------------------------------------------------------------------
+ */
+
+#include "../emgd_uxa.c"
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+
+#define TEST_WIDTH	1024
+#define TEST_HEIGHT	768
+#define TEST_BAND	16
+
+static uint32_t *pattern, *band;
+
+static uint32_t test_pixel(int x, int y, uint32_t seed)
+{
+	return (y << 16) ^ x ^ seed;
+}
+
+static void test_fill_pattern(PixmapPtr pixmap, uint32_t seed)
+{
+	int x, y;
+
+	for (y = 0; y < TEST_HEIGHT; y++)
+		for (x = 0; x < TEST_WIDTH; x++)
+			pattern[y * TEST_WIDTH + x] = test_pixel(x, y, seed);
+	emgd_test_pixmap_write(pixmap, 0, 0, TEST_WIDTH, TEST_HEIGHT,
+		pattern, TEST_WIDTH * 4);
+}
+
+/* Read rows y..y+h in bands and compare them with the pattern */
+static void test_read(PixmapPtr pixmap, int y, int h)
+{
+	int failures = emgd_test_failures;
+
+	for (; h > 0; y += TEST_BAND, h -= TEST_BAND) {
+		CHECK(intel_uxa_get_image(pixmap, 0, y, TEST_WIDTH, TEST_BAND,
+					  (char *)band, TEST_WIDTH * 4));
+		CHECK(memcmp(band, pattern + y * TEST_WIDTH,
+			     TEST_WIDTH * 4 * TEST_BAND) == 0);
+		if (emgd_test_failures != failures) {
+			fprintf(stderr, "band at row %d\n", y);
+			return;
+		}
+	}
+}
+
+static void test_busy(void)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr pixmap;
+
+	mock_drm_reset();
+	memset(&emgd_perf, 0, sizeof(emgd_perf));
+	scrn = emgd_test_screen(70);
+	pixmap = emgd_test_pixmap(scrn, TEST_WIDTH, TEST_HEIGHT, 32,
+		I915_TILING_X);
+	test_fill_pattern(pixmap, 0x5a000000);
+
+	emgd_test_blt_fill(scrn, pixmap, 0, 0, 16, 16);
+	intel_batch_submit(scrn);
+	CHECK_EQ(mock_drm.stats.execs, 1);
+
+	/* 2 MiB chunks of 1024x32 rows: 512 rows, then the 256 left */
+	test_read(pixmap, 0, TEST_HEIGHT);
+	CHECK_EQ(emgd_perf.readback_misses, 1);
+	CHECK_EQ(emgd_perf.readback_hits, TEST_HEIGHT / TEST_BAND - 1);
+	CHECK_EQ(mock_drm.stats.execs, 3);
+	CHECK(mock_drm.stats.stalls <= 2);
+
+	/* Reading it again comes out of the staging copies */
+	test_read(pixmap, 0, 256);
+	CHECK_EQ(emgd_perf.readback_misses, 1);
+	CHECK_EQ(mock_drm.stats.execs, 3);
+
+	/* A GPU write invalidates them */
+	test_fill_pattern(pixmap, 0xa5000000);
+	emgd_test_blt_fill(scrn, pixmap, 0, 0, 16, 16);
+	test_read(pixmap, 0, TEST_BAND);
+	CHECK_EQ(emgd_perf.readback_misses, 2);
+
+	intel_uxa_fini(scrn->pScreen);
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+	CHECK_EQ(mock_drm.stats.bo_live, 0);
+}
+
+static void test_idle(void)
+{
+	ScrnInfoPtr scrn;
+	PixmapPtr pixmap;
+
+	mock_drm_reset();
+	memset(&emgd_perf, 0, sizeof(emgd_perf));
+	scrn = emgd_test_screen(70);
+	pixmap = emgd_test_pixmap(scrn, TEST_WIDTH, TEST_HEIGHT, 32,
+		I915_TILING_NONE);
+	test_fill_pattern(pixmap, 0x3c000000);
+
+	test_read(pixmap, 0, TEST_HEIGHT);
+	CHECK_EQ(emgd_perf.readback_misses, 0);
+	CHECK_EQ(emgd_perf.readback_hits, 0);
+	CHECK_EQ(mock_drm.stats.execs, 0);
+	CHECK_EQ(mock_drm.stats.stalls, 0);
+
+	intel_uxa_fini(scrn->pScreen);
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+int main(int argc, char **argv)
+{
+	pattern = malloc(TEST_WIDTH * TEST_HEIGHT * 4);
+	band = malloc(TEST_WIDTH * TEST_BAND * 4);
+
+	test_busy();
+	test_idle();
+
+	free(pattern);
+	free(band);
+	return emgd_test_done("get_image");
+}
@@ -0,0 +1,279 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_hotplug.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  emgd_output_hotplug_handler() fed simulated kernel uevents through a
+ *  datagram socketpair standing in for the netlink socket:
+ *    - a DRM hotplug event (SUBSYSTEM=drm and HOTPLUG=1) bumps probe_gen
+ *      and asks RandR to reprobe, once for any number of queued events,
+ *    - other subsystems, DRM events without HOTPLUG=1 and keys that only
+ *      start like the expected ones are ignored,
+ *    - emgd_output_detect() answers from the cached connector until such
+ *      an event, and probes on every call without a uevent socket.
+ *
+ *  emgd_output.c is included for its static output hooks.
+ *-----------------------------------------------------------------------------
+ */
+
+#include "../emgd_output.c"
+
+#include <sys/socket.h>
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+
+#define TEST_CONNECTOR	10
+#define TRACE_QUERIES	100
+#define TRACE_HOTPLUGS	5
+
+static int rr_queries;
+
+Bool RRGetInfo(ScreenPtr pScreen, Bool force_query)
+{
+	rr_queries++;
+	return TRUE;
+}
+
+typedef struct {
+	ScrnInfoPtr scrn;
+	drmmode_t drmmode;
+	int kernel_fd;		/* The kernel's end */
+	xf86OutputRec output;
+	emgd_output_priv_t priv;
+} test_kms_t;
+
+static void test_kms_init(test_kms_t *t, Bool uevents)
+{
+	int fds[2];
+
+	memset(t, 0, sizeof(*t));
+	mock_drm_reset();
+	memset(&emgd_perf, 0, sizeof(emgd_perf));
+	rr_queries = 0;
+
+	mock_drm.num_connectors = 1;
+	mock_drm.connectors[0].id = TEST_CONNECTOR;
+	mock_drm.connectors[0].connection = DRM_MODE_CONNECTED;
+
+	t->scrn = emgd_test_screen(70);
+	t->drmmode.scrn = t->scrn;
+	t->drmmode.probe_gen = 1;
+	t->drmmode.uevent_fd = -1;
+	t->kernel_fd = -1;
+	if (uevents) {
+		CHECK(socketpair(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0,
+				 fds) == 0);
+		t->drmmode.uevent_fd = fds[0];
+		t->kernel_fd = fds[1];
+	}
+
+	t->priv.drmmode = &t->drmmode;
+	t->priv.output_id = TEST_CONNECTOR;
+	t->output.driver_private = &t->priv;
+}
+
+static void test_kms_fini(test_kms_t *t)
+{
+	drmModeFreeConnector(t->priv.output);
+	emgd_output_hotplug_fini(&t->drmmode);
+	if (t->kernel_fd >= 0)
+		close(t->kernel_fd);
+	emgd_test_screen_free(t->scrn);
+}
+
+/* Queue one uevent: NUL separated strings, as the kernel sends them */
+static void test_uevent(test_kms_t *t, const char *const *keys)
+{
+	char buf[512];
+	size_t len = 0;
+
+	for (; *keys; keys++) {
+		size_t n = strlen(*keys) + 1;
+
+		memcpy(buf + len, *keys, n);
+		len += n;
+	}
+	CHECK(send(t->kernel_fd, buf, len, 0) == (ssize_t)len);
+}
+
+static const char *const drm_hotplug[] = {
+	"change@/devices/pci0000:00/0000:00:02.0/drm/card0",
+	"ACTION=change",
+	"DEVPATH=/devices/pci0000:00/0000:00:02.0/drm/card0",
+	"SUBSYSTEM=drm",
+	"HOTPLUG=1",
+	"DEVNAME=dri/card0",
+	"SEQNUM=1234",
+	NULL
+};
+
+static void test_events(void)
+{
+	static const char *const usb[] = {
+		"add@/devices/pci0000:00/0000:00:1d.0/usb2",
+		"ACTION=add", "SUBSYSTEM=usb", "HOTPLUG=1", NULL
+	};
+	static const char *const drm_add[] = {
+		"add@/devices/pci0000:00/0000:00:02.0/drm/card0",
+		"ACTION=add", "SUBSYSTEM=drm", NULL
+	};
+	static const char *const prefixes[] = {
+		"add@/devices/virtual/drm_dp_aux_dev/drm_dp_aux0",
+		"SUBSYSTEM=drm_dp_aux_dev", "HOTPLUG=10", NULL
+	};
+	static const char *const last[] = {
+		"change@/devices/pci0000:00/0000:00:02.0/drm/card0",
+		"HOTPLUG=1", "SUBSYSTEM=drm", NULL
+	};
+	test_kms_t t;
+	int i;
+
+	test_kms_init(&t, TRUE);
+
+	/* Nothing queued: nothing happens */
+	emgd_output_hotplug_handler(&t.drmmode);
+	CHECK_EQ(t.drmmode.probe_gen, 1);
+
+	/* Events that aren't DRM hotplugs */
+	test_uevent(&t, usb);
+	test_uevent(&t, drm_add);
+	test_uevent(&t, prefixes);
+	emgd_output_hotplug_handler(&t.drmmode);
+	CHECK_EQ(t.drmmode.probe_gen, 1);
+	CHECK_EQ(emgd_perf.hotplug_events, 0);
+	CHECK_EQ(rr_queries, 0);
+
+	/* One hotplug */
+	test_uevent(&t, drm_hotplug);
+	emgd_output_hotplug_handler(&t.drmmode);
+	CHECK_EQ(t.drmmode.probe_gen, 2);
+	CHECK_EQ(emgd_perf.hotplug_events, 1);
+	CHECK_EQ(rr_queries, 1);
+
+	/* A burst, mixed with other events and in any key order: one reprobe */
+	for (i = 0; i < 3; i++) {
+		test_uevent(&t, usb);
+		test_uevent(&t, i == 1 ? last : drm_hotplug);
+	}
+	emgd_output_hotplug_handler(&t.drmmode);
+	CHECK_EQ(t.drmmode.probe_gen, 3);
+	CHECK_EQ(emgd_perf.hotplug_events, 2);
+	CHECK_EQ(rr_queries, 2);
+
+	/* They were all drained */
+	emgd_output_hotplug_handler(&t.drmmode);
+	CHECK_EQ(t.drmmode.probe_gen, 3);
+
+	test_kms_fini(&t);
+}
+
+static void test_detect(void)
+{
+	test_kms_t t;
+
+	test_kms_init(&t, TRUE);
+
+	CHECK_EQ(emgd_output_detect(&t.output), XF86OutputStatusConnected);
+	CHECK_EQ(emgd_output_detect(&t.output), XF86OutputStatusConnected);
+	CHECK_EQ(mock_drm.stats.connector_probes, 1);
+	CHECK_EQ(emgd_perf.connector_cache_hits, 1);
+
+	/* Unplugged: stale until the kernel says so */
+	mock_drm.connectors[0].connection = DRM_MODE_DISCONNECTED;
+	CHECK_EQ(emgd_output_detect(&t.output), XF86OutputStatusConnected);
+	CHECK_EQ(mock_drm.stats.connector_probes, 1);
+
+	test_uevent(&t, drm_hotplug);
+	emgd_output_hotplug_handler(&t.drmmode);
+	CHECK_EQ(emgd_output_detect(&t.output), XF86OutputStatusDisconnected);
+	CHECK_EQ(emgd_output_detect(&t.output), XF86OutputStatusDisconnected);
+	CHECK_EQ(mock_drm.stats.connector_probes, 2);
+
+	test_kms_fini(&t);
+}
+
+static void test_no_socket(void)
+{
+	test_kms_t t;
+
+	test_kms_init(&t, FALSE);
+
+	CHECK_EQ(emgd_output_detect(&t.output), XF86OutputStatusConnected);
+	mock_drm.connectors[0].connection = DRM_MODE_DISCONNECTED;
+	CHECK_EQ(emgd_output_detect(&t.output), XF86OutputStatusDisconnected);
+	CHECK_EQ(mock_drm.stats.connector_probes, 2);
+	CHECK_EQ(emgd_perf.connector_cache_hits, 0);
+
+	test_kms_fini(&t);
+}
+
+/*
+ * RandR clients querying screen resources between a few hotplugs.
+ * Returns the connector probes.
+ */
+static unsigned long test_run_trace(Bool uevents)
+{
+	test_kms_t t;
+	unsigned long probes;
+	int i;
+
+	test_kms_init(&t, uevents);
+
+	for (i = 0; i < TRACE_QUERIES; i++) {
+		if (i % (TRACE_QUERIES / TRACE_HOTPLUGS) == 0 && uevents) {
+			test_uevent(&t, drm_hotplug);
+			emgd_output_hotplug_handler(&t.drmmode);
+		}
+		emgd_output_detect(&t.output);
+	}
+	probes = mock_drm.stats.connector_probes;
+
+	test_kms_fini(&t);
+	return probes;
+}
+
+static void test_trace(void)
+{
+	unsigned long probes = test_run_trace(TRUE);
+	unsigned long uncached = test_run_trace(FALSE);
+
+	CHECK_EQ(probes, TRACE_HOTPLUGS);
+	CHECK_EQ(uncached, TRACE_QUERIES);
+
+	printf("%d detects, %d hotplugs: %lu connector probes "
+		"(no uevent socket: %lu)\n",
+		TRACE_QUERIES, TRACE_HOTPLUGS, probes, uncached);
+}
+
+int main(int argc, char **argv)
+{
+	test_events();
+	test_detect();
+	test_no_socket();
+	test_trace();
+
+	return emgd_test_done("hotplug");
+}
@@ -0,0 +1,264 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_lines.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Lines and arcs drawn on the driver and on an fb reference server,
+ *  compared pixel for pixel after every round: PolyLine in both
+ *  coordinate modes, PolySegment, PolyArc and PolyFillArc, with random
+ *  line widths from 0 to 12, solid, on-off and double dashes with random
+ *  dash lists and offsets, every cap and join style, both arc modes,
+ *  alus, planemasks, colours and clip lists.  About a third of the line
+ *  vertices are snapped to the previous one's row or column so that the
+ *  horizontal and vertical rectangle paths, and their end points, get
+ *  exercised along with the diagonal ones.
+ *
+ *  Runs against $EMGD_TEST_DISPLAY and $EMGD_REF_DISPLAY, see emgd_xtest.h.
+ *  EMGD_TEST_SEED picks the random sequence; it is printed on failure,
+ *  with the round.
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+
+#include "emgd_test.h"
+#include "emgd_xtest.h"
+
+#define ARRAY_SIZE(x) (int)(sizeof(x) / sizeof((x)[0]))
+
+#define TEST_ROUNDS	400
+#define TEST_WIDTH	256
+#define TEST_HEIGHT	256
+#define TEST_POINTS	16
+
+static int random_coord(int size)
+{
+	return rand() % (size + 64) - 32;
+}
+
+static void random_gc(Display *dpy, GC gc)
+{
+	static const int line_styles[] = {
+		LineSolid, LineSolid, LineOnOffDash, LineDoubleDash,
+	};
+	static const int cap_styles[] = {
+		CapNotLast, CapButt, CapRound, CapProjecting,
+	};
+	static const int join_styles[] = {
+		JoinMiter, JoinRound, JoinBevel,
+	};
+	XGCValues values;
+
+	values.function = rand() % 4 ? GXcopy : rand() % 16;
+	values.plane_mask = rand() % 4 ? AllPlanes :
+		((unsigned long)rand() << 16) ^ rand();
+	values.foreground = ((unsigned long)rand() << 16) ^ rand();
+	values.background = ((unsigned long)rand() << 16) ^ rand();
+	values.fill_style = FillSolid;
+	values.line_width = rand() % 2 ? 0 : rand() % 13;
+	values.line_style = line_styles[rand() % ARRAY_SIZE(line_styles)];
+	values.cap_style = cap_styles[rand() % ARRAY_SIZE(cap_styles)];
+	values.join_style = join_styles[rand() % ARRAY_SIZE(join_styles)];
+	values.arc_mode = rand() & 1 ? ArcChord : ArcPieSlice;
+	XChangeGC(dpy, gc, GCFunction | GCPlaneMask | GCForeground |
+		  GCBackground | GCFillStyle | GCLineWidth | GCLineStyle |
+		  GCCapStyle | GCJoinStyle | GCArcMode, &values);
+
+	if (values.line_style != LineSolid) {
+		char dashes[6];
+		int i, n = 1 + rand() % ARRAY_SIZE(dashes);
+
+		for (i = 0; i < n; i++)
+			dashes[i] = 1 + rand() % 12;
+		XSetDashes(dpy, gc, rand() % 32, dashes, n);
+	}
+
+	if (rand() % 3 == 0) {
+		XRectangle rects[4];
+		int i, n = 1 + rand() % ARRAY_SIZE(rects);
+
+		for (i = 0; i < n; i++) {
+			rects[i].x = random_coord(TEST_WIDTH);
+			rects[i].y = random_coord(TEST_HEIGHT);
+			rects[i].width = 1 + rand() % 160;
+			rects[i].height = 1 + rand() % 160;
+		}
+		XSetClipRectangles(dpy, gc, 0, 0, rects, n, Unsorted);
+	} else {
+		XSetClipMask(dpy, gc, None);
+	}
+}
+
+static void random_points(XPoint *points, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		points[i].x = random_coord(TEST_WIDTH);
+		points[i].y = random_coord(TEST_HEIGHT);
+		if (i > 0 && rand() % 3 == 0) {
+			if (rand() & 1)
+				points[i].x = points[i - 1].x;
+			else
+				points[i].y = points[i - 1].y;
+		}
+	}
+}
+
+static void draw_lines(Display *dpy, Drawable d, GC gc)
+{
+	XPoint points[TEST_POINTS];
+	int i, n = 2 + rand() % (TEST_POINTS - 1);
+
+	random_gc(dpy, gc);
+	random_points(points, n);
+	if (rand() % 4 == 0)
+		points[n - 1] = points[0];	/* Closed */
+
+	if (rand() & 1) {
+		XDrawLines(dpy, d, gc, points, n, CoordModeOrigin);
+	} else {
+		for (i = n - 1; i > 0; i--) {
+			points[i].x -= points[i - 1].x;
+			points[i].y -= points[i - 1].y;
+		}
+		XDrawLines(dpy, d, gc, points, n, CoordModePrevious);
+	}
+}
+
+static void draw_segments(Display *dpy, Drawable d, GC gc)
+{
+	XPoint points[TEST_POINTS];
+	XSegment segs[TEST_POINTS / 2];
+	int i, n = 1 + rand() % ARRAY_SIZE(segs);
+
+	random_gc(dpy, gc);
+	random_points(points, 2 * n);
+	for (i = 0; i < n; i++) {
+		segs[i].x1 = points[2 * i].x;
+		segs[i].y1 = points[2 * i].y;
+		segs[i].x2 = points[2 * i + 1].x;
+		segs[i].y2 = points[2 * i + 1].y;
+	}
+	XDrawSegments(dpy, d, gc, segs, n);
+}
+
+static void random_arcs(XArc *arcs, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		arcs[i].x = random_coord(TEST_WIDTH);
+		arcs[i].y = random_coord(TEST_HEIGHT);
+		arcs[i].width = rand() % 128;
+		arcs[i].height = rand() % 4 ? rand() % 128 : arcs[i].width;
+		/* Whole circles, quadrants and anything in between */
+		arcs[i].angle1 = rand() % 2 ? (rand() % 8) * 45 * 64 :
+			rand() % (720 * 64) - 360 * 64;
+		arcs[i].angle2 = rand() % 4 ? rand() % (720 * 64) - 360 * 64 :
+			360 * 64;
+	}
+}
+
+static void draw_arcs(Display *dpy, Drawable d, GC gc)
+{
+	XArc arcs[8];
+	int n = 1 + rand() % ARRAY_SIZE(arcs);
+
+	random_gc(dpy, gc);
+	random_arcs(arcs, n);
+	XDrawArcs(dpy, d, gc, arcs, n);
+}
+
+static void draw_fill_arcs(Display *dpy, Drawable d, GC gc)
+{
+	XArc arcs[8];
+	int n = 1 + rand() % ARRAY_SIZE(arcs);
+
+	random_gc(dpy, gc);
+	random_arcs(arcs, n);
+	XFillArcs(dpy, d, gc, arcs, n);
+}
+
+static const struct {
+	const char *name;
+	emgd_xtest_draw_t draw;
+} draws[] = {
+	{ "lines", draw_lines },
+	{ "segments", draw_segments },
+	{ "arcs", draw_arcs },
+	{ "fill arcs", draw_fill_arcs },
+};
+
+static unsigned long long fallbacks(const iegd_esc_perf_counters_t *before,
+	const iegd_esc_perf_counters_t *after, int kind)
+{
+	return after->fallbacks[kind] - before->fallbacks[kind];
+}
+
+int main(int argc, char **argv)
+{
+	const char *env = getenv("EMGD_TEST_SEED");
+	unsigned int seed = env ? strtoul(env, NULL, 0) : 1;
+	iegd_esc_perf_counters_t before, after;
+	emgd_xtest_pair_t pair;
+	Bool perf;
+	int i;
+
+	srand(seed);
+	if (!emgd_xtest_pair_open(&pair, TEST_WIDTH, TEST_HEIGHT))
+		return EMGD_TEST_SKIP;
+	perf = emgd_xtest_perf(pair.dpy[0], &before);
+
+	for (i = 0; i < TEST_ROUNDS; i++) {
+		int draw = i % ARRAY_SIZE(draws);
+		long diff;
+		int x, y;
+
+		emgd_xtest_pair_draw(&pair, seed + i, draws[draw].draw);
+		diff = emgd_xtest_pair_compare(&pair, &x, &y);
+		CHECK_EQ(diff, 0);
+		if (diff) {
+			fprintf(stderr, "seed %u, round %d (%s): %ld pixels "
+				"differ, first at (%d, %d)\n", seed, i,
+				draws[draw].name, diff, x, y);
+			break;
+		}
+	}
+
+	if (perf && emgd_xtest_perf(pair.dpy[0], &after)) {
+		printf("%d rounds: %llu fallbacks (lines %llu, segments %llu, "
+		       "arcs %llu), %llu GTT maps\n", i,
+		       (unsigned long long)(emgd_xtest_fallbacks(&after) -
+					    emgd_xtest_fallbacks(&before)),
+		       fallbacks(&before, &after, EMGD_PERF_FALLBACK_POLY_LINES),
+		       fallbacks(&before, &after,
+				 EMGD_PERF_FALLBACK_POLY_SEGMENT),
+		       fallbacks(&before, &after, EMGD_PERF_FALLBACK_POLY_ARC),
+		       (unsigned long long)(after.gtt_maps - before.gtt_maps));
+	}
+
+	emgd_xtest_pair_close(&pair);
+	return emgd_test_done("lines");
+}
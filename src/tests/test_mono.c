@@ -0,0 +1,263 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_mono.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Stippled fills, CopyPlane and PushPixels drawn on the driver and on an
+ *  fb reference server, compared pixel for pixel after every round:
+ *    - FillStippled and FillOpaqueStippled rectangles and polygons (the
+ *      latter through FillSpans) with random stipples of pattern, tiled
+ *      and fallback sizes, tile origins, clip lists, alus and planemasks,
+ *    - CopyPlane from random bitmaps, and from a plane of the pixmap
+ *      itself,
+ *    - text drawn with a rop the glyph path can't take, which fb turns
+ *      into PushPixels, with a solid and a stippled fill.
+ *  The fallbacks and GTT mappings the driver counted are printed when
+ *  the server has the EMGD extension.
+ *
+ *  Runs against $EMGD_TEST_DISPLAY and $EMGD_REF_DISPLAY, see emgd_xtest.h.
+ *  EMGD_TEST_SEED picks the random sequence; it is printed on failure,
+ *  with the round.
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+
+#include "emgd_test.h"
+#include "emgd_xtest.h"
+
+#define ARRAY_SIZE(x) (int)(sizeof(x) / sizeof((x)[0]))
+
+#define TEST_ROUNDS	300
+#define TEST_WIDTH	256
+#define TEST_HEIGHT	256
+
+/* 8x8 and smaller repeats are patterns, 8x8 and up are expanded */
+static const struct {
+	int w, h;
+} stipple_sizes[] = {
+	{ 8, 8 }, { 4, 4 }, { 2, 8 }, { 16, 16 }, { 32, 8 }, { 64, 48 },
+	{ 13, 7 }, { 3, 5 }, { 1, 1 },
+};
+
+static Pixmap random_bitmap(Display *dpy, Drawable d, int w, int h)
+{
+	int size = (w + 7) / 8 * h;
+	char *data = malloc(size);
+	Pixmap bitmap;
+	int i;
+
+	for (i = 0; i < size; i++)
+		data[i] = rand();
+	bitmap = XCreateBitmapFromData(dpy, d, data, w, h);
+	free(data);
+	return bitmap;
+}
+
+static int random_coord(int size)
+{
+	return rand() % (size + 32) - 16;
+}
+
+/* The GC state every draw sets: alu, planemask, colours and clip */
+static void random_gc(Display *dpy, GC gc)
+{
+	XGCValues values;
+
+	values.function = rand() % 16;
+	values.plane_mask = rand() % 4 ? AllPlanes :
+		((unsigned long)rand() << 16) ^ rand();
+	values.foreground = ((unsigned long)rand() << 16) ^ rand();
+	values.background = ((unsigned long)rand() << 16) ^ rand();
+	values.fill_style = FillSolid;
+	values.graphics_exposures = False;
+	XChangeGC(dpy, gc, GCFunction | GCPlaneMask | GCForeground |
+		  GCBackground | GCFillStyle | GCGraphicsExposures, &values);
+
+	if (rand() % 3 == 0) {
+		XRectangle rects[4];
+		int i, n = 1 + rand() % ARRAY_SIZE(rects);
+
+		for (i = 0; i < n; i++) {
+			rects[i].x = random_coord(TEST_WIDTH);
+			rects[i].y = random_coord(TEST_HEIGHT);
+			rects[i].width = 1 + rand() % 128;
+			rects[i].height = 1 + rand() % 128;
+		}
+		XSetClipRectangles(dpy, gc, rand() % 16, rand() % 16,
+				   rects, n, Unsorted);
+	} else {
+		XSetClipMask(dpy, gc, None);
+	}
+}
+
+static void draw_stipple(Display *dpy, Drawable d, GC gc)
+{
+	int size = rand() % ARRAY_SIZE(stipple_sizes);
+	Pixmap stipple;
+	int i, n;
+
+	random_gc(dpy, gc);
+	stipple = random_bitmap(dpy, d, stipple_sizes[size].w,
+				stipple_sizes[size].h);
+	XSetStipple(dpy, gc, stipple);
+	XSetFillStyle(dpy, gc, rand() & 1 ? FillStippled : FillOpaqueStippled);
+	XSetTSOrigin(dpy, gc, random_coord(64), random_coord(64));
+
+	n = 1 + rand() % 8;
+	for (i = 0; i < n; i++) {
+		if (rand() % 4) {
+			XFillRectangle(dpy, d, gc, random_coord(TEST_WIDTH),
+				       random_coord(TEST_HEIGHT),
+				       1 + rand() % 96, 1 + rand() % 96);
+		} else {
+			XPoint points[5];
+			int j, npoints = 3 + rand() % 3;
+
+			for (j = 0; j < npoints; j++) {
+				points[j].x = random_coord(TEST_WIDTH);
+				points[j].y = random_coord(TEST_HEIGHT);
+			}
+			XFillPolygon(dpy, d, gc, points, npoints, Complex,
+				     CoordModeOrigin);
+		}
+	}
+
+	XFreePixmap(dpy, stipple);
+}
+
+static void draw_copy_plane(Display *dpy, Drawable d, GC gc)
+{
+	int depth = DefaultDepth(dpy, DefaultScreen(dpy));
+	int w = 1 + rand() % 128;
+	int h = 1 + rand() % 64;
+	Pixmap bitmap;
+
+	random_gc(dpy, gc);
+	if (rand() % 4) {
+		bitmap = random_bitmap(dpy, d, w, h);
+		XCopyPlane(dpy, bitmap, d, gc, rand() % 8 - 4, rand() % 8 - 4,
+			   w, h, random_coord(TEST_WIDTH),
+			   random_coord(TEST_HEIGHT), 1);
+		XFreePixmap(dpy, bitmap);
+	} else {
+		XCopyPlane(dpy, d, d, gc, random_coord(TEST_WIDTH),
+			   random_coord(TEST_HEIGHT), w, h,
+			   random_coord(TEST_WIDTH), random_coord(TEST_HEIGHT),
+			   1UL << (rand() % depth));
+	}
+}
+
+static void draw_push_pixels(Display *dpy, Drawable d, GC gc)
+{
+	static const int alus[] = {
+		GXxor, GXequiv, GXinvert, GXandReverse, GXorInverted,
+	};
+	Font font = XLoadFont(dpy, "fixed");
+	Pixmap stipple = None;
+	char text[40];
+	int i, len = 2 + rand() % (ARRAY_SIZE(text) - 2);
+
+	random_gc(dpy, gc);
+	XSetFont(dpy, gc, font);
+	XSetFunction(dpy, gc, alus[rand() % ARRAY_SIZE(alus)]);
+	if (rand() & 1) {
+		stipple = random_bitmap(dpy, d, 8, 8);
+		XSetStipple(dpy, gc, stipple);
+		XSetFillStyle(dpy, gc, FillStippled);
+	}
+
+	for (i = 0; i < len; i++)
+		text[i] = ' ' + rand() % 95;
+	XDrawString(dpy, d, gc, random_coord(TEST_WIDTH),
+		    random_coord(TEST_HEIGHT), text, len);
+
+	if (stipple != None)
+		XFreePixmap(dpy, stipple);
+	XUnloadFont(dpy, font);
+}
+
+static const struct {
+	const char *name;
+	emgd_xtest_draw_t draw;
+} draws[] = {
+	{ "stipple", draw_stipple },
+	{ "copy plane", draw_copy_plane },
+	{ "push pixels", draw_push_pixels },
+};
+
+static unsigned long long fallbacks(const iegd_esc_perf_counters_t *before,
+	const iegd_esc_perf_counters_t *after, int kind)
+{
+	return after->fallbacks[kind] - before->fallbacks[kind];
+}
+
+int main(int argc, char **argv)
+{
+	const char *env = getenv("EMGD_TEST_SEED");
+	unsigned int seed = env ? strtoul(env, NULL, 0) : 1;
+	iegd_esc_perf_counters_t before, after;
+	emgd_xtest_pair_t pair;
+	Bool perf;
+	int i;
+
+	srand(seed);
+	if (!emgd_xtest_pair_open(&pair, TEST_WIDTH, TEST_HEIGHT))
+		return EMGD_TEST_SKIP;
+	perf = emgd_xtest_perf(pair.dpy[0], &before);
+
+	for (i = 0; i < TEST_ROUNDS; i++) {
+		int draw = i % ARRAY_SIZE(draws);
+		long diff;
+		int x, y;
+
+		emgd_xtest_pair_draw(&pair, seed + i, draws[draw].draw);
+		diff = emgd_xtest_pair_compare(&pair, &x, &y);
+		CHECK_EQ(diff, 0);
+		if (diff) {
+			fprintf(stderr, "seed %u, round %d (%s): %ld pixels "
+				"differ, first at (%d, %d)\n", seed, i,
+				draws[draw].name, diff, x, y);
+			break;
+		}
+	}
+
+	if (perf && emgd_xtest_perf(pair.dpy[0], &after)) {
+		printf("%d rounds: %llu fallbacks (fill spans %llu, fill rect "
+		       "%llu, copy plane %llu, push pixels %llu), %llu GTT "
+		       "maps\n", i,
+		       (unsigned long long)(emgd_xtest_fallbacks(&after) -
+					    emgd_xtest_fallbacks(&before)),
+		       fallbacks(&before, &after, EMGD_PERF_FALLBACK_FILL_SPANS),
+		       fallbacks(&before, &after,
+				 EMGD_PERF_FALLBACK_POLY_FILL_RECT),
+		       fallbacks(&before, &after, EMGD_PERF_FALLBACK_COPY_PLANE),
+		       fallbacks(&before, &after,
+				 EMGD_PERF_FALLBACK_PUSH_PIXELS),
+		       (unsigned long long)(after.gtt_maps - before.gtt_maps));
+	}
+
+	emgd_xtest_pair_close(&pair);
+	return emgd_test_done("mono");
+}
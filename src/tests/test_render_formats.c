@@ -0,0 +1,155 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_render_formats.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  The i965 Render formats, one table row per picture format: whether it
+ *  is sampled directly and as which surface format, and which surface
+ *  format it renders to as a destination.  Formats that can't be sampled
+ *  must be rejected by i965_check_texture_format() alone, so that UXA
+ *  converts them, and the texture table must not list a format twice.
+ *
+ *  i965_render.c is included for its static format tables.
+ *-----------------------------------------------------------------------------
+ */
+
+#include "../i965_render.c"
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+
+#define NONE	((uint32_t)-1)
+
+static const struct {
+	pixman_format_code_t format;
+	uint32_t texture;	/* NONE: converted by UXA */
+	uint32_t dest;		/* NONE: not a render target */
+} formats[] = {
+	{ PICT_a8, BRW_SURFACEFORMAT_A8_UNORM, BRW_SURFACEFORMAT_A8_UNORM },
+	{ PICT_a8r8g8b8, BRW_SURFACEFORMAT_B8G8R8A8_UNORM,
+	  BRW_SURFACEFORMAT_B8G8R8A8_UNORM },
+	{ PICT_x8r8g8b8, BRW_SURFACEFORMAT_B8G8R8X8_UNORM,
+	  BRW_SURFACEFORMAT_B8G8R8A8_UNORM },
+	{ PICT_a8b8g8r8, BRW_SURFACEFORMAT_R8G8B8A8_UNORM,
+	  BRW_SURFACEFORMAT_R8G8B8A8_UNORM },
+	{ PICT_x8b8g8r8, BRW_SURFACEFORMAT_R8G8B8X8_UNORM,
+	  BRW_SURFACEFORMAT_R8G8B8A8_UNORM },
+	{ PICT_r8g8b8, BRW_SURFACEFORMAT_R8G8B8_UNORM, NONE },
+	{ PICT_r5g6b5, BRW_SURFACEFORMAT_B5G6R5_UNORM,
+	  BRW_SURFACEFORMAT_B5G6R5_UNORM },
+	{ PICT_a1r5g5b5, BRW_SURFACEFORMAT_B5G5R5A1_UNORM,
+	  BRW_SURFACEFORMAT_B5G5R5A1_UNORM },
+	{ PICT_x1r5g5b5, BRW_SURFACEFORMAT_B5G5R5X1_UNORM,
+	  BRW_SURFACEFORMAT_B5G5R5A1_UNORM },
+	{ PICT_a4r4g4b4, BRW_SURFACEFORMAT_B4G4R4A4_UNORM,
+	  BRW_SURFACEFORMAT_B4G4R4A4_UNORM },
+	{ PICT_x4r4g4b4, NONE, BRW_SURFACEFORMAT_B4G4R4A4_UNORM },
+#if XORG_VERSION_CURRENT >= 10699900
+	{ PICT_a2r10g10b10, BRW_SURFACEFORMAT_B10G10R10A2_UNORM,
+	  BRW_SURFACEFORMAT_B10G10R10A2_UNORM },
+	{ PICT_x2r10g10b10, BRW_SURFACEFORMAT_B10G10R10X2_UNORM,
+	  BRW_SURFACEFORMAT_B10G10R10A2_UNORM },
+	{ PICT_a2b10g10r10, BRW_SURFACEFORMAT_R10G10B10A2_UNORM,
+	  BRW_SURFACEFORMAT_R10G10B10A2_UNORM },
+	{ PICT_x2b10g10r10, NONE, BRW_SURFACEFORMAT_R10G10B10A2_UNORM },
+#endif
+	{ PICT_b8g8r8a8, NONE, NONE },
+	{ PICT_a4b4g4r4, NONE, NONE },
+	{ PICT_r3g3b2, NONE, NONE },
+	{ PICT_a4, NONE, NONE },
+	{ PICT_a1, NONE, NONE },
+	{ PICT_c8, NONE, NONE },
+};
+
+static void test_table(void)
+{
+	int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(i965_tex_formats); i++)
+		for (j = i + 1; j < ARRAY_SIZE(i965_tex_formats); j++)
+			CHECK(i965_tex_formats[i].fmt != i965_tex_formats[j].fmt);
+}
+
+static void test_formats(ScreenPtr screen)
+{
+	PictureRec picture;
+	int i;
+
+	memset(&picture, 0, sizeof(picture));
+	for (i = 0; i < ARRAY_SIZE(formats); i++) {
+		int failures = emgd_test_failures;
+
+		picture.format = formats[i].format;
+
+		CHECK_EQ(i965_check_texture_format(screen, formats[i].format),
+			 formats[i].texture != NONE);
+		if (formats[i].texture != NONE)
+			CHECK_EQ(i965_get_card_format(&picture),
+				 formats[i].texture);
+		CHECK_EQ(i965_get_dest_format(&picture), formats[i].dest);
+
+		if (emgd_test_failures != failures)
+			fprintf(stderr, "format 0x%08x\n", formats[i].format);
+	}
+}
+
+/* Other reasons to reject a source aren't format rejections */
+static void test_texture(ScrnInfoPtr scrn)
+{
+	PixmapPtr pixmap = emgd_test_pixmap(scrn, 64, 64, 32,
+		I915_TILING_NONE);
+	PictureRec picture;
+
+	memset(&picture, 0, sizeof(picture));
+	picture.pDrawable = &pixmap->drawable;
+	picture.format = PICT_a8r8g8b8;
+	picture.filter = PictFilterNearest;
+	CHECK(i965_check_composite_texture(scrn->pScreen, &picture));
+
+	picture.filter = PictFilterConvolution;
+	CHECK(!i965_check_composite_texture(scrn->pScreen, &picture));
+	CHECK(i965_check_texture_format(scrn->pScreen, picture.format));
+
+	picture.filter = PictFilterBilinear;
+	picture.format = PICT_b8g8r8a8;
+	CHECK(!i965_check_composite_texture(scrn->pScreen, &picture));
+
+	emgd_test_pixmap_free(pixmap);
+}
+
+int main(int argc, char **argv)
+{
+	ScrnInfoPtr scrn;
+
+	mock_drm_reset();
+	scrn = emgd_test_screen(70);
+
+	test_table();
+	test_formats(scrn->pScreen);
+	test_texture(scrn);
+
+	emgd_test_screen_free(scrn);
+	return emgd_test_done("render formats");
+}
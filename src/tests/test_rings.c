@@ -0,0 +1,340 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_rings.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Batch order across intel_batch_switch_ring(), on the mock_drm exec
+ *  records:
+ *    - independent BLT and render work builds up one batch per ring, with
+ *      no submit on a switch,
+ *    - reading what the parked batch writes, or writing what it reads or
+ *      writes, sets parked_dep, and the parked batch is then submitted
+ *      before the current one on the next switch or submit,
+ *    - ring_read/ring_write keep only the bits of batches still pending,
+ *    - random mixes of BLT fills, BLT copies and render copies never let a
+ *      write run before an earlier access to the same pixmap, or a read
+ *      before an earlier write.
+ *
+ *  EMGD_TEST_SEED picks the random sequence; it is printed on failure.
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+#include "intel_batchbuffer.h"
+
+#define TEST_PIXMAPS	4
+#define TEST_ROUNDS	50
+#define TEST_OPS	300
+
+#define RING_BIT(ring)	(1 << (ring))
+
+enum { OP_FILL, OP_BLT_COPY, OP_RENDER_COPY, OP_SUBMIT };
+
+typedef struct {
+	int type;
+	int src, dst;
+	long exec;		/* Index of the exec that ran it */
+} test_op_t;
+
+static PixmapPtr pixmaps[TEST_PIXMAPS];
+
+static int test_handle(int i)
+{
+	return intel_get_pixmap_private(pixmaps[i])->bo->handle;
+}
+
+static void test_run_op(ScrnInfoPtr scrn, const test_op_t *op)
+{
+	switch (op->type) {
+	case OP_FILL:
+		emgd_test_blt_fill(scrn, pixmaps[op->dst], 0, 0, 16, 16);
+		break;
+	case OP_BLT_COPY:
+		emgd_test_blt_copy(scrn, pixmaps[op->src], pixmaps[op->dst],
+			0, 0, 16, 16);
+		break;
+	case OP_RENDER_COPY:
+		emgd_test_render_copy(scrn, pixmaps[op->src], pixmaps[op->dst],
+			0, 0, 16, 16);
+		break;
+	case OP_SUBMIT:
+		intel_batch_submit(scrn);
+		break;
+	}
+}
+
+static ScrnInfoPtr test_screen(void)
+{
+	ScrnInfoPtr scrn;
+	int i;
+
+	mock_drm_reset();
+	memset(&emgd_perf, 0, sizeof(emgd_perf));
+	scrn = emgd_test_screen(70);
+	for (i = 0; i < TEST_PIXMAPS; i++)
+		pixmaps[i] = emgd_test_pixmap(scrn, 64, 64, 32,
+					      I915_TILING_X);
+	return scrn;
+}
+
+static void test_screen_free(ScrnInfoPtr scrn)
+{
+	int i;
+
+	for (i = 0; i < TEST_PIXMAPS; i++)
+		emgd_test_pixmap_free(pixmaps[i]);
+	emgd_test_screen_free(scrn);
+}
+
+static void test_independent(void)
+{
+	ScrnInfoPtr scrn = test_screen();
+
+	emgd_test_blt_fill(scrn, pixmaps[0], 0, 0, 16, 16);
+	emgd_test_render_copy(scrn, pixmaps[1], pixmaps[2], 0, 0, 16, 16);
+	emgd_test_blt_fill(scrn, pixmaps[3], 0, 0, 16, 16);
+	CHECK_EQ(mock_drm.stats.execs, 0);
+	CHECK_EQ(emgd_perf.ring_switches, 2);
+	CHECK_EQ(emgd_perf.ring_switch_submits, 0);
+	CHECK(!EMGDPTR(scrn)->parked_dep);
+
+	/* Parked render batch first, then both fills in one BLT batch */
+	intel_batch_submit(scrn);
+	CHECK_EQ(mock_drm.num_execs, 2);
+	if (mock_drm.num_execs == 2) {
+		CHECK_EQ(mock_drm.execs[0].ring, RENDER_BATCH);
+		CHECK_EQ(mock_drm.execs[0].num_targets, 2);
+		CHECK_EQ(mock_drm.execs[1].ring, BLT_BATCH);
+		CHECK_EQ(mock_drm.execs[1].num_targets, 2);
+		CHECK_EQ(mock_drm.execs[1].targets[0], test_handle(0));
+		CHECK_EQ(mock_drm.execs[1].targets[1], test_handle(3));
+	}
+	CHECK_EQ(EMGDPTR(scrn)->parked.ring, 0);
+
+	test_screen_free(scrn);
+}
+
+/* The render batch reads what the parked BLT batch writes */
+static void test_read_after_write(void)
+{
+	ScrnInfoPtr scrn = test_screen();
+	struct intel_pixmap *a = intel_get_pixmap_private(pixmaps[0]);
+
+	emgd_test_blt_fill(scrn, pixmaps[0], 0, 0, 16, 16);
+	emgd_test_render_copy(scrn, pixmaps[0], pixmaps[1], 0, 0, 16, 16);
+	CHECK(EMGDPTR(scrn)->parked_dep);
+	CHECK_EQ(a->ring_write, RING_BIT(BLT_BATCH));
+	CHECK_EQ(a->ring_read, RING_BIT(RENDER_BATCH));
+
+	/* Switching back submits the fill ... */
+	emgd_test_blt_fill(scrn, pixmaps[2], 0, 0, 16, 16);
+	CHECK_EQ(emgd_perf.ring_switch_submits, 1);
+	CHECK_EQ(mock_drm.num_execs, 1);
+	if (mock_drm.num_execs == 1) {
+		CHECK_EQ(mock_drm.execs[0].ring, BLT_BATCH);
+		CHECK_EQ(mock_drm.execs[0].targets[0], test_handle(0));
+	}
+	CHECK(!EMGDPTR(scrn)->parked_dep);
+
+	/* ... leaving only the render batch's read pending on it */
+	CHECK_EQ(a->ring_write, 0);
+	CHECK_EQ(a->ring_read, RING_BIT(RENDER_BATCH));
+	CHECK(!a->batch_write);
+	CHECK(a->batch_read);
+
+	intel_batch_submit(scrn);
+	CHECK_EQ(mock_drm.num_execs, 3);
+	if (mock_drm.num_execs == 3) {
+		CHECK_EQ(mock_drm.execs[1].ring, RENDER_BATCH);
+		CHECK_EQ(mock_drm.execs[2].ring, BLT_BATCH);
+	}
+	CHECK_EQ(a->ring_read, 0);
+	CHECK(LIST_IS_EMPTY(&a->batch));
+
+	test_screen_free(scrn);
+}
+
+/* The BLT batch writes what the parked render batch reads */
+static void test_write_after_read(void)
+{
+	ScrnInfoPtr scrn = test_screen();
+
+	emgd_test_render_copy(scrn, pixmaps[0], pixmaps[1], 0, 0, 16, 16);
+	emgd_test_blt_copy(scrn, pixmaps[2], pixmaps[3], 0, 0, 16, 16);
+	CHECK(!EMGDPTR(scrn)->parked_dep);
+	emgd_test_blt_fill(scrn, pixmaps[0], 0, 0, 16, 16);
+	CHECK(EMGDPTR(scrn)->parked_dep);
+	CHECK_EQ(mock_drm.stats.execs, 0);
+
+	/* A plain submit also runs the parked batch first */
+	intel_batch_submit(scrn);
+	CHECK_EQ(mock_drm.num_execs, 2);
+	if (mock_drm.num_execs == 2) {
+		CHECK_EQ(mock_drm.execs[0].ring, RENDER_BATCH);
+		CHECK_EQ(mock_drm.execs[1].ring, BLT_BATCH);
+	}
+	CHECK_EQ(emgd_perf.ring_switch_submits, 0);
+
+	test_screen_free(scrn);
+}
+
+/*
+ * Match each op with the exec that ran it: every ring runs its ops in
+ * order, each leaving its relocations in the batch in emit order.
+ */
+static int test_assign_execs(test_op_t *ops, int num_ops)
+{
+	static const unsigned int rings[] = { BLT_BATCH, RENDER_BATCH };
+	int r;
+
+	for (r = 0; r < ARRAY_SIZE(rings); r++) {
+		unsigned long e = 0;
+		int t = 0, i;
+
+		for (i = 0; i < num_ops; i++) {
+			test_op_t *op = &ops[i];
+			int expect[2], writes[2], n = 0, k;
+
+			if (op->type == OP_SUBMIT ||
+			    (op->type == OP_RENDER_COPY) !=
+			    (rings[r] == RENDER_BATCH))
+				continue;
+
+			switch (op->type) {
+			case OP_FILL:
+				expect[n] = test_handle(op->dst);
+				writes[n++] = 1;
+				break;
+			case OP_BLT_COPY:
+				expect[n] = test_handle(op->dst);
+				writes[n++] = 1;
+				expect[n] = test_handle(op->src);
+				writes[n++] = 0;
+				break;
+			case OP_RENDER_COPY:
+				expect[n] = test_handle(op->src);
+				writes[n++] = 0;
+				expect[n] = test_handle(op->dst);
+				writes[n++] = 1;
+				break;
+			}
+
+			/* An op never straddles two batches */
+			while (e < mock_drm.num_execs &&
+			       (mock_drm.execs[e].ring != rings[r] ||
+				t == mock_drm.execs[e].num_targets)) {
+				e++;
+				t = 0;
+			}
+			if (e == mock_drm.num_execs ||
+			    t + n > mock_drm.execs[e].num_targets)
+				return 0;
+
+			for (k = 0; k < n; k++, t++) {
+				if (mock_drm.execs[e].targets[t] != expect[k] ||
+				    !mock_drm.execs[e].writes[t] != !writes[k])
+					return 0;
+			}
+			op->exec = e;
+		}
+	}
+	return 1;
+}
+
+static int test_round(unsigned int seed)
+{
+	ScrnInfoPtr scrn = test_screen();
+	test_op_t ops[TEST_OPS];
+	long last_write[TEST_PIXMAPS], last_read[TEST_PIXMAPS];
+	int failures = emgd_test_failures;
+	int i, p;
+
+	for (i = 0; i < TEST_OPS; i++) {
+		test_op_t *op = &ops[i];
+		int r = rand() % 64;
+
+		op->type = r == 0 ? OP_SUBMIT : r % 3;
+		op->dst = rand() % TEST_PIXMAPS;
+		op->src = (op->dst + 1 + rand() % (TEST_PIXMAPS - 1)) %
+			TEST_PIXMAPS;
+		op->exec = -1;
+		test_run_op(scrn, op);
+	}
+	intel_batch_submit(scrn);
+
+	CHECK(test_assign_execs(ops, TEST_OPS));
+	if (emgd_test_failures != failures)
+		goto out;
+
+	for (p = 0; p < TEST_PIXMAPS; p++)
+		last_write[p] = last_read[p] = -1;
+	for (i = 0; i < TEST_OPS; i++) {
+		const test_op_t *op = &ops[i];
+
+		if (op->type == OP_SUBMIT)
+			continue;
+		if (op->type != OP_FILL) {
+			CHECK(op->exec >= last_write[op->src]);
+			if (op->exec > last_read[op->src])
+				last_read[op->src] = op->exec;
+		}
+		CHECK(op->exec >= last_write[op->dst]);
+		CHECK(op->exec >= last_read[op->dst]);
+		last_write[op->dst] = op->exec;
+		if (emgd_test_failures != failures) {
+			fprintf(stderr, "op %d\n", i);
+			break;
+		}
+	}
+
+out:
+	if (emgd_test_failures != failures)
+		fprintf(stderr, "seed %u: %lu execs\n", seed,
+			mock_drm.num_execs);
+	test_screen_free(scrn);
+	return emgd_test_failures == failures;
+}
+
+int main(int argc, char **argv)
+{
+	const char *env = getenv("EMGD_TEST_SEED");
+	unsigned int seed = env ? strtoul(env, NULL, 0) : 1;
+	int i;
+
+	test_independent();
+	test_read_after_write();
+	test_write_after_read();
+
+	srand(seed);
+	for (i = 0; i < TEST_ROUNDS; i++) {
+		if (!test_round(seed))
+			break;
+	}
+
+	return emgd_test_done("rings");
+}
@@ -0,0 +1,376 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_submit.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  The batch submission thread, with a batch_exec hook that can hold the
+ *  worker back:
+ *    - a random mix of BLT and render work reaches the (mock) kernel as
+ *      the same batches in the same order with and without the thread,
+ *    - intel_batch_submit() only queues; intel_batch_wait_submitted()
+ *      returns once every queued batch has been issued, and doesn't count
+ *      a wait when nothing is queued,
+ *    - queueing blocks once EMGD_SUBMIT_DEPTH batches are waiting,
+ *    - the queue keeps its own reference to each batch bo,
+ *    - the first failure is returned once, by the next queue or wait,
+ *    - emgd_submit_destroy() issues what is still queued.
+ *
+ *  EMGD_TEST_SEED picks the random sequence; it is printed on failure.
+ *-----------------------------------------------------------------------------
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define EMGD_TEST_DRIVER
+#include "emgd_test.h"
+#include "mock_drm.h"
+#include "intel_batchbuffer.h"
+#include "emgd_submit.h"
+
+#define TEST_PIXMAPS	4
+#define TEST_OPS	2000
+#define TEST_DELAY_MS	20
+#define MAX_EXECS	(TEST_OPS + 1)
+
+/* The worker waits in test_hook() until the gate opens */
+static pthread_mutex_t gate_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gate_cond = PTHREAD_COND_INITIALIZER;
+static int gate_open = 1;
+
+static int hook_calls;
+static int hook_errors[2];	/* Returned by the first calls, if set */
+static int hook_handles[MAX_EXECS];
+
+static int test_hook(intel_screen_private *intel, dri_bo *bo, int used,
+	unsigned int ring)
+{
+	int call;
+
+	pthread_mutex_lock(&gate_lock);
+	while (!gate_open)
+		pthread_cond_wait(&gate_cond, &gate_lock);
+	pthread_mutex_unlock(&gate_lock);
+
+	call = hook_calls++;
+	if (call < MAX_EXECS)
+		hook_handles[call] = bo->handle;
+	if (call < ARRAY_SIZE(hook_errors) && hook_errors[call])
+		return hook_errors[call];
+	return intel_batch_exec(intel, bo, used, ring);
+}
+
+static void test_gate_close(void)
+{
+	pthread_mutex_lock(&gate_lock);
+	gate_open = 0;
+	pthread_mutex_unlock(&gate_lock);
+}
+
+static int test_gate_is_open(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&gate_lock);
+	ret = gate_open;
+	pthread_mutex_unlock(&gate_lock);
+	return ret;
+}
+
+static void *test_opener(void *data)
+{
+	struct timespec delay = { 0, TEST_DELAY_MS * 1000000L };
+
+	nanosleep(&delay, NULL);
+	pthread_mutex_lock(&gate_lock);
+	gate_open = 1;
+	pthread_cond_broadcast(&gate_cond);
+	pthread_mutex_unlock(&gate_lock);
+	return NULL;
+}
+
+/* Open the gate from another thread a little later */
+static pthread_t test_gate_open_later(void)
+{
+	pthread_t thread;
+
+	CHECK(pthread_create(&thread, NULL, test_opener, NULL) == 0);
+	return thread;
+}
+
+static ScrnInfoPtr test_screen(Bool async)
+{
+	ScrnInfoPtr scrn;
+	intel_screen_private *intel;
+
+	mock_drm_reset();
+	memset(&emgd_perf, 0, sizeof(emgd_perf));
+	memset(hook_errors, 0, sizeof(hook_errors));
+	hook_calls = 0;
+
+	scrn = emgd_test_screen(70);
+	intel = EMGDPTR(scrn);
+	intel->batch_exec = test_hook;
+	if (async) {
+		/* What intel_batch_init() does for AsyncSubmit */
+		intel->submit = emgd_submit_create(intel);
+		CHECK(intel->submit != NULL);
+	}
+	return scrn;
+}
+
+/* An exec with its targets as pixmap indices, comparable across runs */
+typedef struct {
+	unsigned int ring;
+	int used;
+	int num_targets;
+	int targets[8];
+	int writes[8];
+} test_exec_t;
+
+static int test_run_mix(Bool async, unsigned int seed, test_exec_t *execs)
+{
+	ScrnInfoPtr scrn = test_screen(async);
+	PixmapPtr pixmaps[TEST_PIXMAPS];
+	unsigned long e;
+	int i, j, k;
+
+	for (i = 0; i < TEST_PIXMAPS; i++)
+		pixmaps[i] = emgd_test_pixmap(scrn, 64, 64, 32,
+					      I915_TILING_X);
+
+	srand(seed);
+	for (i = 0; i < TEST_OPS; i++) {
+		int r = rand() % 8;
+		int dst = rand() % TEST_PIXMAPS;
+		int src = (dst + 1) % TEST_PIXMAPS;
+
+		switch (r % 4) {
+		case 0:
+			emgd_test_blt_fill(scrn, pixmaps[dst], 0, 0, 16, 16);
+			break;
+		case 1:
+			emgd_test_blt_copy(scrn, pixmaps[src], pixmaps[dst],
+				0, 0, 16, 16);
+			break;
+		case 2:
+			emgd_test_render_copy(scrn, pixmaps[src],
+				pixmaps[dst], 0, 0, 16, 16);
+			break;
+		case 3:
+			if (r == 3)
+				intel_batch_submit(scrn);
+			break;
+		}
+	}
+	intel_batch_submit(scrn);
+	intel_batch_wait_submitted(scrn);
+
+	for (e = 0; e < mock_drm.num_execs && e < MAX_EXECS; e++) {
+		const mock_exec_t *exec = &mock_drm.execs[e];
+		test_exec_t *out = &execs[e];
+
+		out->ring = exec->ring;
+		out->used = exec->used;
+		out->num_targets = exec->num_targets < 8 ?
+			exec->num_targets : 8;
+		for (j = 0; j < out->num_targets; j++) {
+			out->targets[j] = -1;
+			for (k = 0; k < TEST_PIXMAPS; k++) {
+				if (exec->targets[j] == intel_get_pixmap_private(
+						pixmaps[k])->bo->handle)
+					out->targets[j] = k;
+			}
+			out->writes[j] = exec->writes[j] != 0;
+		}
+	}
+
+	for (i = 0; i < TEST_PIXMAPS; i++)
+		emgd_test_pixmap_free(pixmaps[i]);
+	emgd_test_screen_free(scrn);
+	return e;
+}
+
+static void test_order(void)
+{
+	const char *env = getenv("EMGD_TEST_SEED");
+	unsigned int seed = env ? strtoul(env, NULL, 0) : 1;
+	static test_exec_t sync[MAX_EXECS], async[MAX_EXECS];
+	int num_sync, num_async, i;
+
+	memset(sync, 0, sizeof(sync));
+	memset(async, 0, sizeof(async));
+	num_sync = test_run_mix(FALSE, seed, sync);
+	num_async = test_run_mix(TRUE, seed, async);
+
+	CHECK(num_sync > 1);
+	CHECK_EQ(num_async, num_sync);
+	for (i = 0; i < num_sync && i < num_async; i++) {
+		if (memcmp(&sync[i], &async[i], sizeof(sync[i])) != 0) {
+			CHECK(memcmp(&sync[i], &async[i],
+				     sizeof(sync[i])) == 0);
+			fprintf(stderr, "seed %u: exec %d of %d differs\n",
+				seed, i, num_sync);
+			break;
+		}
+	}
+}
+
+static void test_wait(void)
+{
+	ScrnInfoPtr scrn = test_screen(TRUE);
+	PixmapPtr pixmap = emgd_test_pixmap(scrn, 64, 64, 32, I915_TILING_X);
+	pthread_t opener;
+
+	test_gate_close();
+	emgd_test_blt_fill(scrn, pixmap, 0, 0, 16, 16);
+	intel_batch_submit(scrn);
+	CHECK_EQ(emgd_perf.submit_queued, 1);
+	CHECK_EQ(mock_drm.stats.execs, 0);
+
+	/* Returns only once the worker got through the gate */
+	opener = test_gate_open_later();
+	intel_batch_wait_submitted(scrn);
+	CHECK(test_gate_is_open());
+	CHECK_EQ(mock_drm.stats.execs, 1);
+	CHECK_EQ(emgd_perf.submit_waits, 1);
+	pthread_join(opener, NULL);
+
+	/* Nothing queued: no wait */
+	intel_batch_wait_submitted(scrn);
+	CHECK_EQ(emgd_perf.submit_waits, 1);
+
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+static void test_depth(void)
+{
+	ScrnInfoPtr scrn = test_screen(TRUE);
+	PixmapPtr pixmap = emgd_test_pixmap(scrn, 64, 64, 32, I915_TILING_X);
+	int handles[EMGD_SUBMIT_DEPTH + 1];
+	pthread_t opener = 0;
+	int i;
+
+	test_gate_close();
+	for (i = 0; i <= EMGD_SUBMIT_DEPTH; i++) {
+		if (i == EMGD_SUBMIT_DEPTH) {
+			/* The queue is full: this one has to wait */
+			CHECK_EQ(emgd_perf.submit_waits, 0);
+			CHECK_EQ(mock_drm.stats.execs, 0);
+			opener = test_gate_open_later();
+		}
+		emgd_test_blt_fill(scrn, pixmap, 0, 0, 16, 16);
+		handles[i] = EMGDPTR(scrn)->batch_bo->handle;
+		intel_batch_submit(scrn);
+	}
+	CHECK(test_gate_is_open());
+	CHECK_EQ(emgd_perf.submit_waits, 1);
+	pthread_join(opener, NULL);
+
+	/* In order, one exec each */
+	intel_batch_wait_submitted(scrn);
+	CHECK_EQ(hook_calls, EMGD_SUBMIT_DEPTH + 1);
+	for (i = 0; i <= EMGD_SUBMIT_DEPTH; i++)
+		CHECK_EQ(hook_handles[i], handles[i]);
+
+	emgd_test_pixmap_free(pixmap);
+	emgd_test_screen_free(scrn);
+}
+
+static void test_queue(void)
+{
+	ScrnInfoPtr scrn = test_screen(FALSE);
+	intel_screen_private *intel = EMGDPTR(scrn);
+	struct emgd_submit *submit = emgd_submit_create(intel);
+	unsigned long live = mock_drm.stats.bo_live;
+	pthread_t opener;
+	dri_bo *bo;
+	int i;
+
+	CHECK(submit != NULL);
+	if (submit == NULL)
+		goto out;
+
+	/* The queue's reference keeps the bo until it has been issued */
+	test_gate_close();
+	bo = dri_bo_alloc(intel->bufmgr, "batch", 4096, 4096);
+	CHECK_EQ(emgd_submit_queue(submit, bo, 8, RENDER_BATCH), 0);
+	dri_bo_unreference(bo);
+	CHECK_EQ(mock_drm.stats.bo_live, live + 1);
+	opener = test_gate_open_later();
+	CHECK_EQ(emgd_submit_wait(submit), 0);
+	pthread_join(opener, NULL);
+	CHECK_EQ(mock_drm.stats.bo_live, live);
+
+	/* The first failure, once */
+	hook_calls = 0;
+	hook_errors[0] = -ENOSPC;
+	hook_errors[1] = -EINVAL;
+	for (i = 0; i < 2; i++) {
+		bo = dri_bo_alloc(intel->bufmgr, "batch", 4096, 4096);
+		emgd_submit_queue(submit, bo, 8, RENDER_BATCH);
+		dri_bo_unreference(bo);
+	}
+	CHECK_EQ(emgd_submit_wait(submit), -ENOSPC);
+	CHECK_EQ(emgd_submit_wait(submit), 0);
+
+	/* Whichever of the next queue and wait sees it reports it */
+	hook_calls = 0;
+	hook_errors[1] = 0;
+	bo = dri_bo_alloc(intel->bufmgr, "batch", 4096, 4096);
+	emgd_submit_queue(submit, bo, 8, RENDER_BATCH);
+	CHECK_EQ(emgd_submit_queue(submit, bo, 8, RENDER_BATCH) +
+		 emgd_submit_wait(submit), -ENOSPC);
+	dri_bo_unreference(bo);
+
+	/* Destroying issues what is still queued */
+	hook_calls = 0;
+	hook_errors[0] = 0;
+	test_gate_close();
+	bo = dri_bo_alloc(intel->bufmgr, "batch", 4096, 4096);
+	for (i = 0; i < 3; i++)
+		emgd_submit_queue(submit, bo, 8, RENDER_BATCH);
+	dri_bo_unreference(bo);
+	opener = test_gate_open_later();
+	emgd_submit_destroy(submit);
+	pthread_join(opener, NULL);
+	CHECK_EQ(hook_calls, 3);
+	CHECK_EQ(mock_drm.stats.bo_live, live);
+
+out:
+	emgd_test_screen_free(scrn);
+}
+
+int main(int argc, char **argv)
+{
+	test_order();
+	test_wait();
+	test_depth();
+	test_queue();
+
+	return emgd_test_done("submit");
+}
@@ -0,0 +1,201 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: test_tiling.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  emgd_detile_rect() and emgd_tile_rect() against a per-byte reference of
+ *  the X and Y tile layouts and every supported bit-6 swizzle, on random
+ *  surfaces, rectangles and (mis)alignments of the linear side.  Bytes
+ *  outside the rectangle, on either side, must not be touched.
+ *
+ *  EMGD_TEST_SEED picks the random sequence; it is printed on failure.
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <i915_drm.h>
+
+#include "emgd_test.h"
+#include "emgd_tiling.h"
+
+#define ARRAY_SIZE(x) (int)(sizeof(x) / sizeof((x)[0]))
+
+#define TEST_ROUNDS	2000
+#define TEST_GUARD	0xa5
+
+static const uint32_t swizzles[] = {
+	I915_BIT_6_SWIZZLE_NONE,
+	I915_BIT_6_SWIZZLE_9,
+	I915_BIT_6_SWIZZLE_9_10,
+	I915_BIT_6_SWIZZLE_9_11,
+	I915_BIT_6_SWIZZLE_9_10_11,
+};
+
+/* Offset of byte (x, y) of a tiled surface, one bit at a time */
+static unsigned long ref_offset(uint32_t tiling, uint32_t swizzle, int pitch,
+	int x, int y)
+{
+	unsigned long offset, bit6;
+
+	if (tiling == I915_TILING_X) {
+		offset = (unsigned long)(y / 8) * (pitch / 512) * 4096 +
+			(x / 512) * 4096 + (y % 8) * 512 + x % 512;
+	} else {
+		offset = (unsigned long)(y / 32) * (pitch / 128) * 4096 +
+			(x / 128) * 4096 + (x % 128 / 16) * 512 +
+			(y % 32) * 16 + x % 16;
+	}
+
+	bit6 = 0;
+	switch (swizzle) {
+	case I915_BIT_6_SWIZZLE_9:
+		bit6 = (offset >> 9) & 1;
+		break;
+	case I915_BIT_6_SWIZZLE_9_10:
+		bit6 = ((offset >> 9) ^ (offset >> 10)) & 1;
+		break;
+	case I915_BIT_6_SWIZZLE_9_11:
+		bit6 = ((offset >> 9) ^ (offset >> 11)) & 1;
+		break;
+	case I915_BIT_6_SWIZZLE_9_10_11:
+		bit6 = ((offset >> 9) ^ (offset >> 10) ^ (offset >> 11)) & 1;
+		break;
+	}
+
+	return offset ^ (bit6 << 6);
+}
+
+static void fill_random(uint8_t *p, size_t len)
+{
+	while (len--)
+		*p++ = rand();
+}
+
+static int test_round(unsigned int seed)
+{
+	uint32_t tiling = rand() & 1 ? I915_TILING_X : I915_TILING_Y;
+	uint32_t swizzle = swizzles[rand() % ARRAY_SIZE(swizzles)];
+	int tile_w = tiling == I915_TILING_X ? 512 : 128;
+	int tile_h = tiling == I915_TILING_X ? 8 : 32;
+	int pitch = tile_w * (1 + rand() % 8);
+	int height = tile_h * (1 + rand() % 4);
+	int w = 1 + rand() % pitch;
+	int h = 1 + rand() % height;
+	int x = rand() % (pitch - w + 1);
+	int y = rand() % (height - h + 1);
+	int misalign = rand() % 16;
+	int linear_pitch = w + rand() % 64;
+	size_t tiled_size = (size_t)pitch * height;
+	size_t linear_size = (size_t)linear_pitch * h + misalign + 64;
+	uint8_t *tiled, *expect, *linear_buf, *linear;
+	int failures = emgd_test_failures;
+	int i, j;
+
+	if (posix_memalign((void **)&tiled, 4096, tiled_size))
+		return 0;
+	expect = malloc(tiled_size);
+	linear_buf = malloc(linear_size);
+	linear = linear_buf + misalign;
+
+	/* Detile: every byte from its reference offset, guards untouched */
+	fill_random(tiled, tiled_size);
+	memset(linear_buf, TEST_GUARD, linear_size);
+	emgd_detile_rect(linear, linear_pitch, tiled, pitch, tiling, swizzle,
+		x, y, w, h);
+	for (j = 0; j < h; j++) {
+		for (i = 0; i < linear_pitch; i++) {
+			uint8_t got = linear[j * linear_pitch + i];
+
+			if (i < w) {
+				CHECK_EQ(got, tiled[ref_offset(tiling, swizzle,
+					pitch, x + i, y + j)]);
+			} else {
+				CHECK_EQ(got, TEST_GUARD);
+			}
+			if (emgd_test_failures != failures)
+				goto out;
+		}
+	}
+	for (i = 0; i < misalign; i++)
+		CHECK_EQ(linear_buf[i], TEST_GUARD);
+
+	/* Tile: the reference writes the same bytes, nothing else changes */
+	fill_random(linear_buf, linear_size);
+	memcpy(expect, tiled, tiled_size);
+	for (j = 0; j < h; j++)
+		for (i = 0; i < w; i++)
+			expect[ref_offset(tiling, swizzle, pitch, x + i, y + j)] =
+				linear[j * linear_pitch + i];
+	emgd_tile_rect(tiled, pitch, tiling, swizzle, linear, linear_pitch,
+		x, y, w, h);
+	CHECK(memcmp(tiled, expect, tiled_size) == 0);
+
+out:
+	if (emgd_test_failures != failures)
+		fprintf(stderr, "seed %u: %s tiling, swizzle %u, pitch %d, "
+			"%dx%d at (%d, %d), linear pitch %d + %d\n", seed,
+			tiling == I915_TILING_X ? "X" : "Y", swizzle, pitch,
+			w, h, x, y, linear_pitch, misalign);
+
+	free(tiled);
+	free(expect);
+	free(linear_buf);
+	return emgd_test_failures == failures;
+}
+
+static void test_supported(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(swizzles); i++) {
+		CHECK(emgd_tiling_supported(I915_TILING_X, swizzles[i]));
+		CHECK(emgd_tiling_supported(I915_TILING_Y, swizzles[i]));
+		CHECK(!emgd_tiling_supported(I915_TILING_NONE, swizzles[i]));
+	}
+
+	/* These depend on the physical address */
+	CHECK(!emgd_tiling_supported(I915_TILING_X, I915_BIT_6_SWIZZLE_9_17));
+	CHECK(!emgd_tiling_supported(I915_TILING_X,
+		I915_BIT_6_SWIZZLE_9_10_17));
+	CHECK(!emgd_tiling_supported(I915_TILING_X,
+		I915_BIT_6_SWIZZLE_UNKNOWN));
+}
+
+int main(int argc, char **argv)
+{
+	const char *env = getenv("EMGD_TEST_SEED");
+	unsigned int seed = env ? strtoul(env, NULL, 0) : 1;
+	int i;
+
+	test_supported();
+
+	srand(seed);
+	for (i = 0; i < TEST_ROUNDS; i++) {
+		if (!test_round(seed))
+			break;
+	}
+
+	return emgd_test_done("tiling");
+}
@@ -0,0 +1,197 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: xserver_stubs.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  The few X server entry points and globals the tested driver paths use.
+ *
+ *  The driver module is normally linked with its server symbols left
+ *  unresolved and the tests are linked the same way, so only what the
+ *  exercised code actually reaches needs to exist here.  Log output is
+ *  dropped unless EMGD_TEST_VERBOSE is set; time comes from the mock_drm
+ *  timeline so that timers (hang recovery, cache expiry) can be driven
+ *  deterministically with emgd_test_run_timers().
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <xf86.h>
+#include <os.h>
+#include <dixstruct.h>
+#include <privates.h>
+
+#include "emgd.h"
+#include "emgd_test.h"
+#include "mock_drm.h"
+
+ScreenInfo screenInfo;
+ScrnInfoPtr *xf86Screens;
+ClientPtr serverClient;
+
+static igd_drv_debug_t test_debug;
+igd_drv_debug_t *igd_debug = &test_debug;
+#ifdef CONFIG_DEBUG
+static pthread_mutex_t test_log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long test_dropped_messages;
+pthread_mutex_t *debug_log_mutex = &test_log_mutex;
+unsigned long *dropped_debug_messages = &test_dropped_messages;
+#endif
+
+static void test_vlog(const char *format, va_list args)
+{
+	if (getenv("EMGD_TEST_VERBOSE"))
+		vfprintf(stderr, format, args);
+}
+
+void xf86DrvMsg(int scrnIndex, MessageType type, const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	test_vlog(format, args);
+	va_end(args);
+}
+
+void xf86Msg(MessageType type, const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	test_vlog(format, args);
+	va_end(args);
+}
+
+void ErrorF(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	test_vlog(format, args);
+	va_end(args);
+}
+
+void FatalError(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+	abort();
+}
+
+CARD32 GetTimeInMillis(void)
+{
+	return (CARD32)(mock_drm.now / 1000000);
+}
+
+Bool dixRegisterPrivateKey(DevPrivateKey key, DevPrivateType type,
+	unsigned size)
+{
+	/* Test pixmaps and clients carry exactly one private slot */
+	key->offset = 0;
+	key->size = size;
+	key->initialized = TRUE;
+	key->type = type;
+	return TRUE;
+}
+
+
+/*
+ * Timers
+ */
+
+struct _OsTimerRec {
+	struct _OsTimerRec *next;
+	CARD32 expires;
+	Bool armed;
+	OsTimerCallback callback;
+	pointer arg;
+};
+
+static OsTimerPtr test_timers;
+
+OsTimerPtr TimerSet(OsTimerPtr timer, int flags, CARD32 millis,
+	OsTimerCallback func, pointer arg)
+{
+	if (timer == NULL) {
+		timer = calloc(1, sizeof(*timer));
+		if (timer == NULL)
+			return NULL;
+		timer->next = test_timers;
+		test_timers = timer;
+	}
+
+	timer->armed = millis != 0;
+	timer->callback = func;
+	timer->arg = arg;
+	timer->expires = (flags & TimerAbsolute) ? millis :
+		GetTimeInMillis() + millis;
+	return timer;
+}
+
+void TimerCancel(OsTimerPtr timer)
+{
+	if (timer)
+		timer->armed = FALSE;
+}
+
+void TimerFree(OsTimerPtr timer)
+{
+	OsTimerPtr *p;
+
+	if (timer == NULL)
+		return;
+
+	for (p = &test_timers; *p; p = &(*p)->next) {
+		if (*p == timer) {
+			*p = timer->next;
+			break;
+		}
+	}
+	free(timer);
+}
+
+void emgd_test_run_timers(void)
+{
+	OsTimerPtr timer;
+	CARD32 now = GetTimeInMillis();
+
+	for (timer = test_timers; timer; timer = timer->next) {
+		CARD32 next;
+
+		if (!timer->armed || (int)(timer->expires - now) > 0)
+			continue;
+
+		timer->armed = FALSE;
+		next = timer->callback(timer, now, timer->arg);
+		if (next) {
+			timer->armed = TRUE;
+			timer->expires = now + next;
+		}
+	}
+}
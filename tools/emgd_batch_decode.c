@@ -0,0 +1,546 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_batch_decode.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Offline decoder for batchbuffer capture files (see src/emgd_capture.h).
+ *
+ *  Understands the MI, 2D BLT and gen4-gen7 3D commands that this driver
+ *  emits and reports, per batch and in total:
+ *    - state packets vs. primitives (3DPRIMITIVE and BLT operations),
+ *    - redundant state: a state packet identical to the previous packet
+ *      of the same type in the same batch,
+ *    - batch bytes per draw.
+ *
+ *  With -v it also lists the relocations written into state bos, such as
+ *  surface state, and the buffers snapshotted with each batch.
+ *
+ *  Build:
+ *    make -f Makefile.gnu tools     (in src/)
+ *
+ *  Usage:
+ *    emgd_batch_decode [-v] <capture file>
+ *      -v  also list every command with its relocations, the state
+ *          relocations and the snapshotted buffers
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EMGD_CAPTURE_DECODER
+#include "emgd_capture.h"
+#include "i830_reg.h"
+#include "i965_reg.h"
+
+#define CMD_TYPE(dw)        ((dw) >> 29)
+#define CMD_TYPE_MI         0
+#define CMD_TYPE_2D         2
+#define CMD_TYPE_3D         3
+#define CMD_3D_OPCODE(dw)   ((dw) & 0xffff0000)
+#define CMD_MI_OPCODE(dw)   (((dw) >> 23) & 0x3f)
+#define CMD_2D_OPCODE(dw)   ((dw) & 0xffc00000)
+
+/* Largest state packet tracked for redundancy detection */
+#define MAX_STATE_DWORDS    64
+#define MAX_STATE_SLOTS     128
+
+typedef enum {
+	CLASS_STATE,
+	CLASS_DRAW,
+	CLASS_FLUSH,
+	CLASS_OTHER,
+} cmd_class_t;
+
+typedef struct {
+	uint32_t opcode;
+	int min_gen, max_gen;
+	cmd_class_t cls;
+	const char *name;
+} cmd_info_t;
+
+static const cmd_info_t cmds_3d[] = {
+	{BRW_URB_FENCE, 40, 59, CLASS_STATE, "URB_FENCE"},
+	{BRW_CS_URB_STATE, 40, 59, CLASS_STATE, "CS_URB_STATE"},
+	{BRW_CONSTANT_BUFFER, 40, 59, CLASS_STATE, "CONSTANT_BUFFER"},
+	{BRW_STATE_BASE_ADDRESS, 40, 79, CLASS_STATE, "STATE_BASE_ADDRESS"},
+	{BRW_STATE_SIP, 40, 79, CLASS_STATE, "STATE_SIP"},
+	{BRW_PIPELINE_SELECT, 40, 44, CLASS_STATE, "PIPELINE_SELECT"},
+	{NEW_PIPELINE_SELECT, 45, 79, CLASS_STATE, "PIPELINE_SELECT"},
+	{BRW_3DSTATE_PIPELINED_POINTERS, 40, 59, CLASS_STATE, "3DSTATE_PIPELINED_POINTERS"},
+	{BRW_3DSTATE_BINDING_TABLE_POINTERS, 40, 69, CLASS_STATE, "3DSTATE_BINDING_TABLE_POINTERS"},
+	{BRW_3DSTATE_VERTEX_BUFFERS, 40, 79, CLASS_STATE, "3DSTATE_VERTEX_BUFFERS"},
+	{BRW_3DSTATE_VERTEX_ELEMENTS, 40, 79, CLASS_STATE, "3DSTATE_VERTEX_ELEMENTS"},
+	{BRW_3DSTATE_INDEX_BUFFER, 40, 79, CLASS_STATE, "3DSTATE_INDEX_BUFFER"},
+	{BRW_3DSTATE_VF_STATISTICS, 40, 79, CLASS_STATE, "3DSTATE_VF_STATISTICS"},
+	{BRW_3DSTATE_DRAWING_RECTANGLE, 40, 79, CLASS_STATE, "3DSTATE_DRAWING_RECTANGLE"},
+	{BRW_3DSTATE_CONSTANT_COLOR, 40, 59, CLASS_STATE, "3DSTATE_CONSTANT_COLOR"},
+	{BRW_3DSTATE_SAMPLER_PALETTE_LOAD, 40, 79, CLASS_STATE, "3DSTATE_SAMPLER_PALETTE_LOAD"},
+	{BRW_3DSTATE_CHROMA_KEY, 40, 79, CLASS_STATE, "3DSTATE_CHROMA_KEY"},
+	{BRW_3DSTATE_DEPTH_BUFFER, 40, 69, CLASS_STATE, "3DSTATE_DEPTH_BUFFER"},
+	{BRW_3DSTATE_POLY_STIPPLE_OFFSET, 40, 79, CLASS_STATE, "3DSTATE_POLY_STIPPLE_OFFSET"},
+	{BRW_3DSTATE_POLY_STIPPLE_PATTERN, 40, 79, CLASS_STATE, "3DSTATE_POLY_STIPPLE_PATTERN"},
+	{BRW_3DSTATE_LINE_STIPPLE, 40, 79, CLASS_STATE, "3DSTATE_LINE_STIPPLE"},
+	{BRW_3DSTATE_GLOBAL_DEPTH_OFFSET_CLAMP, 40, 59, CLASS_STATE, "3DSTATE_GLOBAL_DEPTH_OFFSET_CLAMP"},
+	{BRW_3DSTATE_AA_LINE_PARAMS, 40, 79, CLASS_STATE, "3DSTATE_AA_LINE_PARAMS"},
+	{BRW_3DSTATE_GS_SVB_INDEX, 40, 79, CLASS_STATE, "3DSTATE_GS_SVB_INDEX"},
+	{BRW_3DSTATE_CLEAR_PARAMS, 50, 69, CLASS_STATE, "3DSTATE_CLEAR_PARAMS"},
+	{BRW_PIPE_CONTROL, 40, 79, CLASS_FLUSH, "PIPE_CONTROL"},
+	{BRW_3DPRIMITIVE, 40, 79, CLASS_DRAW, "3DPRIMITIVE"},
+	{GEN6_3DSTATE_SAMPLER_STATE_POINTERS, 60, 69, CLASS_STATE, "3DSTATE_SAMPLER_STATE_POINTERS"},
+	{GEN6_3DSTATE_URB, 60, 69, CLASS_STATE, "3DSTATE_URB"},
+	{GEN6_3DSTATE_VIEWPORT_STATE_POINTERS, 60, 69, CLASS_STATE, "3DSTATE_VIEWPORT_STATE_POINTERS"},
+	{GEN6_3DSTATE_CC_STATE_POINTERS, 60, 79, CLASS_STATE, "3DSTATE_CC_STATE_POINTERS"},
+	{GEN6_3DSTATE_VS, 60, 79, CLASS_STATE, "3DSTATE_VS"},
+	{GEN6_3DSTATE_GS, 60, 79, CLASS_STATE, "3DSTATE_GS"},
+	{GEN6_3DSTATE_CLIP, 60, 79, CLASS_STATE, "3DSTATE_CLIP"},
+	{GEN6_3DSTATE_SF, 60, 79, CLASS_STATE, "3DSTATE_SF"},
+	{GEN6_3DSTATE_WM, 60, 79, CLASS_STATE, "3DSTATE_WM"},
+	{GEN6_3DSTATE_CONSTANT_VS, 60, 79, CLASS_STATE, "3DSTATE_CONSTANT_VS"},
+	{GEN6_3DSTATE_CONSTANT_GS, 60, 79, CLASS_STATE, "3DSTATE_CONSTANT_GS"},
+	{GEN6_3DSTATE_CONSTANT_PS, 60, 79, CLASS_STATE, "3DSTATE_CONSTANT_PS"},
+	{GEN6_3DSTATE_SAMPLE_MASK, 60, 79, CLASS_STATE, "3DSTATE_SAMPLE_MASK"},
+	{GEN6_3DSTATE_MULTISAMPLE, 60, 79, CLASS_STATE, "3DSTATE_MULTISAMPLE"},
+	{GEN7_3DSTATE_CLEAR_PARAMS, 70, 79, CLASS_STATE, "3DSTATE_CLEAR_PARAMS"},
+	{GEN7_3DSTATE_DEPTH_BUFFER, 70, 79, CLASS_STATE, "3DSTATE_DEPTH_BUFFER"},
+	{GEN7_3DSTATE_CONSTANT_HS, 70, 79, CLASS_STATE, "3DSTATE_CONSTANT_HS"},
+	{GEN7_3DSTATE_CONSTANT_DS, 70, 79, CLASS_STATE, "3DSTATE_CONSTANT_DS"},
+	{GEN7_3DSTATE_HS, 70, 79, CLASS_STATE, "3DSTATE_HS"},
+	{GEN7_3DSTATE_TE, 70, 79, CLASS_STATE, "3DSTATE_TE"},
+	{GEN7_3DSTATE_DS, 70, 79, CLASS_STATE, "3DSTATE_DS"},
+	{GEN7_3DSTATE_STREAMOUT, 70, 79, CLASS_STATE, "3DSTATE_STREAMOUT"},
+	{GEN7_3DSTATE_SBE, 70, 79, CLASS_STATE, "3DSTATE_SBE"},
+	{GEN7_3DSTATE_PS, 70, 79, CLASS_STATE, "3DSTATE_PS"},
+	{GEN7_3DSTATE_VIEWPORT_STATE_POINTERS_SF_CL, 70, 79, CLASS_STATE, "3DSTATE_VIEWPORT_STATE_POINTERS_SF_CL"},
+	{GEN7_3DSTATE_VIEWPORT_STATE_POINTERS_CC, 70, 79, CLASS_STATE, "3DSTATE_VIEWPORT_STATE_POINTERS_CC"},
+	{GEN7_3DSTATE_BLEND_STATE_POINTERS, 70, 79, CLASS_STATE, "3DSTATE_BLEND_STATE_POINTERS"},
+	{GEN7_3DSTATE_DEPTH_STENCIL_STATE_POINTERS, 70, 79, CLASS_STATE, "3DSTATE_DEPTH_STENCIL_STATE_POINTERS"},
+	{GEN7_3DSTATE_BINDING_TABLE_POINTERS_VS, 70, 79, CLASS_STATE, "3DSTATE_BINDING_TABLE_POINTERS_VS"},
+	{GEN7_3DSTATE_BINDING_TABLE_POINTERS_HS, 70, 79, CLASS_STATE, "3DSTATE_BINDING_TABLE_POINTERS_HS"},
+	{GEN7_3DSTATE_BINDING_TABLE_POINTERS_DS, 70, 79, CLASS_STATE, "3DSTATE_BINDING_TABLE_POINTERS_DS"},
+	{GEN7_3DSTATE_BINDING_TABLE_POINTERS_GS, 70, 79, CLASS_STATE, "3DSTATE_BINDING_TABLE_POINTERS_GS"},
+	{GEN7_3DSTATE_BINDING_TABLE_POINTERS_PS, 70, 79, CLASS_STATE, "3DSTATE_BINDING_TABLE_POINTERS_PS"},
+	{GEN7_3DSTATE_SAMPLER_STATE_POINTERS_VS, 70, 79, CLASS_STATE, "3DSTATE_SAMPLER_STATE_POINTERS_VS"},
+	{GEN7_3DSTATE_SAMPLER_STATE_POINTERS_GS, 70, 79, CLASS_STATE, "3DSTATE_SAMPLER_STATE_POINTERS_GS"},
+	{GEN7_3DSTATE_SAMPLER_STATE_POINTERS_PS, 70, 79, CLASS_STATE, "3DSTATE_SAMPLER_STATE_POINTERS_PS"},
+	{GEN7_3DSTATE_URB_VS, 70, 79, CLASS_STATE, "3DSTATE_URB_VS"},
+	{GEN7_3DSTATE_URB_HS, 70, 79, CLASS_STATE, "3DSTATE_URB_HS"},
+	{GEN7_3DSTATE_URB_DS, 70, 79, CLASS_STATE, "3DSTATE_URB_DS"},
+	{GEN7_3DSTATE_URB_GS, 70, 79, CLASS_STATE, "3DSTATE_URB_GS"},
+	{GEN7_3DSTATE_PUSH_CONSTANT_ALLOC_VS, 70, 79, CLASS_STATE, "3DSTATE_PUSH_CONSTANT_ALLOC_VS"},
+	{GEN7_3DSTATE_PUSH_CONSTANT_ALLOC_PS, 70, 79, CLASS_STATE, "3DSTATE_PUSH_CONSTANT_ALLOC_PS"},
+};
+
+static const cmd_info_t cmds_2d[] = {
+	{XY_SETUP_CLIP_BLT_CMD & 0xffc00000, 0, 99, CLASS_STATE, "XY_SETUP_CLIP_BLT"},
+	{COLOR_BLT_CMD & 0xffc00000, 0, 99, CLASS_DRAW, "COLOR_BLT"},
+	{SRC_COPY_BLT_CMD & 0xffc00000, 0, 99, CLASS_DRAW, "SRC_COPY_BLT"},
+	{XY_COLOR_BLT_CMD & 0xffc00000, 0, 99, CLASS_DRAW, "XY_COLOR_BLT"},
+	{XY_SRC_COPY_BLT_CMD & 0xffc00000, 0, 99, CLASS_DRAW, "XY_SRC_COPY_BLT"},
+	{XY_MONO_PAT_BLT_CMD & 0xffc00000, 0, 99, CLASS_DRAW, "XY_MONO_PAT_BLT"},
+	{XY_PAT_BLT_IMMEDIATE & 0xffc00000, 0, 99, CLASS_DRAW, "XY_PAT_BLT_IMMEDIATE"},
+};
+
+typedef struct {
+	unsigned long batches;
+	unsigned long bytes;
+	unsigned long state_packets;
+	unsigned long state_bytes;
+	unsigned long redundant_packets;
+	unsigned long redundant_bytes;
+	unsigned long draws;
+	unsigned long flushes;
+	unsigned long relocs;
+	unsigned long state_relocs;
+	unsigned long bos;
+} stats_t;
+
+typedef struct {
+	uint32_t opcode;
+	uint32_t len;
+	uint32_t dw[MAX_STATE_DWORDS];
+} last_state_t;
+
+static int verbose;
+
+
+static const cmd_info_t *lookup(const cmd_info_t *table, int n,
+	uint32_t opcode, int gen)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (table[i].opcode == opcode &&
+			gen >= table[i].min_gen && gen <= table[i].max_gen) {
+			return &table[i];
+		}
+	}
+	return NULL;
+}
+
+
+/*
+ * Decode one command header.  Returns the command length in dwords and
+ * fills in its class and a printable name.
+ */
+static uint32_t decode_cmd(uint32_t dw, int gen, cmd_class_t *cls,
+	const char **name)
+{
+	static char unknown[32];
+	const cmd_info_t *info;
+
+	switch (CMD_TYPE(dw)) {
+	case CMD_TYPE_MI:
+		*cls = CLASS_OTHER;
+		switch (CMD_MI_OPCODE(dw)) {
+		case 0x00: *name = "MI_NOOP"; return 1;
+		case 0x04: *name = "MI_FLUSH"; *cls = CLASS_FLUSH; return 1;
+		case 0x0a: *name = "MI_BATCH_BUFFER_END"; return 1;
+		case 0x03: *name = "MI_WAIT_FOR_EVENT"; return 1;
+		case 0x26: *name = "MI_FLUSH_DW"; *cls = CLASS_FLUSH; break;
+		case 0x12: *name = "MI_LOAD_SCAN_LINES_INCL"; break;
+		case 0x20: *name = "MI_STORE_DATA_IMM"; break;
+		case 0x22: *name = "MI_LOAD_REGISTER_IMM"; break;
+		default:
+			if (CMD_MI_OPCODE(dw) < 0x10) {
+				*name = "MI (1 dword)";
+				return 1;
+			}
+			snprintf(unknown, sizeof(unknown), "MI 0x%02x",
+				CMD_MI_OPCODE(dw));
+			*name = unknown;
+			break;
+		}
+		return (dw & 0x3f) + 2;
+
+	case CMD_TYPE_2D:
+		info = lookup(cmds_2d, sizeof(cmds_2d) / sizeof(cmds_2d[0]),
+			CMD_2D_OPCODE(dw), gen);
+		*cls = info ? info->cls : CLASS_DRAW;
+		if (info) {
+			*name = info->name;
+		} else {
+			snprintf(unknown, sizeof(unknown), "BLT 0x%02x",
+				(dw >> 22) & 0x7f);
+			*name = unknown;
+		}
+		return (dw & 0xff) + 2;
+
+	case CMD_TYPE_3D:
+		info = lookup(cmds_3d, sizeof(cmds_3d) / sizeof(cmds_3d[0]),
+			CMD_3D_OPCODE(dw), gen);
+		*cls = info ? info->cls : CLASS_STATE;
+		if (info) {
+			*name = info->name;
+		} else {
+			snprintf(unknown, sizeof(unknown), "3D 0x%04x",
+				CMD_3D_OPCODE(dw) >> 16);
+			*name = unknown;
+		}
+		/* Single dword 3D commands */
+		if (CMD_3D_OPCODE(dw) == BRW_PIPELINE_SELECT ||
+			CMD_3D_OPCODE(dw) == NEW_PIPELINE_SELECT ||
+			CMD_3D_OPCODE(dw) == BRW_3DSTATE_VF_STATISTICS ||
+			CMD_3D_OPCODE(dw) == (BRW_3DSTATE_VF_STATISTICS & ~(1 << 28))) {
+			return 1;
+		}
+		return (dw & 0xff) + 2;
+
+	default:
+		*cls = CLASS_OTHER;
+		*name = "INVALID";
+		return 1;
+	}
+}
+
+
+/*
+ * Compare a state packet with the last one of the same type in this batch.
+ * Returns 1 if it is an exact repeat.
+ */
+static int check_redundant(last_state_t *slots, int *num_slots,
+	const uint32_t *cmd, uint32_t len)
+{
+	uint32_t opcode = cmd[0] & 0xffff0000;
+	int i;
+
+	if (len > MAX_STATE_DWORDS) {
+		return 0;
+	}
+
+	for (i = 0; i < *num_slots; i++) {
+		if (slots[i].opcode == opcode) {
+			break;
+		}
+	}
+
+	if (i < *num_slots) {
+		if (slots[i].len == len &&
+			memcmp(slots[i].dw, cmd, len * 4) == 0) {
+			return 1;
+		}
+	} else if (*num_slots < MAX_STATE_SLOTS) {
+		(*num_slots)++;
+	} else {
+		return 0;
+	}
+
+	slots[i].opcode = opcode;
+	slots[i].len = len;
+	memcpy(slots[i].dw, cmd, len * 4);
+	return 0;
+}
+
+
+static void print_reloc(const emgd_capture_reloc_t *reloc)
+{
+	printf("  -> handle %u + 0x%x (r 0x%x w 0x%x)",
+		reloc->handle, reloc->delta,
+		reloc->read_domains, reloc->write_domain);
+	if (reloc->bo_index != EMGD_CAPTURE_NO_BO) {
+		printf(" [bo %u]", reloc->bo_index);
+	}
+}
+
+
+static void decode_batch(const emgd_capture_batch_hdr_t *hdr,
+	const uint32_t *batch, const emgd_capture_reloc_t *relocs,
+	int gen, stats_t *total)
+{
+	static last_state_t slots[MAX_STATE_SLOTS];
+	stats_t s;
+	uint32_t dwords = hdr->batch_bytes / 4;
+	uint32_t i = 0, r;
+	int num_slots = 0;
+
+	memset(&s, 0, sizeof(s));
+	s.batches = 1;
+	s.bytes = hdr->batch_bytes;
+	s.bos = hdr->num_bos;
+	for (r = 0; r < hdr->num_relocs; r++) {
+		if (relocs[r].in_handle) {
+			s.state_relocs++;
+		} else {
+			s.relocs++;
+		}
+	}
+
+	if (verbose) {
+		printf("batch %u: %s ring, %u bytes, %u relocs, %u bos\n",
+			hdr->seq, hdr->ring == 3 ? "BLT" : "RENDER",
+			hdr->batch_bytes, hdr->num_relocs, hdr->num_bos);
+	}
+
+	while (i < dwords) {
+		cmd_class_t cls;
+		const char *name;
+		uint32_t len = decode_cmd(batch[i], gen, &cls, &name);
+		int redundant = 0;
+
+		if (i + len > dwords) {
+			len = dwords - i;
+		}
+
+		switch (cls) {
+		case CLASS_STATE:
+			s.state_packets++;
+			s.state_bytes += len * 4;
+			redundant = check_redundant(slots, &num_slots, &batch[i], len);
+			if (redundant) {
+				s.redundant_packets++;
+				s.redundant_bytes += len * 4;
+			}
+			break;
+		case CLASS_DRAW:
+			s.draws++;
+			break;
+		case CLASS_FLUSH:
+			s.flushes++;
+			break;
+		default:
+			break;
+		}
+
+		if (verbose) {
+			uint32_t j;
+
+			printf("  0x%05x: %-40s %3u dw%s\n", i * 4, name, len,
+				redundant ? "  [redundant]" : "");
+			for (j = 0; j < len; j++) {
+				/* Not necessarily in offset order: surface state base
+				 * addresses are relocated when the surfaces are flushed */
+				for (r = 0; r < hdr->num_relocs; r++) {
+					if (!relocs[r].in_handle &&
+						relocs[r].offset == (i + j) * 4) {
+						break;
+					}
+				}
+				printf("           %08x", batch[i + j]);
+				if (r < hdr->num_relocs) {
+					print_reloc(&relocs[r]);
+				}
+				printf("\n");
+			}
+		}
+
+		i += len;
+	}
+
+	if (verbose) {
+		for (r = 0; r < hdr->num_relocs; r++) {
+			if (relocs[r].in_handle) {
+				printf("  state handle %u + 0x%05x", relocs[r].in_handle,
+					relocs[r].offset);
+				print_reloc(&relocs[r]);
+				printf("\n");
+			}
+		}
+	}
+
+	if (verbose || s.redundant_packets) {
+		printf("batch %u: %lu state (%lu B), %lu draws, %lu flushes, "
+			"%lu redundant (%lu B), %.1f B/draw\n",
+			hdr->seq, s.state_packets, s.state_bytes, s.draws, s.flushes,
+			s.redundant_packets, s.redundant_bytes,
+			s.draws ? (double)s.bytes / s.draws : 0.0);
+	}
+
+	total->batches += s.batches;
+	total->bytes += s.bytes;
+	total->state_packets += s.state_packets;
+	total->state_bytes += s.state_bytes;
+	total->redundant_packets += s.redundant_packets;
+	total->redundant_bytes += s.redundant_bytes;
+	total->draws += s.draws;
+	total->flushes += s.flushes;
+	total->relocs += s.relocs;
+	total->state_relocs += s.state_relocs;
+	total->bos += s.bos;
+}
+
+
+/* Skip the snapshots, listing them with -v */
+static int read_bos(FILE *f, uint32_t num_bos)
+{
+	emgd_capture_bo_t bo;
+	uint32_t i;
+
+	for (i = 0; i < num_bos; i++) {
+		if (fread(&bo, sizeof(bo), 1, f) != 1 ||
+			fseek(f, (bo.captured + 3) & ~3, SEEK_CUR)) {
+			return -1;
+		}
+		if (verbose) {
+			printf("  bo %u: handle %u, %u of %u bytes\n",
+				i, bo.handle, bo.captured, bo.size);
+		}
+	}
+	return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+	emgd_capture_file_hdr_t fhdr;
+	emgd_capture_batch_hdr_t hdr;
+	uint32_t *batch = NULL;
+	emgd_capture_reloc_t *relocs = NULL;
+	stats_t total;
+	const char *path;
+	FILE *f;
+
+	if (argc == 3 && strcmp(argv[1], "-v") == 0) {
+		verbose = 1;
+		path = argv[2];
+	} else if (argc == 2) {
+		path = argv[1];
+	} else {
+		fprintf(stderr, "usage: %s [-v] <capture file>\n", argv[0]);
+		return 1;
+	}
+
+	f = fopen(path, "rb");
+	if (!f) {
+		perror(path);
+		return 1;
+	}
+
+	if (fread(&fhdr, sizeof(fhdr), 1, f) != 1 ||
+		memcmp(fhdr.magic, EMGD_CAPTURE_MAGIC, sizeof(EMGD_CAPTURE_MAGIC)) ||
+		fhdr.version != EMGD_CAPTURE_VERSION) {
+		fprintf(stderr, "%s: not a version %d batch capture\n",
+			path, EMGD_CAPTURE_VERSION);
+		fclose(f);
+		return 1;
+	}
+
+	printf("device 0x%04x, gen %u.%u\n", fhdr.devid,
+		fhdr.gen / 10, fhdr.gen % 10);
+
+	memset(&total, 0, sizeof(total));
+	while (fread(&hdr, sizeof(hdr), 1, f) == 1) {
+		if (hdr.tag != EMGD_CAPTURE_TAG_BATCH) {
+			fprintf(stderr, "corrupt record after batch %lu\n", total.batches);
+			break;
+		}
+
+		batch = realloc(batch, hdr.batch_bytes + 4);
+		relocs = realloc(relocs, (hdr.num_relocs + 1) * sizeof(*relocs));
+		if (!batch || !relocs ||
+			fread(batch, 1, hdr.batch_bytes, f) != hdr.batch_bytes ||
+			fread(relocs, sizeof(*relocs), hdr.num_relocs, f) !=
+				hdr.num_relocs) {
+			fprintf(stderr, "truncated record for batch %u\n", hdr.seq);
+			break;
+		}
+
+		decode_batch(&hdr, batch, relocs, fhdr.gen, &total);
+		if (read_bos(f, hdr.num_bos)) {
+			fprintf(stderr, "truncated record for batch %u\n", hdr.seq);
+			break;
+		}
+	}
+	fclose(f);
+	free(batch);
+	free(relocs);
+
+	printf("\n%lu batches, %lu bytes, %lu relocs (+%lu in state), %lu bos\n",
+		total.batches, total.bytes, total.relocs, total.state_relocs,
+		total.bos);
+	printf("state packets:     %lu (%lu bytes)\n",
+		total.state_packets, total.state_bytes);
+	printf("redundant state:   %lu (%lu bytes, %.1f%% of state)\n",
+		total.redundant_packets, total.redundant_bytes,
+		total.state_bytes ?
+			100.0 * total.redundant_bytes / total.state_bytes : 0.0);
+	printf("draws:             %lu\n", total.draws);
+	printf("flushes:           %lu\n", total.flushes);
+	printf("state/draw:        %.2f packets\n",
+		total.draws ? (double)total.state_packets / total.draws : 0.0);
+	printf("bytes/draw:        %.1f\n",
+		total.draws ? (double)total.bytes / total.draws : 0.0);
+
+	return 0;
+}
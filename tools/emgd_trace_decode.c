@@ -0,0 +1,186 @@
+/*
+ *-----------------------------------------------------------------------------
+ * Filename: emgd_trace_decode.c
+ *-----------------------------------------------------------------------------
+ * Copyright (c) 2002-2013, Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ *-----------------------------------------------------------------------------
+ * Description:
+ *  Offline decoder for the driver's binary event trace (see
+ *  src/emgd_trace.h).  Prints one line per record, oldest first, with the
+ *  time relative to the first record and to the previous record of the
+ *  same event.
+ *
+ *  Build:
+ *    make -f Makefile.gnu tools     (in src/)
+ *
+ *  Usage, with Option "TraceFile" "/var/log/emgd-trace.bin":
+ *    kill -USR2 $(pidof Xorg)
+ *    emgd_trace_decode /var/log/emgd-trace.bin
+ *-----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EMGD_TRACE_DECODER
+#include "emgd_trace.h"
+
+static const char *event_names[EMGD_TRACE_NUM_EVENTS] = {
+	"?",
+	"batch",
+	"flip-sched",
+	"flip-done",
+	"vblank",
+	"migrate",
+	"xv-frame",
+	"gpu-hang",
+	"gpu-recover",
+};
+
+static void print_args(const emgd_trace_rec_t *rec)
+{
+	const uint32_t *a = rec->arg;
+
+	switch (rec->event) {
+	case EMGD_TRACE_BATCH_SUBMIT:
+		printf("ring=%u bytes=%u exec=%uus ret=%d",
+			a[0], a[1], a[2], (int)a[3]);
+		break;
+	case EMGD_TRACE_FLIP_SCHEDULE:
+		printf("drawable=0x%x fb=%u target_msc=%u", a[0], a[1], a[2]);
+		break;
+	case EMGD_TRACE_FLIP_COMPLETE:
+		printf("drawable=0x%x msc=%u", a[0], a[1]);
+		break;
+	case EMGD_TRACE_VBLANK:
+		printf("drawable=0x%x msc=%u type=%u", a[0], a[1], a[2]);
+		break;
+	case EMGD_TRACE_PIXMAP_MIGRATE:
+		printf("handle=%u size=%u access=%u wait=%uus",
+			a[0], a[1], a[2], a[3]);
+		break;
+	case EMGD_TRACE_XV_FRAME:
+		printf("path=%s fourcc=%.4s %ux%u",
+			a[0] == EMGD_TRACE_XV_OVERLAY ? "overlay" : "blend",
+			(const char *)&a[1], a[2], a[3]);
+		break;
+	case EMGD_TRACE_GPU_HANG:
+		printf("count=%u retry=%ums", a[0], a[1]);
+		break;
+	case EMGD_TRACE_GPU_RECOVER:
+		printf("count=%u", a[0]);
+		break;
+	default:
+		printf("0x%x 0x%x 0x%x 0x%x", a[0], a[1], a[2], a[3]);
+		break;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	emgd_trace_file_hdr_t hdr;
+	emgd_trace_rec_t *ring;
+	uint64_t last[EMGD_TRACE_NUM_EVENTS];
+	uint64_t first_ts = 0;
+	uint32_t seq, start, mask;
+	unsigned long shown = 0, dropped = 0;
+	FILE *f;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <trace file>\n", argv[0]);
+		return 1;
+	}
+
+	f = fopen(argv[1], "rb");
+	if (!f) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	if (fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+		memcmp(hdr.magic, EMGD_TRACE_MAGIC, sizeof(EMGD_TRACE_MAGIC)) != 0) {
+		fprintf(stderr, "%s: not an EMGD trace file\n", argv[1]);
+		fclose(f);
+		return 1;
+	}
+	if (hdr.version != EMGD_TRACE_VERSION ||
+		hdr.rec_size != sizeof(emgd_trace_rec_t) ||
+		hdr.num_recs == 0 || (hdr.num_recs & (hdr.num_recs - 1))) {
+		fprintf(stderr, "%s: unsupported trace version %u (record size %u)\n",
+			argv[1], hdr.version, hdr.rec_size);
+		fclose(f);
+		return 1;
+	}
+
+	ring = calloc(hdr.num_recs, sizeof(emgd_trace_rec_t));
+	if (!ring) {
+		fclose(f);
+		return 1;
+	}
+	if (fread(ring, sizeof(emgd_trace_rec_t), hdr.num_recs, f) !=
+		hdr.num_recs) {
+		fprintf(stderr, "%s: truncated trace file\n", argv[1]);
+		free(ring);
+		fclose(f);
+		return 1;
+	}
+	fclose(f);
+
+	memset(last, 0, sizeof(last));
+	mask = hdr.num_recs - 1;
+	start = (hdr.head > hdr.num_recs) ? hdr.head - hdr.num_recs : 0;
+
+	printf("%14s %10s  %-10s  %s\n", "time(ms)", "delta(us)", "event", "args");
+	for (seq = start; seq != hdr.head; seq++) {
+		const emgd_trace_rec_t *rec = &ring[seq & mask];
+
+		/* Skip slots that were torn or overwritten during the dump */
+		if (rec->event == 0 || rec->event >= EMGD_TRACE_NUM_EVENTS ||
+			rec->seq != seq) {
+			dropped++;
+			continue;
+		}
+
+		if (!first_ts) {
+			first_ts = rec->ts;
+		}
+
+		printf("%14.3f ", (double)(rec->ts - first_ts) / 1000000.0);
+		if (last[rec->event]) {
+			printf("%10.1f  ", (double)(rec->ts - last[rec->event]) / 1000.0);
+		} else {
+			printf("%10s  ", "-");
+		}
+		printf("%-10s  ", event_names[rec->event]);
+		print_args(rec);
+		printf("\n");
+
+		last[rec->event] = rec->ts;
+		shown++;
+	}
+
+	printf("%lu records, %lu dropped\n", shown, dropped);
+
+	free(ring);
+	return 0;
+}
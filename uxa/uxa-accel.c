@@ -31,12 +31,289 @@
 #ifdef HAVE_DIX_CONFIG_H
 #include <dix-config.h>
 #endif
+#include <stdlib.h>
 #include "uxa-priv.h"
 #include <X11/fonts/fontstruct.h>
 #include "dixfontstr.h"
 #include "uxa.h"
 #include "mipict.h"
 
+/*
+ * Copy pTile repeatedly into the box x1,y1-x2,y2 of pPixmap, with the
+ * tile origin at org_x,org_y.  Both are in pixmap coordinates and a copy
+ * from pTile to pPixmap must have been prepared.  Based on fbTile().
+ */
+static void
+uxa_tile_box(uxa_screen_t *uxa_screen, PixmapPtr pPixmap, PixmapPtr pTile,
+	     int x1, int y1, int x2, int y2, int org_x, int org_y)
+{
+	int tileWidth = pTile->drawable.width;
+	int tileHeight = pTile->drawable.height;
+	int height = y2 - y1;
+	int dstY = y1;
+	int tileY;
+
+	modulus(dstY - org_y, tileHeight, tileY);
+
+	while (height > 0) {
+		int width = x2 - x1;
+		int dstX = x1;
+		int tileX;
+		int h = tileHeight - tileY;
+
+		if (h > height)
+			h = height;
+		height -= h;
+
+		modulus(dstX - org_x, tileWidth, tileX);
+
+		while (width > 0) {
+			int w = tileWidth - tileX;
+			if (w > width)
+				w = width;
+			width -= w;
+
+			(*uxa_screen->info->copy) (pPixmap,
+						   tileX, tileY,
+						   dstX, dstY,
+						   w, h);
+			dstX += w;
+			tileX = 0;
+		}
+		dstY += h;
+		tileY = 0;
+	}
+}
+
+/*
+ * Stippling through the driver's mono expansion.  Stipples that repeat
+ * within 8x8 pixels are replicated into an 8x8 pattern and each box is
+ * a single mono_pattern().  Larger stipples are expanded one repeat at a
+ * time with mono(), which only pays off once a repeat covers a fair
+ * number of pixels, so narrow or short odd-sized stipples fall back.
+ */
+#define UXA_STIPPLE_MIN	8
+
+/* Bits of a depth 1 pixmap held in system memory, or NULL */
+static const CARD8 *
+uxa_mono_bits(PixmapPtr pBitmap)
+{
+	if (pBitmap->drawable.depth != 1 || uxa_pixmap_is_offscreen(pBitmap))
+		return NULL;
+
+	return pBitmap->devPrivate.ptr;
+}
+
+/*
+ * Prepare the driver to fill with pGC's stipple into pPixmap, with the
+ * stipple origin at org_x,org_y in pixmap coordinates.  *pattern tells
+ * uxa_stipple_box() which way the stipple was set up.
+ */
+static Bool
+uxa_prepare_stipple(uxa_screen_t *uxa_screen, DrawablePtr pDrawable,
+		    PixmapPtr pPixmap, GCPtr pGC, int org_x, int org_y,
+		    Bool *pattern)
+{
+	PixmapPtr pStipple = pGC->stipple;
+	int w = pStipple->drawable.width;
+	int h = pStipple->drawable.height;
+	const CARD8 *bits = uxa_mono_bits(pStipple);
+	CARD8 pat[8];
+	int x, y;
+
+	if (!uxa_screen->info->prepare_mono || !bits)
+		return FALSE;
+
+	if (uxa_screen->info->check_mono &&
+	    !uxa_screen->info->check_mono(pDrawable, pGC->alu, pGC->planemask))
+		return FALSE;
+
+	*pattern = (8 % w) == 0 && (8 % h) == 0;
+	if (*pattern) {
+		for (y = 0; y < 8; y++) {
+			CARD8 row = bits[(y % h) * pStipple->devKind] &
+				    ((1 << w) - 1);
+
+			pat[y] = 0;
+			for (x = 0; x < 8; x += w)
+				pat[y] |= row << x;
+		}
+	} else if (w < UXA_STIPPLE_MIN || h < UXA_STIPPLE_MIN) {
+		return FALSE;
+	}
+
+	return (*uxa_screen->info->prepare_mono) (pPixmap, pGC->alu,
+						  pGC->planemask,
+						  pGC->fgPixel, pGC->bgPixel,
+						  pGC->fillStyle ==
+						  FillOpaqueStippled,
+						  *pattern ? pat : NULL,
+						  org_x, org_y);
+}
+
+/*
+ * Stipple the box x1,y1-x2,y2 of pPixmap after uxa_prepare_stipple().
+ * Mirrors uxa_tile_box().
+ */
+static void
+uxa_stipple_box(uxa_screen_t *uxa_screen, PixmapPtr pPixmap,
+		PixmapPtr pStipple, Bool pattern,
+		int x1, int y1, int x2, int y2, int org_x, int org_y)
+{
+	const CARD8 *bits = pStipple->devPrivate.ptr;
+	int stride = pStipple->devKind;
+	int stippleWidth = pStipple->drawable.width;
+	int stippleHeight = pStipple->drawable.height;
+	int height = y2 - y1;
+	int dstY = y1;
+	int stippleY;
+
+	if (pattern) {
+		(*uxa_screen->info->mono_pattern) (pPixmap, x1, y1, x2, y2);
+		return;
+	}
+
+	modulus(dstY - org_y, stippleHeight, stippleY);
+
+	while (height > 0) {
+		int width = x2 - x1;
+		int dstX = x1;
+		int stippleX;
+		int h = stippleHeight - stippleY;
+
+		if (h > height)
+			h = height;
+		height -= h;
+
+		modulus(dstX - org_x, stippleWidth, stippleX);
+
+		while (width > 0) {
+			int w = stippleWidth - stippleX;
+			if (w > width)
+				w = width;
+			width -= w;
+
+			(*uxa_screen->info->mono) (pPixmap, dstX, dstY, w, h,
+						   bits + stippleY * stride,
+						   stride, stippleX);
+			dstX += w;
+			stippleX = 0;
+		}
+		dstY += h;
+		stippleY = 0;
+	}
+}
+
+/*
+ * Span filling.
+ *
+ * Each span is clipped against the band of the (y-x banded) clip region
+ * that holds its row only.  The band is found by walking forward from
+ * the previous span's band while spans come in y order, which is the
+ * usual case whether or not the caller says so, and by bisection
+ * otherwise.  Clipped pieces with the same x extents on consecutive rows
+ * are coalesced into taller rectangles before they reach the driver.
+ */
+#define UXA_SPAN_OPEN	16
+
+typedef struct _uxa_span_fill {
+	uxa_screen_t *uxa_screen;
+	PixmapPtr dst;
+	int off_x, off_y;
+	PixmapPtr tile;		/* NULL for solid fills */
+	PixmapPtr stipple;	/* NULL unless stippling */
+	Bool pattern;		/* Stipple set up as an 8x8 pattern */
+	int org_x, org_y;	/* Tile or stipple origin, pixmap coordinates */
+	BoxRec open[UXA_SPAN_OPEN];	/* Rectangles that may still grow */
+	int num_open;
+} uxa_span_fill_t;
+
+static void
+uxa_span_emit(uxa_span_fill_t *fill, const BoxRec *box)
+{
+	if (fill->stipple)
+		uxa_stipple_box(fill->uxa_screen, fill->dst, fill->stipple,
+				fill->pattern,
+				box->x1 + fill->off_x, box->y1 + fill->off_y,
+				box->x2 + fill->off_x, box->y2 + fill->off_y,
+				fill->org_x, fill->org_y);
+	else if (fill->tile)
+		uxa_tile_box(fill->uxa_screen, fill->dst, fill->tile,
+			     box->x1 + fill->off_x, box->y1 + fill->off_y,
+			     box->x2 + fill->off_x, box->y2 + fill->off_y,
+			     fill->org_x, fill->org_y);
+	else
+		(*fill->uxa_screen->info->solid) (fill->dst,
+						  box->x1 + fill->off_x,
+						  box->y1 + fill->off_y,
+						  box->x2 + fill->off_x,
+						  box->y2 + fill->off_y);
+}
+
+static void
+uxa_span_add(uxa_span_fill_t *fill, int x1, int x2, int y)
+{
+	BoxPtr box;
+	int i, j;
+
+	for (i = 0; i < fill->num_open; i++) {
+		box = &fill->open[i];
+		if (box->y2 == y && box->x1 == x1 && box->x2 == x2) {
+			box->y2++;
+			return;
+		}
+	}
+
+	/* Rectangles that ended above this row won't grow any more */
+	for (i = j = 0; i < fill->num_open; i++) {
+		if (fill->open[i].y2 < y)
+			uxa_span_emit(fill, &fill->open[i]);
+		else
+			fill->open[j++] = fill->open[i];
+	}
+	fill->num_open = j;
+
+	if (fill->num_open == UXA_SPAN_OPEN) {
+		uxa_span_emit(fill, &fill->open[0]);
+		fill->open[0] = fill->open[--fill->num_open];
+	}
+
+	box = &fill->open[fill->num_open++];
+	box->x1 = x1;
+	box->x2 = x2;
+	box->y1 = y;
+	box->y2 = y + 1;
+}
+
+static void
+uxa_span_flush(uxa_span_fill_t *fill)
+{
+	int i;
+
+	for (i = 0; i < fill->num_open; i++)
+		uxa_span_emit(fill, &fill->open[i]);
+	fill->num_open = 0;
+}
+
+/* Index of the first box in the clip band holding row y, or of the band
+ * below it if y falls between bands. */
+static int
+uxa_span_find_band(BoxPtr boxes, int nbox, int y)
+{
+	int lo = 0, hi = nbox;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (boxes[mid].y2 <= y)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
 static void
 uxa_fill_spans(DrawablePtr pDrawable, GCPtr pGC, int n,
 	       DDXPointPtr ppt, int *pwidth, int fSorted)
@@ -44,57 +321,111 @@ uxa_fill_spans(DrawablePtr pDrawable, GCPtr pGC, int n,
 	ScreenPtr screen = pDrawable->pScreen;
 	uxa_screen_t *uxa_screen = uxa_get_screen(screen);
 	RegionPtr pClip = fbGetCompositeClip(pGC);
-	PixmapPtr dst_pixmap;
-	BoxPtr pbox;
-	int nbox;
-	int x1, x2, y;
-	int off_x, off_y;
+	BoxPtr boxes = REGION_RECTS(pClip);
+	int nbox = REGION_NUM_RECTS(pClip);
+	uxa_span_fill_t fill;
+	Pixel pixel = pGC->fgPixel;
+	int band = 0, last_y;
 
 	if (uxa_screen->force_fallback)
 		goto fallback;
 
-	if (pGC->fillStyle != FillSolid)
-		goto fallback;
+	fill.uxa_screen = uxa_screen;
+	fill.tile = NULL;
+	fill.stipple = NULL;
+	fill.num_open = 0;
 
-	dst_pixmap = uxa_get_offscreen_pixmap(pDrawable, &off_x, &off_y);
-	if (!dst_pixmap)
+	fill.dst = uxa_get_offscreen_pixmap(pDrawable, &fill.off_x, &fill.off_y);
+	if (!fill.dst)
 		goto fallback;
 
-	if (uxa_screen->info->check_solid &&
-	    !uxa_screen->info->check_solid(pDrawable, pGC->alu, pGC->planemask))
-		goto fallback;
+	fill.org_x = pDrawable->x + pGC->patOrg.x + fill.off_x;
+	fill.org_y = pDrawable->y + pGC->patOrg.y + fill.off_y;
 
-	if (!(*uxa_screen->info->prepare_solid) (dst_pixmap,
-						 pGC->alu,
-						 pGC->planemask,
-						 pGC->fgPixel))
-		goto fallback;
+	if (pGC->fillStyle == FillTiled) {
+		if (pGC->tileIsPixel) {
+			pixel = pGC->tile.pixel;
+		} else if (pGC->tile.pixmap->drawable.width == 1 &&
+			   pGC->tile.pixmap->drawable.height == 1) {
+			pixel = uxa_get_pixmap_first_pixel(pGC->tile.pixmap);
+		} else {
+			fill.tile = pGC->tile.pixmap;
+		}
+	} else if (pGC->fillStyle != FillSolid) {
+		fill.stipple = pGC->stipple;
+	}
+
+	if (fill.stipple) {
+		if (!uxa_prepare_stipple(uxa_screen, pDrawable, fill.dst, pGC,
+					 fill.org_x, fill.org_y, &fill.pattern))
+			goto fallback;
+	} else if (fill.tile) {
+		if (!uxa_pixmap_is_offscreen(fill.tile))
+			goto fallback;
+
+		if (uxa_screen->info->check_copy &&
+		    !uxa_screen->info->check_copy(fill.tile, fill.dst,
+						  pGC->alu, pGC->planemask))
+			goto fallback;
+
+		if (!(*uxa_screen->info->prepare_copy) (fill.tile, fill.dst,
+							1, 1, pGC->alu,
+							pGC->planemask))
+			goto fallback;
+	} else {
+		if (uxa_screen->info->check_solid &&
+		    !uxa_screen->info->check_solid(pDrawable, pGC->alu,
+						   pGC->planemask))
+			goto fallback;
+
+		if (!(*uxa_screen->info->prepare_solid) (fill.dst,
+							 pGC->alu,
+							 pGC->planemask,
+							 pixel))
+			goto fallback;
+	}
 
+	last_y = nbox ? boxes[0].y1 : 0;
 	while (n--) {
-		x1 = ppt->x;
-		y = ppt->y;
-		x2 = x1 + (int)*pwidth;
+		int x1 = ppt->x;
+		int x2 = x1 + (int)*pwidth;
+		int y = ppt->y;
+		BoxPtr pbox;
+		int i;
+
 		ppt++;
 		pwidth++;
 
-		nbox = REGION_NUM_RECTS(pClip);
-		pbox = REGION_RECTS(pClip);
-		while (nbox--) {
-			int X1 = x1, X2 = x2;
-			if (X1 < pbox->x1)
-				X1 = pbox->x1;
+		if (y >= last_y) {
+			while (band < nbox && boxes[band].y2 <= y)
+				band++;
+		} else {
+			band = uxa_span_find_band(boxes, nbox, y);
+		}
+		last_y = y;
+
+		if (band == nbox || boxes[band].y1 > y)
+			continue;
 
-			if (X2 > pbox->x2)
-				X2 = pbox->x2;
+		/* Boxes in a band share y1 and are sorted by x */
+		for (i = band, pbox = &boxes[band];
+		     i < nbox && pbox->y1 == boxes[band].y1 && pbox->x1 < x2;
+		     i++, pbox++) {
+			int X1 = x1 > pbox->x1 ? x1 : pbox->x1;
+			int X2 = x2 < pbox->x2 ? x2 : pbox->x2;
 
-			if (X2 > X1 && pbox->y1 <= y && pbox->y2 > y)
-				(*uxa_screen->info->solid) (dst_pixmap,
-								X1 + off_x, y + off_y,
-								X2 + off_x, y + 1 + off_y);
-			pbox++;
+			if (X2 > X1)
+				uxa_span_add(&fill, X1, X2, y);
 		}
 	}
-	(*uxa_screen->info->done_solid) (dst_pixmap);
+	uxa_span_flush(&fill);
+
+	if (fill.stipple)
+		(*uxa_screen->info->done_mono) (fill.dst);
+	else if (fill.tile)
+		(*uxa_screen->info->done_copy) (fill.dst);
+	else
+		(*uxa_screen->info->done_solid) (fill.dst);
 
 	return;
 
@@ -500,11 +831,111 @@ uxa_copy_area(DrawablePtr pSrcDrawable, DrawablePtr pDstDrawable, GCPtr pGC,
 			dstx, dsty, uxa_copy_n_to_n, 0, NULL);
 }
 
+/*
+ * CopyPlane from a depth 1 source is an opaque mono expansion in the GC's
+ * foreground and background.  The plane of a deeper source would have to
+ * be extracted on the CPU first, so those take the software path.
+ */
+static void
+uxa_copy_1_to_n(DrawablePtr pSrcDrawable,
+		DrawablePtr pDstDrawable,
+		GCPtr pGC,
+		BoxPtr pbox,
+		int nbox,
+		int dx,
+		int dy,
+		Bool reverse, Bool upsidedown, Pixel bitplane, void *closure)
+{
+	ScreenPtr screen = pDstDrawable->pScreen;
+	uxa_screen_t *uxa_screen = uxa_get_screen(screen);
+	int src_off_x, src_off_y;
+	int dst_off_x, dst_off_y;
+	PixmapPtr pSrcPixmap, pDstPixmap;
+	const CARD8 *bits;
+	int stride;
+
+	pSrcPixmap = uxa_get_drawable_pixmap(pSrcDrawable);
+	pDstPixmap = uxa_get_offscreen_pixmap(pDstDrawable,
+					      &dst_off_x, &dst_off_y);
+	if (!pSrcPixmap || !pDstPixmap)
+		goto fallback;
+
+	bits = uxa_mono_bits(pSrcPixmap);
+	if (!bits)
+		goto fallback;
+	stride = pSrcPixmap->devKind;
+
+	uxa_get_drawable_deltas(pSrcDrawable, pSrcPixmap, &src_off_x,
+				&src_off_y);
+
+	if (uxa_screen->info->check_mono &&
+	    !uxa_screen->info->check_mono(pDstDrawable, pGC->alu,
+					  pGC->planemask))
+		goto fallback;
+
+	if (!(*uxa_screen->info->prepare_mono) (pDstPixmap, pGC->alu,
+						pGC->planemask,
+						pGC->fgPixel, pGC->bgPixel,
+						TRUE, NULL, 0, 0))
+		goto fallback;
+
+	while (nbox--) {
+		(*uxa_screen->info->mono) (pDstPixmap,
+					   pbox->x1 + dst_off_x,
+					   pbox->y1 + dst_off_y,
+					   pbox->x2 - pbox->x1,
+					   pbox->y2 - pbox->y1,
+					   bits +
+					   (pbox->y1 + dy + src_off_y) * stride,
+					   stride,
+					   pbox->x1 + dx + src_off_x);
+		pbox++;
+	}
+	(*uxa_screen->info->done_mono) (pDstPixmap);
+
+	return;
+
+fallback:
+	UXA_FALLBACK(("from %p to %p (%c,%c)\n", pSrcDrawable, pDstDrawable,
+		      uxa_drawable_location(pSrcDrawable),
+		      uxa_drawable_location(pDstDrawable)));
+	UXA_COUNT(screen, FALLBACK_COPY_PLANE);
+	if (uxa_prepare_access(pDstDrawable, UXA_ACCESS_RW)) {
+		if (uxa_prepare_access(pSrcDrawable, UXA_ACCESS_RO)) {
+			fbCopy1toN(pSrcDrawable, pDstDrawable, pGC, pbox, nbox,
+				   dx, dy, reverse, upsidedown, bitplane,
+				   closure);
+			uxa_finish_access(pSrcDrawable, UXA_ACCESS_RO);
+		}
+		uxa_finish_access(pDstDrawable, UXA_ACCESS_RW);
+	}
+}
+
+static RegionPtr
+uxa_copy_plane(DrawablePtr pSrcDrawable, DrawablePtr pDstDrawable, GCPtr pGC,
+	       int srcx, int srcy, int width, int height, int dstx, int dsty,
+	       unsigned long bitPlane)
+{
+	uxa_screen_t *uxa_screen = uxa_get_screen(pDstDrawable->pScreen);
+
+	if (uxa_screen->force_fallback || pSrcDrawable->depth != 1 ||
+	    !uxa_screen->info->prepare_mono) {
+		return uxa_check_copy_plane(pSrcDrawable, pDstDrawable, pGC,
+					    srcx, srcy, width, height,
+					    dstx, dsty, bitPlane);
+	}
+
+	return miDoCopy(pSrcDrawable, pDstDrawable, pGC,
+			srcx, srcy, width, height,
+			dstx, dsty, uxa_copy_1_to_n, bitPlane, NULL);
+}
+
 static void
 uxa_poly_point(DrawablePtr pDrawable, GCPtr pGC, int mode, int npt,
 	       DDXPointPtr ppt)
 {
-	int i;
+	int i, n;
+	int x = 0, y = 0;
 	xRectangle *prect;
 
 	/* If we can't reuse the current GC as is, don't bother accelerating the
@@ -518,24 +949,95 @@ uxa_poly_point(DrawablePtr pDrawable, GCPtr pGC, int mode, int npt,
 	prect = malloc(sizeof(xRectangle) * npt);
 	if (!prect)
 		return;
-	for (i = 0; i < npt; i++) {
-		prect[i].x = ppt[i].x;
-		prect[i].y = ppt[i].y;
+	for (i = n = 0; i < npt; i++) {
 		if (i > 0 && mode == CoordModePrevious) {
-			prect[i].x += prect[i - 1].x;
-			prect[i].y += prect[i - 1].y;
+			x += ppt[i].x;
+			y += ppt[i].y;
+		} else {
+			x = ppt[i].x;
+			y = ppt[i].y;
+		}
+
+		/* Zero-width arcs come through here one pixel at a time;
+		 * grow the last rectangle by a neighbour on its row or
+		 * column rather than starting another one.
+		 */
+		if (n > 0) {
+			xRectangle *r = &prect[n - 1];
+
+			if (r->height == 1 && y == r->y) {
+				if (x == r->x + r->width) {
+					r->width++;
+					continue;
+				}
+				if (x == r->x - 1) {
+					r->x--;
+					r->width++;
+					continue;
+				}
+			}
+			if (r->width == 1 && x == r->x) {
+				if (y == r->y + r->height) {
+					r->height++;
+					continue;
+				}
+				if (y == r->y - 1) {
+					r->y--;
+					r->height++;
+					continue;
+				}
+			}
 		}
-		prect[i].width = 1;
-		prect[i].height = 1;
+
+		prect[n].x = x;
+		prect[n].y = y;
+		prect[n].width = 1;
+		prect[n].height = 1;
+		n++;
 	}
-	pGC->ops->PolyFillRect(pDrawable, pGC, npt, prect);
+	pGC->ops->PolyFillRect(pDrawable, pGC, n, prect);
 	free(prect);
 }
 
+/*
+ * Lines that can't be drawn as rectangles are rasterized by mi, which
+ * emits spans, rectangles and bitmaps through the GC ops, so they stay
+ * on the GPU.  The result matches fb: fb uses the same mi code for wide
+ * lines, and its thin lines share miZeroLine's bias and clipping rules.
+ */
+static void
+uxa_mi_poly_lines(DrawablePtr pDrawable, GCPtr pGC, int mode, int npt,
+		  DDXPointPtr ppt)
+{
+	uxa_screen_t *uxa_screen = uxa_get_screen(pDrawable->pScreen);
+
+	if (uxa_screen->force_fallback ||
+	    !uxa_drawable_is_offscreen(pDrawable)) {
+		uxa_check_poly_lines(pDrawable, pGC, mode, npt, ppt);
+		return;
+	}
+
+	if (pGC->lineWidth == 0) {
+		if (pGC->lineStyle == LineSolid)
+			miZeroLine(pDrawable, pGC, mode, npt, ppt);
+		else
+			miZeroDashLine(pDrawable, pGC, mode, npt, ppt);
+	} else {
+		if (pGC->lineStyle == LineSolid)
+			miWideLine(pDrawable, pGC, mode, npt, ppt);
+		else
+			miWideDash(pDrawable, pGC, mode, npt, ppt);
+	}
+}
+
 /**
  * uxa_poly_lines() checks if it can accelerate the lines as a group of
  * horizontal or vertical lines (rectangles), and uses existing rectangle fill
  * acceleration if so.
+ *
+ * Each rectangle leaves out the segment's end point, which the next
+ * segment starts on, so joints are drawn once as in fb.  The final point
+ * is drawn unless the cap style is CapNotLast or the line is closed.
  */
 static void
 uxa_poly_lines(DrawablePtr pDrawable, GCPtr pGC, int mode, int npt,
@@ -543,22 +1045,22 @@ uxa_poly_lines(DrawablePtr pDrawable, GCPtr pGC, int mode, int npt,
 {
 	xRectangle *prect;
 	int x1, x2, y1, y2;
-	int i;
+	int i, n;
 
-	/* Don't try to do wide lines or non-solid fill style. */
+	/* Only thin solid lines with a solid fill become rectangles. */
 	if (pGC->lineWidth != 0 || pGC->lineStyle != LineSolid ||
-	    pGC->fillStyle != FillSolid) {
-		uxa_check_poly_lines(pDrawable, pGC, mode, npt, ppt);
+	    pGC->fillStyle != FillSolid || npt < 2) {
+		uxa_mi_poly_lines(pDrawable, pGC, mode, npt, ppt);
 		return;
 	}
 
-	prect = malloc(sizeof(xRectangle) * (npt - 1));
+	prect = malloc(sizeof(xRectangle) * npt);
 	if (!prect)
 		return;
 	x1 = ppt[0].x;
 	y1 = ppt[0].y;
-	/* If we have any non-horizontal/vertical, fall back. */
-	for (i = 0; i < npt - 1; i++) {
+	/* If we have any non-horizontal/vertical, let mi draw them. */
+	for (i = n = 0; i < npt - 1; i++) {
 		if (mode == CoordModePrevious) {
 			x2 = x1 + ppt[i + 1].x;
 			y2 = y1 + ppt[i + 1].y;
@@ -569,32 +1071,70 @@ uxa_poly_lines(DrawablePtr pDrawable, GCPtr pGC, int mode, int npt,
 
 		if (x1 != x2 && y1 != y2) {
 			free(prect);
-			uxa_check_poly_lines(pDrawable, pGC, mode, npt, ppt);
+			uxa_mi_poly_lines(pDrawable, pGC, mode, npt, ppt);
 			return;
 		}
 
-		if (x1 < x2) {
-			prect[i].x = x1;
-			prect[i].width = x2 - x1 + 1;
-		} else {
-			prect[i].x = x2;
-			prect[i].width = x1 - x2 + 1;
-		}
-		if (y1 < y2) {
-			prect[i].y = y1;
-			prect[i].height = y2 - y1 + 1;
-		} else {
-			prect[i].y = y2;
-			prect[i].height = y1 - y2 + 1;
+		if (x1 != x2 || y1 != y2) {
+			if (x1 < x2) {
+				prect[n].x = x1;
+				prect[n].width = x2 - x1;
+			} else if (x1 > x2) {
+				prect[n].x = x2 + 1;
+				prect[n].width = x1 - x2;
+			} else {
+				prect[n].x = x1;
+				prect[n].width = 1;
+			}
+			if (y1 < y2) {
+				prect[n].y = y1;
+				prect[n].height = y2 - y1;
+			} else if (y1 > y2) {
+				prect[n].y = y2 + 1;
+				prect[n].height = y1 - y2;
+			} else {
+				prect[n].y = y1;
+				prect[n].height = 1;
+			}
+			n++;
 		}
 
 		x1 = x2;
 		y1 = y2;
 	}
-	pGC->ops->PolyFillRect(pDrawable, pGC, npt - 1, prect);
+
+	if (pGC->capStyle != CapNotLast &&
+	    (x1 != ppt[0].x || y1 != ppt[0].y)) {
+		prect[n].x = x1;
+		prect[n].y = y1;
+		prect[n].width = 1;
+		prect[n].height = 1;
+		n++;
+	}
+
+	pGC->ops->PolyFillRect(pDrawable, pGC, n, prect);
 	free(prect);
 }
 
+/* Segments drawn by mi, one two-point line each, as fb does. */
+static void
+uxa_mi_poly_segment(DrawablePtr pDrawable, GCPtr pGC, int nseg,
+		    xSegment * pSeg)
+{
+	uxa_screen_t *uxa_screen = uxa_get_screen(pDrawable->pScreen);
+	int i;
+
+	if (uxa_screen->force_fallback ||
+	    !uxa_drawable_is_offscreen(pDrawable)) {
+		uxa_check_poly_segment(pDrawable, pGC, nseg, pSeg);
+		return;
+	}
+
+	for (i = 0; i < nseg; i++)
+		uxa_mi_poly_lines(pDrawable, pGC, CoordModeOrigin, 2,
+				  (DDXPointPtr) &pSeg[i]);
+}
+
 /**
  * uxa_poly_segment() checks if it can accelerate the lines as a group of
  * horizontal or vertical lines (rectangles), and uses existing rectangle fill
@@ -604,19 +1144,19 @@ static void
 uxa_poly_segment(DrawablePtr pDrawable, GCPtr pGC, int nseg, xSegment * pSeg)
 {
 	xRectangle *prect;
-	int i;
+	int i, n;
 
-	/* Don't try to do wide lines or non-solid fill style. */
+	/* Only thin solid lines with a solid fill become rectangles. */
 	if (pGC->lineWidth != 0 || pGC->lineStyle != LineSolid ||
 	    pGC->fillStyle != FillSolid) {
-		uxa_check_poly_segment(pDrawable, pGC, nseg, pSeg);
+		uxa_mi_poly_segment(pDrawable, pGC, nseg, pSeg);
 		return;
 	}
 
-	/* If we have any non-horizontal/vertical, fall back. */
+	/* If we have any non-horizontal/vertical, let mi draw them. */
 	for (i = 0; i < nseg; i++) {
 		if (pSeg[i].x1 != pSeg[i].x2 && pSeg[i].y1 != pSeg[i].y2) {
-			uxa_check_poly_segment(pDrawable, pGC, nseg, pSeg);
+			uxa_mi_poly_segment(pDrawable, pGC, nseg, pSeg);
 			return;
 		}
 	}
@@ -624,34 +1164,59 @@ uxa_poly_segment(DrawablePtr pDrawable, GCPtr pGC, int nseg, xSegment * pSeg)
 	prect = malloc(sizeof(xRectangle) * nseg);
 	if (!prect)
 		return;
-	for (i = 0; i < nseg; i++) {
-		if (pSeg[i].x1 < pSeg[i].x2) {
-			prect[i].x = pSeg[i].x1;
-			prect[i].width = pSeg[i].x2 - pSeg[i].x1 + 1;
-		} else {
-			prect[i].x = pSeg[i].x2;
-			prect[i].width = pSeg[i].x1 - pSeg[i].x2 + 1;
-		}
-		if (pSeg[i].y1 < pSeg[i].y2) {
-			prect[i].y = pSeg[i].y1;
-			prect[i].height = pSeg[i].y2 - pSeg[i].y1 + 1;
-		} else {
-			prect[i].y = pSeg[i].y2;
-			prect[i].height = pSeg[i].y1 - pSeg[i].y2 + 1;
-		}
+	for (i = n = 0; i < nseg; i++) {
+		int x1 = pSeg[i].x1, y1 = pSeg[i].y1;
+		int x2 = pSeg[i].x2, y2 = pSeg[i].y2;
 
 		/* don't paint last pixel */
 		if (pGC->capStyle == CapNotLast) {
-			if (prect[i].width == 1)
-				prect[i].height--;
+			if (x1 == x2 && y1 == y2)
+				continue;
+			if (y1 == y2)
+				x2 += x1 < x2 ? -1 : 1;
 			else
-				prect[i].width--;
+				y2 += y1 < y2 ? -1 : 1;
+		}
+
+		if (x1 < x2) {
+			prect[n].x = x1;
+			prect[n].width = x2 - x1 + 1;
+		} else {
+			prect[n].x = x2;
+			prect[n].width = x1 - x2 + 1;
+		}
+		if (y1 < y2) {
+			prect[n].y = y1;
+			prect[n].height = y2 - y1 + 1;
+		} else {
+			prect[n].y = y2;
+			prect[n].height = y1 - y2 + 1;
 		}
+		n++;
 	}
-	pGC->ops->PolyFillRect(pDrawable, pGC, nseg, prect);
+	pGC->ops->PolyFillRect(pDrawable, pGC, n, prect);
 	free(prect);
 }
 
+/*
+ * Arcs are rasterized by mi into points, spans and (for rops that must
+ * not touch a pixel twice) a bitmap pushed with PushPixels, all of which
+ * are accelerated.  Filled arcs already go through miPolyFillArc.
+ */
+static void
+uxa_poly_arc(DrawablePtr pDrawable, GCPtr pGC, int narcs, xArc * pArcs)
+{
+	uxa_screen_t *uxa_screen = uxa_get_screen(pDrawable->pScreen);
+
+	if (uxa_screen->force_fallback ||
+	    !uxa_drawable_is_offscreen(pDrawable)) {
+		uxa_check_poly_arc(pDrawable, pGC, narcs, pArcs);
+		return;
+	}
+
+	miPolyArc(pDrawable, pGC, narcs, pArcs);
+}
+
 static Bool uxa_fill_region_solid(DrawablePtr pDrawable, RegionPtr pRegion,
 				  Pixel pixel, CARD32 planemask, CARD32 alu);
 
@@ -664,6 +1229,8 @@ uxa_poly_fill_rect(DrawablePtr pDrawable,
 	PixmapPtr pPixmap;
 	RegionPtr pReg;
 	BoxPtr pbox;
+	PixmapPtr pStipple = NULL;
+	Bool pattern = FALSE;
 	int fullX1, fullX2, fullY1, fullY2;
 	int xoff, yoff;
 	int xorg, yorg;
@@ -704,28 +1271,39 @@ uxa_poly_fill_rect(DrawablePtr pDrawable,
 		}
 	}
 
-	if (pGC->fillStyle != FillSolid &&
-	    !(pGC->tileIsPixel && pGC->fillStyle == FillTiled)) {
-		goto fallback;
-	}
+	xorg = pDrawable->x;
+	yorg = pDrawable->y;
 
-	if (uxa_screen->info->check_solid &&
-	    !uxa_screen->info->check_solid(pDrawable, pGC->alu, pGC->planemask)) {
-		goto fallback;
-	}
+	if (pGC->fillStyle == FillStippled ||
+	    pGC->fillStyle == FillOpaqueStippled) {
+		if (!uxa_prepare_stipple(uxa_screen, pDrawable, pPixmap, pGC,
+					 xorg + pGC->patOrg.x + xoff,
+					 yorg + pGC->patOrg.y + yoff,
+					 &pattern))
+			goto fallback;
+		pStipple = pGC->stipple;
+	} else {
+		if (pGC->fillStyle != FillSolid &&
+		    !(pGC->tileIsPixel && pGC->fillStyle == FillTiled)) {
+			goto fallback;
+		}
 
-	if (!(*uxa_screen->info->prepare_solid) (pPixmap,
-						 pGC->alu,
-						 pGC->planemask,
-						 pGC->fgPixel)) {
+		if (uxa_screen->info->check_solid &&
+		    !uxa_screen->info->check_solid(pDrawable, pGC->alu,
+						   pGC->planemask)) {
+			goto fallback;
+		}
+
+		if (!(*uxa_screen->info->prepare_solid) (pPixmap,
+							 pGC->alu,
+							 pGC->planemask,
+							 pGC->fgPixel)) {
 fallback:
-		uxa_check_poly_fill_rect(pDrawable, pGC, nrect, prect);
-		goto out;
+			uxa_check_poly_fill_rect(pDrawable, pGC, nrect, prect);
+			goto out;
+		}
 	}
 
-	xorg = pDrawable->x;
-	yorg = pDrawable->y;
-
 	while (nrect--) {
 		fullX1 = prect->x + xorg;
 		fullY1 = prect->y + yorg;
@@ -759,31 +1337,308 @@ fallback:
 			if (x1 >= x2 || y1 >= y2)
 				continue;
 
-			(*uxa_screen->info->solid) (pPixmap,
-						    x1 + xoff,
-						    y1 + yoff,
-						    x2 + xoff,
-						    y2 + yoff);
+			if (pStipple)
+				uxa_stipple_box(uxa_screen, pPixmap, pStipple,
+						pattern,
+						x1 + xoff, y1 + yoff,
+						x2 + xoff, y2 + yoff,
+						xorg + pGC->patOrg.x + xoff,
+						yorg + pGC->patOrg.y + yoff);
+			else
+				(*uxa_screen->info->solid) (pPixmap,
+							    x1 + xoff,
+							    y1 + yoff,
+							    x2 + xoff,
+							    y2 + yoff);
 		}
 	}
-	(*uxa_screen->info->done_solid) (pPixmap);
+	if (pStipple)
+		(*uxa_screen->info->done_mono) (pPixmap);
+	else
+		(*uxa_screen->info->done_solid) (pPixmap);
 
 out:
 	REGION_UNINIT(pScreen, pReg);
 	REGION_DESTROY(pScreen, pReg);
 }
 
+/*
+ * PushPixels with a solid fill is a transparent mono expansion of the
+ * bitmap in the GC's foreground, clipped to each box of the clip.
+ */
+static void
+uxa_push_pixels(GCPtr pGC, PixmapPtr pBitmap, DrawablePtr pDrawable,
+		int w, int h, int x, int y)
+{
+	uxa_screen_t *uxa_screen = uxa_get_screen(pDrawable->pScreen);
+	RegionPtr pClip = fbGetCompositeClip(pGC);
+	BoxPtr pbox = REGION_RECTS(pClip);
+	int nbox = REGION_NUM_RECTS(pClip);
+	const CARD8 *bits;
+	PixmapPtr pPixmap;
+	BoxRec extents;
+	int xoff, yoff;
+
+	if (uxa_screen->force_fallback || pGC->fillStyle != FillSolid ||
+	    !uxa_screen->info->prepare_mono)
+		goto fallback;
+
+	bits = uxa_mono_bits(pBitmap);
+	pPixmap = uxa_get_offscreen_pixmap(pDrawable, &xoff, &yoff);
+	if (!bits || !pPixmap)
+		goto fallback;
+
+	if (uxa_screen->info->check_mono &&
+	    !uxa_screen->info->check_mono(pDrawable, pGC->alu,
+					  pGC->planemask))
+		goto fallback;
+
+	if (!(*uxa_screen->info->prepare_mono) (pPixmap, pGC->alu,
+						pGC->planemask,
+						pGC->fgPixel, 0,
+						FALSE, NULL, 0, 0))
+		goto fallback;
+
+	extents.x1 = x + pDrawable->x;
+	extents.y1 = y + pDrawable->y;
+	extents.x2 = extents.x1 + w;
+	extents.y2 = extents.y1 + h;
+
+	for (; nbox-- && pbox->y1 < extents.y2; pbox++) {
+		int x1 = extents.x1 > pbox->x1 ? extents.x1 : pbox->x1;
+		int y1 = extents.y1 > pbox->y1 ? extents.y1 : pbox->y1;
+		int x2 = extents.x2 < pbox->x2 ? extents.x2 : pbox->x2;
+		int y2 = extents.y2 < pbox->y2 ? extents.y2 : pbox->y2;
+
+		if (x1 >= x2 || y1 >= y2)
+			continue;
+
+		(*uxa_screen->info->mono) (pPixmap,
+					   x1 + xoff, y1 + yoff,
+					   x2 - x1, y2 - y1,
+					   bits +
+					   (y1 - extents.y1) * pBitmap->devKind,
+					   pBitmap->devKind,
+					   x1 - extents.x1);
+	}
+	(*uxa_screen->info->done_mono) (pPixmap);
+
+	return;
+
+fallback:
+	uxa_check_push_pixels(pGC, pBitmap, pDrawable, w, h, x, y);
+}
+
+/*
+ * Core font text.  The glyphs of a string are OR'ed into one bitmap in
+ * system memory, which the driver then expands clip box by clip box, so
+ * a line of xterm output is a few blits and never maps the destination.
+ */
+
+/* Draw the glyphs of a string with its origin at x,y into a zeroed
+ * bitmap covering box.  Based on fbPolyGlyphBlt(). */
+static void
+uxa_glyph_bits(CARD8 *bits, int stride, const BoxRec *box, int x, int y,
+	       unsigned int nglyph, CharInfoPtr *ppci, pointer pglyphBase)
+{
+	while (nglyph--) {
+		CharInfoPtr pci = *ppci++;
+		const CARD8 *src = FONTGLYPHBITS(pglyphBase, pci);
+		int gw = GLYPHWIDTHPIXELS(pci);
+		int gh = GLYPHHEIGHTPIXELS(pci);
+		int gstride = GLYPHWIDTHBYTESPADDED(pci);
+		int gx = x + pci->metrics.leftSideBearing - box->x1;
+		int gy = y - pci->metrics.ascent - box->y1;
+		int shift = gx & 7;
+		int nbytes = (gw + 7) >> 3;
+		CARD8 last = (gw & 7) ? (1 << (gw & 7)) - 1 : 0xff;
+		CARD8 *dst = bits + gy * stride + (gx >> 3);
+		int i;
+
+		x += pci->metrics.characterWidth;
+
+		while (gh--) {
+			for (i = 0; i < nbytes; i++) {
+				CARD8 b = src[i];
+
+				if (i == nbytes - 1)
+					b &= last;
+				dst[i] |= b << shift;
+				if (shift)
+					dst[i + 1] |= b >> (8 - shift);
+			}
+			src += gstride;
+			dst += stride;
+		}
+	}
+}
+
+static Bool
+uxa_glyph_blt(DrawablePtr pDrawable, GCPtr pGC, int x, int y,
+	      unsigned int nglyph, CharInfoPtr *ppci, pointer pglyphBase,
+	      Bool image)
+{
+	uxa_screen_t *uxa_screen = uxa_get_screen(pDrawable->pScreen);
+	RegionPtr pClip = fbGetCompositeClip(pGC);
+	BoxPtr pbox;
+	int nbox;
+	int alu = image ? GXcopy : pGC->alu;
+	ExtentInfoRec info;
+	BoxRec box, back;
+	Bool opaque = FALSE, fill_back = FALSE;
+	PixmapPtr pPixmap;
+	CARD8 *bits;
+	int xoff, yoff;
+	int stride;
+
+	if (uxa_screen->force_fallback || !uxa_screen->info->prepare_mono)
+		return FALSE;
+
+	/* Overlapping glyphs are drawn once, so the rop must not care */
+	if (!image &&
+	    (pGC->fillStyle != FillSolid ||
+	     (nglyph > 1 && alu != GXcopy && alu != GXclear &&
+	      alu != GXnoop && alu != GXcopyInverted && alu != GXset &&
+	      alu != GXor && alu != GXand)))
+		return FALSE;
+
+	pPixmap = uxa_get_offscreen_pixmap(pDrawable, &xoff, &yoff);
+	if (!pPixmap)
+		return FALSE;
+
+	if (uxa_screen->info->check_mono &&
+	    !uxa_screen->info->check_mono(pDrawable, alu, pGC->planemask))
+		return FALSE;
+
+	QueryGlyphExtents(pGC->font, ppci, nglyph, &info);
+	x += pDrawable->x;
+	y += pDrawable->y;
+
+	box.x1 = x + info.overallLeft;
+	box.x2 = x + info.overallRight;
+	box.y1 = y - info.overallAscent;
+	box.y2 = y + info.overallDescent;
+
+	if (image) {
+		back.x1 = x + (info.overallWidth < 0 ? info.overallWidth : 0);
+		back.x2 = back.x1 + abs(info.overallWidth);
+		back.y1 = y - FONTASCENT(pGC->font);
+		back.y2 = y + FONTDESCENT(pGC->font);
+
+		/* If the ink stays inside the background, which it does
+		 * for terminal fonts, one opaque expansion draws both. */
+		if (box.x1 >= box.x2 || box.y1 >= box.y2 ||
+		    (box.x1 >= back.x1 && box.x2 <= back.x2 &&
+		     box.y1 >= back.y1 && box.y2 <= back.y2)) {
+			box = back;
+			opaque = TRUE;
+		} else {
+			fill_back = back.x1 < back.x2 && back.y1 < back.y2;
+		}
+	}
+
+	if (box.x1 >= box.x2 || box.y1 >= box.y2)
+		return TRUE;
+
+	stride = ((box.x2 - box.x1 + 7) >> 3) + 1;
+	bits = calloc(stride, box.y2 - box.y1);
+	if (!bits)
+		return FALSE;
+	uxa_glyph_bits(bits, stride, &box, x, y, nglyph, ppci, pglyphBase);
+
+	if (fill_back) {
+		if ((uxa_screen->info->check_solid &&
+		     !uxa_screen->info->check_solid(pDrawable, GXcopy,
+						    pGC->planemask)) ||
+		    !(*uxa_screen->info->prepare_solid) (pPixmap, GXcopy,
+							 pGC->planemask,
+							 pGC->bgPixel)) {
+			free(bits);
+			return FALSE;
+		}
+
+		nbox = REGION_NUM_RECTS(pClip);
+		pbox = REGION_RECTS(pClip);
+		for (; nbox-- && pbox->y1 < back.y2; pbox++) {
+			int x1 = back.x1 > pbox->x1 ? back.x1 : pbox->x1;
+			int y1 = back.y1 > pbox->y1 ? back.y1 : pbox->y1;
+			int x2 = back.x2 < pbox->x2 ? back.x2 : pbox->x2;
+			int y2 = back.y2 < pbox->y2 ? back.y2 : pbox->y2;
+
+			if (x1 < x2 && y1 < y2)
+				(*uxa_screen->info->solid) (pPixmap,
+							    x1 + xoff,
+							    y1 + yoff,
+							    x2 + xoff,
+							    y2 + yoff);
+		}
+		(*uxa_screen->info->done_solid) (pPixmap);
+	}
+
+	if (!(*uxa_screen->info->prepare_mono) (pPixmap, alu, pGC->planemask,
+						pGC->fgPixel, pGC->bgPixel,
+						opaque, NULL, 0, 0)) {
+		free(bits);
+		return FALSE;
+	}
+
+	nbox = REGION_NUM_RECTS(pClip);
+	pbox = REGION_RECTS(pClip);
+	for (; nbox-- && pbox->y1 < box.y2; pbox++) {
+		int x1 = box.x1 > pbox->x1 ? box.x1 : pbox->x1;
+		int y1 = box.y1 > pbox->y1 ? box.y1 : pbox->y1;
+		int x2 = box.x2 < pbox->x2 ? box.x2 : pbox->x2;
+		int y2 = box.y2 < pbox->y2 ? box.y2 : pbox->y2;
+
+		if (x1 >= x2 || y1 >= y2)
+			continue;
+
+		(*uxa_screen->info->mono) (pPixmap,
+					   x1 + xoff, y1 + yoff,
+					   x2 - x1, y2 - y1,
+					   bits + (y1 - box.y1) * stride,
+					   stride, x1 - box.x1);
+	}
+	(*uxa_screen->info->done_mono) (pPixmap);
+
+	free(bits);
+	UXA_COUNT(pDrawable->pScreen, CORE_TEXT);
+	return TRUE;
+}
+
+static void
+uxa_image_glyph_blt(DrawablePtr pDrawable, GCPtr pGC, int x, int y,
+		    unsigned int nglyph, CharInfoPtr *ppci,
+		    pointer pglyphBase)
+{
+	if (!uxa_glyph_blt(pDrawable, pGC, x, y, nglyph, ppci, pglyphBase,
+			   TRUE))
+		uxa_check_image_glyph_blt(pDrawable, pGC, x, y, nglyph, ppci,
+					  pglyphBase);
+}
+
+static void
+uxa_poly_glyph_blt(DrawablePtr pDrawable, GCPtr pGC, int x, int y,
+		   unsigned int nglyph, CharInfoPtr *ppci,
+		   pointer pglyphBase)
+{
+	if (!uxa_glyph_blt(pDrawable, pGC, x, y, nglyph, ppci, pglyphBase,
+			   FALSE))
+		uxa_check_poly_glyph_blt(pDrawable, pGC, x, y, nglyph, ppci,
+					 pglyphBase);
+}
+
 const GCOps uxa_ops = {
 	uxa_fill_spans,
 	uxa_check_set_spans,
 	uxa_put_image,
 	uxa_copy_area,
-	uxa_check_copy_plane,
+	uxa_copy_plane,
 	uxa_poly_point,
 	uxa_poly_lines,
 	uxa_poly_segment,
 	miPolyRectangle,
-	uxa_check_poly_arc,
+	uxa_poly_arc,
 	miFillPolygon,
 	uxa_poly_fill_rect,
 	miPolyFillArc,
@@ -791,15 +1646,51 @@ const GCOps uxa_ops = {
 	miPolyText16,
 	miImageText8,
 	miImageText16,
-	uxa_check_image_glyph_blt,
-	uxa_check_poly_glyph_blt,
-	uxa_check_push_pixels,
+	uxa_image_glyph_blt,
+	uxa_poly_glyph_blt,
+	uxa_push_pixels,
 };
 
+/* Boxes uxa_copy_window() orders on the stack before it needs malloc() */
+#define UXA_COPY_WINDOW_BOXES	32
+
+/*
+ * Put the boxes of a YX-banded region into an order in which none of
+ * them overwrites the source of a box copied after it: bands bottom up
+ * when copying from above (upsidedown), boxes within a band right to
+ * left when copying from the left (reverse).  This is the order
+ * miCopyRegion builds, into a buffer of the caller's.
+ */
+static void
+uxa_copy_window_order(BoxPtr out, const BoxRec *in, int nbox,
+		      Bool reverse, Bool upsidedown)
+{
+	const BoxRec *band, *next, *end = in + nbox;
+	int o = upsidedown ? nbox : 0;
+
+	for (band = in; band < end; band = next) {
+		int i, n;
+
+		for (next = band; next < end && next->y1 == band->y1; next++)
+			;
+		n = next - band;
+
+		if (upsidedown)
+			o -= n;
+		for (i = 0; i < n; i++)
+			out[o + i] = band[reverse ? n - 1 - i : i];
+		if (!upsidedown)
+			o += n;
+	}
+}
+
 void uxa_copy_window(WindowPtr pWin, DDXPointRec ptOldOrg, RegionPtr prgnSrc)
 {
+	uxa_screen_t *uxa_screen = uxa_get_screen(pWin->drawable.pScreen);
+	BoxRec stack[UXA_COPY_WINDOW_BOXES];
 	RegionRec rgnDst;
-	int dx, dy;
+	BoxPtr pbox;
+	int dx, dy, nbox;
 	PixmapPtr pPixmap = (*pWin->drawable.pScreen->GetWindowPixmap) (pWin);
 
 	dx = ptOldOrg.x - pWin->drawable.x;
@@ -816,8 +1707,34 @@ void uxa_copy_window(WindowPtr pWin, DDXPointRec ptOldOrg, RegionPtr prgnSrc)
 				 -pPixmap->screen_x, -pPixmap->screen_y);
 #endif
 
-	miCopyRegion(&pPixmap->drawable, &pPixmap->drawable,
-		     NULL, &rgnDst, dx, dy, uxa_copy_n_to_n, 0, NULL);
+	/*
+	 * A pure translation within one pixmap: all the boxes go through a
+	 * single uxa_copy_n_to_n(), so the move is one prepare_copy() and
+	 * one copy() per box.  Only their order matters, and a move down
+	 * and right can use the region's own.
+	 */
+	nbox = REGION_NUM_RECTS(&rgnDst);
+	pbox = REGION_RECTS(&rgnDst);
+	if (nbox > 1 && (dx < 0 || dy < 0)) {
+		pbox = stack;
+		if (nbox > UXA_COPY_WINDOW_BOXES)
+			pbox = malloc(nbox * sizeof(BoxRec));
+		if (pbox)
+			uxa_copy_window_order(pbox, REGION_RECTS(&rgnDst),
+					      nbox, dx < 0, dy < 0);
+	}
+	if (pbox == NULL)
+		miCopyRegion(&pPixmap->drawable, &pPixmap->drawable,
+			     NULL, &rgnDst, dx, dy, uxa_copy_n_to_n, 0, NULL);
+	else if (nbox)
+		uxa_copy_n_to_n(&pPixmap->drawable, &pPixmap->drawable, NULL,
+				pbox, nbox, dx, dy, dx < 0, dy < 0, 0, NULL);
+	if (pbox != stack && pbox != REGION_RECTS(&rgnDst))
+		free(pbox);
+
+	if (nbox && uxa_screen->info->copy_window_damage)
+		uxa_screen->info->copy_window_damage(pPixmap, &rgnDst,
+						     dx, dy);
 
 	REGION_UNINIT(pWin->drawable.pScreen, &rgnDst);
 }
@@ -905,43 +1822,13 @@ uxa_fill_region_tiled(DrawablePtr pDrawable,
 
 	if ((*uxa_screen->info->prepare_copy) (pTile, pPixmap, 1, 1, alu,
 					       planemask)) {
+		int org_x = xoff + pDrawable->x + pPatOrg->x;
+		int org_y = yoff + pDrawable->y + pPatOrg->y;
+
 		while (nbox--) {
-			int height = pBox->y2 - pBox->y1;
-			int dstY = pBox->y1;
-			int tileY;
-
-			modulus(dstY - yoff - pDrawable->y - pPatOrg->y,
-				tileHeight, tileY);
-
-			while (height > 0) {
-				int width = pBox->x2 - pBox->x1;
-				int dstX = pBox->x1;
-				int tileX;
-				int h = tileHeight - tileY;
-
-				if (h > height)
-					h = height;
-				height -= h;
-
-				modulus(dstX - xoff - pDrawable->x - pPatOrg->x,
-					tileWidth, tileX);
-
-				while (width > 0) {
-					int w = tileWidth - tileX;
-					if (w > width)
-						w = width;
-					width -= w;
-
-					(*uxa_screen->info->copy) (pPixmap,
-								   tileX, tileY,
-								   dstX, dstY,
-								   w, h);
-					dstX += w;
-					tileX = 0;
-				}
-				dstY += h;
-				tileY = 0;
-			}
+			uxa_tile_box(uxa_screen, pPixmap, pTile,
+				     pBox->x1, pBox->y1, pBox->x2, pBox->y2,
+				     org_x, org_y);
 			pBox++;
 		}
 		(*uxa_screen->info->done_copy) (pPixmap);
@@ -968,7 +1855,7 @@ uxa_get_image(DrawablePtr pDrawable, int x, int y, int w, int h,
 {
 	ScreenPtr screen = pDrawable->pScreen;
 	uxa_screen_t *uxa_screen = uxa_get_screen(screen);
-	BoxRec Box;
+	BoxRec Box, access_box;
 	PixmapPtr pPix = uxa_get_drawable_pixmap(pDrawable);
 	int xoff, yoff;
 	Bool ok;
@@ -1008,7 +1895,11 @@ fallback:
 	UXA_FALLBACK(("from %p (%c)\n", pDrawable,
 		      uxa_drawable_location(pDrawable)));
 
-	if (uxa_prepare_access(pDrawable, UXA_ACCESS_RO)) {
+	access_box.x1 = pDrawable->x + x;
+	access_box.y1 = pDrawable->y + y;
+	access_box.x2 = access_box.x1 + w;
+	access_box.y2 = access_box.y1 + h;
+	if (uxa_prepare_access_box(pDrawable, &access_box, UXA_ACCESS_RO)) {
 		fbGetImage(pDrawable, x, y, w, h, format, planeMask, d);
 		uxa_finish_access(pDrawable, UXA_ACCESS_RO);
 	}
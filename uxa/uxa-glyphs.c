@@ -132,6 +132,35 @@ void uxa_glyphs_fini(ScreenPtr pScreen)
 	uxa_unrealize_glyph_caches(pScreen);
 }
 
+static Bool uxa_realize_glyph_caches(ScreenPtr pScreen);
+
+/**
+ * Throw away every cached glyph and reallocate the cache pixmaps.  Used
+ * after a GPU reset, when the cache contents can no longer be trusted.
+ */
+void uxa_glyphs_reset(ScreenPtr pScreen)
+{
+	uxa_screen_t *uxa_screen = uxa_get_screen(pScreen);
+	int i, j;
+
+	if (uxa_screen->glyph_cache_initialized) {
+		for (i = 0; i < UXA_NUM_GLYPH_CACHE_FORMATS; i++) {
+			uxa_glyph_cache_t *cache = &uxa_screen->glyphCaches[i];
+
+			if (!cache->glyphs)
+				continue;
+
+			for (j = 0; j < GLYPH_CACHE_SIZE; j++) {
+				if (cache->glyphs[j])
+					uxa_glyph_unrealize(pScreen, cache->glyphs[j]);
+			}
+		}
+		uxa_unrealize_glyph_caches(pScreen);
+	}
+
+	uxa_realize_glyph_caches(pScreen);
+}
+
 /* All caches for a single format share a single pixmap for glyph storage,
  * allowing mixing glyphs of different sizes without paying a penalty
  * for switching between source pixmaps. (Note that for a size of font
@@ -769,6 +798,7 @@ uxa_glyphs_to_dst(CARD8 op,
 
 			priv = uxa_glyph_get_private(glyph);
 			if (priv != NULL) {
+				UXA_COUNT(screen, GLYPH_CACHE_HIT);
 				mask_x = priv->x;
 				mask_y = priv->y;
 				this_atlas = priv->cache->picture;
@@ -777,6 +807,7 @@ uxa_glyphs_to_dst(CARD8 op,
 					uxa_screen->info->done_composite(dst_pixmap);
 					glyph_atlas = NULL;
 				}
+				UXA_COUNT(screen, GLYPH_CACHE_MISS);
 				this_atlas = uxa_glyph_cache(screen, glyph, &mask_x, &mask_y);
 				if (this_atlas == NULL) {
 					/* no cache for this glyph */
@@ -976,6 +1007,7 @@ uxa_glyphs_via_mask(CARD8 op,
 
 			priv = uxa_glyph_get_private(glyph);
 			if (priv != NULL) {
+				UXA_COUNT(screen, GLYPH_CACHE_HIT);
 				src_x = priv->x;
 				src_y = priv->y;
 				this_atlas = priv->cache->picture;
@@ -984,6 +1016,7 @@ uxa_glyphs_via_mask(CARD8 op,
 					uxa_screen->info->done_composite(pixmap);
 					glyph_atlas = NULL;
 				}
+				UXA_COUNT(screen, GLYPH_CACHE_MISS);
 				this_atlas = uxa_glyph_cache(screen, glyph, &src_x, &src_y);
 				if (this_atlas == NULL) {
 					/* no cache for this glyph */
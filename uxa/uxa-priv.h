@@ -163,6 +163,13 @@ static inline uxa_screen_t *uxa_get_screen(ScreenPtr screen)
 #endif
 }
 
+/* Report a UXA_COUNT_* event to the driver, if it keeps statistics */
+#define UXA_COUNT(screen, event) do {					\
+	uxa_screen_t *_uxa_screen = uxa_get_screen(screen);		\
+	if (_uxa_screen->info->count)					\
+		_uxa_screen->info->count(screen, UXA_COUNT_##event);	\
+} while (0)
+
 /** Align an offset to an arbitrary alignment */
 #define UXA_ALIGN(offset, align) (((offset) + (align) - 1) - \
 	(((offset) + (align) - 1) % (align)))
@@ -315,6 +322,9 @@ uxa_check_composite(CARD8 op,
 
 /* uxa.c */
 Bool uxa_prepare_access(DrawablePtr pDrawable, uxa_access_t access);
+
+Bool uxa_prepare_access_box(DrawablePtr pDrawable, const BoxRec *box,
+			    uxa_access_t access);
 void uxa_finish_access(DrawablePtr pDrawable, uxa_access_t access);
 
 Bool uxa_picture_prepare_access(PicturePtr picture, int mode);
@@ -384,6 +394,9 @@ uxa_triangles(CARD8 op, PicturePtr pSrc, PicturePtr pDst,
 PicturePtr
 uxa_acquire_solid(ScreenPtr screen, SourcePict *source);
 
+void
+uxa_solid_reset(ScreenPtr screen);
+
 PicturePtr
 uxa_acquire_drawable(ScreenPtr pScreen,
 		     PicturePtr pSrc,
@@ -411,6 +424,8 @@ Bool uxa_glyphs_init(ScreenPtr pScreen);
 
 void uxa_glyphs_fini(ScreenPtr pScreen);
 
+void uxa_glyphs_reset(ScreenPtr pScreen);
+
 void
 uxa_glyphs(CARD8 op,
 	   PicturePtr pSrc,
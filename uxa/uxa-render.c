@@ -623,6 +623,30 @@ uxa_solid_clear(ScreenPtr screen)
 	return picture;
 }
 
+/**
+ * Drop all cached solid source pictures; they are recreated on demand.
+ */
+void
+uxa_solid_reset(ScreenPtr screen)
+{
+	uxa_screen_t *uxa_screen = uxa_get_screen(screen);
+	int i;
+
+	if (uxa_screen->solid_clear)
+		FreePicture(uxa_screen->solid_clear, 0);
+	if (uxa_screen->solid_black)
+		FreePicture(uxa_screen->solid_black, 0);
+	if (uxa_screen->solid_white)
+		FreePicture(uxa_screen->solid_white, 0);
+	for (i = 0; i < uxa_screen->solid_cache_size; i++)
+		FreePicture(uxa_screen->solid_cache[i].picture, 0);
+
+	uxa_screen->solid_clear = NULL;
+	uxa_screen->solid_black = NULL;
+	uxa_screen->solid_white = NULL;
+	uxa_screen->solid_cache_size = 0;
+}
+
 PicturePtr
 uxa_acquire_solid(ScreenPtr screen, SourcePict *source)
 {
@@ -639,29 +663,35 @@ uxa_acquire_solid(ScreenPtr screen, SourcePict *source)
 		goto DONE;
 	} else if (solid->color == 0xff000000) {
 		if (!uxa_screen->solid_black) {
+			UXA_COUNT(screen, SOLID_CACHE_MISS);
 			uxa_screen->solid_black = uxa_create_solid(screen, 0xff000000);
 			if (!uxa_screen->solid_black)
 				return 0;
-		}
+		} else
+			UXA_COUNT(screen, SOLID_CACHE_HIT);
 		picture = uxa_screen->solid_black;
 		goto DONE;
 	} else if (solid->color == 0xffffffff) {
 		if (!uxa_screen->solid_white) {
+			UXA_COUNT(screen, SOLID_CACHE_MISS);
 			uxa_screen->solid_white = uxa_create_solid(screen, 0xffffffff);
 			if (!uxa_screen->solid_white)
 				return 0;
-		}
+		} else
+			UXA_COUNT(screen, SOLID_CACHE_HIT);
 		picture = uxa_screen->solid_white;
 		goto DONE;
 	}
 
 	for (i = 0; i < uxa_screen->solid_cache_size; i++) {
 		if (uxa_screen->solid_cache[i].color == solid->color) {
+			UXA_COUNT(screen, SOLID_CACHE_HIT);
 			picture = uxa_screen->solid_cache[i].picture;
 			goto DONE;
 		}
 	}
 
+	UXA_COUNT(screen, SOLID_CACHE_MISS);
 	picture = uxa_create_solid(screen, solid->color);
 	if (!picture)
 		return 0;
@@ -742,15 +772,26 @@ uxa_render_picture(ScreenPtr screen,
 		   INT16 x, INT16 y,
 		   CARD16 width, CARD16 height)
 {
+	uxa_screen_t *uxa_screen = uxa_get_screen(screen);
 	PicturePtr picture;
 	int ret = 0;
 
-	/* XXX we need a mechanism for the card to choose the fallback format */
-
 	/* force alpha channel in case source does not entirely cover the extents */
 	if (PIXMAN_FORMAT_A(format) == 0)
 		format = PIXMAN_a8r8g8b8; /* available on all hardware */
 
+	/* Keep the source format if the card can sample it, otherwise convert
+	 * to one that is available on all hardware rather than leaving the
+	 * whole operation to software.
+	 */
+	if (uxa_screen->info->check_texture_format &&
+	    !uxa_screen->info->check_texture_format(screen, format)) {
+		if (PIXMAN_FORMAT_TYPE(format) == PIXMAN_TYPE_A)
+			format = PIXMAN_a8;
+		else
+			format = PIXMAN_a8r8g8b8;
+	}
+
 	picture = uxa_picture_for_pixman_format(screen, format, width, height);
 	if (!picture)
 		return 0;
@@ -788,6 +829,155 @@ drawable_contains (DrawablePtr drawable, int x, int y, int w, int h)
 	return TRUE;
 }
 
+/*
+ * The part of a depth-1 source that compositing x, y, width, height
+ * samples, in bitmap coordinates: the destination rectangle through the
+ * source transform, plus a pixel for rounding and bilinear filtering.
+ * Returns TRUE and the whole bitmap when the extents can't be bounded,
+ * or reach outside a repeating bitmap, so the repeat must be kept.
+ */
+static Bool
+uxa_bitmap_extents(PictTransformPtr transform, Bool repeat,
+		   int bitmap_width, int bitmap_height,
+		   INT16 x, INT16 y, CARD16 width, CARD16 height,
+		   pixman_box16_t * box)
+{
+	box->x1 = x;
+	box->y1 = y;
+	box->x2 = x + width < MAXSHORT ? x + width : MAXSHORT;
+	box->y2 = y + height < MAXSHORT ? y + height : MAXSHORT;
+
+	if (transform && !pixman_transform_bounds(transform, box))
+		goto whole;
+
+	box->x1 = box->x1 > 0 ? box->x1 - 1 : 0;
+	box->y1 = box->y1 > 0 ? box->y1 - 1 : 0;
+	box->x2 = box->x2 < bitmap_width ? box->x2 + 1 : bitmap_width;
+	box->y2 = box->y2 < bitmap_height ? box->y2 + 1 : bitmap_height;
+	if (box->x1 >= box->x2 || box->y1 >= box->y2)
+		goto whole;
+
+	/* Samples outside a repeating bitmap wrap around into all of it */
+	if (repeat && (box->x1 == 0 || box->y1 == 0 ||
+		       box->x2 == bitmap_width || box->y2 == bitmap_height))
+		goto whole;
+
+	return FALSE;
+
+whole:
+	box->x1 = 0;
+	box->y1 = 0;
+	box->x2 = bitmap_width;
+	box->y2 = bitmap_height;
+	return TRUE;
+}
+
+/*
+ * Expand a depth-1 source into an a8 pixmap with CopyPlane, which the
+ * driver can do on the blitter, instead of converting it with pixman.
+ *
+ * If the samples are an untransformed rectangle inside the bitmap only
+ * that rectangle is expanded.  Otherwise only the transformed sample
+ * extents are, and the new picture keeps the source's transform, moved
+ * to the expanded rectangle, and filter, so the transformed lookup is
+ * still done by the GPU.
+ */
+static PicturePtr
+uxa_expand_bitmap(ScreenPtr pScreen,
+		  PicturePtr pSrc,
+		  INT16 x, INT16 y,
+		  CARD16 width, CARD16 height,
+		  INT16 * out_x, INT16 * out_y)
+{
+	DrawablePtr pDrawable = pSrc->pDrawable;
+	struct pixman_transform transform;
+	pixman_box16_t box;
+	PixmapPtr pPixmap;
+	PicturePtr pDst;
+	ChangeGCVal gcv[2];
+	XID repeat = RepeatNone;
+	Mask mask = 0;
+	int tx, ty, error;
+	Bool transformed;
+	GCPtr pGC;
+
+	transformed =
+		!transform_is_integer_translation(pSrc->transform, &tx, &ty) ||
+		!drawable_contains(pDrawable, x + tx, y + ty, width, height);
+	if (transformed) {
+		if (uxa_bitmap_extents(pSrc->transform, pSrc->repeat,
+				       pDrawable->width, pDrawable->height,
+				       x, y, width, height, &box) &&
+		    pSrc->repeat) {
+			repeat = pSrc->repeatType;
+			mask = CPRepeat;
+		}
+	} else {
+		box.x1 = x + tx;
+		box.y1 = y + ty;
+		box.x2 = box.x1 + width;
+		box.y2 = box.y1 + height;
+	}
+
+	pPixmap = pScreen->CreatePixmap(pScreen,
+					box.x2 - box.x1, box.y2 - box.y1, 8,
+					CREATE_PIXMAP_USAGE_SCRATCH);
+	if (!pPixmap)
+		return 0;
+
+	if (!uxa_pixmap_is_offscreen(pPixmap)) {
+		pScreen->DestroyPixmap(pPixmap);
+		return 0;
+	}
+
+	pGC = GetScratchGC(8, pScreen);
+	if (!pGC) {
+		pScreen->DestroyPixmap(pPixmap);
+		return 0;
+	}
+
+	gcv[0].val = 0xff;
+	gcv[1].val = 0;
+	ChangeGC(NullClient, pGC, GCForeground | GCBackground, gcv);
+	ValidateGC(&pPixmap->drawable, pGC);
+	pGC->ops->CopyPlane(pDrawable, &pPixmap->drawable, pGC,
+			    box.x1, box.y1,
+			    box.x2 - box.x1, box.y2 - box.y1, 0, 0, 1);
+	FreeScratchGC(pGC);
+
+	pDst = CreatePicture(0, &pPixmap->drawable,
+			     PictureMatchFormat(pScreen, 8, PICT_a8),
+			     mask, &repeat, serverClient, &error);
+	pScreen->DestroyPixmap(pPixmap);
+	if (!pDst)
+		return 0;
+
+	if (transformed) {
+		/* Sample the expanded rectangle where the source was sampled */
+		if (pSrc->transform)
+			transform = *pSrc->transform;
+		else
+			pixman_transform_init_identity(&transform);
+		if (!pixman_transform_translate(&transform, NULL,
+						pixman_int_to_fixed(-box.x1),
+						pixman_int_to_fixed(-box.y1)) ||
+		    SetPictureTransform(pDst, &transform) != Success) {
+			FreePicture(pDst, 0);
+			return 0;
+		}
+		pDst->filter = pSrc->filter;
+		*out_x = x;
+		*out_y = y;
+	} else {
+		*out_x = 0;
+		*out_y = 0;
+	}
+
+	ValidatePicture(pDst);
+	pDst->componentAlpha = pSrc->componentAlpha;
+	return pDst;
+}
+
 PicturePtr
 uxa_acquire_drawable(ScreenPtr pScreen,
 		     PicturePtr pSrc,
@@ -802,6 +992,14 @@ uxa_acquire_drawable(ScreenPtr pScreen,
 	GCPtr pGC;
 
 	depth = pSrc->pDrawable->depth;
+	if (depth == 1 && !pSrc->alphaMap &&
+	    pSrc->filter != PictFilterConvolution) {
+		pDst = uxa_expand_bitmap(pScreen, pSrc, x, y, width, height,
+					 out_x, out_y);
+		if (pDst)
+			return pDst;
+	}
+
 	if (!transform_is_integer_translation(pSrc->transform, &tx, &ty) ||
 	    !drawable_contains(pSrc->pDrawable, x + tx, y + ty, width, height) ||
 	    depth == 1 ||
@@ -96,6 +96,19 @@ void uxa_picture_finish_access(PicturePtr picture, int mode)
 }
 
 
+/**
+ * Prepares the destination of a GC operation for access.  fb clips all
+ * rendering to the GC's composite clip, so only its extents need to be
+ * synchronized with the GPU.
+ */
+static Bool uxa_prepare_access_dest(DrawablePtr pDrawable, GCPtr pGC)
+{
+	return uxa_prepare_access_box(pDrawable,
+				      REGION_EXTENTS(pDrawable->pScreen,
+						     pGC->pCompositeClip),
+				      UXA_ACCESS_RW);
+}
+
 char uxa_drawable_location(DrawablePtr pDrawable)
 {
 	return uxa_drawable_is_offscreen(pDrawable) ? 's' : 'm';
@@ -109,7 +122,8 @@ uxa_check_fill_spans(DrawablePtr pDrawable, GCPtr pGC, int nspans,
 
 	UXA_FALLBACK(("to %p (%c)\n", pDrawable,
 		      uxa_drawable_location(pDrawable)));
-	if (uxa_prepare_access(pDrawable, UXA_ACCESS_RW)) {
+	UXA_COUNT(screen, FALLBACK_FILL_SPANS);
+	if (uxa_prepare_access_dest(pDrawable, pGC)) {
 		if (uxa_prepare_access_gc(pGC)) {
 			fbFillSpans(pDrawable, pGC, nspans, ppt, pwidth,
 				    fSorted);
@@ -127,7 +141,8 @@ uxa_check_set_spans(DrawablePtr pDrawable, GCPtr pGC, char *psrc,
 
 	UXA_FALLBACK(("to %p (%c)\n", pDrawable,
 		      uxa_drawable_location(pDrawable)));
-	if (uxa_prepare_access(pDrawable, UXA_ACCESS_RW)) {
+	UXA_COUNT(screen, FALLBACK_SET_SPANS);
+	if (uxa_prepare_access_dest(pDrawable, pGC)) {
 		fbSetSpans(pDrawable, pGC, psrc, ppt, pwidth, nspans, fSorted);
 		uxa_finish_access(pDrawable, UXA_ACCESS_RW);
 	}
@@ -142,7 +157,8 @@ uxa_check_put_image(DrawablePtr pDrawable, GCPtr pGC, int depth,
 
 	UXA_FALLBACK(("to %p (%c)\n", pDrawable,
 		      uxa_drawable_location(pDrawable)));
-	if (uxa_prepare_access(pDrawable, UXA_ACCESS_RW)) {
+	UXA_COUNT(screen, FALLBACK_PUT_IMAGE);
+	if (uxa_prepare_access_dest(pDrawable, pGC)) {
 		fbPutImage(pDrawable, pGC, depth, x, y, w, h, leftPad, format,
 			   bits);
 		uxa_finish_access(pDrawable, UXA_ACCESS_RW);
@@ -155,12 +171,18 @@ uxa_check_copy_area(DrawablePtr pSrc, DrawablePtr pDst, GCPtr pGC,
 {
 	ScreenPtr screen = pSrc->pScreen;
 	RegionPtr ret = NULL;
+	BoxRec src_box;
 
 	UXA_FALLBACK(("from %p to %p (%c,%c)\n", pSrc, pDst,
 		      uxa_drawable_location(pSrc),
 		      uxa_drawable_location(pDst)));
-	if (uxa_prepare_access(pDst, UXA_ACCESS_RW)) {
-		if (uxa_prepare_access(pSrc, UXA_ACCESS_RO)) {
+	UXA_COUNT(screen, FALLBACK_COPY_AREA);
+	src_box.x1 = pSrc->x + srcx;
+	src_box.y1 = pSrc->y + srcy;
+	src_box.x2 = src_box.x1 + w;
+	src_box.y2 = src_box.y1 + h;
+	if (uxa_prepare_access_dest(pDst, pGC)) {
+		if (uxa_prepare_access_box(pSrc, &src_box, UXA_ACCESS_RO)) {
 			ret =
 			    fbCopyArea(pSrc, pDst, pGC, srcx, srcy, w, h, dstx,
 				       dsty);
@@ -178,12 +200,18 @@ uxa_check_copy_plane(DrawablePtr pSrc, DrawablePtr pDst, GCPtr pGC,
 {
 	ScreenPtr screen = pSrc->pScreen;
 	RegionPtr ret = NULL;
+	BoxRec src_box;
 
 	UXA_FALLBACK(("from %p to %p (%c,%c)\n", pSrc, pDst,
 		      uxa_drawable_location(pSrc),
 		      uxa_drawable_location(pDst)));
-	if (uxa_prepare_access(pDst, UXA_ACCESS_RW)) {
-		if (uxa_prepare_access(pSrc, UXA_ACCESS_RO)) {
+	UXA_COUNT(screen, FALLBACK_COPY_PLANE);
+	src_box.x1 = pSrc->x + srcx;
+	src_box.y1 = pSrc->y + srcy;
+	src_box.x2 = src_box.x1 + w;
+	src_box.y2 = src_box.y1 + h;
+	if (uxa_prepare_access_dest(pDst, pGC)) {
+		if (uxa_prepare_access_box(pSrc, &src_box, UXA_ACCESS_RO)) {
 			ret =
 			    fbCopyPlane(pSrc, pDst, pGC, srcx, srcy, w, h, dstx,
 					dsty, bitPlane);
@@ -202,7 +230,8 @@ uxa_check_poly_point(DrawablePtr pDrawable, GCPtr pGC, int mode, int npt,
 
 	UXA_FALLBACK(("to %p (%c)\n", pDrawable,
 		      uxa_drawable_location(pDrawable)));
-	if (uxa_prepare_access(pDrawable, UXA_ACCESS_RW)) {
+	UXA_COUNT(screen, FALLBACK_POLY_POINT);
+	if (uxa_prepare_access_dest(pDrawable, pGC)) {
 		fbPolyPoint(pDrawable, pGC, mode, npt, pptInit);
 		uxa_finish_access(pDrawable, UXA_ACCESS_RW);
 	}
@@ -217,9 +246,10 @@ uxa_check_poly_lines(DrawablePtr pDrawable, GCPtr pGC,
 	UXA_FALLBACK(("to %p (%c), width %d, mode %d, count %d\n",
 		      pDrawable, uxa_drawable_location(pDrawable),
 		      pGC->lineWidth, mode, npt));
+	UXA_COUNT(screen, FALLBACK_POLY_LINES);
 
 	if (pGC->lineWidth == 0) {
-		if (uxa_prepare_access(pDrawable, UXA_ACCESS_RW)) {
+		if (uxa_prepare_access_dest(pDrawable, pGC)) {
 			if (uxa_prepare_access_gc(pGC)) {
 				fbPolyLine(pDrawable, pGC, mode, npt, ppt);
 				uxa_finish_access_gc(pGC);
@@ -241,8 +271,9 @@ uxa_check_poly_segment(DrawablePtr pDrawable, GCPtr pGC,
 	UXA_FALLBACK(("to %p (%c) width %d, count %d\n", pDrawable,
 		      uxa_drawable_location(pDrawable), pGC->lineWidth,
 		      nsegInit));
+	UXA_COUNT(screen, FALLBACK_POLY_SEGMENT);
 	if (pGC->lineWidth == 0) {
-		if (uxa_prepare_access(pDrawable, UXA_ACCESS_RW)) {
+		if (uxa_prepare_access_dest(pDrawable, pGC)) {
 			if (uxa_prepare_access_gc(pGC)) {
 				fbPolySegment(pDrawable, pGC, nsegInit,
 					      pSegInit);
@@ -263,6 +294,7 @@ uxa_check_poly_arc(DrawablePtr pDrawable, GCPtr pGC, int narcs, xArc * pArcs)
 
 	UXA_FALLBACK(("to %p (%c)\n", pDrawable,
 		      uxa_drawable_location(pDrawable)));
+	UXA_COUNT(screen, FALLBACK_POLY_ARC);
 
 	/* Disable this as fbPolyArc can call miZeroPolyArc which in turn
 	 * can call accelerated functions, that as yet, haven't been notified
@@ -270,7 +302,7 @@ uxa_check_poly_arc(DrawablePtr pDrawable, GCPtr pGC, int narcs, xArc * pArcs)
 	 */
 #if 0
 	if (pGC->lineWidth == 0) {
-		if (uxa_prepare_access(pDrawable, UXA_ACCESS_RW)) {
+		if (uxa_prepare_access_dest(pDrawable, pGC)) {
 			if (uxa_prepare_access_gc(pGC)) {
 				fbPolyArc(pDrawable, pGC, narcs, pArcs);
 				uxa_finish_access_gc(pGC);
@@ -291,8 +323,9 @@ uxa_check_poly_fill_rect(DrawablePtr pDrawable, GCPtr pGC,
 
 	UXA_FALLBACK(("to %p (%c)\n", pDrawable,
 		      uxa_drawable_location(pDrawable)));
+	UXA_COUNT(screen, FALLBACK_POLY_FILL_RECT);
 
-	if (uxa_prepare_access(pDrawable, UXA_ACCESS_RW)) {
+	if (uxa_prepare_access_dest(pDrawable, pGC)) {
 		if (uxa_prepare_access_gc(pGC)) {
 			fbPolyFillRect(pDrawable, pGC, nrect, prect);
 			uxa_finish_access_gc(pGC);
@@ -310,7 +343,8 @@ uxa_check_image_glyph_blt(DrawablePtr pDrawable, GCPtr pGC,
 
 	UXA_FALLBACK(("to %p (%c)\n", pDrawable,
 		      uxa_drawable_location(pDrawable)));
-	if (uxa_prepare_access(pDrawable, UXA_ACCESS_RW)) {
+	UXA_COUNT(screen, FALLBACK_IMAGE_GLYPH_BLT);
+	if (uxa_prepare_access_dest(pDrawable, pGC)) {
 		if (uxa_prepare_access_gc(pGC)) {
 			fbImageGlyphBlt(pDrawable, pGC, x, y, nglyph, ppci,
 					pglyphBase);
@@ -330,7 +364,8 @@ uxa_check_poly_glyph_blt(DrawablePtr pDrawable, GCPtr pGC,
 	UXA_FALLBACK(("to %p (%c), style %d alu %d\n", pDrawable,
 		      uxa_drawable_location(pDrawable), pGC->fillStyle,
 		      pGC->alu));
-	if (uxa_prepare_access(pDrawable, UXA_ACCESS_RW)) {
+	UXA_COUNT(screen, FALLBACK_POLY_GLYPH_BLT);
+	if (uxa_prepare_access_dest(pDrawable, pGC)) {
 		if (uxa_prepare_access_gc(pGC)) {
 			fbPolyGlyphBlt(pDrawable, pGC, x, y, nglyph, ppci,
 				       pglyphBase);
@@ -349,7 +384,8 @@ uxa_check_push_pixels(GCPtr pGC, PixmapPtr pBitmap,
 	UXA_FALLBACK(("from %p to %p (%c,%c)\n", pBitmap, pDrawable,
 		      uxa_drawable_location(&pBitmap->drawable),
 		      uxa_drawable_location(pDrawable)));
-	if (uxa_prepare_access(pDrawable, UXA_ACCESS_RW)) {
+	UXA_COUNT(screen, FALLBACK_PUSH_PIXELS);
+	if (uxa_prepare_access_dest(pDrawable, pGC)) {
 		if (uxa_prepare_access(&pBitmap->drawable, UXA_ACCESS_RO)) {
 			if (uxa_prepare_access_gc(pGC)) {
 				fbPushPixels(pGC, pBitmap, pDrawable, w, h, x,
@@ -371,6 +407,7 @@ uxa_check_get_spans(DrawablePtr pDrawable,
 
 	UXA_FALLBACK(("from %p (%c)\n", pDrawable,
 		      uxa_drawable_location(pDrawable)));
+	UXA_COUNT(screen, FALLBACK_GET_SPANS);
 	if (uxa_prepare_access(pDrawable, UXA_ACCESS_RO)) {
 		fbGetSpans(pDrawable, wMax, ppt, pwidth, nspans, pdstStart);
 		uxa_finish_access(pDrawable, UXA_ACCESS_RO);
@@ -390,6 +427,7 @@ uxa_check_composite(CARD8 op,
 	ScreenPtr screen = pDst->pDrawable->pScreen;
 
 	UXA_FALLBACK(("from picts %p/%p to pict %p\n", pSrc, pMask, pDst));
+	UXA_COUNT(screen, FALLBACK_COMPOSITE);
 
 	if (uxa_picture_prepare_access(pDst, UXA_ACCESS_RW)) {
 		if (uxa_picture_prepare_access(pSrc, UXA_ACCESS_RO)) {
@@ -416,6 +454,7 @@ uxa_check_add_traps(PicturePtr pPicture,
 
 	UXA_FALLBACK(("to pict %p (%c)\n", pPicture,
 		      uxa_drawable_location(pPicture->pDrawable)));
+	UXA_COUNT(screen, FALLBACK_ADD_TRAPS);
 	if (uxa_picture_prepare_access(pPicture, UXA_ACCESS_RW)) {
 		fbAddTraps(pPicture, x_off, y_off, ntrap, traps);
 		uxa_picture_finish_access(pPicture, UXA_ACCESS_RW);
@@ -143,18 +143,59 @@ PixmapPtr uxa_get_offscreen_pixmap(DrawablePtr drawable, int *xp, int *yp)
  * PrepareAccess() is necessary, and working around PrepareAccess() failure.
  */
 Bool uxa_prepare_access(DrawablePtr pDrawable, uxa_access_t access)
+{
+	return uxa_prepare_access_box(pDrawable, NULL, access);
+}
+
+/**
+ * uxa_prepare_access_box() is uxa_prepare_access() for callers that know
+ * which part of the drawable they are going to touch.
+ *
+ * @param box bounding box of the access, in the same coordinate space as
+ *            pDrawable->x/y, or NULL for the whole drawable.
+ *
+ * The box is clipped to the drawable and handed to the driver in pixmap
+ * coordinates, so that it can skip flushing or waiting for GPU rendering
+ * to other parts of the pixmap.
+ */
+Bool uxa_prepare_access_box(DrawablePtr pDrawable, const BoxRec *box,
+			    uxa_access_t access)
 {
 	ScreenPtr pScreen = pDrawable->pScreen;
 	uxa_screen_t *uxa_screen = uxa_get_screen(pScreen);
 	PixmapPtr pPixmap = uxa_get_drawable_pixmap(pDrawable);
 	Bool offscreen = uxa_pixmap_is_offscreen(pPixmap);
+	BoxRec extents;
+	int xoff, yoff;
 
 	if (!offscreen)
 		return TRUE;
 
-	if (uxa_screen->info->prepare_access)
-		return (*uxa_screen->info->prepare_access) (pPixmap, access);
-	return TRUE;
+	if (!uxa_screen->info->prepare_access)
+		return TRUE;
+
+	extents.x1 = pDrawable->x;
+	extents.y1 = pDrawable->y;
+	extents.x2 = pDrawable->x + pDrawable->width;
+	extents.y2 = pDrawable->y + pDrawable->height;
+	if (box) {
+		if (box->x1 > extents.x1)
+			extents.x1 = box->x1;
+		if (box->y1 > extents.y1)
+			extents.y1 = box->y1;
+		if (box->x2 < extents.x2)
+			extents.x2 = box->x2;
+		if (box->y2 < extents.y2)
+			extents.y2 = box->y2;
+	}
+
+	uxa_get_drawable_deltas(pDrawable, pPixmap, &xoff, &yoff);
+	extents.x1 += xoff;
+	extents.y1 += yoff;
+	extents.x2 += xoff;
+	extents.y2 += yoff;
+
+	return (*uxa_screen->info->prepare_access) (pPixmap, &extents, access);
 }
 
 /**
@@ -349,6 +390,18 @@ void uxa_set_force_fallback(ScreenPtr screen, Bool value)
 	uxa_screen->force_fallback = value;
 }
 
+/**
+ * uxa_reset_caches() discards the glyph and solid-fill caches, whose
+ * pixmaps may hold garbage after the GPU has been reset.
+ */
+void uxa_reset_caches(ScreenPtr screen)
+{
+#ifdef RENDER
+	uxa_solid_reset(screen);
+	uxa_glyphs_reset(screen);
+#endif
+}
+
 /**
  * uxa_close_screen() unwraps its wrapped screen functions and tears down UXA's
  * screen private, before calling down to the next CloseSccreen.
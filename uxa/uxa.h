@@ -295,6 +295,19 @@ typedef struct _UxaDriver {
 	Bool(*check_composite_texture) (ScreenPtr pScreen,
 					PicturePtr pPicture);
 
+	/**
+	 * check_texture_format() checks to see if a source to the composite
+	 * operation can be sampled in the given format.
+	 *
+	 * @param pScreen Screen
+	 * @param format Picture format
+	 *
+	 * Sources UXA resolves on the CPU are converted to a8 or a8r8g8b8 when
+	 * this rejects their format.  check_texture_format() is not required.
+	 */
+	Bool(*check_texture_format) (ScreenPtr pScreen,
+				     pixman_format_code_t format);
+
 	/**
 	 * prepare_composite() sets up the driver for doing a composite
 	 * operation described in the Render extension protocol spec.
@@ -470,6 +483,9 @@ typedef struct _UxaDriver {
 	 * prepare_access() is called before CPU access to an offscreen pixmap.
 	 *
 	 * @param pPix the pixmap being accessed
+	 * @param box bounding box, in pixmap coordinates, of the pixels that
+	 *        will be accessed.  The driver may skip synchronizing with GPU
+	 *        rendering outside of it.  The box may be empty.
 	 * @param index the index of the pixmap being accessed.
 	 *
 	 * prepare_access() will be called before CPU access to an offscreen
@@ -503,7 +519,7 @@ typedef struct _UxaDriver {
 	 * @return FALSE if prepare_access() is unsuccessful and UXA should use
 	 * get_image() to migate the pixmap out.
 	 */
-	Bool(*prepare_access) (PixmapPtr pPix, uxa_access_t access);
+	Bool(*prepare_access) (PixmapPtr pPix, BoxPtr box, uxa_access_t access);
 
 	/**
 	 * finish_access() is called after CPU access to an offscreen pixmap.
@@ -533,6 +549,117 @@ typedef struct _UxaDriver {
 	Bool(*pixmap_is_offscreen) (PixmapPtr pPix);
 
 	/** @} */
+
+	/** @name mono
+	 * @{
+	 */
+	/**
+	 * check_mono() checks whether the driver can expand 1bpp data into
+	 * this drawable.
+	 * @param pDrawable Destination drawable
+	 * @param alu raster operation
+	 * @param planemask write mask for the expansion
+	 *
+	 * The check_mono() call is recommended if prepare_mono() is
+	 * implemented, but is not required.
+	 */
+	Bool(*check_mono) (DrawablePtr pDrawable, int alu, Pixel planemask);
+
+	/**
+	 * prepare_mono() sets up the driver for expanding 1bpp data.
+	 * @param pPixmap Destination pixmap
+	 * @param alu raster operation
+	 * @param planemask write mask for the expansion
+	 * @param fg pixel value drawn where the source bit is set
+	 * @param bg pixel value drawn where the source bit is clear
+	 * @param opaque FALSE if clear source bits leave the destination
+	 *        untouched, in which case bg is ignored
+	 * @param pattern NULL, or 8 bytes of an 8x8 pattern
+	 * @param pat_x X origin of the pattern in pPixmap
+	 * @param pat_y Y origin of the pattern in pPixmap
+	 *
+	 * Source bits are laid out as in a depth 1 pixmap: row by row, with
+	 * the leftmost pixel of each byte in its least significant bit.
+	 *
+	 * If pattern is NULL, the following operations are mono() calls.
+	 * Otherwise they are mono_pattern() calls filling with pattern,
+	 * repeated every 8 pixels in each direction from (pat_x, pat_y).
+	 *
+	 * Optional; if prepare_mono() is NULL or fails, stippled fills,
+	 * CopyPlane and PushPixels fall back to software rendering.
+	 */
+	Bool(*prepare_mono) (PixmapPtr pPixmap,
+			     int alu, Pixel planemask, Pixel fg, Pixel bg,
+			     Bool opaque, const CARD8 *pattern,
+			     int pat_x, int pat_y);
+
+	/**
+	 * mono() expands a bitmap set up by the last prepare_mono() call.
+	 * @param pPixmap destination pixmap
+	 * @param x left coordinate in pPixmap
+	 * @param y top coordinate in pPixmap
+	 * @param w width
+	 * @param h height
+	 * @param bits first row of the source
+	 * @param stride bytes between source rows
+	 * @param src_x bit offset of the leftmost source pixel in each row
+	 *
+	 * This call is required if prepare_mono() ever succeeds without a
+	 * pattern.
+	 */
+	void (*mono) (PixmapPtr pPixmap, int x, int y, int w, int h,
+		      const CARD8 *bits, int stride, int src_x);
+
+	/**
+	 * mono_pattern() fills (x1,y1)-(x2,y2) of pPixmap with the pattern
+	 * set up by the last prepare_mono() call.
+	 *
+	 * This call is required if prepare_mono() ever succeeds with a
+	 * pattern.
+	 */
+	void (*mono_pattern) (PixmapPtr pPixmap,
+			      int x1, int y1, int x2, int y2);
+
+	/**
+	 * done_mono() finishes a series of mono() or mono_pattern() calls.
+	 *
+	 * This call is required if prepare_mono() ever succeeds.
+	 */
+	void (*done_mono) (PixmapPtr pPixmap);
+	/** @} */
+
+	/** @name statistics
+	 * @{
+	 */
+	/**
+	 * count() is called once for every #UXA_COUNT_* event: software
+	 * fallbacks, glyph and solid picture cache lookups and core text
+	 * drawn by mono expansion.
+	 * @param pScreen the screen the event happened on
+	 * @param event the UXA_COUNT_* value
+	 *
+	 * count() is not required.
+	 */
+	void (*count) (ScreenPtr pScreen, int event);
+
+	/**
+	 * copy_window_damage() is called after a window move or scroll has
+	 * been copied within its pixmap, with the damage it left.
+	 * @param pPixmap the window pixmap
+	 * @param pRegion the copied boxes at their destination, in pixmap
+	 *        coordinates, one copy() each
+	 * @param dx x offset of the source from the destination
+	 * @param dy y offset of the source from the destination
+	 *
+	 * The region is the source region translated by (-dx, -dy), so a
+	 * consumer of it can repeat the move instead of re-reading the
+	 * pixels.
+	 *
+	 * copy_window_damage() is not required.
+	 */
+	void (*copy_window_damage) (PixmapPtr pPixmap, RegionPtr pRegion,
+				    int dx, int dy);
+	/** @} */
 } uxa_driver_t;
 
 /** @name UXA driver flags
@@ -547,6 +674,38 @@ typedef struct _UxaDriver {
 
 /** @} */
 
+/** @name UXA statistics events, see count()
+ * @{
+ */
+enum {
+	/* Software fallbacks, one per uxa_check_*() entry point */
+	UXA_COUNT_FALLBACK_FILL_SPANS,
+	UXA_COUNT_FALLBACK_SET_SPANS,
+	UXA_COUNT_FALLBACK_PUT_IMAGE,
+	UXA_COUNT_FALLBACK_COPY_AREA,
+	UXA_COUNT_FALLBACK_COPY_PLANE,
+	UXA_COUNT_FALLBACK_POLY_POINT,
+	UXA_COUNT_FALLBACK_POLY_LINES,
+	UXA_COUNT_FALLBACK_POLY_SEGMENT,
+	UXA_COUNT_FALLBACK_POLY_ARC,
+	UXA_COUNT_FALLBACK_POLY_FILL_RECT,
+	UXA_COUNT_FALLBACK_IMAGE_GLYPH_BLT,
+	UXA_COUNT_FALLBACK_POLY_GLYPH_BLT,
+	UXA_COUNT_FALLBACK_PUSH_PIXELS,
+	UXA_COUNT_FALLBACK_GET_SPANS,
+	UXA_COUNT_FALLBACK_COMPOSITE,
+	UXA_COUNT_FALLBACK_ADD_TRAPS,
+	UXA_COUNT_NUM_FALLBACKS,
+
+	UXA_COUNT_GLYPH_CACHE_HIT = UXA_COUNT_NUM_FALLBACKS,
+	UXA_COUNT_GLYPH_CACHE_MISS,
+	UXA_COUNT_SOLID_CACHE_HIT,
+	UXA_COUNT_SOLID_CACHE_MISS,
+	UXA_COUNT_CORE_TEXT,
+	UXA_COUNT_NUM_EVENTS
+};
+/** @} */
+
 /** @name UXA CreatePixmap hint flags
  * @{
  */
@@ -574,6 +733,7 @@ uxa_get_color_for_pixmap (PixmapPtr	 pixmap,
 
 void uxa_set_fallback_debug(ScreenPtr screen, Bool enable);
 void uxa_set_force_fallback(ScreenPtr screen, Bool enable);
+void uxa_reset_caches(ScreenPtr screen);
 
 /**
  * Returns TRUE if the given planemask covers all the significant bits in the